@@ -0,0 +1,35 @@
+#ifndef ASM_DIALECT_H
+#define ASM_DIALECT_H
+
+#include <stdbool.h>
+
+#include "asm_writer.h"
+
+/* the assembler the output is written for, chosen with --asm=gas|nasm */
+typedef enum AsmDialect {
+    ASM_NASM,
+    ASM_GAS,
+} AsmDialect;
+
+/* the emitter produces NASM syntax, and each line is printed in the
+ * chosen dialect as it is written out. for GAS that is .intel_syntax
+ * noprefix, so instructions pass through and only these change:
+ *   section, global, extern, align      .section, .globl, .extern, .balign
+ *   db, dw, dd, dq, times, resb to resq .byte to .quad, .ascii, .rept, .zero
+ *   DWORD [x], [rel x]                  DWORD PTR [x], [rip + x]
+ *   ; comment                           # comment
+ * symbols named like GAS operators, such as mod or eq, get a "__" prefix.
+ * lines starting with '.' are already GAS and are left alone.
+ *
+ * the translation is textual, so a NASM spelling it does not know, such as
+ * a new directive or size keyword in the emitter, passes through unchanged.
+ * run_gas_roundtrip.sh catches that: as rejects the line, or with nasm
+ * installed the two objects' .text differ.
+ *
+ * with compact, as for --compact-asm, the comment is cut off the line
+ * and lines left blank are not written at all.
+ */
+void write_asm_line(AsmWriter * out, AsmDialect dialect, bool compact, char * line);
+void write_gas_line(AsmWriter * out, const char * line);
+
+#endif //ASM_DIALECT_H
@@ -0,0 +1,42 @@
+#ifndef ASM_WRITER_H
+#define ASM_WRITER_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* the assembly output. text is collected in one large buffer, which goes
+ * out with a single write when it fills up and when the writer is closed.
+ * the same bytes are echoed to stdout, as the emitter always has.
+ */
+typedef struct AsmWriter {
+    int fd;                 // the output file, or -1 to write through file
+    FILE * file;            // for memory streams, which have no descriptor
+    bool echo;              // copy everything to stdout as well
+    char * buffer;
+    size_t length;
+    size_t capacity;
+    size_t bytes_written;   // to the output, not counting the echo
+    char * line;            // emit_line formats here before the line is written
+    size_t line_capacity;
+} AsmWriter;
+
+AsmWriter * asm_writer_open(const char * path);
+AsmWriter * asm_writer_from_fp(FILE * file);
+
+/* flushes, closes the output and frees the writer */
+void asm_writer_close(AsmWriter * writer);
+
+void asm_writer_flush(AsmWriter * writer);
+void asm_write(AsmWriter * writer, const char * text, size_t length);
+void asm_write_str(AsmWriter * writer, const char * text);
+void asm_write_char(AsmWriter * writer, char c);
+void asm_write_int(AsmWriter * writer, long long value);
+
+/* formats into writer->line and returns it. %s, %d, %u, %ld, %lu, %+d and %%
+ * are converted by hand. anything else, such as %08X, goes to snprintf.
+ */
+char * asm_format_line(AsmWriter * writer, const char * fmt, va_list args);
+
+#endif //ASM_WRITER_H
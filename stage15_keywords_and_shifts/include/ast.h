@@ -154,6 +154,8 @@ typedef struct ASTNode {
             ASTNode* body;
 //            bool declaration_only;
             int size;
+            int saved_registers;    // callee saved registers holding promoted locals
+            int save_area;          // frame offset they are saved at while the function runs
         } function_def;
 
         struct {
@@ -217,6 +219,7 @@ typedef struct ASTNode {
 
         struct {
             ASTNode * expr;
+            int line;                       // reported when an _assert fails
         } expr_stmt;
 
         struct {
@@ -266,8 +269,14 @@ typedef struct ASTNode {
     };
 } ASTNode;
 
+typedef void (*ASTNodeVisitor)(ASTNode * node, void * arg);
+typedef void (*ASTNodeSlotVisitor)(ASTNode ** slot, void * arg);
+
 ASTNode * create_ast();
 void free_ast(ASTNode * node);
+int get_ast_node_count();
+void ast_for_each_child(ASTNode * node, ASTNodeVisitor visit, void * arg);
+void ast_for_each_child_slot(ASTNode * node, ASTNodeSlotVisitor visit, void * arg);
 
 BinaryOperator get_binary_operator_from_tok(Token * tok);
 const char * get_binary_op_name(BinaryOperator op);
@@ -280,6 +289,7 @@ int get_total_nested_array_elements(ASTNode * node);
 int get_array_base_element_size(ASTNode * node);
 
 bool is_assignment(ASTNode * node);
+bool is_inc_dec(ASTNode * node);
 bool is_comparison_op(BinaryOperator op);
 
 #endif
@@ -0,0 +1,25 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct Bitset {
+    int size;           // number of bits
+    int word_count;
+    uint64_t * words;
+} Bitset;
+
+Bitset * bitset_new(int size);
+void bitset_free(Bitset * set);
+void bitset_set(Bitset * set, int bit);
+void bitset_clear(Bitset * set, int bit);
+bool bitset_test(const Bitset * set, int bit);
+void bitset_clear_all(Bitset * set);
+void bitset_set_all(Bitset * set);
+void bitset_copy(Bitset * dest, const Bitset * src);
+bool bitset_equals(const Bitset * a, const Bitset * b);
+bool bitset_union(Bitset * dest, const Bitset * src);      // returns true if dest changed
+bool bitset_intersect(Bitset * dest, const Bitset * src);  // returns true if dest changed
+
+#endif //BITSET_H
@@ -0,0 +1,66 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+
+/* statement level control flow graph of a single function.
+ * blocks reference the AST nodes, nothing is copied, so passes can
+ * rewrite the tree through the items and rebuild the graph afterwards.
+ * the edges mirror what the emitter generates for each statement.
+ */
+
+typedef enum {
+    CFG_ITEM_STATEMENT,     // expression statement, declaration, _print, _assert
+    CFG_ITEM_CONDITION,     // branch condition owned by an if/while/for/do-while
+    CFG_ITEM_EXPRESSION,    // for init/update expression or switch value
+    CFG_ITEM_JUMP,          // return, break, continue, goto
+    CFG_ITEM_LABEL,         // labeled/case/default statement, its inner statement has its own items
+    CFG_ITEM_LOOP           // for/while/do-while entered here, keeps a loop with no other items reachable
+} CFGItemKind;
+
+typedef struct CFGItem {
+    CFGItemKind kind;
+    ASTNode * node;
+    ASTNode * owner;        // statement the condition or expression belongs to
+} CFGItem;
+
+typedef struct BasicBlock {
+    int id;
+    CFGItem * items;
+    int item_count;
+    int item_capacity;
+    struct BasicBlock ** succs;
+    int succ_count;
+    int succ_capacity;
+    struct BasicBlock ** preds;
+    int pred_count;
+    int pred_capacity;
+    bool reachable;
+    int rpo_index;                  // position in reverse post order, -1 if unreachable
+    struct BasicBlock * idom;       // immediate dominator, NULL for the entry
+    ASTNode * loop;                 // for or while statement this block is the header of
+} BasicBlock;
+
+typedef struct CFG {
+    ASTNode * function;
+    BasicBlock ** blocks;
+    int block_count;
+    int block_capacity;
+    BasicBlock * entry;
+    BasicBlock * exit;
+    BasicBlock ** rpo;              // reachable blocks in reverse post order
+    int rpo_count;
+} CFG;
+
+/* label and loop items only mark where a statement starts, they evaluate nothing */
+bool is_marker_item(const CFGItem * item);
+
+CFG * build_cfg(ASTNode * function_def);
+void free_cfg(CFG * cfg);
+void compute_dominators(CFG * cfg);
+bool dominates(BasicBlock * a, BasicBlock * b);
+void print_cfg(CFG * cfg);
+
+#endif //CFG_H
@@ -0,0 +1,55 @@
+#ifndef COMPILE_STATS_H
+#define COMPILE_STATS_H
+
+#include <stdio.h>
+
+typedef struct CompileStats {
+    // dead symbol elimination
+    int functions_removed;
+    int globals_removed;
+    int literals_removed;
+    int runtime_helpers_removed;
+
+    // dead code elimination
+    int unreachable_statements_removed;
+    int dead_stores_removed;
+    int dead_computations_removed;
+
+    // common subexpression elimination
+    int common_subexpressions_eliminated;
+
+    // loop optimization
+    int loop_invariants_hoisted;
+    int induction_accesses_reduced;
+    int loops_fully_unrolled;
+    int loops_unrolled;
+    int loops_vectorized;
+
+    // register allocation
+    int locals_promoted;
+
+    // instruction selection
+    int constant_divisions_reduced;
+    int branchless_selects;
+    int fp_values_held;
+    int array_templates;
+    int asserts_outlined;
+
+    // .rodata
+    int literal_bytes;
+    int literal_bytes_merged;
+
+    // input, where the time covers tokenizing only
+    long source_bytes;
+    long tokenize_microseconds;
+
+    // output, where the time covers emitting and writing the assembly
+    long asm_bytes;
+    long emit_microseconds;
+} CompileStats;
+
+CompileStats * get_compile_stats();
+void reset_compile_stats();
+void print_compile_stats(FILE * out);
+
+#endif //COMPILE_STATS_H
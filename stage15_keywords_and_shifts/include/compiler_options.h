@@ -0,0 +1,36 @@
+#ifndef COMPILER_OPTIONS_H
+#define COMPILER_OPTIONS_H
+
+#include <stdbool.h>
+
+#include "asm_dialect.h"
+
+typedef struct CompilerOptions {
+    int opt_level;          // 0 disables the optimization passes
+    bool print_stats;       // --stats
+    bool align_loops;       // --align-loops, pads loop bodies to 16 bytes
+    int unroll_factor;      // --unroll=N, iterations per trip of an unrolled loop, 1 disables unrolling
+    bool vectorize;         // cleared by --no-vectorize, runs array loops on packed SSE2 registers
+    bool fast_math;         // --fast-math, allows reassociating floating point reductions
+    bool branchless;        // cleared by --no-branchless, turns cheap selects into cmov instead of branches
+    bool register_locals;   // cleared by --no-register-locals, keeps scalar locals in callee saved registers
+    AsmDialect asm_dialect; // --asm=gas|nasm, the assembler the output is written for
+    bool compact_asm;       // --compact-asm, leaves out comments and blank lines
+} CompilerOptions;
+
+CompilerOptions * get_compiler_options();
+void reset_compiler_options();
+
+/* false at -O0, which turns off the optimization passes and the emitter's
+ * optional lowerings, leaving the plainest code for each expression:
+ *   arithmetic and compares with a memory or immediate operand
+ *   division by constants, which stays idiv
+ *   branching on a comparison's flags, instead of on its 0 or 1
+ *   selects with cmov, minsd or masks instead of branches
+ *   leaving out extensions a value is known not to need
+ *   holding float and double values in xmm8 to xmm15 instead of the stack
+ * loads and stores use the same addressing at every level.
+ */
+bool optimizations_enabled();
+
+#endif //COMPILER_OPTIONS_H
@@ -0,0 +1,23 @@
+#ifndef EMIT_BRANCHLESS_H
+#define EMIT_BRANCHLESS_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+#include "emitter_context.h"
+
+/* c ? a : b without a branch when a and b are cheap and can be evaluated
+ * whatever c is: cmovcc for integers and pointers, minss/maxsd when c
+ * compares a with b, and a cmpsd mask blend for other float selects.
+ * leaves the result in rax or xmm0. false, with nothing emitted, when the
+ * cost model prefers a branch.
+ */
+bool emit_branchless_select(EmitterContext * ctx, ASTNode * node);
+
+/* if (c) x = a; else x = b; and if (c) x = a; for a variable x, stored
+ * as x = c ? a : b through emit_branchless_select. false when the
+ * statement does not have that shape or the select does not pay.
+ */
+bool emit_branchless_if(EmitterContext * ctx, ASTNode * node);
+
+#endif //EMIT_BRANCHLESS_H
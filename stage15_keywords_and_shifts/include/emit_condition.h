@@ -4,10 +4,24 @@
 
 #ifndef _EMIT_CONDITION_H
 #define _EMIT_CONDITION_H
+#include <stdbool.h>
+
 #include "ast.h"
 #include "emitter.h"
 #include "emitter_context.h"
 
-void emit_condition(EmitterContext * ctx, ASTNode * node, int ltrue, int lfalse, EvalMode mode);
+bool is_comparison(ASTNode * node);
+
+/* the comparison that holds exactly when op does not. only integers may
+ * be negated this way; unordered floats fail both a < b and a >= b.
+ */
+BinaryOperator negated_comparison(BinaryOperator op);
+
+/* the condition code suffix of jcc, setcc and cmovcc that tests op on the
+ * flags of an integer cmp, such as "l" for signed < and "b" for unsigned
+ */
+const char * int_condition_code(BinaryOperator op, bool is_signed);
+
+void emit_branch(EmitterContext * ctx, ASTNode * node, const char * target, bool jump_if);
 
 #endif// _EMIT_CONDITION_H
\ No newline at end of file
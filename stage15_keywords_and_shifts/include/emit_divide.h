@@ -0,0 +1,29 @@
+#ifndef EMIT_DIVIDE_H
+#define EMIT_DIVIDE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "emitter.h"
+#include "emitter_context.h"
+
+/* x / d for a constant d > 1 that is not a power of two is the high half
+ * of x * multiplier, shifted right by shift and rounded toward zero. the
+ * multiplier is a bits wide two's complement value; when its top bit is
+ * set x has to be added back to the high half. Hacker's Delight, 10-1.
+ */
+typedef struct DivisionMagic {
+    uint64_t multiplier;
+    int shift;
+} DivisionMagic;
+
+DivisionMagic signed_division_magic(uint64_t divisor, int bits);
+
+/* x / k and x % k on int and long for a literal k, with shifts for powers
+ * of two and a multiply-high for everything else. false when the divisor
+ * is not a nonzero literal, and at -O0, which keeps idiv.
+ */
+bool emit_int_divide_by_constant(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+#endif //EMIT_DIVIDE_H
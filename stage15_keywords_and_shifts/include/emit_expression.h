@@ -14,7 +14,6 @@ void emit_int_assignment_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalM
 void emit_int_binary_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode);
 void emit_fp_binary_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode);
 void emit_fp_assignment_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode);
-void emit_fp_add_assignment_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode);
 void emit_binary_expr_to_reg(EmitterContext * ctx, ASTNode * node, EvalMode mode);
 void emit_expr_to_reg(EmitterContext * ctx, ASTNode * node, EvalMode mode);
 void emit_fp_assignment_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode);
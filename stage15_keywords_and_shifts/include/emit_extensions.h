@@ -8,8 +8,9 @@
 #include "ast.h"
 #include "emitter_context.h"
 
-void emit_print_int_extension_function(EmitterContext * ctx);
-void emit_print_double_extension_function(EmitterContext * ctx);
 void emit_print_extension_statement(EmitterContext * ctx, ASTNode * node);
 void emit_print_extension_call(EmitterContext * ctx, ASTNode * node);
+
+/* writes the failure paths of the function's _asserts to .text.cold */
+void emit_assert_failure_paths(EmitterContext * ctx, const char * function_name);
 #endif //EMIT_EXTENSIONS_H
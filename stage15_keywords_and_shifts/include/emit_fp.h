@@ -0,0 +1,45 @@
+#ifndef EMIT_FP_H
+#define EMIT_FP_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+#include "emitter_context.h"
+#include "emit_stack.h"
+
+/* float and double expressions are evaluated in xmm0. a value that has
+ * to wait while other code is emitted is held in xmm8 to xmm15, used as
+ * a register stack: nothing else in the emitter touches them, and only
+ * a call clobbers them. the value goes to the stack instead when a call
+ * comes in between, when all eight are taken, and always at -O0.
+ */
+typedef struct HeldFPValue {
+    const char * reg;       // "xmm8" to "xmm15", or NULL when on the stack
+    FPWidth width;
+} HeldFPValue;
+
+/* holds xmm0 while the code for pending is emitted */
+HeldFPValue hold_fp_value(EmitterContext * ctx, CType * ctype, ASTNode * pending);
+
+/* moves a held value into xmm and frees where it was held */
+void restore_fp_value(EmitterContext * ctx, HeldFPValue * held, const char * xmm);
+
+/* calls clobber every xmm register */
+bool contains_call(ASTNode * node);
+
+/* lhs in xmm0 and rhs in xmm1, with no stack traffic unless both make calls */
+void emit_fp_operands(EmitterContext * ctx, ASTNode * lhs, ASTNode * rhs);
+
+/* x + y, x - y, x * y, x / y and -x, leaving the result in xmm0 */
+void emit_fp_arith(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+void emit_fp_negate(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+/* conversions to float and double, from memory when the source is a
+ * variable, except at -O0. the result is left in xmm0.
+ */
+void emit_fp_conversion(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+/* 0.0 and 0.0f, which are zeroed with xorps instead of loaded */
+bool is_fp_zero(ASTNode * node);
+
+#endif //EMIT_FP_H
@@ -0,0 +1,41 @@
+#ifndef EMIT_INITIALIZER_H
+#define EMIT_INITIALIZER_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+#include "emitter_context.h"
+
+/* the constant elements of a local array initializer, laid out in .rodata
+ * and copied into the frame when the declaration runs. slots holds one
+ * initializer per element, NULL for elements that start out zero.
+ */
+typedef struct ArrayTemplate {
+    char * label;
+    CType * element_type;
+    ASTNode ** slots;
+    int count;
+    struct ArrayTemplate * next;
+} ArrayTemplate;
+
+/* int a[n] = { ... } for a local array. the constant elements are copied
+ * from a template with movdqu or rep movsb, the rest of the array is
+ * zeroed with pxor stores or rep stosq, and only elements that are not
+ * constant are evaluated and stored one at a time.
+ */
+void emit_array_initializer(EmitterContext * ctx, ASTNode * var_decl);
+
+/* the data of an initialized global array, written as it is walked. runs
+ * of equal values become times lines.
+ */
+void emit_global_array(EmitterContext * ctx, ASTNode * global_var);
+
+/* true when every element of the global array starts out zero, so it can
+ * go to .bss
+ */
+bool is_zero_array_initializer(ASTNode * global_var);
+
+/* writes out the templates of the functions emitted so far and frees them */
+void emit_array_templates(EmitterContext * ctx);
+
+#endif //EMIT_INITIALIZER_H
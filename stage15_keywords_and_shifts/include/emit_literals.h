@@ -0,0 +1,31 @@
+#ifndef EMIT_LITERALS_H
+#define EMIT_LITERALS_H
+
+#include "ast.h"
+#include "emitter_context.h"
+
+/* string, float and double literals are pooled by content. equal literals
+ * share one label, and a string that ends another one points into its
+ * tail: "ld\n" becomes Str4+5 when "world\n" is Str4.
+ */
+typedef struct LiteralPool {
+    ASTNode ** entries;     // the literals that are written out
+    int count;
+    int capacity;
+} LiteralPool;
+
+typedef struct LiteralPools {
+    LiteralPool strings;
+    LiteralPool floats;
+    LiteralPool doubles;
+} LiteralPools;
+
+/* labels every literal of the translation unit and fills ctx->literal_pools */
+void assign_literal_labels(EmitterContext * ctx, ASTNode * translation_unit);
+
+/* the pooled literals for .rodata: doubles and floats first, from a 16 byte
+ * boundary, then the strings
+ */
+void emit_literal_pools(EmitterContext * ctx);
+
+#endif //EMIT_LITERALS_H
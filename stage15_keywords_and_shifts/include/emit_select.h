@@ -0,0 +1,141 @@
+#ifndef EMIT_SELECT_H
+#define EMIT_SELECT_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+#include "emitter_context.h"
+#include "vreg.h"
+
+/* an x86-64 memory operand, [base + index*scale + disp]. globals are
+ * addressed relative to rip, which takes a displacement but no index.
+ * a local promoted to a register has no memory operand, only reg.
+ */
+typedef struct Address {
+    const char * base;      // "rbp", "rcx" or NULL for a label
+    const char * label;     // global or string literal
+    const char * index;     // "rdx" or NULL
+    int scale;
+    long disp;
+    PhysGpr reg;            // promoted local, or PR_NONE
+    char text[160];
+    char operand[176];
+} Address;
+
+/* covers an lvalue with a single memory operand. the tiles are matched
+ * largest first:
+ *   x                    [rbp-8] or [rel x]
+ *   a[3], m[1][2]        [rbp-40+12]
+ *   a[i], a[i+1]         [rbp+rdx*4-36] after movsxd rdx, dword [i]
+ *   p[i], *(p+i)         [rcx+rdx*4] after mov rcx, [p]
+ * pointers and indexes that are not variables are evaluated through the
+ * stack first. the operand may use rcx and rdx, so it has to be used
+ * before anything else is evaluated.
+ */
+void select_address(EmitterContext * ctx, ASTNode * node, Address * address);
+const char * address_text(Address * address);
+
+/* the operand for a value of ctype at address, as in "dword [rbp-8]", or
+ * the part of the register a promoted local lives in, as in "ebx"
+ */
+const char * operand_text(Address * address, CType * ctype);
+
+/* named variables, and named arrays indexed by constants, whose address
+ * takes no instructions
+ */
+bool has_direct_address(ASTNode * node);
+
+/* the same object, found without side effects */
+bool same_lvalue(ASTNode * a, ASTNode * b);
+
+/* integer literals, possibly cast to another integer or pointer type,
+ * with the value truncated to the width of the cast
+ */
+bool literal_value(ASTNode * node, long * value);
+
+/* loads a variable, array element or dereferenced pointer straight from
+ * its address. arrays are their address.
+ */
+void emit_lvalue_to_reg(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+/* target = value, storing an immediate straight to memory when value is
+ * a literal
+ */
+void emit_store_to_lvalue(EmitterContext * ctx, ASTNode * target, ASTNode * value, EvalMode mode);
+
+/* x += y, x -= y, ++x, x-- and x = x op y for integers and pointers
+ * become one instruction on memory, such as add dword [rbp-8], 3. false
+ * when node is none of those.
+ */
+bool emit_read_modify_write(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+/* x += y and x -= y on float and double */
+void emit_fp_compound_assignment(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+/* int and long arithmetic with an immediate or memory rhs, multiplication
+ * by constants with lea and shifts, and x + y*s with lea. false when none
+ * applies, and at -O0, as are the other tiles.
+ */
+bool emit_int_binary_tile(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+/* float and double arithmetic whose rhs is a variable or literal of the
+ * same type, as in addsd xmm0, qword [rbp-16], or whose lhs is for + and
+ * *. false otherwise.
+ */
+bool emit_fp_binary_tile(EmitterContext * ctx, ASTNode * node, EvalMode mode);
+
+/* sets the flags for an int, long or pointer comparison against an
+ * immediate or memory operand, as in cmp dword [rbp-8], 10. false when
+ * neither side fits.
+ */
+bool emit_int_compare_tile(EmitterContext * ctx, ASTNode * node);
+
+/* sets the flags for any comparison. floats use ucomiss or ucomisd, with
+ * rhs compared against lhs when swapped, so that < and <= can be tested
+ * as > and >=, which unordered operands fail. integers ignore swapped.
+ */
+void emit_comparison_flags(EmitterContext * ctx, ASTNode * node, bool swapped);
+
+/* sets ZF when an integer or pointer value is zero, comparing variables
+ * and array elements in memory except at -O0. false for other types.
+ */
+bool emit_int_test_tile(EmitterContext * ctx, ASTNode * node);
+
+/* integer value in rax. loads and literals skip the stack. */
+void emit_int_operand(EmitterContext * ctx, ASTNode * node);
+
+/* how emit_int_operand leaves the value of node in rax: the low bits that
+ * already hold it extended as its type is, and what the upper half holds.
+ * at -O0 only what its type guarantees.
+ */
+VReg int_operand_vreg(ASTNode * node);
+
+/* integer value in rax, extended to size bytes. variables load extended
+ * straight from memory with movsx, movzx or movsxd; other values are
+ * extended only as far as int_operand_vreg says they are not already.
+ */
+void emit_int_operand_extended(EmitterContext * ctx, ASTNode * node, int size);
+
+/* the low part of an integer variable, array element or dereferenced
+ * pointer, loaded as to_type straight from its address. false for
+ * other values, and at -O0.
+ */
+bool emit_truncating_load(EmitterContext * ctx, ASTNode * node, CType * to_type);
+
+/* float or double value in xmm0 */
+void emit_fp_operand(EmitterContext * ctx, ASTNode * node);
+
+/* the memory operand of a float or double literal in .rodata, or of a
+ * variable or array element
+ */
+void select_fp_leaf(EmitterContext * ctx, ASTNode * node, Address * address);
+
+/* lhs in rax and rhs in rcx, loading literals and variables directly
+ * instead of pushing and popping them
+ */
+void emit_operands_to_rax_rcx(EmitterContext * ctx, ASTNode * lhs, ASTNode * rhs);
+
+/* the same, with both operands extended to size bytes */
+void emit_operands_extended(EmitterContext * ctx, ASTNode * lhs, ASTNode * rhs, int size);
+
+#endif //EMIT_SELECT_H
@@ -0,0 +1,13 @@
+#ifndef EMIT_VECTOR_H
+#define EMIT_VECTOR_H
+
+#include "ast.h"
+#include "emitter_context.h"
+
+/* emitted after the initializer of a for loop that match_vector_loop
+ * accepts. packed SSE2 code processes the elements that fill whole
+ * registers, and the loop itself then handles what is left.
+ */
+void emit_vector_loop(EmitterContext * ctx, ASTNode * node);
+
+#endif //EMIT_VECTOR_H
@@ -26,7 +26,7 @@ void emit_tree_node(EmitterContext * ctx, ASTNode * node);
 //void emit_addr(EmitterContext * ctx, ASTNode * node);
 void emit_translation_unit(EmitterContext * ctx, ASTNode * node);
 void emit_header(EmitterContext * ctx);
-void emit_rodata(EmitterContext * ctx, ASTNode_list * string_literals, ASTNode_list * float_literals, ASTNode_list * double_literals);
+void emit_rodata(EmitterContext * ctx);
 void emit_text_section_header(EmitterContext * ctx);
 void emit_data_section_header(EmitterContext * ctx);
 void emit_bss_section_header(EmitterContext * ctx);
@@ -8,6 +8,7 @@
 #include <stdbool.h>
 
 #include "ast.h"
+#include "runtime_usage.h"
 
 typedef struct FunctionExitContext {
     char * exit_label;
@@ -28,14 +29,17 @@ typedef struct LoopContext {
 typedef struct EmitterContext {
     int label_id;
     char* filename;
-    FILE * out;
-    bool emit_print_int_extension;
-    bool emit_print_double_extension;
+    struct AsmWriter * out;     // see asm_writer.h
     FunctionExitContext * functionExitStack;
     SwitchContext * switch_stack;
     LoopContext * loop_stack;
     int stack_depth;
     int local_space;
+    int fp_held;        // xmm8 and up holding operands, see emit_fp.h
+    struct ArrayTemplate * array_templates;     // local array initializers waiting for .rodata
+    struct LiteralPools * literal_pools;        // see emit_literals.h
+    struct AssertSite * assert_sites;           // failure paths waiting for .text.cold
+    RuntimeUsage runtime_usage;
 } EmitterContext;
 
 EmitterContext * create_emitter_context();
@@ -0,0 +1,37 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+/* the runs the tokenizer skips a block at a time. each scanner takes the
+ * '\0' terminated source and a position in it, and returns the position
+ * of the first character that ends the run, which can be the '\0'.
+ */
+typedef int (*LexScanner)(const char * text, int pos);
+
+typedef struct LexScanners {
+    LexScanner skip_whitespace;     // to the first character isspace rejects
+    LexScanner skip_identifier;     // to the first character not in [A-Za-z0-9_]
+    LexScanner find_line_end;       // to the next '\n'
+    LexScanner find_slash;          // to the next '/', where a block comment may end
+    LexScanner find_string_stop;    // to the next '"' or '\\'
+} LexScanners;
+
+/* the scalar loops are the default. the SIMD versions, asked for with
+ * --lex-scan, measured no faster inside tokenize, where the per-token work
+ * dominates, and fall back to a lower mode the CPU does support
+ */
+typedef enum LexScanMode {
+    LEX_SCAN_SCALAR,
+    LEX_SCAN_SSE2,
+    LEX_SCAN_AVX2,
+} LexScanMode;
+
+const LexScanners * get_lex_scanners();
+LexScanMode get_lex_scan_mode();
+
+/* for tests and benchmarks. asks for a mode, and returns the one used,
+ * which is lower when the CPU does not support it
+ */
+LexScanMode set_lex_scan_mode(LexScanMode mode);
+const char * lex_scan_mode_name(LexScanMode mode);
+
+#endif //LEXER_SCAN_H
@@ -0,0 +1,13 @@
+#ifndef OPT_CSE_H
+#define OPT_CSE_H
+
+#include "ast.h"
+
+/* global value numbering over the dominator tree. a repeated element address
+ * or integer computation whose operands have not changed since a dominating
+ * occurrence is replaced by a read of a temporary that the first occurrence
+ * now assigns.
+ */
+void eliminate_common_subexpressions(ASTNode * function_def);
+
+#endif //OPT_CSE_H
@@ -0,0 +1,12 @@
+#ifndef OPT_DEAD_CODE_H
+#define OPT_DEAD_CODE_H
+
+#include "ast.h"
+
+/* removes statements that can not be reached in the function's control flow
+ * graph, then uses liveness of the scalar locals to drop dead stores and
+ * expression statements whose value is never used.
+ */
+void eliminate_dead_code(ASTNode * function_def);
+
+#endif //OPT_DEAD_CODE_H
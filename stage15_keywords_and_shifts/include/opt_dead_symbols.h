@@ -0,0 +1,13 @@
+#ifndef OPT_DEAD_SYMBOLS_H
+#define OPT_DEAD_SYMBOLS_H
+
+#include "ast.h"
+#include "runtime_usage.h"
+
+/* removes functions, globals and literals that can not be reached from main.
+ * the runtime helpers used by the surviving code are recorded in usage.
+ * a translation unit without main keeps all of its functions.
+ */
+void eliminate_dead_symbols(ASTNode * translation_unit, RuntimeUsage * usage);
+
+#endif //OPT_DEAD_SYMBOLS_H
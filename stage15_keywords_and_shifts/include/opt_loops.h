@@ -0,0 +1,20 @@
+#ifndef OPT_LOOPS_H
+#define OPT_LOOPS_H
+
+#include "ast.h"
+
+/* finds the natural loops of the function's control flow graph that come
+ * from for and while statements. computations that do not change inside a
+ * loop are moved in front of it, and array indexing by the induction
+ * variable of a for loop is replaced by a pointer stepped with it.
+ */
+void optimize_loops(ASTNode * function_def);
+
+/* for loops counting a local from a constant start to a constant bound in
+ * a few iterations are replaced by a copy of the body per iteration. other
+ * counted loops with a small body run --unroll=N iterations per trip,
+ * followed by the original loop for the remainder.
+ */
+void unroll_loops(ASTNode * function_def);
+
+#endif //OPT_LOOPS_H
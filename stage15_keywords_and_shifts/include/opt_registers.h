@@ -0,0 +1,14 @@
+#ifndef OPT_REGISTERS_H
+#define OPT_REGISTERS_H
+
+#include "ast.h"
+
+/* integer and pointer locals whose address is never taken are kept in the
+ * callee saved registers rbx and r12 to r15 for the whole function instead
+ * of in its frame. the most used ones get a register, with uses inside
+ * loops counting for more. calls leave these registers alone, so nothing
+ * is spilled around them; the function saves the ones it uses on entry.
+ */
+void promote_locals_to_registers(ASTNode * function_def);
+
+#endif //OPT_REGISTERS_H
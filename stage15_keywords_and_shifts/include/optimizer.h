@@ -0,0 +1,44 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+#include "symbol.h"
+#include "bitset.h"
+#include "runtime_usage.h"
+
+/* scalar locals and parameters of one function that can be tracked by the
+ * data flow passes. arrays and variables whose address is taken are left out
+ * since they can be read or written through pointers.
+ */
+typedef struct LocalVars {
+    Symbol ** symbols;
+    int count;
+    int capacity;
+} LocalVars;
+
+void optimize_translation_unit(ASTNode * translation_unit, RuntimeUsage * usage);
+
+void discard_ast(ASTNode * node);
+bool is_pure_expression(ASTNode * node);
+bool is_tracked_var_ref(ASTNode * node, LocalVars * vars);
+
+void collect_scalar_locals(ASTNode * function_def, LocalVars * vars);
+void add_local_var(LocalVars * vars, Symbol * symbol);
+int local_var_index(LocalVars * vars, Symbol * symbol);
+void free_local_vars(LocalVars * vars);
+void collect_stores(ASTNode * node, LocalVars * vars, Bitset * stores, bool * clobbers);
+
+bool is_reusable_address(ASTNode * node);
+bool is_reusable_arithmetic(ASTNode * node);
+
+Symbol * create_temp_local(ASTNode * function_def, CType * ctype, const char * prefix);
+ASTNode * create_temp_ref(Symbol * temp);
+ASTNode * create_temp_assignment(Symbol * temp, ASTNode * value);
+ASTNode * create_typed_unary(UnaryOperator op, ASTNode * operand, CType * ctype);
+bool is_cloneable(ASTNode * node);
+ASTNode * clone_expression(ASTNode * node);
+ASTNode * clone_statement(ASTNode * node);
+
+#endif //OPTIMIZER_H
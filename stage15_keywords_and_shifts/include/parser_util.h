@@ -40,7 +40,7 @@ ASTNode * create_cast_expr_node(CType * target_type, ASTNode * expr);
 ASTNode * create_array_access_node(ASTNode * arrayNode, ASTNode * index);
 ASTNode * create_initializer_list(ASTNode_list * list);
 ASTNode * create_print_extension_node(ASTNode * expr);
-ASTNode * create_assert_extension_node(ASTNode * expr);
+ASTNode * create_assert_extension_node(ASTNode * expr, int line);
 ASTNode * create_string_literal_node(const char *text);
 ASTNode * create_declaration_node(CType * ctype);
 ASTNode * create_cond_expr_node(ASTNode * condExpression, ASTNode * thenExpression, ASTNode * elseExpression);
@@ -0,0 +1,25 @@
+#ifndef RUNTIME_USAGE_H
+#define RUNTIME_USAGE_H
+
+#include <stdbool.h>
+
+/* runtime routines and fixed .rodata entries the emitter can reference.
+ * the routines are linked from libmimic99_runtime.a and only declared
+ * extern when used. masks left false are not written to the output.
+ */
+typedef struct RuntimeUsage {
+    bool mask_f32;
+    bool mask_f64;
+    bool print_int;
+    bool print_long;
+    bool print_double;
+    bool print_string;
+    bool assert_fail;
+} RuntimeUsage;
+
+#define RUNTIME_HELPER_COUNT 7
+
+void runtime_usage_init(RuntimeUsage * usage, bool used);
+int runtime_usage_count(RuntimeUsage * usage);
+
+#endif //RUNTIME_USAGE_H
@@ -5,6 +5,7 @@
 #ifndef SYMBOL_H
 #define SYMBOL_H
 #include "c_type.h"
+#include "vreg.h"
 #define MAX_DIMENSIONS 8
 
 typedef enum {
@@ -27,6 +28,7 @@ typedef struct Symbol {
     StorageKind storage;
     CType * ctype;
     ASTNode * node;
+    PhysGpr reg;            // register a promoted local lives in, PR_NONE when it is in memory
 
     union {
         struct {
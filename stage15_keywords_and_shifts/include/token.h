@@ -1,6 +1,8 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <stdbool.h>
+
 #include "list_util.h"
 
 typedef enum {
@@ -68,31 +70,50 @@ typedef enum {
     TOKEN_EOF
 } TokenType;
 
+/* 16 bytes. the text is a span of the token source. an int or float
+ * literal keeps its value in value, and a double literal the index of its
+ * value in the source's literal table. line and col are worked out from
+ * the offset when they are asked for.
+ */
 typedef struct {
-    TokenType type;
-    char * text;
-    int length;
-    int int_value;
-    float float_value;
-    double double_value;
-    int line;
-    int col;
+    unsigned char type;     // a TokenType
+    unsigned int offset;    // where the text starts in the token source
+    unsigned int length;
+    unsigned int value;
 } Token;
 
 DEFINE_LINKED_LIST(Token*, tokenlist);
 
 const char * token_type_name(TokenType type);
 
+/* the text token spans point into. init_tokenizer_context sets it, and it
+ * has to outlive the tokens made from it. the tokens, their literal table
+ * and the line table belong to the source, and go when the next source is
+ * set or release_token_source is called.
+ */
+void set_token_source(const char * text);
+const char * get_token_source();
+void release_token_source();
+
+const char * token_start(const Token * token);
+char * token_text(const Token * token);     // a copy the caller frees, string escapes resolved
+bool token_text_is(const Token * token, const char * text);
+int token_line(const Token * token);
+int token_col(const Token * token);
+int token_int_value(const Token * token);
+float token_float_value(const Token * token);
+double token_double_value(const Token * token);
+
 void init_token_list(tokenlist * list);
 void cleanup_token_list(tokenlist * tokenList);
 void add_token(tokenlist * list, Token * token);
-Token * make_token(TokenType type, const char * text, int line, int col);
-Token * make_int_token(char * numberText, int line, int col);
-Token * make_float_token(char * numberText, int line, int col);
-Token * make_double_token(char * numberText, int line, int col);
-Token * make_eof_token(int line, int col);
-Token * make_identifier_token(const char * id, int line, int col);
-Token * make_string_literal_token(char * buf, int line, int col);
+Token * make_token(TokenType type, int offset, int length);
+Token * make_int_token(int offset, int length);
+Token * make_float_token(int offset, int length);
+Token * make_double_token(int offset, int length);
+Token * make_eof_token(int offset);
+Token * make_identifier_token(int offset, int length);
+Token * make_string_literal_token(int offset, int length);
 
 void free_token(Token * token);
 
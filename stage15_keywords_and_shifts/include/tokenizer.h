@@ -8,6 +8,6 @@
 
 tokenlist * tokenize(const char * text);
 
-Token * match_keyword(TokenizerContext * ctx, const char * text);
+Token * match_keyword(TokenizerContext * ctx, int start, int length);
 
 #endif
\ No newline at end of file
@@ -14,6 +14,7 @@ typedef struct {
 } TokenizerContext;
 
 char advance(TokenizerContext * context);
+char advance_to(TokenizerContext * context, int pos);
 TokenizerContext * init_tokenizer_context(const char * text);
 // TokenList * get_tokens(TokenizerContext * context);
 // Token * get_next_token(TokenizerContext * context);
@@ -1,9 +1,22 @@
 #ifndef __UTIL_H__
 #define __UTIL_H__
 
+#include <stddef.h>
+#include <stdbool.h>
+
 
 char* change_extension(const char* source_file, const char* new_ext);
 char * read_text_file(const char* filename);
+
+/* a source file, mapped read-only when it can be */
+typedef struct SourceText {
+    const char * text;      // followed by a '\0'
+    size_t length;
+    bool mapped;            // munmap rather than free
+} SourceText;
+
+SourceText map_text_file(const char * filename);
+void release_text_file(SourceText * source);
 char *write_temp_file(const char *content);
 const char * get_file_extension(const char * filename);
 void print_indent(int indent);
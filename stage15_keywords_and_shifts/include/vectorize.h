@@ -0,0 +1,39 @@
+#ifndef VECTORIZE_H
+#define VECTORIZE_H
+
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+
+typedef enum {
+    VECTOR_REDUCTION,       // s += a[i] or s += a[i] * b[i]
+    VECTOR_ELEMENTWISE      // c[i] = x op y, where x and y are a[i] or an invariant scalar
+} VectorLoopKind;
+
+/* a for loop over int, float or double arrays that can run several
+ * elements per iteration. every array is a named local or global indexed
+ * by the induction variable itself, so no element depends on another.
+ */
+typedef struct VectorLoop {
+    VectorLoopKind kind;
+    CType * element_type;
+    ASTNode * iv;           // induction variable in the condition
+    ASTNode * bound;        // int literal or scalar int variable
+    bool inclusive;         // i <= bound
+    ASTNode * target;       // accumulator or destination array
+    BinaryOperator op;      // BINOP_UNASSIGNED_OP for a sum, copy or fill
+    ASTNode * lhs;
+    ASTNode * rhs;          // NULL when op is BINOP_UNASSIGNED_OP
+} VectorLoop;
+
+/* true for loops the emitter turns into packed SSE2 code when
+ * vectorization is enabled. float and double reductions reassociate the
+ * additions, so they are only accepted with --fast-math.
+ */
+bool match_vector_loop(ASTNode * for_stmt, VectorLoop * loop);
+
+/* operand lhs or rhs of the loop reads an array rather than a scalar */
+bool is_vector_array_operand(ASTNode * operand);
+
+#endif //VECTORIZE_H
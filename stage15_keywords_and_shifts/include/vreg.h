@@ -8,9 +8,17 @@
 #include "c_type.h"
 
 typedef enum { W8, W16, W32, W64 } Width;
+
+/* the upper half of a general purpose register: unknown, cleared by a 32
+ * bit write, or holding the value extended to all 64 bits
+ */
 typedef enum { ZK_UNKNOWN, ZK_ZEROEXT32, ZK_FULL64 } ZeroKind;
 typedef enum { RC_GPR, RC_XMM } RegClass;
-typedef enum { PR_RAX, PR_RCX } PhysGpr;
+/* rbx and r12 to r15 are callee saved, so locals promoted to them live
+ * across calls without being spilled
+ */
+typedef enum { PR_RAX, PR_RCX, PR_RDX, PR_RBX, PR_R12, PR_R13, PR_R14, PR_R15, PR_NONE } PhysGpr;
+#define CALLEE_SAVED_GPR_COUNT 5
 typedef enum { PX_XMM0, PX_XMM1 } PhysXmm;
 
 typedef struct {
@@ -19,9 +27,18 @@ typedef struct {
     CType *ctype;
     int phys;               // PR_RAX, or PX_XMM0. needs to be consistent with regClass
     bool spill_off;
-    Width width;
+    Width width;            // low bits that hold the value, sign or zero extended as its ctype is
     ZeroKind zeroKind;
 } VReg;
 
 VReg  make_vreg(RegClass rc, CType* ctype);
+
+Width width_for_size(int size);
+int width_bits(Width width);
+
+/* the callee saved registers in the order locals are given them */
+PhysGpr callee_saved_gpr(int index);
+
+/* the part of reg holding size bytes: "bl", "r12w", "eax", "rdx" */
+const char * phys_gpr_name(PhysGpr reg, int size);
 #endif //_VREG_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+/* local array initializers: constants are copied from a template, the rest
+ * of the array is zeroed in bulk, and only the elements that are not
+ * constant are computed. each check that holds adds its own bit.
+ */
+
+int seven() {
+    return 7;
+}
+
+int fill(int n) {
+    int buf[4096] = {0};
+    int big[300] = {1, 2, 3, n};
+    long s = 0;
+    int i;
+    for (i = 0; i < 4096; i++) {
+        s = s + buf[i];
+    }
+    for (i = 0; i < 300; i++) {
+        s = s + big[i];
+    }
+    return s;
+}
+
+int main() {
+    int x = 5;
+    int a[4] = {-1, 6};
+    double d[3] = {1, -2.5, x};
+    float f[3] = {1.5f, 2, seven()};
+    long l[3] = {-3, x, 4};
+    char c[2][3] = {{1, 2}, {3}};
+    short h[5] = {300, 0, 0, 0, -2};
+    int r = 0;
+
+    if (a[0] == -1 && a[1] == 6 && a[2] == 0 && a[3] == 0) r = r + 1;
+    if (d[0] == 1.0 && d[1] == -2.5 && d[2] == 5.0) r = r + 2;
+    if (f[0] == 1.5f && f[1] == 2.0f && f[2] == 7.0f) r = r + 4;
+    if (l[0] == -3 && l[1] == 5 && l[2] == 4) r = r + 8;
+
+    // a braced row starts a new row, the rest of the short one is zero
+    if (c[0][0] == 1 && c[0][1] == 2 && c[0][2] == 0 && c[1][0] == 3 && c[1][2] == 0) r = r + 16;
+    if (h[0] == 300 && h[3] == 0 && h[4] == -2) r = r + 32;
+
+    // the big arrays start out zero past their initializers every call
+    if (fill(4) == 10 && fill(-6) == 0) r = r - 21;
+    return r;
+}
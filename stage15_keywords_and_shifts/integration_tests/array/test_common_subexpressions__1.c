@@ -0,0 +1,42 @@
+int g;
+int bump() { g = g + 1; return g; }
+int main() {
+    int a[8];
+    double d[4];
+    int *p;
+    int i;
+    int j;
+    int s = 0;
+    int x = 2;
+    for (i = 0; i < 8; i++) { a[i] = i; }
+    p = a;
+    i = 3;
+    s = a[i] * 3;
+    p[3] = 10;
+    s = s + a[i] * 3;
+    g = 4;
+    s = s + g * x;
+    bump();
+    s = s + g * x;
+    j = 0;
+    while (j < 3) {
+        s = s + a[j + 1] * x;
+        x = x + 1;
+        j = j + 1;
+    }
+    s = s + (x * x);
+    if (s > 0) { s = s + x * x; } else { s = s - x * x; }
+    s = s + x * x;
+    i = 0;
+again:
+    s = s + a[i] * 2;
+    i = i + 1;
+    if (i < 3) goto again;
+    s = s + (i > 1 && a[i] * 7 > 0) + a[i] * 7;
+    d[2] = 1.5;
+    d[2] = d[2] + d[2];
+    if (d[2] > 2.5) {
+        s = s + 256;
+    }
+    return s % 256;
+}
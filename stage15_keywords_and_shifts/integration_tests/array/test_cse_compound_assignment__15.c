@@ -0,0 +1,15 @@
+/* the rhs of a compound assignment runs before the target's address is
+ * taken, so a repeated y[i] has to get its temporary on the rhs
+ */
+int y[4];
+
+int main() {
+    int i = 1;
+    int c = 1;
+    y[1] = 5;
+    y[i] += y[i] * 2;
+    y[2] = 3;
+    i = 2;
+    y[i] += (c ? y[i] : 2);
+    return y[1] + y[2] - 6;
+}
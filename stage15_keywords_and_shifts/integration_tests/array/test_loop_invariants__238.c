@@ -0,0 +1,49 @@
+int g;
+long sum_long(long * x, int n) {
+    long s = 0;
+    int i;
+    for (i = 0; i < n; i = i + 1) {
+        s += x[i];
+    }
+    return s;
+}
+int main() {
+    int a[16];
+    long b[16];
+    int m[4][4];
+    int i;
+    int j;
+    int n = 16;
+    int k = 3;
+    int s = 0;
+    for (i = 0; i < n; i++) {
+        a[i] = i * k;
+        b[i] = i;
+    }
+    g = 2;
+    for (i = 0; i < n; i++) {
+        s = s + a[i] * (n * k) + g;
+    }
+    for (i = 1; i < n - 1; i += 2) {
+        a[i] = a[i - 1] + a[i + 1];
+    }
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            m[i][j] = i * 4 + j;
+        }
+    }
+    i = 0;
+    while (i < 4) {
+        s = s + m[k][i] + n / 4;
+        i++;
+    }
+    for (i = n - 1; i >= 0; i--) {
+        if (a[i] > 30) continue;
+        s = s + a[i];
+    }
+    for (i = 0; i < 0; i++) {
+        s = s + 100 / i;
+    }
+    s = s + sum_long(b, n);
+    return s % 256;
+}
@@ -0,0 +1,62 @@
+float fa[37];
+float fb[37];
+float fc[37];
+double da[21];
+double db[21];
+double dc[21];
+
+int main() {
+    int i;
+    int j;
+    int errors = 0;
+    float x = 2.5f;
+    double y = 0.25;
+
+    for (i = 0; i < 37; i++) {
+        fa[i] = i;
+        fb[i] = 0.5f;
+    }
+    for (i = 0; i < 37; i++) {
+        fc[i] = fa[i] * x;
+    }
+    for (i = 0; i < 37; i++) {
+        fc[i] = fc[i] / fb[i];
+    }
+    for (i = 0; i < 37; i++) {
+        fc[i] = fc[i] - 1.0f;
+    }
+    j = 0;
+    while (j < 37) {
+        if (fc[j] != j * 5.0f - 1.0f) errors++;
+        j++;
+    }
+
+    for (i = 0; i < 21; i++) {
+        da[i] = i;
+        db[i] = i * 2;
+    }
+    for (i = 0; i < 21; i++) {
+        dc[i] = da[i] + db[i];
+    }
+    for (i = 0; i < 21; i++) {
+        dc[i] += y;
+    }
+    double s = 0.0;
+    for (i = 0; i < 21; i++) {
+        s = s + dc[i];
+    }
+    j = 0;
+    while (j < 21) {
+        if (dc[j] != j * 3.0 + 0.25) errors++;
+        j++;
+    }
+    if (s != 635.25) errors++;
+
+    float fs = 0.0f;
+    for (i = 0; i < 37; i++) {
+        fs += fa[i] * fb[i];
+    }
+    if (fs != 333.0f) errors++;
+
+    return 42 + errors;
+}
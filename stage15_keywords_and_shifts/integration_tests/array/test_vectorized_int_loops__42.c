@@ -0,0 +1,82 @@
+int a[1003];
+int b[1003];
+int c[1003];
+
+/* reference sum over a while loop, which the vectorizer leaves alone */
+int scalar_sum(int start, int end) {
+    int s = 0;
+    int j = start;
+    while (j < end) {
+        s = s + c[j];
+        j++;
+    }
+    return s;
+}
+
+int main() {
+    int n = 1003;
+    int k = 7;
+    int i;
+    int j;
+    int errors = 0;
+
+    for (i = 0; i < n; i++) {
+        a[i] = i;
+        b[i] = 3 * i - 500;
+    }
+
+    for (i = 0; i < n; i++) {
+        c[i] = a[i] + b[i];
+    }
+    j = 0;
+    while (j < n) {
+        if (c[j] != 4 * j - 500) errors++;
+        j++;
+    }
+
+    for (i = 0; i < n; i++) {
+        c[i] -= k;
+    }
+    for (i = 0; i < n; i++) {
+        c[i] = c[i] ^ a[i];
+    }
+    j = 0;
+    while (j < n) {
+        if (c[j] != ((4 * j - 507) ^ j)) errors++;
+        j++;
+    }
+
+    // every short trip count, so each remainder length is reached
+    int start;
+    int end;
+    for (start = 0; start < 4; start++) {
+        for (end = start; end < start + 11; end++) {
+            int s = 0;
+            for (i = start; i < end; i++) {
+                s += c[i];
+            }
+            if (s != scalar_sum(start, end)) errors++;
+            if (i != end) errors++;
+        }
+    }
+
+    int local[50];
+    for (i = 0; i <= 49; i++) {
+        local[i] = k;
+    }
+    for (i = 0; i < 50; i = i + 1) {
+        local[i] = local[i] & a[i];
+    }
+    int t = 0;
+    for (i = 0; i < 50; ++i) {
+        t = t + local[i];
+    }
+    j = 0;
+    while (j < 50) {
+        t = t - (j & 7);
+        j++;
+    }
+    if (t != 0) errors++;
+
+    return 42 + errors;
+}
@@ -0,0 +1,95 @@
+/* selects whose arms are cheap compile to cmov, minsd/maxsd or a mask
+ * blend. each check compares against the same choice made by a branch in
+ * a function of its own.
+ */
+
+long seed;
+double zero;
+
+int next_value() {
+    seed = seed * 6364136223 + 1442695040;
+    return seed >> 40;
+}
+
+int pick(int c, int a, int b) {
+    if (c) return a;
+    return b;
+}
+
+double pick_double(int c, double a, double b) {
+    if (c) return a;
+    return b;
+}
+
+int check_ints(int x, int y) {
+    int errors = 0;
+    long lx = x;
+    long ly = y;
+    int m;
+    int * p = &m;
+    int * q = 0;
+
+    if ((x < y ? x : y) != pick(x < y, x, y)) errors++;
+    if ((x >= y ? x : y) != pick(x >= y, x, y)) errors++;
+    if ((x > 100 ? 100 : x) != pick(x > 100, 100, x)) errors++;
+    if ((x < 0 ? -x : x) != pick(x < 0, -x, x)) errors++;
+    if ((x ? y + 1 : y - 1) != pick(x != 0, y + 1, y - 1)) errors++;
+    if ((!(x == y) ? x * 3 : 7) != pick(x != y, x * 3, 7)) errors++;
+    if ((lx > ly ? lx - ly : ly - lx) != pick(x > y, x - y, y - x)) errors++;
+    if ((lx < 0 ? -1 : 1) != pick(x < 0, -1, 1)) errors++;
+    if ((x & 1 ? p : q) != (x & 1 ? p : 0)) errors++;
+
+    m = x;
+    if (y > m) m = y;
+    if (m != pick(y > x, y, x)) errors++;
+    if (x < 0) m = 0; else m = x;
+    if (m != pick(x < 0, 0, x)) errors++;
+    return errors;
+}
+
+int check_doubles(double a, double b) {
+    int errors = 0;
+    double d;
+    float f = a;
+    float g = b;
+
+    if ((a < b ? a : b) != pick_double(a < b, a, b)) errors++;
+    if ((a < b ? b : a) != pick_double(a < b, b, a)) errors++;
+    if ((a > b ? a : b) != pick_double(a > b, a, b)) errors++;
+    if ((a > b ? b : a) != pick_double(a > b, b, a)) errors++;
+    if ((a < 0.0 ? 0.0 : a) != pick_double(a < 0.0, 0.0, a)) errors++;
+    if ((a == b ? 1.0 : a + b) != pick_double(a == b, 1.0, a + b)) errors++;
+    if ((a != b ? a * 2.0 : 3.0) != pick_double(a != b, a * 2.0, 3.0)) errors++;
+    if ((a >= b ? a - b : b - a) != pick_double(a >= b, a - b, b - a)) errors++;
+    if ((f < g ? f : g) != pick_double(f < g, f, g)) errors++;
+    if ((f <= g ? g : 2.5f) != pick_double(f <= g, g, 2.5f)) errors++;
+
+    d = b;
+    if (a > d) d = a;
+    if (d != pick_double(a > b, a, b)) errors++;
+    return errors;
+}
+
+int main() {
+    int errors = 0;
+    int i;
+    double nan;
+    seed = 12345;
+
+    for (i = 0; i < 1000; i++) {
+        int x = next_value() - 8000000;
+        int y = next_value() - 8000000;
+        errors = errors + check_ints(x, y);
+        errors = errors + check_ints(x, x);
+        errors = errors + check_doubles(x / 3.0, y / 5.0);
+    }
+    errors = errors + check_doubles(1.0, 1.0) + check_doubles(0.0, -2.0);
+
+    // comparisons with NaN are false, so the else arm is taken
+    nan = zero / zero;
+    if ((nan < 1.0 ? 1.0 : 2.0) != 2.0) errors++;
+    if ((1.0 > nan ? 1.0 : nan) == 1.0) errors++;
+    if ((nan != nan ? 4 : 5) != 4) errors++;
+
+    return errors == 0 ? 42 : errors;
+}
@@ -0,0 +1,72 @@
+/* division and remainder by literals against idiv on the same values.
+ * div and mod take the divisor as a variable, so they always use idiv.
+ */
+
+long seed;
+
+int next_value(int shift) {
+    seed = seed * 6364136223 + 1442695040;
+    return seed >> shift;
+}
+
+int div(int x, int d) {
+    return x / d;
+}
+
+int mod(int x, int d) {
+    return x % d;
+}
+
+long ldiv(long x, long d) {
+    return x / d;
+}
+
+long lmod(long x, long d) {
+    return x % d;
+}
+
+int check_int(int x) {
+    int errors = 0;
+    if (x / 2 != div(x, 2) || x % 2 != mod(x, 2)) errors++;
+    if (x / 3 != div(x, 3) || x % 3 != mod(x, 3)) errors++;
+    if (x / 7 != div(x, 7) || x % 7 != mod(x, 7)) errors++;
+    if (x / 10 != div(x, 10) || x % 10 != mod(x, 10)) errors++;
+    if (x / 16 != div(x, 16) || x % 16 != mod(x, 16)) errors++;
+    if (x / 641 != div(x, 641) || x % 641 != mod(x, 641)) errors++;
+    if (x / 1000 != div(x, 1000) || x % 1000 != mod(x, 1000)) errors++;
+    if (x / -3 != div(x, -3) || x % -3 != mod(x, -3)) errors++;
+    if (x / -8 != div(x, -8) || x % -8 != mod(x, -8)) errors++;
+    if (x / 1 != div(x, 1) || x % 1 != mod(x, 1)) errors++;
+    if (x / 1073741824 != div(x, 1073741824) || x % 1073741824 != mod(x, 1073741824)) errors++;
+    if (x / 2147483647 != div(x, 2147483647) || x % 2147483647 != mod(x, 2147483647)) errors++;
+    return errors;
+}
+
+int check_long(long x) {
+    int errors = 0;
+    if (x / 3 != ldiv(x, 3) || x % 3 != lmod(x, 3)) errors++;
+    if (x / 7 != ldiv(x, 7) || x % 7 != lmod(x, 7)) errors++;
+    if (x / 10 != ldiv(x, 10) || x % 10 != lmod(x, 10)) errors++;
+    if (x / 64 != ldiv(x, 64) || x % 64 != lmod(x, 64)) errors++;
+    if (x / 1000 != ldiv(x, 1000) || x % 1000 != lmod(x, 1000)) errors++;
+    if (x / -7 != ldiv(x, -7) || x % -7 != lmod(x, -7)) errors++;
+    if (x / 2147483647 != ldiv(x, 2147483647) || x % 2147483647 != lmod(x, 2147483647)) errors++;
+    return errors;
+}
+
+int main() {
+    int errors = 0;
+    int i;
+    long big;
+    seed = 12345;
+
+    for (i = 0; i < 2000; i++) {
+        errors = errors + check_int(next_value(32));
+        errors = errors + check_int(next_value(48));
+        big = next_value(32);
+        errors = errors + check_long(big * 1000003 + next_value(40));
+    }
+    errors = errors + check_int(2147483647) + check_int(-2147483647) + check_int(0);
+
+    return errors == 0 ? 42 : errors;
+}
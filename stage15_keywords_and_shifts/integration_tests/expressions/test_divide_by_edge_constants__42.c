@@ -0,0 +1,64 @@
+/* division and remainder by INT_MIN, -1, 1 and powers of two, against
+ * idiv through div and mod. INT_MIN and LONG_MIN by -1 overflow, so
+ * those two are left out.
+ */
+
+int div(int x, int d) {
+    return x / d;
+}
+
+int mod(int x, int d) {
+    return x % d;
+}
+
+long ldiv(long x, long d) {
+    return x / d;
+}
+
+long lmod(long x, long d) {
+    return x % d;
+}
+
+int check_int(int x) {
+    int errors = 0;
+    int int_min = -2147483647 - 1;
+    if (x / (-2147483647 - 1) != div(x, int_min) || x % (-2147483647 - 1) != mod(x, int_min)) errors++;
+    if (x != int_min && (x / -1 != div(x, -1) || x % -1 != mod(x, -1))) errors++;
+    if (x / 1 != div(x, 1) || x % 1 != mod(x, 1)) errors++;
+    if (x / 2 != div(x, 2) || x % 2 != mod(x, 2)) errors++;
+    if (x / 4 != div(x, 4) || x % 4 != mod(x, 4)) errors++;
+    if (x / -2 != div(x, -2) || x % -2 != mod(x, -2)) errors++;
+    if (x / 1073741824 != div(x, 1073741824) || x % 1073741824 != mod(x, 1073741824)) errors++;
+    if (x / -1073741824 != div(x, -1073741824) || x % -1073741824 != mod(x, -1073741824)) errors++;
+    return errors;
+}
+
+int check_long(long x, long long_min) {
+    int errors = 0;
+    long int_min = -2147483647 - 1;
+    if (x / (long) (-2147483647 - 1) != ldiv(x, int_min) || x % (long) (-2147483647 - 1) != lmod(x, int_min)) errors++;
+    if (x != long_min && (x / (long) -1 != ldiv(x, -1) || x % (long) -1 != lmod(x, -1))) errors++;
+    if (x / (long) 2 != ldiv(x, 2) || x % (long) 2 != lmod(x, 2)) errors++;
+    if (x / (long) 4096 != ldiv(x, 4096) || x % (long) 4096 != lmod(x, 4096)) errors++;
+    if (x / (long) -2 != ldiv(x, -2) || x % (long) -2 != lmod(x, -2)) errors++;
+    if (x / (long) 1073741824 != ldiv(x, 1073741824) || x % (long) 1073741824 != lmod(x, 1073741824)) errors++;
+    return errors;
+}
+
+int main() {
+    int errors = 0;
+    int int_min = -2147483647 - 1;
+    long long_min = 1;
+    long_min = long_min << 63;
+
+    errors = errors + check_int(0) + check_int(1) + check_int(-1) + check_int(7) + check_int(-7);
+    errors = errors + check_int(2147483647) + check_int(int_min) + check_int(int_min + 1);
+    errors = errors + check_int(1073741824) + check_int(-1073741824) + check_int(-1073741825);
+
+    errors = errors + check_long(0, long_min) + check_long(-1, long_min) + check_long(4095, long_min);
+    errors = errors + check_long(-4097, long_min) + check_long(int_min, long_min);
+    errors = errors + check_long(long_min, long_min) + check_long(long_min + 1, long_min);
+    errors = errors + check_long(~long_min, long_min);
+
+    return errors == 0 ? 42 : errors;
+}
@@ -0,0 +1,21 @@
+// long operands that are not variables or literals, which -O0 computes in rax and rcx
+long shifted(int n) {
+    long one = 1;
+    return one << n;
+}
+
+int main() {
+    long a = shifted(20);
+    long big = shifted(40);
+    int s = 33;
+    int errors = 0;
+
+    if (a * (a + 1) != big + a) errors++;
+    if ((a << s) != shifted(53)) errors++;
+    if ((shifted(62) >> s) != shifted(29)) errors++;
+    if (-(a * a) != 0 - big) errors++;
+    if ((big | a) - (big & a) != (big ^ a)) errors++;
+    if (~big != -big - 1) errors++;
+    if (!(big + 0)) errors++;
+    return errors == 0 ? 42 : errors;
+}
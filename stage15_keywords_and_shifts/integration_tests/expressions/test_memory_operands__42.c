@@ -0,0 +1,78 @@
+int g[8];
+long lg[4];
+char text[6];
+
+/* p[-1] and *(p - 1) step back through a pointer into the middle of an array */
+int before(int * p) {
+    return p[-1] + *(p - 1);
+}
+
+int main() {
+    int a[10];
+    int m[3][4];
+    int errors = 0;
+    int i = 2;
+    int j;
+    long u = 3;
+    long l = 5;
+    int * p = a;
+    char c = 100;
+    double d = 2.5;
+    double e = 0.5;
+
+    for (j = 0; j < 10; j++) {
+        a[j] = j;
+    }
+
+    // read-modify-write on memory
+    a[i] += 3;
+    a[i + 1] -= 2;
+    a[u] = a[u] + 10;
+    a[4] = 20 + a[4];
+    g[i] = a[i] * 3;
+    g[i] = g[i] | 1;
+    g[i] = g[i] ^ 2;
+    if (a[2] != 5 || a[3] != 11 || a[4] != 24 || g[2] != 13) errors++;
+
+    // prefix values on array elements, and stepping pointers
+    j = ++a[i];
+    if (j != 6 || a[2] != 6) errors++;
+    j = --a[i];
+    if (j != 5 || a[2] != 5) errors++;
+    p++;
+    p += 2;
+    *p += 1;
+    p = p - 1;
+    if (*p != 5 || a[3] != 12 || before(p) != 2) errors++;
+
+    // rows of a two dimensional array
+    for (j = 0; j < 4; j++) {
+        m[1][j] = j * 5;
+        m[2][3 - j] = j * 9;
+    }
+    if (m[1][i] != 10 || m[2][i + 1] != 0 || m[2][0] != 27) errors++;
+
+    // multiplications by constants and scaled adds
+    lg[1] = l * 3 + l;
+    lg[2] = l * 9 - 1;
+    lg[3] = l + lg[1] * 4;
+    j = i * 7 + (i << 3);
+    if (lg[1] != 20 || lg[2] != 44 || lg[3] != 85 || j != 30) errors++;
+
+    // shifts by constants and narrow types stay narrow
+    j = -64;
+    j = j >> 4;
+    c += 100;
+    text[i] = 97;
+    text[i] += 1;
+    if (j != -4 || c != -56 || text[2] != 98) errors++;
+
+    // compare against memory and immediates
+    if (a[i] > g[i] || l < 5 || p != &a[2]) errors++;
+
+    d -= e;
+    d += d;
+    if (d != 4.0) errors++;
+
+    return errors == 0 ? 42 : errors;
+}
@@ -0,0 +1,55 @@
+/* conditional expressions and if/else assignments whose arms have side
+ * effects or can fault. only the arm chosen may run, so these stay
+ * branches even where a cheap select would be a cmov.
+ */
+
+int calls;
+int values[4];
+
+int counted(int v) {
+    calls++;
+    return v;
+}
+
+int main() {
+    int errors = 0;
+    int i = 0;
+    int n = 0;
+    int zero = 0;
+    int x = 12;
+    int y;
+    int * none = 0;
+    double d;
+
+    // calls
+    y = x > 5 ? counted(1) : counted(2);
+    if (y != 1 || calls != 1) errors++;
+    if (x < 5) y = counted(3); else y = counted(4);
+    if (y != 4 || calls != 2) errors++;
+
+    // increments and decrements
+    y = x > 5 ? values[i++] : values[i + 2];
+    if (i != 1) errors++;
+    y = x < 5 ? ++n : n;
+    if (n != 0) errors++;
+    y = x > 5 ? 7 : n--;
+    if (y != 7 || n != 0) errors++;
+
+    // division by zero and a null pointer, on the arm not taken
+    y = zero != 0 ? x / zero : -1;
+    if (y != -1) errors++;
+    y = none ? *none : 3;
+    if (y != 3) errors++;
+    if (zero) y = x % zero; else y = 5;
+    if (y != 5) errors++;
+
+    // a float arm with a call
+    d = x > 5 ? 0.5 : counted(8) * 2.0;
+    if (d != 0.5 || calls != 2) errors++;
+
+    // a cheap select next to them, which can still be a cmov
+    y = x > n ? x : n;
+    if (y != 12) errors++;
+
+    return errors == 0 ? 42 : errors;
+}
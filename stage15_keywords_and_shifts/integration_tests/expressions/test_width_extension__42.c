@@ -0,0 +1,60 @@
+/* casts and mixed width arithmetic, whose operands are extended by the
+ * loads themselves or only as far as they are not already. each check
+ * that fails adds one to the result.
+ */
+
+char bytes[4];
+short halves[4];
+int words[4];
+long total;
+
+long widen(int x) {
+    return x;
+}
+
+int narrow(long x) {
+    return x;
+}
+
+int main() {
+    char c = -3;
+    short s = -300;
+    int i = -70000;
+    long l = 4096;
+    long big = 65536;
+    int k = 2;
+    int errors = 0;
+
+    big = big * 65536 + 7;
+
+    bytes[1] = -1;
+    halves[2] = -2;
+    words[3] = -5;
+
+    // sign extension of narrow operands into long arithmetic
+    if (l + c != 4093) errors++;
+    if (l - s != 4396) errors++;
+    if (l + i != -65904) errors++;
+    if (c + s + i != -70303) errors++;
+    if ((long) c * 2 != -6) errors++;
+    if ((long) i - 1 != -70001) errors++;
+    if (widen(i) != -70000 || widen(c) != -3) errors++;
+
+    // truncation keeps the low bytes, read as the narrower type
+    if ((int) big != 7 || narrow(big) != 7) errors++;
+    if ((char) s != -44) errors++;
+    if ((short) i != -4464) errors++;
+    if ((char) (big + 250) != 1) errors++;
+
+    // extended array elements and indexes
+    total = bytes[1] + halves[2] + words[3] + l;
+    if (total != 4088) errors++;
+    if (words[k + 1] + (long) halves[k] != -7) errors++;
+    if (l / c != -1365 || l % s != 196) errors++;
+    if (big / i != -61356) errors++;
+
+    // comparisons of mixed widths
+    if (i > l || c > s + 400 || big < i) errors++;
+
+    return errors == 0 ? 42 : errors;
+}
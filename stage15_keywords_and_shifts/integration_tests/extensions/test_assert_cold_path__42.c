@@ -0,0 +1,24 @@
+int clamp(int x, int low, int high) {
+    _assert(low <= high);
+    if (x < low) {
+        return low;
+    }
+    if (x > high) {
+        return high;
+    }
+    return x;
+}
+
+int main() {
+    int total = 0;
+    int i;
+    for (i = -20; i < 20; i = i + 1) {
+        int c = clamp(i, -2, 3);
+        _assert(c >= -2 && c <= 3);
+        _assert(!(c > 3));
+        total = total + c;
+    }
+    // -2 * 19 + (-1 + 0 + 1 + 2) + 3 * 17
+    _assert(total == 15);
+    return total + 27;
+}
@@ -0,0 +1,8 @@
+// the buffered output comes before the message, which has no newline
+int main() {
+    _print(7);
+    _print("before");
+    _assert(1 < 0);
+    _print("after");
+    return 0;
+}
@@ -0,0 +1,15 @@
+// more than the 64 KiB the runtime buffers, so it is flushed part way
+char line[1001];
+
+int main() {
+    int i;
+    for (i = 0; i < 1000; i++) {
+        line[i] = 97 + i % 26;
+    }
+    line[1000] = 0;
+    for (i = 0; i < 65; i++) {
+        _print(line);
+        _print(i);
+    }
+    return 5;
+}
@@ -0,0 +1,11 @@
+int main() {
+    double d = -2.5;
+    char * empty = "";
+    char * none = 0;
+    _print(d);
+    _print(0.125);
+    _print(empty);
+    _print(none);
+    _print("done");
+    return 4;
+}
@@ -0,0 +1,25 @@
+// integer literals are int, so the long extremes are built with shifts
+int main() {
+    int imin = -2147483647 - 1;
+    long lmin = 1;
+    long lmax;
+    long power = 1;
+    int i;
+    lmin = lmin << 63;
+    lmax = ~lmin;
+    _print(0);
+    _print(-1);
+    _print(9);
+    _print(-10);
+    _print(99);
+    for (i = 0; i <= 18; i++) {
+        _print(power);
+        _print(-power);
+        power = power * 10;
+    }
+    _print(2147483647);
+    _print(imin);
+    _print(lmax);
+    _print(lmin);
+    return 3;
+}
@@ -0,0 +1,64 @@
+/* float and double expressions held in xmm registers: operands deeper
+ * than the eight held registers, calls on either side of an operator,
+ * conversions from memory, negation and zero literals. each check that
+ * fails adds one to the result.
+ */
+
+double weights[8];
+float halves[4];
+
+double twice(double x) {
+    return x * 2.0;
+}
+
+float third(float x) {
+    return x / 3.0f;
+}
+
+double nested(double a, double b) {
+    return (a - b) * (a + b) - (b - twice(a)) / (a * b + 1.0);
+}
+
+int main() {
+    double a = 1.5;
+    double b = 2.5;
+    double zero = 0.0;
+    float f = 6.0f;
+    int i = 7;
+    long l = 9;
+    int k = 1;
+    int errors = 0;
+    double deep;
+
+    // ten operands waiting on the innermost one, two more than are held in registers
+    deep = (a + b) * ((a - b) + ((a * b) - ((a + a) * ((b + b) - ((a * a) +
+           ((b * b) - ((a - b) * ((a + b) - ((b * a) + (b / a))))))))));
+    if (deep < 35.999 || deep > 36.001) errors++;
+
+    // calls on the left, on the right and on both sides
+    if (twice(a) + b != 5.5) errors++;
+    if (b - twice(a) != -0.5) errors++;
+    if (twice(a) * twice(b) != 15.0) errors++;
+    if (nested(a, b) != -4.0 + 0.5 / 4.75) errors++;
+    if (third(f) + third(f) * f != 14.0f) errors++;
+
+    // conversions, from memory and from computed values
+    if (i / 2.0 != 3.5 || l * 0.5 != 4.5) errors++;
+    if ((double) (i + k) != 8.0 || (float) (l - i) != 2.0f) errors++;
+    if ((int) (b * 3.0) != 7 || (long) -b != -2) errors++;
+    if ((double) f + a != 7.5 || (float) (a * b) != 3.75f) errors++;
+
+    // negation and zero
+    if (-a + zero != -1.5 || -(a * b) != -3.75) errors++;
+    if (zero * a != 0.0 || 0.0 - a != -1.5) errors++;
+
+    // stores and compound assignments to computed places
+    weights[i - 5] = a * b + twice(b);
+    weights[(int) (a * 2.0)] += b * b;
+    halves[k + 1] = f / 4.0f - 1.0f;
+    halves[k] -= -halves[k + 1];
+    if (weights[2] != 8.75 || weights[3] != 6.25) errors++;
+    if (halves[2] != 0.5f || halves[1] != 0.5f) errors++;
+
+    return errors == 0 ? 42 : errors;
+}
@@ -0,0 +1,19 @@
+int unused_global = 7;
+int used_global = 40;
+
+int never_called(int a) {
+    _print("never printed");
+    return a + unused_global;
+}
+
+int only_called_by_dead(int a) {
+    return never_called(a) * 2;
+}
+
+int add_two(int a) {
+    return a + 2;
+}
+
+int main() {
+    return add_two(used_global);
+}
@@ -0,0 +1,34 @@
+/* global array initializers are written as they are walked: runs of equal
+ * values become one times line and arrays that are all zero go to .bss.
+ */
+
+int table[1000000] = {1, 2, 3, 3, 3, 3, 3, 3, 4};
+long zeros[1000000] = {0};
+int grid[1000][1000] = {{1}, {2, 2}, {0}, {5, 6, 7}};
+short steps[3][4] = {1, 2, 3, 4, 5};
+double scale[4] = {0.5, 2, -1.0};
+char * names[3] = {"one", "two"};
+
+int main() {
+    long sum = 0;
+    int i;
+    int r = 0;
+
+    for (i = 0; i < 1000000; i++) {
+        sum = sum + table[i] + zeros[i];
+    }
+    if (sum == 1 + 2 + 6 * 3 + 4) r = r + 1;
+
+    table[999999] = 9;
+    if (table[999999] == 9 && table[999998] == 0) r = r + 2;
+
+    // each braced row starts a row of its own
+    if (grid[0][0] == 1 && grid[0][1] == 0 && grid[1][1] == 2 && grid[3][2] == 7 && grid[999][999] == 0) r = r + 4;
+
+    // without braces the values run on into the next row
+    if (steps[0][3] == 4 && steps[1][0] == 5 && steps[1][1] == 0 && steps[2][3] == 0) r = r + 8;
+
+    if (scale[0] * scale[1] == 1.0 && scale[2] == -1.0 && scale[3] == 0.0) r = r + 16;
+    if (*names[0] == *"one" && *names[1] == *"two" && names[2] == 0) r = r + 11;
+    return r;
+}
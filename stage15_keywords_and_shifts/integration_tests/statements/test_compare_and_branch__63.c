@@ -0,0 +1,45 @@
+/* conditions branch straight on the flags of the comparison. each test
+ * that holds adds its own bit; the ones worth 100 must not hold.
+ */
+
+int a[4];
+
+int main() {
+    int i = 3;
+    long l = 5;
+    long big = 65536;
+    float f = 2.5f;
+    double d = 1.5;
+    double zero = 0.0;
+    double nan;
+    int r = 0;
+    int * p = a;
+
+    // 2^32, which is above every int
+    big = big * 65536;
+
+    if (i < 4) r = r + 1;
+    if (l >= i && big > i) r = r + 2;
+    if (d > 1.0 && d <= 1.5 && f >= 2.5f && f < 3.0f) r = r + 4;
+
+    // NaN is unordered: unequal to itself and neither below nor above
+    nan = zero / zero;
+    if (nan == nan) r = r + 100;
+    if (nan != nan) r = r + 8;
+    if (nan < d || nan >= d || nan <= d || nan > d) r = r + 100;
+    if (!(nan > d)) r = r + 16;
+
+    while (i) {
+        i = i - 1;
+        a[i] = i;
+    }
+    do {
+        i = i + 1;
+    } while (i < 2 || a[i] != 3 && i < 3);
+    if (a[2] == 2 && p && i == 3) r = r + 32;
+
+    // || and && as values
+    if ((i == 0 || l == 0) + (i == 3 && l == 5) != 1) r = r + 100;
+
+    return r;
+}
@@ -0,0 +1,35 @@
+int counter = 0;
+int bump() { counter = counter + 1; return counter; }
+int main() {
+    int i = 0;
+    int sum = 0;
+    int unused = 5;
+    int t = 0;
+    t = bump();
+    unused = sum + 3;
+    while (i < 10) {
+        int tmp = i * 2;
+        tmp = i;
+        sum = sum + tmp;
+        i = i + 1;
+        if (i == 100) {
+            return 7;
+            sum = 0;
+        }
+    }
+    goto skip;
+    sum = 1000;
+skip:
+    do {
+        sum = sum + 1;
+        i = i - 1;
+    } while (i > 5);
+    switch (sum) {
+        case 50:
+            sum = sum + 1;
+        default:
+            sum = sum + counter;
+    }
+
+    return sum;
+}
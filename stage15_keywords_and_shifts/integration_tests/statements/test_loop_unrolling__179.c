@@ -0,0 +1,23 @@
+int g;
+int f(int x) { g = g + x; return x * 2; }
+int main() {
+    int a[64];
+    int i;
+    int n = 37;
+    int s = 0;
+    for (i = 0; i < 64; i++) { a[i] = i * 3 - 20; }
+    for (i = 0; i < 4; i++) { s = s + a[i] * i; }
+    for (i = 10; i >= 2; i -= 3) { s = s + a[i]; }
+    for (i = 5; i <= 7; i++) s = s + i;
+    for (i = 0; i < 0; i++) { s = s + 1000; }
+    s = s + i;
+    for (i = 0; i < n; i++) {
+        if (a[i] > 10) s = s + a[i]; else s = s - 1;
+    }
+    s = s + i;
+    for (i = n; i > 3; i--) { s = s + f(a[i]); }
+    for (i = 1; i <= n; i += 2) { s = s + (a[i] > 0 ? a[i] : -a[i]); }
+    s = s + i + g;
+    for (i = 0; i < n; i++) { if (a[i] == 40) return s % 256; }
+    return (s + i) % 256;
+}
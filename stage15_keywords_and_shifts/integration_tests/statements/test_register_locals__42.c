@@ -0,0 +1,79 @@
+/* locals whose address is never taken live in callee saved registers.
+ * callers keep theirs across calls, including recursive ones, and locals
+ * that have their address taken or do not get a register stay in memory.
+ */
+
+int a[8];
+
+int bump(int * p) {
+    *p = *p + 1;
+    return *p;
+}
+
+// each level keeps n and its partial sum in the same registers as its caller
+int sum_down(int n) {
+    int s = 0;
+    if (n == 0) return 0;
+    s = n + sum_down(n - 1);
+    return s;
+}
+
+long mix(char c, short h, long l, int * p) {
+    char small = c;
+    short half = h;
+    long wide = l;
+    int i;
+    for (i = 0; i < 3; i++) {
+        small = small + 1;
+        half = half * 2;
+        wide = wide + *p;
+        p++;
+    }
+    return small + half + wide;
+}
+
+int main() {
+    int i;
+    int j;
+    int k = 0;
+    int counted = 0;
+    long total = 0;
+    char c = 100;
+    short h = 1000;
+    int * p = a;
+    int spare1 = 1;
+    int spare2 = 2;
+    int r = 0;
+
+    for (i = 0; i < 8; i++) {
+        a[i] = i;
+    }
+
+    // calls inside the loop must not disturb i, j and total
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            total = total + bump(&counted) + sum_down(j);
+        }
+    }
+    if (counted == 16 && total == 136 + 4 * 10) r = r + 1;
+
+    // wraps like a char in memory would
+    for (i = 0; i < 30; i++) {
+        c = c + 1;
+    }
+    if (c == -126) r = r + 2;
+
+    h = h * 40;
+    if (h == -25536) r = r + 4;
+
+    // p walks the array while k counts
+    while (k < 8) {
+        if (*p != k) r = r + 100;
+        p++;
+        k++;
+    }
+
+    if (mix(10, 3, 1000000000, a) == 13 + 24 + 1000000003) r = r + 8;
+    if (spare1 + spare2 == 3) r = r + 27;
+    return r;
+}
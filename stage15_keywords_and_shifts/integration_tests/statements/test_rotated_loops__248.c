@@ -0,0 +1,33 @@
+int main() {
+    int i;
+    int j;
+    int s = 0;
+    int a[10];
+    int *p = 0;
+    for (i = 0; i < 10; i++) a[i] = i;
+    for (i = 0; i < 10; i++)
+        for (j = 0; j < 10; j++)
+            s = s + i * j;
+    i = 0;
+    while (i < 10 && a[i] != 7) {
+        i++;
+        if (i == 3) continue;
+        s = s + 1;
+    }
+    i = 0;
+    while (1) {
+        for (j = 0; j < 5; j++) {
+            if (j == 2) break;
+        }
+        i++;
+        if (i > 4 || j > 5) break;
+    }
+    s = s + i;
+    j = 0;
+    do { j = j + 2; if (j == 4) continue; s = s + j; } while (!(j >= 10) && j != 99);
+    if (!p) s = s + 1000;
+    if (p || s < 0) s = 0; else s = s + 1;
+    while (0) { s = 0; }
+    for (;;) { s++; if (s > 3000) break; }
+    return s % 256;
+}
@@ -0,0 +1,32 @@
+/* equal literals share one copy in .rodata, and a string that ends a
+ * longer one points into its tail. each check that holds adds its bit.
+ */
+
+char * greeting = "hello world";
+
+int length(char * s) {
+    int n = 0;
+    while (s[n]) {
+        n++;
+    }
+    return n;
+}
+
+int main() {
+    char * world = "world";
+    char * empty = "";
+    char * again = "hello world";
+    double half = 0.5;
+    double other_half = 0.5;
+    float quarter = 0.25f;
+    int r = 0;
+
+    if (length(world) == 5 && world[0] == *"w" && world[4] == *"d") r = r + 1;
+    if (length(empty) == 0) r = r + 2;
+    if (again == greeting && length(again) == 11) r = r + 4;
+    if (half + other_half == 1.0 && quarter * 4.0f == 1.0f) r = r + 8;
+
+    // the tail must still be a string of its own
+    if (world[5] == 0 && world == greeting + 6) r = r + 27;
+    return r;
+}
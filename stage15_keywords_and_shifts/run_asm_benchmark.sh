@@ -0,0 +1,69 @@
+#! /bin/bash
+
+# compares compiling and assembling a large generated program with
+# --asm=nasm against --asm=gas
+#
+# usage: ./run_asm_benchmark.sh [program] [functions]
+
+PROG=${1:-mimic99}
+FUNCTIONS=${2:-2000}
+
+BUILD_DIR=integration_tests/build/asm_benchmark
+mkdir -p "$BUILD_DIR"
+SRC="$BUILD_DIR/generated.c"
+
+echo "Generating $FUNCTIONS functions into $SRC..."
+{
+    echo "int table[4096];"
+    for ((i = 0; i < FUNCTIONS; i++)); do
+        echo "int f$i(int n) {"
+        echo "    int s = $i;"
+        echo "    int i;"
+        echo "    double d = 1.5;"
+        echo "    for (i = 0; i < n; i = i + 1) {"
+        echo "        s = s + table[(i * $((i % 7 + 1))) & 4095] * $((i % 13 + 2));"
+        echo "        if (s > 100000) { s = s - 99991; }"
+        echo "        d = d * 0.5 + s;"
+        echo "    }"
+        echo "    _assert(s >= 0);"
+        echo "    return s + (int) d;"
+        echo "}"
+    done
+    echo "int main() {"
+    echo "    int s = 0;"
+    for ((i = 0; i < FUNCTIONS; i++)); do
+        echo "    s = s + f$i(s & 7);"
+    done
+    echo "    return s & 1;"
+    echo "}"
+} > "$SRC"
+
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+for dialect in nasm gas; do
+    ASM_FILE="$BUILD_DIR/generated_$dialect.s"
+    OBJ_FILE="$BUILD_DIR/generated_$dialect.o"
+
+    start=$(now_ms)
+    if ! ./$PROG "$SRC" -o "$ASM_FILE" --asm=$dialect > /dev/null; then
+        echo "$dialect: compile failed"
+        continue
+    fi
+    compiled=$(now_ms)
+
+    if [ "$dialect" == "gas" ]; then
+        ASSEMBLE="as --64 $ASM_FILE -o $OBJ_FILE"
+    else
+        ASSEMBLE="nasm -felf64 $ASM_FILE -o $OBJ_FILE"
+    fi
+    if ! $ASSEMBLE; then
+        echo "$dialect: assembler failed or missing"
+        continue
+    fi
+    assembled=$(now_ms)
+
+    printf "%-5s %8d lines  compile %6d ms  assemble %6d ms  total %6d ms\n" "$dialect" \
+        "$(wc -l < "$ASM_FILE")" $((compiled - start)) $((assembled - compiled)) $((assembled - start))
+done
@@ -0,0 +1,83 @@
+#! /bin/bash
+
+# compares a loop that checks two _asserts per element against the same
+# loop with the asserts removed. vectorizing and unrolling are off so both
+# run the same scalar loop and only the asserts differ.
+#
+# usage: ./run_assert_benchmark.sh [program] [passes] [runs]
+#
+# MIMIC99_ASM=gas assembles with GNU as instead of nasm
+
+PROG=${1:-mimic99}
+PASSES=${2:-200000}
+RUNS=${3:-3}
+ASM_DIALECT=${MIMIC99_ASM:-nasm}
+RUNTIME_LIB="runtime/build/libmimic99_runtime.a"
+FLAGS="--no-vectorize --unroll=1"
+
+BUILD_DIR=integration_tests/build/assert_benchmark
+mkdir -p "$BUILD_DIR"
+
+# $1 is the name, $2 what goes in front of each check, // to remove it
+generate() {
+    cat > "$BUILD_DIR/$1.c" << EOF
+int data[1000];
+
+int main() {
+    long total = 0;
+    int pass;
+    int i;
+    for (i = 0; i < 1000; i = i + 1) {
+        data[i] = i % 100;
+    }
+    for (pass = 0; pass < $PASSES; pass = pass + 1) {
+        for (i = 0; i < 1000; i = i + 1) {
+            int v = data[i];
+            $2 _assert(v >= 0);
+            $2 _assert(v < 100);
+            total = total + v;
+        }
+    }
+    return total & 1;
+}
+EOF
+}
+
+generate with_asserts ""
+generate without_asserts "//"
+
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+for variant in with_asserts without_asserts; do
+    SRC="$BUILD_DIR/$variant.c"
+    ASM_FILE="$BUILD_DIR/$variant.s"
+    OBJ_FILE="$BUILD_DIR/$variant.o"
+    EXE_FILE="$BUILD_DIR/$variant"
+
+    if ! ./$PROG "$SRC" -o "$ASM_FILE" --asm=$ASM_DIALECT $FLAGS > /dev/null; then
+        echo "$variant: compile failed"
+        continue
+    fi
+    if [ "$ASM_DIALECT" == "gas" ]; then
+        ASSEMBLE="as --64 $ASM_FILE -o $OBJ_FILE"
+    else
+        ASSEMBLE="nasm -felf64 $ASM_FILE -o $OBJ_FILE"
+    fi
+    if ! $ASSEMBLE || ! gcc -no-pie -o "$EXE_FILE" "$OBJ_FILE" "$RUNTIME_LIB"; then
+        echo "$variant: assembler or linker failed"
+        continue
+    fi
+
+    best=
+    for ((run = 0; run < RUNS; run++)); do
+        start=$(now_ms)
+        ./"$EXE_FILE"
+        ms=$(( $(now_ms) - start ))
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+            best=$ms
+        fi
+    done
+    printf "%-16s %7d ms\n" "$variant" "$best"
+done
@@ -0,0 +1,101 @@
+#! /bin/bash
+
+# compares three selects over 1M ints and doubles built branchless
+# against the same program built with --no-branchless, once on random
+# input, where the branches mispredict, and once on sorted input
+#
+# usage: ./run_branchless_benchmark.sh [program] [passes] [runs]
+#
+# MIMIC99_ASM=gas assembles with GNU as instead of nasm
+
+PROG=${1:-mimic99}
+PASSES=${2:-60}
+RUNS=${3:-3}
+ASM_DIALECT=${MIMIC99_ASM:-nasm}
+RUNTIME_LIB="runtime/build/libmimic99_runtime.a"
+
+BUILD_DIR=integration_tests/build/branchless_benchmark
+mkdir -p "$BUILD_DIR"
+
+# $1 is the name, $2 the value stored at index i
+generate() {
+    cat > "$BUILD_DIR/$1.c" << EOF
+int v[1000000];
+double d[1000000];
+long seed;
+
+int next_value() {
+    seed = seed * 6364136223 + 1442695040;
+    return seed >> 40;
+}
+
+int main() {
+    int n = 1000000;
+    int high = 0;
+    long clamped = 0;
+    double low = 0.0;
+    int pass;
+    int i;
+    seed = 12345;
+    for (i = 0; i < n; i++) {
+        v[i] = $2;
+        d[i] = v[i] * 0.25;
+    }
+    for (pass = 0; pass < $PASSES; pass++) {
+        for (i = 0; i < n; i++) {
+            int x = v[i];
+            double y = d[i];
+            high = x > high ? x : high;
+            clamped = clamped + (x < 0 ? 0 : x);
+            low = y < low ? y : low;
+        }
+    }
+    return (high + (int) clamped + (int) low) & 1;
+}
+EOF
+}
+
+generate random "next_value()"
+generate sorted "i * 16 - 8000000"
+
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+for input in random sorted; do
+    SRC="$BUILD_DIR/$input.c"
+    for variant in branchless no_branchless; do
+        ASM_FILE="$BUILD_DIR/${input}_$variant.s"
+        OBJ_FILE="$BUILD_DIR/${input}_$variant.o"
+        EXE_FILE="$BUILD_DIR/${input}_$variant"
+        FLAGS=
+        if [ "$variant" == "no_branchless" ]; then
+            FLAGS=--no-branchless
+        fi
+
+        if ! ./$PROG "$SRC" -o "$ASM_FILE" --asm=$ASM_DIALECT $FLAGS > /dev/null; then
+            echo "$input $variant: compile failed"
+            continue
+        fi
+        if [ "$ASM_DIALECT" == "gas" ]; then
+            ASSEMBLE="as --64 $ASM_FILE -o $OBJ_FILE"
+        else
+            ASSEMBLE="nasm -felf64 $ASM_FILE -o $OBJ_FILE"
+        fi
+        if ! $ASSEMBLE || ! gcc -no-pie -o "$EXE_FILE" "$OBJ_FILE" "$RUNTIME_LIB"; then
+            echo "$input $variant: assembler or linker failed"
+            continue
+        fi
+
+        best=
+        for ((run = 0; run < RUNS; run++)); do
+            start=$(now_ms)
+            ./"$EXE_FILE"
+            ms=$(( $(now_ms) - start ))
+            if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+                best=$ms
+            fi
+        done
+        printf "%-7s %-14s %7d ms\n" "$input" "$variant" "$best"
+    done
+done
@@ -0,0 +1,66 @@
+#! /bin/bash
+
+# compiles every integration test with --asm=gas and assembles it with as,
+# which fails on any NASM spelling the GAS writer does not translate. when
+# nasm is installed the --asm=nasm output is assembled as well, and the
+# .text of the two objects has to be byte for byte the same.
+#
+# usage: ./run_gas_roundtrip.sh [program] [subdir] [compiler flags...]
+
+PROG=${1:-mimic99}
+SUBDIR=$2
+shift $(( $# < 2 ? $# : 2 ))
+FLAGS="$@"
+
+BUILD_DIR=integration_tests/build/gas_roundtrip
+mkdir -p "$BUILD_DIR"
+
+TEST_DIR=integration_tests
+if [[ -n "$SUBDIR" ]]; then
+    TEST_DIR="$TEST_DIR/$SUBDIR"
+fi
+
+HAVE_NASM=0
+if command -v nasm > /dev/null; then
+    HAVE_NASM=1
+else
+    echo "nasm not found, only checking that as accepts the output"
+fi
+
+TOTAL=0
+FAILED=()
+
+for cfile in $(find $TEST_DIR -name 'test*.c' | sort); do
+    TOTAL=$((TOTAL + 1))
+    name=$(basename "$cfile" .c)
+    base="$BUILD_DIR/$name"
+
+    if ! ./$PROG "$cfile" -o "$base.gas.s" --asm=gas $FLAGS > /dev/null 2>&1; then
+        # a test the compiler rejects is the integration tests' business
+        continue
+    fi
+    if ! as --64 "$base.gas.s" -o "$base.gas.o" 2> "$base.as.log"; then
+        FAILED+=("$name: as rejected the output, see $base.as.log")
+        continue
+    fi
+    if [ $HAVE_NASM -eq 0 ]; then
+        continue
+    fi
+
+    ./$PROG "$cfile" -o "$base.nasm.s" --asm=nasm $FLAGS > /dev/null 2>&1
+    if ! nasm -felf64 "$base.nasm.s" -o "$base.nasm.o"; then
+        FAILED+=("$name: nasm rejected the output")
+        continue
+    fi
+    objcopy -O binary --only-section=.text "$base.gas.o" "$base.gas.text"
+    objcopy -O binary --only-section=.text "$base.nasm.o" "$base.nasm.text"
+    if ! cmp -s "$base.gas.text" "$base.nasm.text"; then
+        FAILED+=("$name: .text differs between as and nasm")
+    fi
+done
+
+echo "$TOTAL tests, ${#FAILED[@]} failed"
+for failure in "${FAILED[@]}"; do
+    echo "    $failure"
+done
+[ ${#FAILED[@]} -eq 0 ]
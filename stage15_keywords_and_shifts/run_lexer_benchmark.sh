@@ -0,0 +1,78 @@
+#! /bin/bash
+
+# compares the tokenize time of the lexer scan modes on a comment heavy
+# and an identifier heavy generated program
+#
+# usage: ./run_lexer_benchmark.sh [program] [functions] [runs]
+
+PROG=${1:-mimic99}
+FUNCTIONS=${2:-2000}
+RUNS=${3:-5}
+
+BUILD_DIR=integration_tests/build/lexer_benchmark
+mkdir -p "$BUILD_DIR"
+
+echo "Generating $FUNCTIONS functions into $BUILD_DIR..."
+{
+    for ((i = 0; i < FUNCTIONS; i++)); do
+        echo "/*"
+        echo " * f$i adds its argument to a running total. this block is here to give"
+        echo " * the lexer a long comment to skip, as real headers and sources have."
+        echo " */"
+        echo "int f$i(int n) {"
+        echo "                                        // the total starts at the function's number"
+        echo "    int s = $i;                         // and grows by n"
+        echo "    s = s + n;                          /* nothing else happens to it */"
+        echo "    return s;                           // then goes back to main"
+        echo "}"
+    done
+    echo "int main() {"
+    echo "    int s = 0;"
+    for ((i = 0; i < FUNCTIONS; i++)); do
+        echo "    s = f$i(s & 7);"
+    done
+    echo "    return s & 1;"
+    echo "}"
+} > "$BUILD_DIR/comments.c"
+
+{
+    for ((i = 0; i < FUNCTIONS; i++)); do
+        echo "int accumulate_running_total_for_function_$i(int starting_value_of_the_total) {"
+        echo "    int intermediate_running_total_value = starting_value_of_the_total;"
+        echo "    int increment_applied_on_every_step = $((i % 13 + 1));"
+        echo "    intermediate_running_total_value = intermediate_running_total_value + increment_applied_on_every_step;"
+        echo "    intermediate_running_total_value = intermediate_running_total_value * increment_applied_on_every_step;"
+        echo "    return intermediate_running_total_value;"
+        echo "}"
+    done
+    echo "int main() {"
+    echo "    int total_across_all_functions = 0;"
+    for ((i = 0; i < FUNCTIONS; i++)); do
+        echo "    total_across_all_functions = accumulate_running_total_for_function_$i(total_across_all_functions & 7);"
+    done
+    echo "    return total_across_all_functions & 1;"
+    echo "}"
+} > "$BUILD_DIR/identifiers.c"
+
+for input in comments identifiers; do
+    SRC="$BUILD_DIR/$input.c"
+    for mode in scalar sse2 avx2; do
+        best=
+        for ((run = 0; run < RUNS; run++)); do
+            stats=$(./$PROG "$SRC" -o "$BUILD_DIR/$input.s" --stats --lex-scan=$mode 2>/dev/null)
+            if [ $? -ne 0 ]; then
+                echo "$input $mode: compile failed"
+                continue 2
+            fi
+            us=$(echo "$stats" | awk '/^tokenize time/ { print $NF }')
+            used=$(echo "$stats" | awk '/^lexer scan mode/ { print $NF }')
+            if [ -z "$best" ] || [ "$us" -lt "$best" ]; then
+                best=$us
+            fi
+        done
+        bytes=$(wc -c < "$SRC")
+        awk -v input="$input" -v mode="$used" -v bytes="$bytes" -v us="$best" 'BEGIN {
+            printf "%-12s %-7s %9d bytes  tokenize %7d us  %8.1f MB/s\n", input, mode, bytes, us, bytes / us
+        }'
+    done
+done
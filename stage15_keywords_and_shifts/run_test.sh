@@ -18,7 +18,15 @@ if [ -z "$SRC" ] || [ -z "$EXPECTED" ] || [ -z "$PROG" ]; then
     exit 1
 fi
 
-UNSIGNED_EXPECTED=$(( (EXPECTED + 256) % 256 ))
+# a test named __hang passes when the program is still running at the time limit
+if [ "$EXPECTED" != "hang" ]; then
+    UNSIGNED_EXPECTED=$(( (EXPECTED + 256) % 256 ))
+fi
+
+# MIMIC99_ASM=gas assembles with GNU as instead of nasm
+ASM_DIALECT=${MIMIC99_ASM:-nasm}
+# MIMIC99_FLAGS goes to the compiler as well, as in MIMIC99_FLAGS=-O0
+COMPILER_FLAGS=${MIMIC99_FLAGS:-}
 
 echo SRC=$SRC
 echo EXPECTED=$EXPECTED
@@ -28,6 +36,9 @@ filename=$(basename "$SRC" .c)
 ASM_FILE="integration_tests/build/${filename}.s"
 OBJ_FILE="integration_tests/build/${filename}.o"
 EXE_FILE="integration_tests/build/${filename}"
+OUT_FILE="integration_tests/build/${filename}.stdout"
+EXPECTED_OUT="${SRC%.c}.out"
+RUNTIME_LIB="runtime/build/libmimic99_runtime.a"
 
 #ASM_FILE="${SRC%.c}.s"
 #OBJ_FILE="${SRC%.c}.o"
@@ -36,11 +47,12 @@ EXE_FILE="integration_tests/build/${filename}"
 echo ASM_FILE=$ASM_FILE
 echo OBJ_FILE=$OBJ_FILE
 echo EXE_FILE=$EXE_FILE
+echo OUT_FILE=$OUT_FILE
 
 set -e
 
 # compile C to ASM
-CMD="./$PROG $SRC -o $ASM_FILE"
+CMD="./$PROG $SRC -o $ASM_FILE --asm=$ASM_DIALECT $COMPILER_FLAGS"
 if [ "$USE_VALGRIND" -eq 1 ]; then
     echo "🔍 Running under Valgrind: $CMD"
     CMD="valgrind --leak-check=full --show-leak-kinds=all --track-origins=yes --error-exitcode=2 $CMD"
@@ -67,23 +79,36 @@ else
 fi
 
 echo "Assemble..."
-if ! nasm -felf64 -g -F dwarf "$ASM_FILE" -o "$OBJ_FILE"; then
+if [ "$ASM_DIALECT" == "gas" ]; then
+    ASSEMBLE="as --64 -g $ASM_FILE -o $OBJ_FILE"
+else
+    ASSEMBLE="nasm -felf64 -g -F dwarf $ASM_FILE -o $OBJ_FILE"
+fi
+if ! $ASSEMBLE; then
     echo "Assembler failure."
     exit 98
 fi
 
 echo "Linking..."    
-if ! gcc -no-pie -o "$EXE_FILE" "$OBJ_FILE"; then
+if ! gcc -no-pie -o "$EXE_FILE" "$OBJ_FILE" "$RUNTIME_LIB"; then
     echo "Linking failure."
     exit 97
 fi
 
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m'
+
 echo "executing compiled file $EXE_FILE ..."
 set +e
-timeout 2s ./"$EXE_FILE"
+timeout 2s ./"$EXE_FILE" > "$OUT_FILE"
 EXIT_CODE=$?
+cat "$OUT_FILE"
 
-if [ $EXIT_CODE -eq 124 ]; then
+if [ $EXIT_CODE -eq 124 ] && [ "$EXPECTED" == "hang" ]; then
+    echo -e "${GREEN}✅ Test: $SRC Passed, still running at the time limit${NC}"
+    exit 0
+elif [ $EXIT_CODE -eq 124 ]; then
     echo -e "${RED}⏱ Timeout: $EXE_FILE exceeded time limit${NC}"
     exit 96
 fi
@@ -92,13 +117,14 @@ set -e
 
 echo "Program $EXE_FILE exited with code $EXIT_CODE"
 
-GREEN='\033[0;32m'
-RED='\033[0;31m'
-NC='\033[0m'
-
-
+# a test with a .out file next to it also has to print exactly that
+if [ -f "$EXPECTED_OUT" ] && ! cmp -s "$EXPECTED_OUT" "$OUT_FILE"; then
+    echo -e "${RED}❌ Test: $SRC Failed: output differs from $EXPECTED_OUT${NC}"
+    diff "$EXPECTED_OUT" "$OUT_FILE" | head -20
+    exit 1
+fi
 
-if [ $EXIT_CODE -eq $UNSIGNED_EXPECTED ]; then
+if [ "$EXPECTED" != "hang" ] && [ $EXIT_CODE -eq $UNSIGNED_EXPECTED ]; then
     echo -e "${GREEN}✅ Test: $SRC Passed${NC}"
     exit 0
 else 
@@ -0,0 +1,91 @@
+#! /bin/bash
+
+# compares the large array loops built with the vectorizer against the
+# same program built with --no-vectorize: c = a + b, s += c[i] and
+# y = x * k over 1M element arrays
+#
+# usage: ./run_vectorize_benchmark.sh [program] [passes] [runs]
+#
+# MIMIC99_ASM=gas assembles with GNU as instead of nasm
+
+PROG=${1:-mimic99}
+PASSES=${2:-100}
+RUNS=${3:-3}
+ASM_DIALECT=${MIMIC99_ASM:-nasm}
+RUNTIME_LIB="runtime/build/libmimic99_runtime.a"
+
+BUILD_DIR=integration_tests/build/vectorize_benchmark
+mkdir -p "$BUILD_DIR"
+SRC="$BUILD_DIR/arrays.c"
+
+cat > "$SRC" << EOF
+int a[1000000];
+int b[1000000];
+int c[1000000];
+double x[1000000];
+double y[1000000];
+
+int main() {
+    int n = 1000000;
+    int s = 0;
+    double k = 1.5;
+    int pass;
+    int i;
+    for (i = 0; i < n; i++) {
+        a[i] = i;
+        b[i] = 3;
+        x[i] = i;
+    }
+    for (pass = 0; pass < $PASSES; pass++) {
+        for (i = 0; i < n; i++) {
+            c[i] = a[i] + b[i];
+        }
+        for (i = 0; i < n; i++) {
+            s += c[i];
+        }
+        for (i = 0; i < n; i++) {
+            y[i] = x[i] * k;
+        }
+    }
+    return (s + (int) y[n - 1]) & 1;
+}
+EOF
+
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+for variant in vectorized no_vectorize; do
+    ASM_FILE="$BUILD_DIR/$variant.s"
+    OBJ_FILE="$BUILD_DIR/$variant.o"
+    EXE_FILE="$BUILD_DIR/$variant"
+    FLAGS=
+    if [ "$variant" == "no_vectorize" ]; then
+        FLAGS=--no-vectorize
+    fi
+
+    if ! ./$PROG "$SRC" -o "$ASM_FILE" --asm=$ASM_DIALECT $FLAGS > /dev/null; then
+        echo "$variant: compile failed"
+        continue
+    fi
+    if [ "$ASM_DIALECT" == "gas" ]; then
+        ASSEMBLE="as --64 $ASM_FILE -o $OBJ_FILE"
+    else
+        ASSEMBLE="nasm -felf64 $ASM_FILE -o $OBJ_FILE"
+    fi
+    if ! $ASSEMBLE || ! gcc -no-pie -o "$EXE_FILE" "$OBJ_FILE" "$RUNTIME_LIB"; then
+        echo "$variant: assembler or linker failed"
+        continue
+    fi
+
+    best=
+    for ((run = 0; run < RUNS; run++)); do
+        start=$(now_ms)
+        ./"$EXE_FILE"
+        ms=$(( $(now_ms) - start ))
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+            best=$ms
+        fi
+    done
+    printf "%-14s %7d ms\n" "$variant" "$best"
+done
@@ -0,0 +1,280 @@
+; runtime support for the _print and _assert extensions.
+;
+; generated code calls these instead of carrying its own copies, and is
+; linked against libmimic99_runtime.a, which CMake builds from this file.
+; every routine is entered with the stack aligned as for any other call.
+;
+; output is collected in a 64 KiB buffer and written with one syscall when
+; it fills up, when an assert fails and at exit, through .fini_array. a
+; program killed by a signal loses what is still buffered.
+
+default rel
+
+extern snprintf
+extern strlen
+
+global __mimic99_print_int
+global __mimic99_print_long
+global __mimic99_print_double
+global __mimic99_print_string
+global __mimic99_assert_fail
+
+BUFFER_SIZE         equ 65536
+INTEGER_ROOM        equ 64          ; prefix, sign, 20 digits and newline, rounded up for the copy
+
+section .rodata
+
+align 16
+; "00" to "99", so the digits are converted two at a time
+digit_pairs:
+%assign i 0
+%rep 100
+    db '0' + i / 10, '0' + i % 10
+%assign i i + 1
+%endrep
+
+integer_prefix:     db "Integer: "
+string_prefix:      db "String: "
+null_string:        db "(null)", 0  ; what printf shows for NULL
+dbl_format:         db "Double: %f", 10, 0
+assert_fail_msg:    db "Assertion failed!", 10
+ASSERT_FAIL_LENGTH  equ 17              ; the newline is not written
+assert_line_msg:    db "_assert failed at line "
+ASSERT_LINE_LENGTH  equ $ - assert_line_msg
+
+section .bss
+
+alignb 64
+out_buffer:         resb BUFFER_SIZE
+out_length:         resq 1
+
+section .fini_array alloc write align=8
+    dq flush_output
+
+section .text
+
+; writes rdx bytes from rsi to the file in edi, retrying short writes
+write_all:
+    test rdx, rdx
+    jz .done
+.again:
+    mov eax, 1                          ; write
+    syscall
+    cmp rax, -4                         ; EINTR
+    je .again
+    test rax, rax
+    jle .done                           ; nowhere left to report the error
+    add rsi, rax
+    sub rdx, rax
+    jnz .again
+.done:
+    ret
+
+flush_output:
+    mov edi, 1                          ; stdout
+    lea rsi, [out_buffer]
+    mov rdx, [out_length]
+    mov qword [out_length], 0
+    jmp write_all
+
+; appends rdx bytes from rsi, flushing first when they do not fit.
+; text longer than the whole buffer is written directly.
+append:
+    mov rax, [out_length]
+    lea rcx, [rax + rdx]
+    cmp rcx, BUFFER_SIZE
+    jbe .copy
+    push rsi
+    push rdx
+    call flush_output
+    pop rdx
+    pop rsi
+    cmp rdx, BUFFER_SIZE
+    mov edi, 1
+    ja write_all
+    xor eax, eax
+.copy:
+    lea rdi, [out_buffer]
+    add rdi, rax
+    add rax, rdx
+    mov [out_length], rax
+    mov rcx, rdx
+    rep movsb
+    ret
+
+; void __mimic99_print_int(int value)
+__mimic99_print_int:
+    movsxd rdi, edi
+    ; fall through
+
+; void __mimic99_print_long(long value)
+__mimic99_print_long:
+    mov r8, rdi
+    mov rax, [out_length]
+    cmp rax, BUFFER_SIZE - INTEGER_ROOM
+    jbe .room
+    call flush_output
+    xor eax, eax
+.room:
+    lea rdi, [out_buffer]
+    add rdi, rax
+    mov rcx, [integer_prefix]
+    mov [rdi], rcx
+    mov byte [rdi + 8], ' '
+    add rdi, 9
+    test r8, r8
+    jns .digits
+    mov byte [rdi], '-'
+    inc rdi
+    neg r8                              ; the minimum stays correct read as unsigned
+
+.digits:
+    mov rax, r8
+    call write_digits
+    mov byte [rdi], 10
+    inc rdi
+    lea rax, [out_buffer]
+    sub rdi, rax
+    mov [out_length], rdi
+    ret
+
+; writes the unsigned value in rax at rdi in decimal and leaves rdi past it.
+; up to 32 bytes at rdi are overwritten.
+write_digits:
+    ; the digits are written backwards below the stack pointer, in the red zone
+    mov r10, rsp
+    lea r11, [digit_pairs]
+.pairs:
+    cmp rax, 100
+    jb .last
+    mov r9, rax
+    shr rax, 2
+    mov rdx, 0x28f5c28f5c28f5c3         ; n / 100 is ((n >> 2) * this) >> 66
+    mul rdx
+    shr rdx, 2
+    imul rcx, rdx, 100
+    sub r9, rcx
+    movzx ecx, word [r11 + r9 * 2]
+    sub r10, 2
+    mov [r10], cx
+    mov rax, rdx
+    jmp .pairs
+.last:
+    cmp rax, 10
+    jb .single
+    movzx ecx, word [r11 + rax * 2]
+    sub r10, 2
+    mov [r10], cx
+    jmp .copy
+.single:
+    add al, '0'
+    dec r10
+    mov [r10], al
+
+.copy:
+    ; at most 20 digits, so two 16 byte moves cover them
+    mov rcx, rsp
+    sub rcx, r10
+    movdqu xmm0, [r10]
+    movdqu xmm1, [r10 + 16]
+    movdqu [rdi], xmm0
+    movdqu [rdi + 16], xmm1
+    add rdi, rcx
+    ret
+
+; void __mimic99_print_double(double value), value in xmm0.
+; printf's %f rounding is kept by formatting straight into the buffer.
+__mimic99_print_double:
+    sub rsp, 24
+    movsd [rsp], xmm0
+.format:
+    mov rax, [out_length]
+    lea rdi, [out_buffer]
+    add rdi, rax
+    mov esi, BUFFER_SIZE
+    sub rsi, rax
+    mov [rsp + 8], rsi
+    lea rdx, [dbl_format]
+    movsd xmm0, [rsp]
+    mov eax, 1                          ; one vector register argument
+    call snprintf
+    movsxd rax, eax
+    cmp rax, [rsp + 8]                  ; the terminating zero has to fit as well
+    jb .done
+    call flush_output
+    jmp .format
+.done:
+    add [out_length], rax
+    add rsp, 24
+    ret
+
+; void __mimic99_print_string(const char * value)
+__mimic99_print_string:
+    push rbx
+    mov rbx, rdi
+    test rdi, rdi
+    jnz .prefix
+    lea rbx, [null_string]
+.prefix:
+    lea rsi, [string_prefix]
+    mov edx, 8
+    call append
+    mov rdi, rbx
+    call strlen
+    mov rsi, rbx
+    mov rdx, rax
+    call append
+    mov rax, [out_length]
+    cmp rax, BUFFER_SIZE
+    jb .newline
+    call flush_output
+    xor eax, eax
+.newline:
+    lea rdi, [out_buffer]
+    mov byte [rdi + rax], 10
+    inc rax
+    mov [out_length], rax
+    pop rbx
+    ret
+
+; void __mimic99_assert_fail(int line, const char * function), does not return.
+; stdout gets the same message as always, stderr gets where the assert was.
+__mimic99_assert_fail:
+    mov ebx, edi
+    mov r12, rsi
+    call flush_output
+    mov edi, 1
+    lea rsi, [assert_fail_msg]
+    mov edx, ASSERT_FAIL_LENGTH
+    call write_all
+
+    ; the emptied buffer holds "_assert failed at line N in function"
+    lea rdi, [out_buffer]
+    lea rsi, [assert_line_msg]
+    mov ecx, ASSERT_LINE_LENGTH
+    rep movsb
+    mov eax, ebx
+    call write_digits
+    mov dword [rdi], ' in '
+    add rdi, 4
+    mov rsi, r12
+.name:
+    lodsb
+    test al, al
+    jz .report
+    stosb
+    jmp .name
+.report:
+    mov byte [rdi], 10
+    inc rdi
+    lea rsi, [out_buffer]
+    mov rdx, rdi
+    sub rdx, rsi
+    mov edi, 2                          ; stderr
+    call write_all
+
+    mov eax, 60                         ; exit
+    mov edi, 1
+    syscall
+
+section .note.GNU-stack noalloc noexec nowrite progbits
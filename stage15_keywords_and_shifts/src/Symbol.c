@@ -12,6 +12,7 @@ Symbol * create_symbol(const char * name, SymbolKind kind, CType * ctype, ASTNod
     symbol->kind = kind;
     symbol->ctype = ctype;
     symbol->node = node;
+    symbol->reg = PR_NONE;
     return symbol;
 }
 
@@ -36,6 +36,15 @@ CType * usual_arithmetic_conversion(CType * a, CType * b) {
     return b;
 }
 
+/* literals in an initializer list are converted where the list is laid out */
+static bool is_literal_initializer(ASTNode * node) {
+    if (node->type == AST_UNARY_EXPR && (node->unary.op == UNARY_NEGATE || node->unary.op == UNARY_PLUS)) {
+        node = node->unary.operand;
+    }
+    return node->type == AST_INT_LITERAL || node->type == AST_FLOAT_LITERAL ||
+           node->type == AST_DOUBLE_LITERAL;
+}
+
 bool is_lvalue(ASTNode * node) {
     if (node == NULL) {
         error("node must not be null");
@@ -328,7 +337,10 @@ void analyze(AnalyzerContext * ctx, ASTNode * node) {
                         arg_type = make_pointer_type(arg_type->base_type);
                     }
                     CType * param_type = Symbol_list_get(functionSymbol->info.func.params_symbol_list, arg_index)->ctype;
-                    if (!ctype_equal_or_compatible( param_type, arg_type)) {
+                    // narrower integers are compatible but still have to be widened
+                    bool widens = is_integer_type(param_type) && is_integer_type(arg_type) &&
+                                  param_type->size != arg_type->size;
+                    if (widens || !ctype_equal_or_compatible( param_type, arg_type)) {
                         if (is_castable(param_type, arg_type)) {
                             arg->value = create_cast_expr_node(param_type, arg->value);
                         }
@@ -400,8 +412,13 @@ void analyze(AnalyzerContext * ctx, ASTNode * node) {
                 }
                 analyze(ctx, node->var_decl.init_expr);
 
+                CType * init_type = node->var_decl.init_expr->ctype;
                 if (node->var_decl.init_expr->type == AST_FUNCTION_CALL_EXPR) {
-                    //TODO
+                    // only integer results of another width need converting
+                    if (is_integer_type(node->ctype) && is_integer_type(init_type) &&
+                        node->ctype->size != init_type->size) {
+                        node->var_decl.init_expr = create_cast_expr_node(node->ctype, node->var_decl.init_expr);
+                    }
                 } else if (!ctype_equals(node->ctype, node->var_decl.init_expr->ctype)) {
                     node->var_decl.init_expr =
                         create_cast_expr_node(node->ctype, node->var_decl.init_expr);
@@ -457,6 +474,15 @@ void analyze(AnalyzerContext * ctx, ASTNode * node) {
                     CType * result_type = usual_arithmetic_conversion(promoted_left, promoted_right);
                     node->ctype = get_binary_expr_return_type(result_type, node->binary.op);
                     node->binary.common_type = result_type;
+
+                    // p + i, i + p and p - i keep the pointer type
+                    if (node->binary.op == BINOP_ADD || node->binary.op == BINOP_SUB) {
+                        if (is_pointer_type(lhsCType) && is_integer_type(rhsCType)) {
+                            node->ctype = lhsCType;
+                        } else if (node->binary.op == BINOP_ADD && is_integer_type(lhsCType) && is_pointer_type(rhsCType)) {
+                            node->ctype = rhsCType;
+                        }
+                    }
                 }
             }
             break;
@@ -495,8 +521,11 @@ void analyze(AnalyzerContext * ctx, ASTNode * node) {
             analyze(ctx, node->return_stmt.expr);
 //            node->ctype = node->return_stmt.expr->ctype;
             node->ctype = ctx->current_function_return_type;
-            if (!ctype_equal_or_compatible(ctx->current_function_return_type,
-                node->return_stmt.expr->ctype)) {
+            CType * value_type = node->return_stmt.expr->ctype;
+            // callers read the whole register of the return type, so narrower integers are widened
+            bool widens = is_integer_type(node->ctype) && is_integer_type(value_type) &&
+                          node->ctype->size != value_type->size;
+            if (widens || !ctype_equal_or_compatible(ctx->current_function_return_type, value_type)) {
                 if (is_castable(node->ctype, ctx->current_function_return_type)) {
                     node->return_stmt.expr = create_cast_expr_node(ctx->current_function_return_type, node->return_stmt.expr);
                     break;
@@ -632,8 +661,16 @@ void analyze(AnalyzerContext * ctx, ASTNode * node) {
 
         case AST_INITIALIZER_LIST: {
             assert(node->initializer_list.element_type);
+            CType * element_type = node->initializer_list.element_type;
             for (ASTNode_list_node * n = node->initializer_list.items->head; n; n = n->next) {
                 analyze(ctx, n->value);
+                ASTNode * item = n->value;
+                bool arithmetic = item->type != AST_INITIALIZER_LIST &&
+                                  (is_integer_type(element_type) || is_floating_point_type(element_type)) &&
+                                  (is_integer_type(item->ctype) || is_floating_point_type(item->ctype));
+                if (arithmetic && !is_literal_initializer(item) && !ctype_equals(item->ctype, element_type)) {
+                    n->value = create_cast_expr_node(element_type, item);
+                }
                 // if (n->value->type == AST_INITIALIZER_LIST) {
                 //     if (is_array_type(node->ctype)) {
                 //         node->var_decl.init_expr->initializer_list.element_type = get_base_type(node->ctype);
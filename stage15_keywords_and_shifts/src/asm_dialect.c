@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#include "asm_dialect.h"
+
+/* Intel syntax operators in GAS, which can not be used as symbol names */
+static const char * GAS_OPERATORS[] = {
+    "and", "or", "xor", "not", "shl", "shr", "mod",
+    "eq", "ne", "lt", "le", "gt", "ge", "offset", "ptr", NULL
+};
+
+static const struct {
+    const char * nasm;
+    const char * gas;
+    int size;
+} DATA_DIRECTIVES[] = {
+    { "db", ".byte", 1 }, { "dw", ".short", 2 }, { "dd", ".long", 4 }, { "dq", ".quad", 8 },
+    { "resb", NULL, 1 }, { "resw", NULL, 2 }, { "resd", NULL, 4 }, { "resq", NULL, 8 },
+    { NULL, NULL, 0 }
+};
+
+static bool is_symbol_start(char c) {
+    return isalpha((unsigned char) c) || c == '_' || c == '.' || c == '$' || c == '?' || c == '@';
+}
+
+static bool is_symbol_char(char c) {
+    return is_symbol_start(c) || isdigit((unsigned char) c);
+}
+
+static bool word_is(const char * word, int length, const char * name) {
+    return (int) strlen(name) == length && strncasecmp(word, name, length) == 0;
+}
+
+static const char * skip_spaces(const char * s) {
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    return s;
+}
+
+static int symbol_length(const char * s) {
+    int length = 0;
+    if (is_symbol_start(s[0])) {
+        while (is_symbol_char(s[length])) {
+            length++;
+        }
+    }
+    return length;
+}
+
+static void write_symbol(AsmWriter * out, const char * name, int length) {
+    for (int i = 0; GAS_OPERATORS[i]; i++) {
+        if (word_is(name, length, GAS_OPERATORS[i])) {
+            asm_write_str(out, "__");
+            break;
+        }
+    }
+    asm_write(out, name, length);
+}
+
+/* the code ends at the first ; outside a string, which starts the comment */
+static char * find_comment(const char * line) {
+    char quote = 0;
+    for (const char * s = line; *s; s++) {
+        if (quote) {
+            if (*s == quote) quote = 0;
+        } else if (*s == '"' || *s == '\'' || *s == '`') {
+            quote = *s;
+        } else if (*s == ';') {
+            return (char *) s;
+        }
+    }
+    return NULL;
+}
+
+/* operands keep their Intel syntax, apart from sizes, rel and names */
+static void write_operands(AsmWriter * out, const char * s, const char * end) {
+    char previous = 0;      // the last character written that is not a space
+    while (s < end) {
+        int length = symbol_length(s);
+        if (length > 0 && s + length <= end) {
+            const char * next = skip_spaces(s + length);
+            if (*next == '[' && (word_is(s, length, "byte") || word_is(s, length, "word") ||
+                                 word_is(s, length, "dword") || word_is(s, length, "qword"))) {
+                for (int i = 0; i < length; i++) {
+                    asm_write_char(out, toupper((unsigned char) s[i]));
+                }
+                asm_write_str(out, " PTR");
+            } else if (*next == '[' && word_is(s, length, "oword")) {
+                asm_write_str(out, "XMMWORD PTR");
+            } else if (previous == '[' && word_is(s, length, "rel")) {
+                asm_write_str(out, "rip +");
+            } else {
+                write_symbol(out, s, length);
+            }
+            previous = s[length - 1];
+            s += length;
+        } else if (isdigit((unsigned char) *s)) {
+            // numbers such as 0x4e are not symbols
+            while (s < end && isalnum((unsigned char) *s)) {
+                asm_write_char(out, *s++);
+            }
+            previous = '0';
+        } else if (*s == '\'' && s + 2 < end && s[2] == '\'') {
+            asm_write_int(out, (unsigned char) s[1]);
+            previous = '0';
+            s += 3;
+        } else {
+            if (*s != ' ' && *s != '\t') {
+                previous = *s;
+            }
+            asm_write_char(out, *s++);
+        }
+    }
+}
+
+/* a quoted NASM string as .ascii, which needs \ and " escaped */
+static void write_ascii(AsmWriter * out, const char * s, const char * end) {
+    asm_write_str(out, ".ascii \"");
+    for (s++; s < end - 1; s++) {
+        if (*s == '"' || *s == '\\') {
+            asm_write_char(out, '\\');
+        }
+        asm_write_char(out, *s);
+    }
+    asm_write_char(out, '"');
+}
+
+/* 42.0 and -1.5e3, which dd and dq take as float and double constants */
+static bool is_float_text(const char * s, const char * end) {
+    if (*s == '-' || *s == '+') {
+        s++;
+    }
+    if (s == end || !isdigit((unsigned char) *s) || (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))) {
+        return false;
+    }
+    for (; s < end; s++) {
+        if (*s == '.' || *s == 'e' || *s == 'E') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* db "text", 10, 0 becomes .ascii "text"; .byte 10, 0 */
+static void write_data(AsmWriter * out, const char * integer_directive, const char * s, const char * end) {
+    const char * in_values = NULL;      // the directive of the values being written
+    bool first = true;
+    while (s < end) {
+        s = skip_spaces(s);
+        const char * item = s;
+        char quote = 0;
+        while (s < end && (quote || *s != ',')) {
+            if (quote) {
+                if (*s == quote) quote = 0;
+            } else if (*s == '"' || *s == '\'' || *s == '`') {
+                quote = *s;
+            }
+            s++;
+        }
+        const char * item_end = s;
+        while (item_end > item && (item_end[-1] == ' ' || item_end[-1] == '\t')) {
+            item_end--;
+        }
+        if (item_end > item + 1 && (*item == '"' || *item == '`' ||
+                                    (*item == '\'' && item_end - item != 3))) {
+            asm_write_str(out, first ? "" : "; ");
+            write_ascii(out, item, item_end);
+            in_values = NULL;
+        } else if (item_end > item) {
+            const char * directive = integer_directive;
+            if (is_float_text(item, item_end)) {
+                directive = strcmp(integer_directive, ".quad") == 0 ? ".double" : ".float";
+            }
+            if (directive == in_values) {
+                asm_write_str(out, ", ");
+            } else {
+                asm_write_str(out, first ? "" : "; ");
+                asm_write_str(out, directive);
+                asm_write_char(out, ' ');
+            }
+            write_operands(out, item, item_end);
+            in_values = directive;
+        }
+        first = false;
+        if (s < end) {
+            s++;    // the comma
+        }
+    }
+}
+
+static int find_data_directive(const char * word, int length) {
+    for (int i = 0; DATA_DIRECTIVES[i].nasm; i++) {
+        if (word_is(word, length, DATA_DIRECTIVES[i].nasm)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void write_section(AsmWriter * out, const char * name, int length) {
+    if (word_is(name, length, ".text") || word_is(name, length, ".data") || word_is(name, length, ".bss")) {
+        asm_write(out, name, length);
+    } else if (word_is(name, length, ".text.cold")) {
+        asm_write_str(out, ".section .text.cold,\"ax\",@progbits");
+    } else {
+        asm_write_str(out, ".section ");
+        asm_write(out, name, length);
+    }
+}
+
+/* everything after an optional label */
+static void write_statement(AsmWriter * out, const char * s, const char * end) {
+    int length = symbol_length(s);
+    const char * rest = skip_spaces(s + length);
+    int directive = find_data_directive(s, length);
+
+    if (word_is(s, length, "section")) {
+        write_section(out, rest, symbol_length(rest));
+    } else if (word_is(s, length, "global") || word_is(s, length, "extern")) {
+        asm_write_str(out, word_is(s, length, "global") ? ".globl " : ".extern ");
+        write_symbol(out, rest, symbol_length(rest));
+    } else if (word_is(s, length, "align") || word_is(s, length, "alignb")) {
+        asm_write_str(out, ".balign ");
+        asm_write(out, rest, end - rest);
+    } else if (word_is(s, length, "times")) {
+        // .fill only repeats 4 byte values, so quads need .rept
+        const char * count = rest;
+        const char * count_end = count;
+        while (count_end < end && !isspace((unsigned char) *count_end)) {
+            count_end++;
+        }
+        const char * value = skip_spaces(count_end);
+        int value_length = symbol_length(value);
+        directive = find_data_directive(value, value_length);
+        asm_write_str(out, ".rept ");
+        asm_write(out, count, count_end - count);
+        asm_write_char(out, '\n');
+        write_data(out, DATA_DIRECTIVES[directive].gas, skip_spaces(value + value_length), end);
+        asm_write_str(out, "\n.endr");
+    } else if (directive >= 0 && DATA_DIRECTIVES[directive].gas) {
+        write_data(out, DATA_DIRECTIVES[directive].gas, rest, end);
+    } else if (directive >= 0) {
+        asm_write_str(out, ".zero (");
+        asm_write(out, rest, end - rest);
+        asm_write_str(out, ") * ");
+        asm_write_int(out, DATA_DIRECTIVES[directive].size);
+    } else {
+        asm_write(out, s, rest - s);
+        write_operands(out, rest, end);
+    }
+}
+
+void write_gas_line(AsmWriter * out, const char * line) {
+    const char * s = skip_spaces(line);
+    if (*s == '.') {
+        asm_write_str(out, line);
+        asm_write_char(out, '\n');
+        return;
+    }
+    const char * comment = find_comment(s);
+    const char * end = comment ? comment : s + strlen(s);
+    while (end > s && isspace((unsigned char) end[-1])) {
+        end--;
+    }
+
+    asm_write(out, line, s - line);
+    int length = symbol_length(s);
+    if (length > 0 && s[length] == ':') {
+        write_symbol(out, s, length);
+        asm_write_char(out, ':');
+        s = skip_spaces(s + length + 1);
+        if (s < end) {
+            asm_write_char(out, ' ');
+        }
+    }
+    if (s < end) {
+        write_statement(out, s, end);
+    }
+    if (comment) {
+        asm_write(out, end, comment - end);
+        asm_write_char(out, '#');
+        asm_write_str(out, comment + 1);
+    }
+    asm_write_char(out, '\n');
+}
+
+void write_asm_line(AsmWriter * out, AsmDialect dialect, bool compact, char * line) {
+    if (compact) {
+        char * comment = find_comment(line);
+        char * end = comment ? comment : line + strlen(line);
+        while (end > line && isspace((unsigned char) end[-1])) {
+            end--;
+        }
+        if (end == line) {
+            return;
+        }
+        *end = '\0';
+    }
+    if (dialect == ASM_GAS) {
+        write_gas_line(out, line);
+        return;
+    }
+    asm_write_str(out, line);
+    asm_write_char(out, '\n');
+}
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "error.h"
+#include "asm_writer.h"
+
+#define ASM_BUFFER_SIZE (1 << 20)
+
+static AsmWriter * create_writer(int fd, FILE * file) {
+    AsmWriter * writer = malloc(sizeof(AsmWriter));
+    writer->fd = fd;
+    writer->file = file;
+    writer->echo = true;
+    writer->capacity = ASM_BUFFER_SIZE;
+    writer->buffer = malloc(writer->capacity);
+    writer->length = 0;
+    writer->bytes_written = 0;
+    writer->line_capacity = 256;
+    writer->line = malloc(writer->line_capacity);
+    return writer;
+}
+
+AsmWriter * asm_writer_open(const char * path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error("Could not open %s for writing", path);
+    }
+    return create_writer(fd, NULL);
+}
+
+AsmWriter * asm_writer_from_fp(FILE * file) {
+    return create_writer(-1, file);
+}
+
+static void write_fully(int fd, const char * text, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, text, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error("Could not write the assembly output");
+            return;
+        }
+        text += written;
+        length -= written;
+    }
+}
+
+static void write_out(AsmWriter * writer, const char * text, size_t length) {
+    if (writer->fd >= 0) {
+        write_fully(writer->fd, text, length);
+    } else {
+        fwrite(text, 1, length, writer->file);
+    }
+    writer->bytes_written += length;
+    if (writer->echo) {
+        // whatever the driver printed so far comes first
+        fflush(stdout);
+        write_fully(STDOUT_FILENO, text, length);
+    }
+}
+
+void asm_writer_flush(AsmWriter * writer) {
+    if (writer->length > 0) {
+        write_out(writer, writer->buffer, writer->length);
+        writer->length = 0;
+    }
+}
+
+void asm_writer_close(AsmWriter * writer) {
+    asm_writer_flush(writer);
+    if (writer->fd >= 0) {
+        close(writer->fd);
+    } else {
+        fclose(writer->file);
+    }
+    free(writer->buffer);
+    free(writer->line);
+    free(writer);
+}
+
+void asm_write(AsmWriter * writer, const char * text, size_t length) {
+    if (writer->length + length > writer->capacity) {
+        asm_writer_flush(writer);
+        if (length > writer->capacity) {
+            write_out(writer, text, length);
+            return;
+        }
+    }
+    memcpy(writer->buffer + writer->length, text, length);
+    writer->length += length;
+}
+
+void asm_write_str(AsmWriter * writer, const char * text) {
+    asm_write(writer, text, strlen(text));
+}
+
+void asm_write_char(AsmWriter * writer, char c) {
+    if (writer->length == writer->capacity) {
+        asm_writer_flush(writer);
+    }
+    writer->buffer[writer->length++] = c;
+}
+
+/* the decimal digits at the end of digits, returning where they start */
+static char * format_digits(char digits[24], unsigned long long magnitude, bool negative) {
+    char * p = digits + 24;
+    do {
+        *--p = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (negative) {
+        *--p = '-';
+    }
+    return p;
+}
+
+static char * format_int(char digits[24], long long value) {
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long) value : (unsigned long long) value;
+    return format_digits(digits, magnitude, value < 0);
+}
+
+void asm_write_int(AsmWriter * writer, long long value) {
+    char digits[24];
+    char * start = format_int(digits, value);
+    asm_write(writer, start, digits + 24 - start);
+}
+
+static void reserve_line(AsmWriter * writer, size_t needed) {
+    if (needed > writer->line_capacity) {
+        while (writer->line_capacity < needed) {
+            writer->line_capacity *= 2;
+        }
+        writer->line = realloc(writer->line, writer->line_capacity);
+    }
+}
+
+static size_t append_line(AsmWriter * writer, size_t length, const char * text, size_t count) {
+    reserve_line(writer, length + count + 1);
+    memcpy(writer->line + length, text, count);
+    return length + count;
+}
+
+/* one conversion the hand written cases do not cover, such as %08X or %f.
+ * * widths are not supported.
+ */
+static size_t append_formatted(AsmWriter * writer, size_t length, const char * spec, size_t spec_length,
+                               va_list * args) {
+    char format[32];
+    if (spec_length >= sizeof(format)) {
+        error("Unsupported format %.*s", (int) spec_length, spec);
+        return length;
+    }
+    memcpy(format, spec, spec_length);
+    format[spec_length] = '\0';
+
+    char conversion = spec[spec_length - 1];
+    int longs = 0;
+    for (size_t i = 0; i < spec_length; i++) {
+        longs += spec[i] == 'l' || spec[i] == 'z';
+    }
+
+    char text[512];
+    int count;
+    switch (conversion) {
+        case 'd': case 'i':
+            count = longs == 0 ? snprintf(text, sizeof(text), format, va_arg(*args, int))
+                  : longs == 1 ? snprintf(text, sizeof(text), format, va_arg(*args, long))
+                  : snprintf(text, sizeof(text), format, va_arg(*args, long long));
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            count = longs == 0 ? snprintf(text, sizeof(text), format, va_arg(*args, unsigned))
+                  : longs == 1 ? snprintf(text, sizeof(text), format, va_arg(*args, unsigned long))
+                  : snprintf(text, sizeof(text), format, va_arg(*args, unsigned long long));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            count = snprintf(text, sizeof(text), format, va_arg(*args, double));
+            break;
+        case 'c':
+            count = snprintf(text, sizeof(text), format, va_arg(*args, int));
+            break;
+        case 's':
+            count = snprintf(text, sizeof(text), format, va_arg(*args, const char *));
+            break;
+        case 'p':
+            count = snprintf(text, sizeof(text), format, va_arg(*args, void *));
+            break;
+        default:
+            error("Unsupported format %s", format);
+            return length;
+    }
+    if (count >= (int) sizeof(text)) {
+        error("Formatted text too long for %s", format);
+        return length;
+    }
+    return append_line(writer, length, text, count);
+}
+
+char * asm_format_line(AsmWriter * writer, const char * fmt, va_list args) {
+    va_list remaining;
+    va_copy(remaining, args);
+    size_t length = 0;
+
+    while (*fmt) {
+        const char * literal = fmt;
+        while (*fmt && *fmt != '%') {
+            fmt++;
+        }
+        if (fmt > literal) {
+            length = append_line(writer, length, literal, fmt - literal);
+        }
+        if (!*fmt) {
+            break;
+        }
+
+        // a conversion runs from the % to its first letter other than a length modifier
+        const char * spec = fmt++;
+        while (*fmt && strchr("-+ #0123456789.*hlzjtL", *fmt)) {
+            fmt++;
+        }
+        if (!*fmt) {
+            error("Incomplete format %s", spec);
+            break;
+        }
+        char conversion = *fmt++;
+        size_t spec_length = fmt - spec;
+
+        if (conversion == '%' && spec_length == 2) {
+            length = append_line(writer, length, "%", 1);
+        } else if (conversion == 's' && spec_length == 2) {
+            const char * text = va_arg(remaining, const char *);
+            text = text ? text : "(null)";
+            length = append_line(writer, length, text, strlen(text));
+        } else if ((conversion == 'd' || conversion == 'u') &&
+                   (spec_length == 2 || (spec_length == 3 && (spec[1] == 'l' || spec[1] == '+')))) {
+            char digits[24];
+            char * start;
+            if (conversion == 'u') {
+                unsigned long value = spec[1] == 'l' ? va_arg(remaining, unsigned long) : va_arg(remaining, unsigned);
+                start = format_digits(digits, value, false);
+            } else {
+                long value = spec[1] == 'l' ? va_arg(remaining, long) : va_arg(remaining, int);
+                start = format_int(digits, value);
+                if (spec[1] == '+' && value >= 0) {
+                    length = append_line(writer, length, "+", 1);
+                }
+            }
+            length = append_line(writer, length, start, digits + 24 - start);
+        } else {
+            length = append_formatted(writer, length, spec, spec_length, &remaining);
+        }
+    }
+
+    va_end(remaining);
+    reserve_line(writer, length + 1);
+    writer->line[length] = '\0';
+    return writer->line;
+}
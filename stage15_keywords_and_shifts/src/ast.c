@@ -174,6 +174,145 @@ void free_ast(ASTNode * node) {
     free(node);
 }
 
+int get_ast_node_count() {
+    return ast_id;
+}
+
+static void for_each_in_list(ASTNode_list * list, ASTNodeSlotVisitor visit, void * arg) {
+    if (!list) return;
+    for (ASTNode_list_node * n = list->head; n; n = n->next) {
+        visit(&n->value, arg);
+    }
+}
+
+/* calls visit with the address of each direct child of node, so the visitor
+ * can replace the child. null children are skipped. the literal lists of a
+ * translation unit are not children, the literal nodes are reached through
+ * the expressions that own them.
+ */
+void ast_for_each_child_slot(ASTNode * node, ASTNodeSlotVisitor visit, void * arg) {
+    if (!node) return;
+
+#define VISIT(child) do { if (child) visit(&(child), arg); } while (0)
+
+    switch(node->type) {
+        case AST_TRANSLATION_UNIT:
+            for_each_in_list(node->translation_unit.globals, visit, arg);
+            for_each_in_list(node->translation_unit.functions, visit, arg);
+            break;
+        case AST_VAR_DECL:
+            VISIT(node->var_decl.init_expr);
+            break;
+        case AST_FUNCTION_DECL:
+            for_each_in_list(node->function_decl.param_list, visit, arg);
+            break;
+        case AST_FUNCTION_DEF:
+            for_each_in_list(node->function_def.param_list, visit, arg);
+            VISIT(node->function_def.body);
+            break;
+        case AST_FUNCTION_CALL_EXPR:
+            for_each_in_list(node->function_call.arg_list, visit, arg);
+            break;
+        case AST_RETURN_STMT:
+            VISIT(node->return_stmt.expr);
+            break;
+        case AST_BLOCK_STMT:
+            for_each_in_list(node->block.statements, visit, arg);
+            break;
+        case AST_IF_STMT:
+            VISIT(node->if_stmt.cond);
+            VISIT(node->if_stmt.then_stmt);
+            VISIT(node->if_stmt.else_stmt);
+            break;
+        case AST_WHILE_STMT:
+            VISIT(node->while_stmt.cond);
+            VISIT(node->while_stmt.body);
+            break;
+        case AST_FOR_STMT:
+            VISIT(node->for_stmt.init_expr);
+            VISIT(node->for_stmt.cond_expr);
+            VISIT(node->for_stmt.update_expr);
+            VISIT(node->for_stmt.body);
+            break;
+        case AST_ASSERT_EXTENSION_STATEMENT:
+        case AST_PRINT_EXTENSION_STATEMENT:
+        case AST_EXPRESSION_STMT:
+            VISIT(node->expr_stmt.expr);
+            break;
+        case AST_ARRAY_ACCESS:
+            VISIT(node->array_access.base);
+            VISIT(node->array_access.index);
+            break;
+        case AST_LABELED_STMT:
+            VISIT(node->labeled_stmt.stmt);
+            break;
+        case AST_SWITCH_STMT:
+            VISIT(node->switch_stmt.expr);
+            VISIT(node->switch_stmt.stmt);
+            break;
+        case AST_CASE_STMT:
+            VISIT(node->case_stmt.constExpression);
+            VISIT(node->case_stmt.stmt);
+            break;
+        case AST_DEFAULT_STMT:
+            VISIT(node->default_stmt.stmt);
+            break;
+        case AST_BINARY_EXPR:
+            VISIT(node->binary.lhs);
+            VISIT(node->binary.rhs);
+            break;
+        case AST_UNARY_EXPR:
+            VISIT(node->unary.operand);
+            break;
+        case AST_DO_WHILE_STMT:
+            VISIT(node->do_while_stmt.body);
+            VISIT(node->do_while_stmt.expr);
+            break;
+        case AST_CAST_EXPR:
+            VISIT(node->cast_expr.expr);
+            break;
+        case AST_INITIALIZER_LIST:
+            for_each_in_list(node->initializer_list.items, visit, arg);
+            break;
+        case AST_DECLARATION_STMT:
+            for_each_in_list(node->declaration.init_declarator_list, visit, arg);
+            break;
+        case AST_COND_EXPR:
+            VISIT(node->cond_expr.cond);
+            VISIT(node->cond_expr.then_expr);
+            VISIT(node->cond_expr.else_expr);
+            break;
+        case AST_GOTO_STMT:
+        case AST_CONTINUE_STMT:
+        case AST_BREAK_STMT:
+        case AST_INT_LITERAL:
+        case AST_FLOAT_LITERAL:
+        case AST_DOUBLE_LITERAL:
+        case AST_STRING_LITERAL:
+        case AST_VAR_REF_EXPR:
+            // no children
+            break;
+    }
+
+#undef VISIT
+}
+
+typedef struct ChildVisit {
+    ASTNodeVisitor visit;
+    void * arg;
+} ChildVisit;
+
+static void visit_child(ASTNode ** slot, void * arg) {
+    ChildVisit * child_visit = arg;
+    child_visit->visit(*slot, child_visit->arg);
+}
+
+/* calls visit on each direct child of node, see ast_for_each_child_slot */
+void ast_for_each_child(ASTNode * node, ASTNodeVisitor visit, void * arg) {
+    ChildVisit child_visit = { visit, arg };
+    ast_for_each_child_slot(node, visit_child, &child_visit);
+}
+
 BinaryOperator get_binary_operator_from_tok(Token * tok) {
     switch (tok->type) {
         case TOKEN_PLUS: return BINOP_ADD; break;
@@ -188,7 +327,7 @@ BinaryOperator get_binary_operator_from_tok(Token * tok) {
         case TOKEN_SHIFT_LEFT: return BINOP_SHIFT_LEFT; break;
         case TOKEN_SHIFT_RIGHT: return BINOP_SHIFT_RIGHT; break;
         default:
-            error("Unknown binary operator '%s'\n", tok->text);
+            error("Unknown binary operator '%.*s'\n", tok->length, token_start(tok));
             return BINOP_UNASSIGNED_OP;\
     }
 }
@@ -417,6 +556,12 @@ bool is_assignment(ASTNode * node) {
                 node->binary.op == BINOP_COMPOUND_SUB_ASSIGN;
 }
 
+bool is_inc_dec(ASTNode * node) {
+    if (node->type != AST_UNARY_EXPR) return false;
+    UnaryOperator op = node->unary.op;
+    return op == UNARY_PRE_INC || op == UNARY_PRE_DEC || op == UNARY_POST_INC || op == UNARY_POST_DEC;
+}
+
 bool is_comparison_op(BinaryOperator op) {
     return op == BINOP_EQ || op == BINOP_NE || op == BINOP_GT || op == BINOP_GE || op == BINOP_LT || op == BINOP_LE;
 }
\ No newline at end of file
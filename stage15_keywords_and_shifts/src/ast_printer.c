@@ -225,7 +225,7 @@ void print_ast(ASTNode * node, int indent) {
                         printf("Cast");
                     }
                     else {
-                        error("Invalid initializer list type");
+                        printf("(%s)", get_ast_node_name(n->value));
                     }
                     if (n->next != NULL) {
                         printf(", ");
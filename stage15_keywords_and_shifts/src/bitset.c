@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bitset.h"
+
+Bitset * bitset_new(int size) {
+    Bitset * set = malloc(sizeof(Bitset));
+    set->size = size;
+    set->word_count = (size + 63) / 64;
+    set->words = calloc(set->word_count ? set->word_count : 1, sizeof(uint64_t));
+    return set;
+}
+
+void bitset_free(Bitset * set) {
+    if (!set) return;
+    free(set->words);
+    free(set);
+}
+
+void bitset_set(Bitset * set, int bit) {
+    set->words[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+void bitset_clear(Bitset * set, int bit) {
+    set->words[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+}
+
+bool bitset_test(const Bitset * set, int bit) {
+    return (set->words[bit / 64] >> (bit % 64)) & 1;
+}
+
+void bitset_clear_all(Bitset * set) {
+    memset(set->words, 0, set->word_count * sizeof(uint64_t));
+}
+
+void bitset_set_all(Bitset * set) {
+    memset(set->words, 0xff, set->word_count * sizeof(uint64_t));
+    if (set->size % 64) {
+        set->words[set->word_count - 1] = ((uint64_t)1 << (set->size % 64)) - 1;
+    }
+}
+
+void bitset_copy(Bitset * dest, const Bitset * src) {
+    memcpy(dest->words, src->words, dest->word_count * sizeof(uint64_t));
+}
+
+bool bitset_equals(const Bitset * a, const Bitset * b) {
+    return memcmp(a->words, b->words, a->word_count * sizeof(uint64_t)) == 0;
+}
+
+bool bitset_union(Bitset * dest, const Bitset * src) {
+    bool changed = false;
+    for (int i = 0; i < dest->word_count; i++) {
+        uint64_t w = dest->words[i] | src->words[i];
+        changed |= w != dest->words[i];
+        dest->words[i] = w;
+    }
+    return changed;
+}
+
+bool bitset_intersect(Bitset * dest, const Bitset * src) {
+    bool changed = false;
+    for (int i = 0; i < dest->word_count; i++) {
+        uint64_t w = dest->words[i] & src->words[i];
+        changed |= w != dest->words[i];
+        dest->words[i] = w;
+    }
+    return changed;
+}
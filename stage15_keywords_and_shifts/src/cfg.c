@@ -0,0 +1,501 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "error.h"
+#include "cfg.h"
+
+typedef struct LoopFrame {
+    BasicBlock * break_target;
+    BasicBlock * continue_target;
+    struct LoopFrame * next;
+} LoopFrame;
+
+typedef struct SwitchFrame {
+    BasicBlock * break_target;
+    struct SwitchFrame * next;
+} SwitchFrame;
+
+typedef struct LabelBlock {
+    const char * label;
+    BasicBlock * block;
+    struct LabelBlock * next;
+} LabelBlock;
+
+typedef struct CFGBuilder {
+    CFG * cfg;
+    BasicBlock * current;
+    LoopFrame * loops;
+    SwitchFrame * switches;
+    LabelBlock * labels;
+} CFGBuilder;
+
+static void build_statement(CFGBuilder * builder, ASTNode * node);
+
+static BasicBlock * new_block(CFG * cfg) {
+    BasicBlock * block = calloc(1, sizeof(BasicBlock));
+    block->id = cfg->block_count;
+    if (cfg->block_count == cfg->block_capacity) {
+        cfg->block_capacity = cfg->block_capacity ? cfg->block_capacity * 2 : 16;
+        cfg->blocks = realloc(cfg->blocks, cfg->block_capacity * sizeof(BasicBlock *));
+    }
+    cfg->blocks[cfg->block_count++] = block;
+    return block;
+}
+
+static void append_block_ptr(BasicBlock *** array, int * count, int * capacity, BasicBlock * block) {
+    for (int i = 0; i < *count; i++) {
+        if ((*array)[i] == block) return;
+    }
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 2;
+        *array = realloc(*array, *capacity * sizeof(BasicBlock *));
+    }
+    (*array)[(*count)++] = block;
+}
+
+static void add_edge(BasicBlock * from, BasicBlock * to) {
+    append_block_ptr(&from->succs, &from->succ_count, &from->succ_capacity, to);
+    append_block_ptr(&to->preds, &to->pred_count, &to->pred_capacity, from);
+}
+
+static void add_item(BasicBlock * block, CFGItemKind kind, ASTNode * node, ASTNode * owner) {
+    if (block->item_count == block->item_capacity) {
+        block->item_capacity = block->item_capacity ? block->item_capacity * 2 : 4;
+        block->items = realloc(block->items, block->item_capacity * sizeof(CFGItem));
+    }
+    CFGItem * item = &block->items[block->item_count++];
+    item->kind = kind;
+    item->node = node;
+    item->owner = owner;
+}
+
+bool is_marker_item(const CFGItem * item) {
+    return item->kind == CFG_ITEM_LABEL || item->kind == CFG_ITEM_LOOP;
+}
+
+static BasicBlock * label_block(CFGBuilder * builder, const char * label) {
+    for (LabelBlock * l = builder->labels; l; l = l->next) {
+        if (strcmp(l->label, label) == 0) {
+            return l->block;
+        }
+    }
+    LabelBlock * l = malloc(sizeof(LabelBlock));
+    l->label = label;
+    l->block = new_block(builder->cfg);
+    l->next = builder->labels;
+    builder->labels = l;
+    return l->block;
+}
+
+/* ends the current block with a jump to target. code following the jump
+ * starts a fresh block with no predecessors.
+ */
+static void jump_to(CFGBuilder * builder, BasicBlock * target) {
+    if (target) {
+        add_edge(builder->current, target);
+    }
+    builder->current = new_block(builder->cfg);
+}
+
+/* continue building in block, which is entered by falling through from the current block */
+static void fall_into(CFGBuilder * builder, BasicBlock * block) {
+    add_edge(builder->current, block);
+    builder->current = block;
+}
+
+static void build_if(CFGBuilder * builder, ASTNode * node) {
+    add_item(builder->current, CFG_ITEM_CONDITION, node->if_stmt.cond, node);
+    BasicBlock * cond_block = builder->current;
+    BasicBlock * join = new_block(builder->cfg);
+
+    builder->current = new_block(builder->cfg);
+    add_edge(cond_block, builder->current);
+    build_statement(builder, node->if_stmt.then_stmt);
+    add_edge(builder->current, join);
+
+    if (node->if_stmt.else_stmt) {
+        builder->current = new_block(builder->cfg);
+        add_edge(cond_block, builder->current);
+        build_statement(builder, node->if_stmt.else_stmt);
+        add_edge(builder->current, join);
+    } else {
+        add_edge(cond_block, join);
+    }
+    builder->current = join;
+}
+
+static void build_loop_body(CFGBuilder * builder, ASTNode * body, BasicBlock * break_target, BasicBlock * continue_target) {
+    LoopFrame frame = { break_target, continue_target, builder->loops };
+    builder->loops = &frame;
+    build_statement(builder, body);
+    builder->loops = frame.next;
+}
+
+static void build_while(CFGBuilder * builder, ASTNode * node) {
+    BasicBlock * header = new_block(builder->cfg);
+    BasicBlock * body = new_block(builder->cfg);
+    BasicBlock * end = new_block(builder->cfg);
+
+    fall_into(builder, header);
+    header->loop = node;
+    add_item(header, CFG_ITEM_LOOP, node, NULL);
+    add_item(header, CFG_ITEM_CONDITION, node->while_stmt.cond, node);
+    add_edge(header, body);
+    add_edge(header, end);
+
+    builder->current = body;
+    build_loop_body(builder, node->while_stmt.body, end, header);
+    add_edge(builder->current, header);
+    builder->current = end;
+}
+
+static void build_do_while(CFGBuilder * builder, ASTNode * node) {
+    BasicBlock * body = new_block(builder->cfg);
+    BasicBlock * cond = new_block(builder->cfg);
+    BasicBlock * end = new_block(builder->cfg);
+
+    fall_into(builder, body);
+    add_item(body, CFG_ITEM_LOOP, node, NULL);
+    build_loop_body(builder, node->do_while_stmt.body, end, cond);
+    fall_into(builder, cond);
+    add_item(cond, CFG_ITEM_CONDITION, node->do_while_stmt.expr, node);
+    add_edge(cond, body);
+    add_edge(cond, end);
+    builder->current = end;
+}
+
+static void build_for(CFGBuilder * builder, ASTNode * node) {
+    if (node->for_stmt.init_expr) {
+        ASTNode * init = node->for_stmt.init_expr;
+        if (init->type == AST_DECLARATION_STMT || init->type == AST_EXPRESSION_STMT) {
+            build_statement(builder, init);
+        } else {
+            add_item(builder->current, CFG_ITEM_EXPRESSION, init, node);
+        }
+    }
+
+    BasicBlock * cond = new_block(builder->cfg);
+    BasicBlock * body = new_block(builder->cfg);
+    BasicBlock * update = new_block(builder->cfg);
+    BasicBlock * end = new_block(builder->cfg);
+
+    fall_into(builder, cond);
+    cond->loop = node;
+    // for (;;) {} has no other item, without this the pass removing unreachable code deletes it
+    add_item(cond, CFG_ITEM_LOOP, node, NULL);
+    if (node->for_stmt.cond_expr) {
+        add_item(cond, CFG_ITEM_CONDITION, node->for_stmt.cond_expr, node);
+        add_edge(cond, end);
+    }
+    add_edge(cond, body);
+
+    builder->current = body;
+    build_loop_body(builder, node->for_stmt.body, end, update);
+    fall_into(builder, update);
+    if (node->for_stmt.update_expr) {
+        add_item(update, CFG_ITEM_EXPRESSION, node->for_stmt.update_expr, node);
+    }
+    add_edge(update, cond);
+    builder->current = end;
+}
+
+/* only the case and default statements at the top of the switch body are
+ * emitted, each one falls through into the next. without a default the
+ * dispatch falls into the first case body as well as skipping to the end.
+ */
+static void build_switch(CFGBuilder * builder, ASTNode * node) {
+    add_item(builder->current, CFG_ITEM_EXPRESSION, node->switch_stmt.expr, node);
+    BasicBlock * dispatch = builder->current;
+    BasicBlock * end = new_block(builder->cfg);
+    bool has_default = false;
+
+    SwitchFrame frame = { end, builder->switches };
+    builder->switches = &frame;
+
+    builder->current = new_block(builder->cfg);
+    BasicBlock * first_case = NULL;
+    ASTNode * body = node->switch_stmt.stmt;
+    if (body && body->type == AST_BLOCK_STMT) {
+        for (ASTNode_list_node * n = body->block.statements->head; n; n = n->next) {
+            ASTNode * stmt = n->value;
+            if (stmt->type != AST_CASE_STMT && stmt->type != AST_DEFAULT_STMT) {
+                continue;
+            }
+            BasicBlock * case_block = new_block(builder->cfg);
+            if (!first_case) {
+                first_case = case_block;
+            }
+            add_edge(dispatch, case_block);
+            fall_into(builder, case_block);
+            add_item(case_block, CFG_ITEM_LABEL, stmt, node);
+            if (stmt->type == AST_CASE_STMT) {
+                build_statement(builder, stmt->case_stmt.stmt);
+            } else {
+                has_default = true;
+                build_statement(builder, stmt->default_stmt.stmt);
+            }
+        }
+    }
+    add_edge(builder->current, end);
+
+    if (!has_default) {
+        add_edge(dispatch, first_case ? first_case : end);
+        add_edge(dispatch, end);
+    }
+
+    builder->switches = frame.next;
+    builder->current = end;
+}
+
+static void build_statement(CFGBuilder * builder, ASTNode * node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case AST_BLOCK_STMT:
+            for (ASTNode_list_node * n = node->block.statements->head; n; n = n->next) {
+                build_statement(builder, n->value);
+            }
+            break;
+
+        case AST_DECLARATION_STMT:
+            for (ASTNode_list_node * n = node->declaration.init_declarator_list->head; n; n = n->next) {
+                add_item(builder->current, CFG_ITEM_STATEMENT, n->value, node);
+            }
+            break;
+
+        case AST_IF_STMT:
+            build_if(builder, node);
+            break;
+        case AST_WHILE_STMT:
+            build_while(builder, node);
+            break;
+        case AST_DO_WHILE_STMT:
+            build_do_while(builder, node);
+            break;
+        case AST_FOR_STMT:
+            build_for(builder, node);
+            break;
+        case AST_SWITCH_STMT:
+            build_switch(builder, node);
+            break;
+
+        case AST_RETURN_STMT:
+            add_item(builder->current, CFG_ITEM_JUMP, node, NULL);
+            jump_to(builder, builder->cfg->exit);
+            break;
+
+        case AST_BREAK_STMT: {
+            // matches get_break_label in the emitter, loops take precedence over switches
+            BasicBlock * target = builder->loops ? builder->loops->break_target :
+                                  builder->switches ? builder->switches->break_target : NULL;
+            add_item(builder->current, CFG_ITEM_JUMP, node, NULL);
+            jump_to(builder, target);
+            break;
+        }
+
+        case AST_CONTINUE_STMT:
+            add_item(builder->current, CFG_ITEM_JUMP, node, NULL);
+            jump_to(builder, builder->loops ? builder->loops->continue_target : NULL);
+            break;
+
+        case AST_GOTO_STMT:
+            add_item(builder->current, CFG_ITEM_JUMP, node, NULL);
+            jump_to(builder, label_block(builder, node->goto_stmt.label));
+            break;
+
+        case AST_LABELED_STMT:
+            fall_into(builder, label_block(builder, node->labeled_stmt.label));
+            add_item(builder->current, CFG_ITEM_LABEL, node, NULL);
+            build_statement(builder, node->labeled_stmt.stmt);
+            break;
+
+        case AST_CASE_STMT:
+            // case outside the top of a switch body, the emitter treats it as a plain statement
+            build_statement(builder, node->case_stmt.stmt);
+            break;
+        case AST_DEFAULT_STMT:
+            build_statement(builder, node->default_stmt.stmt);
+            break;
+
+        default:
+            add_item(builder->current, CFG_ITEM_STATEMENT, node, NULL);
+            break;
+    }
+}
+
+static void mark_reachable(BasicBlock * block) {
+    // iterative depth first walk, deep statement nesting would overflow recursion
+    int capacity = 16;
+    int count = 0;
+    BasicBlock ** stack = malloc(capacity * sizeof(BasicBlock *));
+    stack[count++] = block;
+    block->reachable = true;
+    while (count > 0) {
+        BasicBlock * b = stack[--count];
+        for (int i = 0; i < b->succ_count; i++) {
+            BasicBlock * s = b->succs[i];
+            if (s->reachable) continue;
+            s->reachable = true;
+            if (count == capacity) {
+                capacity *= 2;
+                stack = realloc(stack, capacity * sizeof(BasicBlock *));
+            }
+            stack[count++] = s;
+        }
+    }
+    free(stack);
+}
+
+CFG * build_cfg(ASTNode * function_def) {
+    if (function_def->type != AST_FUNCTION_DEF) {
+        error("CFG can only be built for a function definition");
+        return NULL;
+    }
+
+    CFG * cfg = calloc(1, sizeof(CFG));
+    cfg->function = function_def;
+    cfg->entry = new_block(cfg);
+    cfg->exit = new_block(cfg);
+
+    CFGBuilder builder = {0};
+    builder.cfg = cfg;
+    builder.current = new_block(cfg);
+    add_edge(cfg->entry, builder.current);
+
+    build_statement(&builder, function_def->function_def.body);
+
+    // falling off the end of the body returns
+    add_edge(builder.current, cfg->exit);
+
+    while (builder.labels) {
+        LabelBlock * next = builder.labels->next;
+        free(builder.labels);
+        builder.labels = next;
+    }
+
+    mark_reachable(cfg->entry);
+    return cfg;
+}
+
+static void post_order(BasicBlock * block, BasicBlock ** order, int * count, bool * visited) {
+    // explicit stack of (block, next successor) pairs
+    typedef struct { BasicBlock * block; int next; } Frame;
+    int capacity = 16;
+    int depth = 0;
+    Frame * stack = malloc(capacity * sizeof(Frame));
+    stack[depth++] = (Frame){ block, 0 };
+    visited[block->id] = true;
+    while (depth > 0) {
+        Frame * top = &stack[depth - 1];
+        if (top->next < top->block->succ_count) {
+            BasicBlock * s = top->block->succs[top->next++];
+            if (!visited[s->id]) {
+                visited[s->id] = true;
+                if (depth == capacity) {
+                    capacity *= 2;
+                    stack = realloc(stack, capacity * sizeof(Frame));
+                }
+                stack[depth++] = (Frame){ s, 0 };
+            }
+        } else {
+            order[(*count)++] = top->block;
+            depth--;
+        }
+    }
+    free(stack);
+}
+
+static BasicBlock * intersect(BasicBlock * a, BasicBlock * b) {
+    while (a != b) {
+        while (a->rpo_index > b->rpo_index) a = a->idom;
+        while (b->rpo_index > a->rpo_index) b = b->idom;
+    }
+    return a;
+}
+
+/* iterative dominator computation of Cooper, Harvey and Kennedy over the
+ * reachable blocks. fills rpo, rpo_index and idom.
+ */
+void compute_dominators(CFG * cfg) {
+    bool * visited = calloc(cfg->block_count, sizeof(bool));
+    BasicBlock ** order = malloc(cfg->block_count * sizeof(BasicBlock *));
+    int count = 0;
+    post_order(cfg->entry, order, &count, visited);
+    free(visited);
+
+    free(cfg->rpo);
+    cfg->rpo = malloc((count ? count : 1) * sizeof(BasicBlock *));
+    cfg->rpo_count = count;
+    for (int i = 0; i < cfg->block_count; i++) {
+        cfg->blocks[i]->rpo_index = -1;
+        cfg->blocks[i]->idom = NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        cfg->rpo[i] = order[count - 1 - i];
+        cfg->rpo[i]->rpo_index = i;
+    }
+    free(order);
+
+    cfg->entry->idom = cfg->entry;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 1; i < cfg->rpo_count; i++) {
+            BasicBlock * block = cfg->rpo[i];
+            BasicBlock * new_idom = NULL;
+            for (int p = 0; p < block->pred_count; p++) {
+                BasicBlock * pred = block->preds[p];
+                if (pred->rpo_index < 0 || !pred->idom) continue;
+                new_idom = new_idom ? intersect(pred, new_idom) : pred;
+            }
+            if (new_idom != block->idom) {
+                block->idom = new_idom;
+                changed = true;
+            }
+        }
+    }
+    cfg->entry->idom = NULL;
+}
+
+bool dominates(BasicBlock * a, BasicBlock * b) {
+    while (b) {
+        if (a == b) return true;
+        b = b->idom;
+    }
+    return false;
+}
+
+void free_cfg(CFG * cfg) {
+    if (!cfg) return;
+    for (int i = 0; i < cfg->block_count; i++) {
+        BasicBlock * block = cfg->blocks[i];
+        free(block->items);
+        free(block->succs);
+        free(block->preds);
+        free(block);
+    }
+    free(cfg->blocks);
+    free(cfg->rpo);
+    free(cfg);
+}
+
+void print_cfg(CFG * cfg) {
+    printf("CFG for %s\n", cfg->function->function_def.name);
+    for (int i = 0; i < cfg->block_count; i++) {
+        BasicBlock * block = cfg->blocks[i];
+        printf("  B%d%s%s%s:", block->id,
+            block == cfg->entry ? " (entry)" : "",
+            block == cfg->exit ? " (exit)" : "",
+            block->reachable ? "" : " (unreachable)");
+        for (int j = 0; j < block->succ_count; j++) {
+            printf(" ->B%d", block->succs[j]->id);
+        }
+        printf("\n");
+        for (int j = 0; j < block->item_count; j++) {
+            printf("      %s\n", get_ast_node_name(block->items[j].node));
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "compile_stats.h"
+#include "lexer_scan.h"
+
+static CompileStats compile_stats;
+
+CompileStats * get_compile_stats() {
+    return &compile_stats;
+}
+
+void reset_compile_stats() {
+    memset(&compile_stats, 0, sizeof(compile_stats));
+}
+
+void print_compile_stats(FILE * out) {
+    fprintf(out, "\n");
+    fprintf(out, "--------------------------------------------\n");
+    fprintf(out, "Compile Statistics\n");
+    fprintf(out, "--------------------------------------------\n");
+    fprintf(out, "%-32s %8d\n", "functions removed:", compile_stats.functions_removed);
+    fprintf(out, "%-32s %8d\n", "globals removed:", compile_stats.globals_removed);
+    fprintf(out, "%-32s %8d\n", "literals removed:", compile_stats.literals_removed);
+    fprintf(out, "%-32s %8d\n", "runtime helpers removed:", compile_stats.runtime_helpers_removed);
+    fprintf(out, "%-32s %8d\n", "unreachable statements removed:", compile_stats.unreachable_statements_removed);
+    fprintf(out, "%-32s %8d\n", "dead stores removed:", compile_stats.dead_stores_removed);
+    fprintf(out, "%-32s %8d\n", "dead computations removed:", compile_stats.dead_computations_removed);
+    fprintf(out, "%-32s %8d\n", "common subexpressions reused:", compile_stats.common_subexpressions_eliminated);
+    fprintf(out, "%-32s %8d\n", "loop invariants hoisted:", compile_stats.loop_invariants_hoisted);
+    fprintf(out, "%-32s %8d\n", "induction accesses reduced:", compile_stats.induction_accesses_reduced);
+    fprintf(out, "%-32s %8d\n", "loops fully unrolled:", compile_stats.loops_fully_unrolled);
+    fprintf(out, "%-32s %8d\n", "loops unrolled:", compile_stats.loops_unrolled);
+    fprintf(out, "%-32s %8d\n", "loops vectorized:", compile_stats.loops_vectorized);
+    fprintf(out, "%-32s %8d\n", "locals kept in registers:", compile_stats.locals_promoted);
+    fprintf(out, "%-32s %8d\n", "constant divisions reduced:", compile_stats.constant_divisions_reduced);
+    fprintf(out, "%-32s %8d\n", "branchless selects:", compile_stats.branchless_selects);
+    fprintf(out, "%-32s %8d\n", "fp values held in registers:", compile_stats.fp_values_held);
+    fprintf(out, "%-32s %8d\n", "array initializer templates:", compile_stats.array_templates);
+    fprintf(out, "%-32s %8d\n", "asserts with cold failure paths:", compile_stats.asserts_outlined);
+    fprintf(out, "%-32s %8d\n", "rodata literal bytes:", compile_stats.literal_bytes);
+    fprintf(out, "%-32s %8d\n", "rodata bytes saved by merging:", compile_stats.literal_bytes_merged);
+    fprintf(out, "%-32s %8ld\n", "source bytes tokenized:", compile_stats.source_bytes);
+    fprintf(out, "%-32s %8ld\n", "tokenize time (us):", compile_stats.tokenize_microseconds);
+    if (compile_stats.tokenize_microseconds > 0) {
+        fprintf(out, "%-32s %8.1f\n", "tokenize throughput (MB/s):",
+                (double) compile_stats.source_bytes / compile_stats.tokenize_microseconds);
+    }
+    fprintf(out, "%-32s %8s\n", "lexer scan mode:", lex_scan_mode_name(get_lex_scan_mode()));
+    fprintf(out, "%-32s %8ld\n", "assembly bytes written:", compile_stats.asm_bytes);
+    fprintf(out, "%-32s %8ld\n", "emit time (us):", compile_stats.emit_microseconds);
+    if (compile_stats.emit_microseconds > 0) {
+        fprintf(out, "%-32s %8.1f\n", "emit throughput (MB/s):",
+                (double) compile_stats.asm_bytes / compile_stats.emit_microseconds);
+    }
+}
@@ -0,0 +1,37 @@
+#include <stdbool.h>
+
+#include "compiler_options.h"
+
+static CompilerOptions compiler_options = {
+    .opt_level = 1,
+    .print_stats = false,
+    .align_loops = false,
+    .unroll_factor = 4,
+    .vectorize = true,
+    .fast_math = false,
+    .branchless = true,
+    .register_locals = true,
+    .asm_dialect = ASM_NASM,
+    .compact_asm = false,
+};
+
+CompilerOptions * get_compiler_options() {
+    return &compiler_options;
+}
+
+void reset_compiler_options() {
+    compiler_options.opt_level = 1;
+    compiler_options.print_stats = false;
+    compiler_options.align_loops = false;
+    compiler_options.unroll_factor = 4;
+    compiler_options.vectorize = true;
+    compiler_options.fast_math = false;
+    compiler_options.branchless = true;
+    compiler_options.register_locals = true;
+    compiler_options.asm_dialect = ASM_NASM;
+    compiler_options.compact_asm = false;
+}
+
+bool optimizations_enabled() {
+    return compiler_options.opt_level > 0;
+}
@@ -0,0 +1,424 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "emit_select.h"
+#include "emit_condition.h"
+#include "compiler_options.h"
+#include "compile_stats.h"
+#include "emit_branchless.h"
+
+/* a select evaluates both arms every time. a well predicted branch costs
+ * next to nothing and a mispredicted one about 15 cycles, so arms within
+ * this budget win once the branch goes the wrong way one time in four.
+ */
+#define SELECT_BUDGET 6
+
+// calls, stores, division and loads through computed addresses
+#define NOT_SPECULABLE 1000
+
+/* the registers an int or long select runs in. arms that take more than a
+ * load are computed into then and other before the flags are set.
+ */
+typedef struct SelectRegisters {
+    const char * result;
+    const char * then;
+    const char * other;
+} SelectRegisters;
+
+static const SelectRegisters DWORD_SELECT = { "eax", "r8d", "r9d" };
+static const SelectRegisters QWORD_SELECT = { "rax", "r8", "r9" };
+
+static int add_cost(int a, int b) {
+    return a + b > NOT_SPECULABLE ? NOT_SPECULABLE : a + b;
+}
+
+static int operator_cost(ASTNode * node) {
+    bool fp = is_floating_point_type(node->ctype);
+    switch (node->binary.op) {
+        case BINOP_ADD:
+        case BINOP_SUB:
+            return fp ? 3 : 1;
+        case BINOP_BITWISE_AND:
+        case BINOP_BITWISE_OR:
+        case BINOP_BITWISE_XOR:
+        case BINOP_SHIFT_LEFT:
+        case BINOP_SHIFT_RIGHT:
+            return 1;
+        case BINOP_MUL:
+            return fp ? 4 : 3;
+        case BINOP_DIV:
+            // idiv faults on zero, divsd does not
+            return fp ? 12 : NOT_SPECULABLE;
+        case BINOP_EQ:
+        case BINOP_NE:
+        case BINOP_LT:
+        case BINOP_LE:
+        case BINOP_GT:
+        case BINOP_GE:
+            return 2;
+        default:
+            return NOT_SPECULABLE;
+    }
+}
+
+/* rough cycles to evaluate node on a path that may not be taken.
+ * NOT_SPECULABLE when evaluating it there could have side effects or fault.
+ */
+static int speculation_cost(ASTNode * node) {
+    switch (node->type) {
+        case AST_INT_LITERAL:
+        case AST_FLOAT_LITERAL:
+        case AST_DOUBLE_LITERAL:
+            return 0;
+        case AST_VAR_REF_EXPR:
+        case AST_ARRAY_ACCESS:
+            return has_direct_address(node) && is_scalar_type(node->ctype) ? 1 : NOT_SPECULABLE;
+        case AST_CAST_EXPR:
+            return add_cost(1, speculation_cost(node->cast_expr.expr));
+        case AST_UNARY_EXPR:
+            switch (node->unary.op) {
+                case UNARY_NEGATE:
+                case UNARY_PLUS:
+                case UNARY_BITWISE_NOT:
+                case UNARY_LOGICAL_NOT:
+                    return add_cost(1, speculation_cost(node->unary.operand));
+                case UNARY_ADDRESS:
+                    return has_direct_address(node->unary.operand) ? 1 : NOT_SPECULABLE;
+                default:
+                    return NOT_SPECULABLE;
+            }
+        case AST_BINARY_EXPR:
+            return add_cost(operator_cost(node),
+                            add_cost(speculation_cost(node->binary.lhs), speculation_cost(node->binary.rhs)));
+        default:
+            return NOT_SPECULABLE;
+    }
+}
+
+/* strips logical nots off a condition, leaving the node that sets the flags */
+static ASTNode * flag_test(ASTNode * cond, bool * negated) {
+    *negated = false;
+    while (cond->type == AST_UNARY_EXPR && cond->unary.op == UNARY_LOGICAL_NOT) {
+        *negated = !*negated;
+        cond = cond->unary.operand;
+    }
+    return cond;
+}
+
+/* the cmovcc suffix that picks the then arm after emit_select_flags, or
+ * NULL when a single cmov cannot express the test
+ */
+static const char * select_condition_code(ASTNode * test, bool negated) {
+    if (is_comparison(test)) {
+        CType * ctype = test->binary.common_type;
+        BinaryOperator op = test->binary.op;
+        if (!is_floating_point_type(ctype)) {
+            return int_condition_code(negated ? negated_comparison(op) : op,
+                                      is_signed_integer_type(ctype) || is_pointer_type(ctype));
+        }
+        // < and <= are tested swapped, as in emit_branch. unordered
+        // operands set ZF and PF together, so == and != would take two cmovs
+        switch (op) {
+            case BINOP_GT:
+            case BINOP_LT:
+                return negated ? "be" : "a";
+            case BINOP_GE:
+            case BINOP_LE:
+                return negated ? "b" : "ae";
+            default:
+                return NULL;
+        }
+    }
+    if (!test->ctype || !(is_integer_type(test->ctype) || is_pointer_type(test->ctype))) return NULL;
+    if (test->type == AST_BINARY_EXPR &&
+        (test->binary.op == BINOP_LOGICAL_AND || test->binary.op == BINOP_LOGICAL_OR)) {
+        return NULL;
+    }
+    return negated ? "e" : "ne";
+}
+
+static void emit_select_flags(EmitterContext * ctx, ASTNode * test) {
+    if (is_comparison(test)) {
+        BinaryOperator op = test->binary.op;
+        bool swapped = is_floating_point_type(test->binary.common_type) && (op == BINOP_LT || op == BINOP_LE);
+        emit_comparison_flags(ctx, test, swapped);
+    } else {
+        emit_int_test_tile(ctx, test);
+    }
+}
+
+/* arms that load with a single mov or cmov, which leave the flags alone,
+ * so they can wait until the condition has been tested
+ */
+static bool is_select_leaf(ASTNode * node, CType * ctype) {
+    long constant;
+    if (!node->ctype) return false;
+    if (is_floating_point_type(ctype)) {
+        return node->ctype->kind == ctype->kind &&
+               (node->type == AST_FLOAT_LITERAL || node->type == AST_DOUBLE_LITERAL || has_direct_address(node));
+    }
+    if (literal_value(node, &constant)) return true;
+    return has_direct_address(node) && node->ctype->size == ctype->size &&
+           (is_integer_type(node->ctype) || is_pointer_type(node->ctype));
+}
+
+/* arms that are not leaves are computed in rax or xmm0 first, so they
+ * need the select's own width
+ */
+static bool fits_select(ASTNode * node, CType * ctype) {
+    if (!node->ctype) return false;
+    if (is_floating_point_type(ctype)) return node->ctype->kind == ctype->kind;
+    return (is_integer_type(node->ctype) || is_pointer_type(node->ctype)) && node->ctype->size == ctype->size;
+}
+
+static void select_leaf(EmitterContext * ctx, ASTNode * node, Address * address) {
+    if (is_floating_point_type(node->ctype)) {
+        select_fp_leaf(ctx, node, address);
+    } else {
+        select_address(ctx, node, address);
+    }
+}
+
+static void emit_arm_to_register(EmitterContext * ctx, ASTNode * arm, CType * ctype, const char * reg) {
+    if (is_floating_point_type(ctype)) {
+        emit_fp_operand(ctx, arm);
+        emit_line(ctx, "%s %s, xmm0", ctype->kind == CTYPE_FLOAT ? "movd" : "movq", reg);
+    } else {
+        emit_int_operand(ctx, arm);
+        emit_line(ctx, "mov %s, %s", reg, ctype->size == 8 ? "rax" : "eax");
+    }
+}
+
+/* else arm in the result register, then cmovcc of the then arm over it.
+ * floats and doubles travel through rax as their bits.
+ */
+static bool emit_cmov_select(EmitterContext * ctx, ASTNode * node) {
+    CType * ctype = node->ctype;
+    ASTNode * then_arm = node->cond_expr.then_expr;
+    ASTNode * else_arm = node->cond_expr.else_expr;
+    bool negated;
+    ASTNode * test = flag_test(node->cond_expr.cond, &negated);
+    const char * condition_code = select_condition_code(test, negated);
+    if (!condition_code || (ctype->size != 4 && ctype->size != 8)) return false;
+
+    bool then_leaf = is_select_leaf(then_arm, ctype);
+    bool else_leaf = is_select_leaf(else_arm, ctype);
+    if ((!then_leaf && !fits_select(then_arm, ctype)) || (!else_leaf && !fits_select(else_arm, ctype))) return false;
+    if (add_cost(speculation_cost(then_arm), speculation_cost(else_arm)) > SELECT_BUDGET) return false;
+    // arms computed ahead of the condition must not miss its side effects
+    if ((!then_leaf || !else_leaf) && speculation_cost(node->cond_expr.cond) >= NOT_SPECULABLE) return false;
+
+    const SelectRegisters * regs = ctype->size == 8 ? &QWORD_SELECT : &DWORD_SELECT;
+    Address address;
+    long constant;
+
+    emit_line(ctx, "; emitting branchless select");
+    if (!then_leaf) emit_arm_to_register(ctx, then_arm, ctype, regs->then);
+    if (!else_leaf) emit_arm_to_register(ctx, else_arm, ctype, regs->other);
+    emit_select_flags(ctx, test);
+
+    if (!else_leaf) {
+        emit_line(ctx, "mov %s, %s", regs->result, regs->other);
+    } else if (!is_floating_point_type(ctype) && literal_value(else_arm, &constant)) {
+        emit_line(ctx, "mov %s, %ld", regs->result, constant);
+    } else {
+        select_leaf(ctx, else_arm, &address);
+        emit_line(ctx, "mov %s, %s", regs->result, operand_text(&address, ctype));
+    }
+
+    // cmov takes no immediate
+    if (!then_leaf) {
+        emit_line(ctx, "cmov%s %s, %s", condition_code, regs->result, regs->then);
+    } else if (!is_floating_point_type(ctype) && literal_value(then_arm, &constant)) {
+        emit_line(ctx, "mov %s, %ld", regs->then, constant);
+        emit_line(ctx, "cmov%s %s, %s", condition_code, regs->result, regs->then);
+    } else {
+        select_leaf(ctx, then_arm, &address);
+        emit_line(ctx, "cmov%s %s, %s", condition_code, regs->result, operand_text(&address, ctype));
+    }
+
+    if (is_floating_point_type(ctype)) {
+        emit_line(ctx, "%s xmm0, %s", ctype->kind == CTYPE_FLOAT ? "movd" : "movq", regs->result);
+    }
+    return true;
+}
+
+static bool same_leaf(ASTNode * a, ASTNode * b) {
+    if (a->type == AST_FLOAT_LITERAL && b->type == AST_FLOAT_LITERAL) {
+        return a->float_literal.value == b->float_literal.value;
+    }
+    if (a->type == AST_DOUBLE_LITERAL && b->type == AST_DOUBLE_LITERAL) {
+        return a->double_literal.value == b->double_literal.value;
+    }
+    return same_lvalue(a, b);
+}
+
+/* minsd d, s is d < s ? d : s and maxsd d, s is d > s ? d : s, giving s
+ * when the operands are unordered or equal. a < b ? a : b and the other
+ * strict arrangements match exactly; <= and >= differ only in the sign of
+ * a zero result, so they need --fast-math.
+ */
+static bool emit_min_max_select(EmitterContext * ctx, ASTNode * node) {
+    CType * ctype = node->ctype;
+    ASTNode * cond = node->cond_expr.cond;
+    if (!is_comparison(cond) || cond->binary.common_type->kind != ctype->kind) return false;
+
+    BinaryOperator op = cond->binary.op;
+    bool fast_math = get_compiler_options()->fast_math;
+    bool less = op == BINOP_LT || (fast_math && op == BINOP_LE);
+    bool greater = op == BINOP_GT || (fast_math && op == BINOP_GE);
+    ASTNode * lhs = cond->binary.lhs;
+    ASTNode * rhs = cond->binary.rhs;
+    if ((!less && !greater) || !is_select_leaf(lhs, ctype) || !is_select_leaf(rhs, ctype)) return false;
+
+    ASTNode * first;
+    ASTNode * second;
+    bool minimum;
+    if (same_leaf(node->cond_expr.then_expr, lhs) && same_leaf(node->cond_expr.else_expr, rhs)) {
+        first = lhs;
+        second = rhs;
+        minimum = less;
+    } else if (same_leaf(node->cond_expr.then_expr, rhs) && same_leaf(node->cond_expr.else_expr, lhs)) {
+        first = rhs;
+        second = lhs;
+        minimum = greater;
+    } else {
+        return false;
+    }
+
+    Address address;
+    emit_line(ctx, "; emitting branchless select");
+    emit_fp_operand(ctx, first);
+    select_fp_leaf(ctx, second, &address);
+    emit_line(ctx, "%s%s xmm0, %s", minimum ? "min" : "max", ctype->kind == CTYPE_FLOAT ? "ss" : "sd",
+              operand_text(&address, ctype));
+    return true;
+}
+
+/* the cmpss or cmpsd predicate for op, which has no > or >=; those
+ * compare the operands the other way round
+ */
+static const char * mask_predicate(BinaryOperator op, bool negated, bool * swapped) {
+    *swapped = op == BINOP_GT || op == BINOP_GE;
+    switch (op) {
+        case BINOP_EQ: return negated ? "neq" : "eq";
+        case BINOP_NE: return negated ? "eq" : "neq";
+        case BINOP_LT:
+        case BINOP_GT:
+            return negated ? "nlt" : "lt";
+        default:
+            return negated ? "nle" : "le";
+    }
+}
+
+static void emit_fp_arm_to_register(EmitterContext * ctx, ASTNode * arm, CType * ctype, const char * reg) {
+    if (is_select_leaf(arm, ctype)) {
+        Address address;
+        select_fp_leaf(ctx, arm, &address);
+        emit_line(ctx, "%s %s, %s", mov_instruction_for_type(ctype), reg, operand_text(&address, ctype));
+    } else {
+        emit_fp_operand(ctx, arm);
+        emit_line(ctx, "movaps %s, xmm0", reg);
+    }
+}
+
+/* a float comparison of the select's own type leaves an all ones or all
+ * zeros mask in xmm0, which picks between the arms in xmm2 and xmm3 with
+ * and, andn and or. the arms are computed first, so the condition has to
+ * be free of side effects.
+ */
+static bool emit_mask_select(EmitterContext * ctx, ASTNode * node) {
+    CType * ctype = node->ctype;
+    ASTNode * then_arm = node->cond_expr.then_expr;
+    ASTNode * else_arm = node->cond_expr.else_expr;
+    bool negated;
+    ASTNode * test = flag_test(node->cond_expr.cond, &negated);
+    if (!is_comparison(test) || test->binary.common_type->kind != ctype->kind) return false;
+    if (!fits_select(then_arm, ctype) || !fits_select(else_arm, ctype)) return false;
+    if (add_cost(speculation_cost(then_arm), speculation_cost(else_arm)) > SELECT_BUDGET) return false;
+    if (speculation_cost(test) >= NOT_SPECULABLE) return false;
+
+    bool swapped;
+    const char * predicate = mask_predicate(test->binary.op, negated, &swapped);
+    const char * scalar = ctype->kind == CTYPE_FLOAT ? "ss" : "sd";
+    const char * packed = ctype->kind == CTYPE_FLOAT ? "ps" : "pd";
+    ASTNode * first = swapped ? test->binary.rhs : test->binary.lhs;
+    ASTNode * second = swapped ? test->binary.lhs : test->binary.rhs;
+
+    emit_line(ctx, "; emitting branchless select");
+    emit_fp_arm_to_register(ctx, then_arm, ctype, "xmm2");
+    emit_fp_arm_to_register(ctx, else_arm, ctype, "xmm3");
+    if (is_select_leaf(second, ctype)) {
+        Address address;
+        emit_fp_operand(ctx, first);
+        select_fp_leaf(ctx, second, &address);
+        emit_line(ctx, "cmp%s%s xmm0, %s", predicate, scalar, operand_text(&address, ctype));
+    } else {
+        emit_fp_operand(ctx, second);
+        emit_line(ctx, "movaps xmm4, xmm0");
+        emit_fp_operand(ctx, first);
+        emit_line(ctx, "cmp%s%s xmm0, xmm4", predicate, scalar);
+    }
+    emit_line(ctx, "and%s xmm2, xmm0", packed);
+    emit_line(ctx, "andn%s xmm0, xmm3", packed);
+    emit_line(ctx, "or%s xmm0, xmm2", packed);
+    return true;
+}
+
+bool emit_branchless_select(EmitterContext * ctx, ASTNode * node) {
+    CType * ctype = node->ctype;
+    if (!optimizations_enabled() || !get_compiler_options()->branchless || !ctype) return false;
+
+    bool emitted = false;
+    if (is_floating_point_type(ctype)) {
+        emitted = emit_min_max_select(ctx, node) || emit_mask_select(ctx, node) || emit_cmov_select(ctx, node);
+    } else if (is_integer_type(ctype) || is_pointer_type(ctype)) {
+        emitted = emit_cmov_select(ctx, node);
+    }
+    if (emitted) {
+        get_compile_stats()->branchless_selects++;
+    }
+    return emitted;
+}
+
+/* the assignment a statement is made of, looking through braces */
+static ASTNode * single_assignment(ASTNode * stmt) {
+    while (stmt->type == AST_BLOCK_STMT && stmt->block.statements->count == 1) {
+        stmt = stmt->block.statements->head->value;
+    }
+    if (stmt->type != AST_EXPRESSION_STMT) return NULL;
+    ASTNode * expr = stmt->expr_stmt.expr;
+    if (!expr || expr->type != AST_BINARY_EXPR || expr->binary.op != BINOP_ASSIGNMENT) return NULL;
+    return expr;
+}
+
+bool emit_branchless_if(EmitterContext * ctx, ASTNode * node) {
+    ASTNode * then_assignment = single_assignment(node->if_stmt.then_stmt);
+    ASTNode * else_assignment = node->if_stmt.else_stmt ? single_assignment(node->if_stmt.else_stmt) : NULL;
+    if (!then_assignment || (node->if_stmt.else_stmt && !else_assignment)) return false;
+
+    // without an else, x keeps its value, so storing it back is harmless
+    ASTNode * target = then_assignment->binary.lhs;
+    if (!has_direct_address(target) || !is_scalar_type(target->ctype)) return false;
+    if (else_assignment && !same_lvalue(target, else_assignment->binary.lhs)) return false;
+
+    ASTNode select;
+    memset(&select, 0, sizeof select);
+    select.type = AST_COND_EXPR;
+    select.ctype = target->ctype;
+    select.cond_expr.cond = node->if_stmt.cond;
+    select.cond_expr.then_expr = then_assignment->binary.rhs;
+    select.cond_expr.else_expr = else_assignment ? else_assignment->binary.rhs : target;
+    if (!emit_branchless_select(ctx, &select)) return false;
+
+    CType * ctype = target->ctype;
+    const char * reg = is_floating_point_type(ctype) ? "xmm0" : ctype->size == 8 ? "rax" : "eax";
+    Address address;
+    select_address(ctx, target, &address);
+    emit_line(ctx, "%s %s, %s", mov_instruction_for_type(ctype), operand_text(&address, ctype), reg);
+    return true;
+}
@@ -2,65 +2,148 @@
 // Created by scott on 10/12/25.
 //
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
 #include "emitter_context.h"
 #include "ast.h"
 #include "emitter.h"
 #include "emit_expression.h"
 #include "emit_condition.h"
+#include "emit_select.h"
 
 #include "emitter_helpers.h"
 #include "emit_stack.h"
+#include "compiler_options.h"
 #include "error.h"
 
-void branch_on_truth_intptr(EmitterContext * ctx, int ltrue, int lfalse) {
-    emit_line(ctx, "test rax, rax");
-    emit_jump(ctx, "jne", "Lcond", ltrue);
-    emit_jump(ctx, "jmp", "Lcond", lfalse);
+bool is_comparison(ASTNode * node) {
+    if (node->type != AST_BINARY_EXPR) return false;
+    switch (node->binary.op) {
+        case BINOP_EQ:
+        case BINOP_NE:
+        case BINOP_GT:
+        case BINOP_GE:
+        case BINOP_LT:
+        case BINOP_LE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+BinaryOperator negated_comparison(BinaryOperator op) {
+    switch (op) {
+        case BINOP_EQ: return BINOP_NE;
+        case BINOP_NE: return BINOP_EQ;
+        case BINOP_LT: return BINOP_GE;
+        case BINOP_LE: return BINOP_GT;
+        case BINOP_GT: return BINOP_LE;
+        case BINOP_GE: return BINOP_LT;
+        default:
+            error("Unsupported comparison operator %d", op);
+            return op;
+    }
+}
+
+const char * int_condition_code(BinaryOperator op, bool is_signed) {
+    switch (op) {
+        case BINOP_EQ: return "e";
+        case BINOP_NE: return "ne";
+        case BINOP_LT: return is_signed ? "l" : "b";
+        case BINOP_LE: return is_signed ? "le" : "be";
+        case BINOP_GT: return is_signed ? "g" : "a";
+        case BINOP_GE: return is_signed ? "ge" : "ae";
+        default:
+            error("Unsupported comparison operator %d", op);
+            return NULL;
+    }
+}
+
+static void emit_int_compare_and_branch(EmitterContext * ctx, ASTNode * node, const char * target, bool jump_if) {
+    CType * ctype = node->binary.common_type;
+    BinaryOperator op = jump_if ? node->binary.op : negated_comparison(node->binary.op);
+    char jump[8];
+    snprintf(jump, sizeof jump, "j%s", int_condition_code(op, is_signed_integer_type(ctype) || is_pointer_type(ctype)));
+    emit_comparison_flags(ctx, node, false);
+    emit_jump_from_text(ctx, jump, target);
 }
 
-void emit_condition(EmitterContext * ctx, ASTNode * node, int ltrue, int lfalse, EvalMode mode) {
-    switch (node->type) {
-        case AST_UNARY_EXPR: {
-            if (node->unary.op == UNARY_LOGICAL_NOT) {
-                emit_condition(ctx, node->unary.operand, lfalse, ltrue, mode);
-                return;
-            }
+/* ucomiss and ucomisd set ZF, PF and CF all at once for unordered operands.
+ * a < b and a <= b are tested as b > a and b >= a with ja and jae, which
+ * are not taken then. == and != look at the parity flag as well.
+ */
+static void emit_fp_compare_and_branch(EmitterContext * ctx, ASTNode * node, const char * target, bool jump_if) {
+    BinaryOperator op = node->binary.op;
+    bool swapped = op == BINOP_LT || op == BINOP_LE;
+    emit_comparison_flags(ctx, node, swapped);
+
+    switch (op) {
+        case BINOP_GT:
+        case BINOP_LT:
+            emit_jump_from_text(ctx, jump_if ? "ja" : "jbe", target);
+            return;
+        case BINOP_GE:
+        case BINOP_LE:
+            emit_jump_from_text(ctx, jump_if ? "jae" : "jb", target);
+            return;
+        default:
+            break;
+    }
+    // unordered operands are unequal
+    if (jump_if == (op == BINOP_NE)) {
+        emit_jump_from_text(ctx, "jp", target);
+        emit_jump_from_text(ctx, "jne", target);
+    } else {
+        char * unordered_label = make_label_text("unordered", get_label_id(ctx));
+        emit_jump_from_text(ctx, "jp", unordered_label);
+        emit_jump_from_text(ctx, "je", target);
+        emit_label_from_text(ctx, unordered_label);
+        free(unordered_label);
+    }
+}
+
+/* evaluates a condition for control flow only. jumps to target when the
+ * condition's truth equals jump_if and falls through otherwise, so the caller
+ * decides which path follows the test. && and || short circuit with one
+ * conditional jump per operand.
+ */
+void emit_branch(EmitterContext * ctx, ASTNode * node, const char * target, bool jump_if) {
+    if (node->type == AST_UNARY_EXPR && node->unary.op == UNARY_LOGICAL_NOT) {
+        emit_branch(ctx, node->unary.operand, target, !jump_if);
+        return;
+    }
+    if (node->type == AST_BINARY_EXPR &&
+        (node->binary.op == BINOP_LOGICAL_AND || node->binary.op == BINOP_LOGICAL_OR)) {
+        // a && b is false as soon as a is, a || b is true as soon as a is
+        bool decides = node->binary.op == BINOP_LOGICAL_OR;
+        if (jump_if == decides) {
+            emit_branch(ctx, node->binary.lhs, target, jump_if);
+            emit_branch(ctx, node->binary.rhs, target, jump_if);
+        } else {
+            char * skip_label = make_label_text("cond_skip", get_label_id(ctx));
+            emit_branch(ctx, node->binary.lhs, skip_label, decides);
+            emit_branch(ctx, node->binary.rhs, target, jump_if);
+            emit_label_from_text(ctx, skip_label);
+            free(skip_label);
         }
-        case AST_BINARY_EXPR: {
-            switch (node->binary.op) {
-                case BINOP_LOGICAL_AND: {
-                    int lmid = get_label_id(ctx);
-                    emit_condition(ctx, node->binary.lhs, lmid, lfalse, mode);
-                    emit_label(ctx, "Lcond", lmid);
-                    emit_condition(ctx, node->binary.rhs, ltrue, lfalse, mode);
-                    return;
-                }
-                case BINOP_LOGICAL_OR: {
-                    int lmid = get_label_id(ctx);
-                    emit_condition(ctx, node->binary.lhs, ltrue, lmid, mode);
-                    emit_label(ctx, "Lcond", lmid);
-                    emit_condition(ctx, node->binary.rhs, ltrue, lfalse, mode);
-                    return;
-                }
-                case BINOP_EQ:
-                case BINOP_NE:
-                case BINOP_GT:
-                case BINOP_GE:
-                case BINOP_LT:
-                case BINOP_LE: {
-                    emit_expr_to_reg(ctx, node, WANT_VALUE);
-                    emit_pop(ctx, "rax");
-                    branch_on_truth_intptr(ctx, ltrue, lfalse);
-                    return;
-                }
-            }
-            default: {
-                emit_expr_to_reg(ctx, node, WANT_VALUE);
-                emit_pop(ctx, "rax");
-                branch_on_truth_intptr(ctx, ltrue, lfalse);
+        return;
+    }
 
-                return;
-            }
+    // comparisons set the flags the branch tests, without a 0 or 1 in between
+    if (optimizations_enabled() && is_comparison(node)) {
+        if (is_floating_point_type(node->binary.common_type)) {
+            emit_fp_compare_and_branch(ctx, node, target, jump_if);
+        } else {
+            emit_int_compare_and_branch(ctx, node, target, jump_if);
         }
+        return;
+    }
+    if (!emit_int_test_tile(ctx, node)) {
+        emit_int_expr_to_rax(ctx, node, WANT_VALUE);
+        emit_pop(ctx, "rax");
+        emit_line(ctx, "test eax, eax");
     }
+    emit_jump_from_text(ctx, jump_if ? "jne" : "je", target);
 }
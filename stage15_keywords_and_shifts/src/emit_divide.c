@@ -0,0 +1,169 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "emit_stack.h"
+#include "emit_select.h"
+#include "compile_stats.h"
+#include "compiler_options.h"
+#include "emit_divide.h"
+
+typedef struct DivisionRegisters {
+    int bits;
+    const char * a;         // dividend, then result
+    const char * c;
+    const char * d;
+} DivisionRegisters;
+
+static const DivisionRegisters DWORD_DIVISION = { 32, "eax", "ecx", "edx" };
+static const DivisionRegisters QWORD_DIVISION = { 64, "rax", "rcx", "rdx" };
+
+DivisionMagic signed_division_magic(uint64_t divisor, int bits) {
+    uint64_t mask = bits == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << bits) - 1;
+    uint64_t two_w1 = (uint64_t) 1 << (bits - 1);
+    uint64_t anc = two_w1 - 1 - two_w1 % divisor;     // largest dividend with remainder divisor - 1
+    uint64_t q1 = two_w1 / anc;
+    uint64_t r1 = two_w1 - q1 * anc;
+    uint64_t q2 = two_w1 / divisor;
+    uint64_t r2 = two_w1 - q2 * divisor;
+    uint64_t delta;
+    int p = bits - 1;
+
+    // smallest p for which 2^p / divisor, rounded up, is close enough
+    do {
+        p++;
+        q1 = (q1 * 2) & mask;
+        r1 = (r1 * 2) & mask;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 = (q2 * 2) & mask;
+        r2 = (r2 * 2) & mask;
+        if (r2 >= divisor) {
+            q2++;
+            r2 -= divisor;
+        }
+        delta = divisor - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    DivisionMagic magic = { (q2 + 1) & mask, p - bits };
+    return magic;
+}
+
+static int log2_of_power(uint64_t value) {
+    if (value & (value - 1)) return -1;
+    int shift = 0;
+    while (value > 1) {
+        value >>= 1;
+        shift++;
+    }
+    return shift;
+}
+
+/* a literal, or a negated literal, possibly widened as in (long) -2 */
+static bool constant_divisor(ASTNode * node, long * value) {
+    if (literal_value(node, value)) return true;
+    if (node->type == AST_CAST_EXPR && is_integer_type(node->ctype) &&
+        is_integer_type(node->cast_expr.expr->ctype) && node->ctype->size >= node->cast_expr.expr->ctype->size) {
+        return constant_divisor(node->cast_expr.expr, value);
+    }
+    if (node->type == AST_UNARY_EXPR && node->unary.op == UNARY_NEGATE && literal_value(node->unary.operand, value)) {
+        *value = -*value;
+        return true;
+    }
+    return false;
+}
+
+/* 2^k - 1 in d when the dividend is negative and 0 otherwise, so that
+ * shifting the biased dividend rounds toward zero
+ */
+static void emit_rounding_bias(EmitterContext * ctx, const DivisionRegisters * regs, int k) {
+    emit_line(ctx, "mov %s, %s", regs->d, regs->a);
+    if (k > 1) {
+        emit_line(ctx, "sar %s, %d", regs->d, regs->bits - 1);
+    }
+    emit_line(ctx, "shr %s, %d", regs->d, regs->bits - k);
+}
+
+static void emit_power_of_two_division(EmitterContext * ctx, const DivisionRegisters * regs, int k, bool remainder) {
+    emit_rounding_bias(ctx, regs, k);
+    if (remainder) {
+        // x - ((x + bias) & -2^k)
+        emit_line(ctx, "add %s, %s", regs->d, regs->a);
+        emit_line(ctx, "and %s, %ld", regs->d, -(1L << k));
+        emit_line(ctx, "sub %s, %s", regs->a, regs->d);
+    } else {
+        emit_line(ctx, "add %s, %s", regs->a, regs->d);
+        emit_line(ctx, "sar %s, %d", regs->a, k);
+    }
+}
+
+/* the high half of x * multiplier, shifted, plus one when it is negative.
+ * x stays in c for the remainder.
+ */
+static void emit_magic_division(EmitterContext * ctx, const DivisionRegisters * regs, uint64_t divisor, bool remainder) {
+    DivisionMagic magic = signed_division_magic(divisor, regs->bits);
+    long multiplier = regs->bits == 64 ? (long) (int64_t) magic.multiplier : (long) (int32_t) magic.multiplier;
+
+    emit_line(ctx, "mov %s, %s", regs->c, regs->a);
+    emit_line(ctx, "mov %s, %ld", regs->a, multiplier);
+    emit_line(ctx, "imul %s", regs->c);
+    if (multiplier < 0) {
+        emit_line(ctx, "add %s, %s", regs->d, regs->c);
+    }
+    if (magic.shift > 0) {
+        emit_line(ctx, "sar %s, %d", regs->d, magic.shift);
+    }
+    emit_line(ctx, "mov %s, %s", regs->a, regs->d);
+    emit_line(ctx, "shr %s, %d", regs->a, regs->bits - 1);
+    emit_line(ctx, "add %s, %s", regs->a, regs->d);
+
+    if (remainder) {
+        emit_line(ctx, "imul %s, %s, %lu", regs->a, regs->a, divisor);
+        emit_line(ctx, "sub %s, %s", regs->c, regs->a);
+        emit_line(ctx, "mov %s, %s", regs->a, regs->c);
+    }
+}
+
+bool emit_int_divide_by_constant(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    CType * ctype = node->ctype;
+    ASTNode * lhs = node->binary.lhs;
+    long divisor;
+    if (!optimizations_enabled()) return false;
+    if (!ctype || (ctype->kind != CTYPE_INT && ctype->kind != CTYPE_LONG) || !ctype->is_signed) return false;
+    if (!is_integer_type(lhs->ctype) || !constant_divisor(node->binary.rhs, &divisor) || divisor == 0) return false;
+
+    const DivisionRegisters * regs = ctype->size == 8 ? &QWORD_DIVISION : &DWORD_DIVISION;
+    bool remainder = node->binary.op == BINOP_MOD;
+    // the sign of a remainder follows the dividend, so only quotients care about the divisor's
+    uint64_t magnitude = divisor < 0 ? -(uint64_t) divisor : (uint64_t) divisor;
+    if (regs->bits == 32) {
+        magnitude &= 0xffffffff;
+    }
+
+    emit_int_operand_extended(ctx, lhs, regs->bits / 8);
+
+    int k = log2_of_power(magnitude);
+    if (magnitude == 1) {
+        if (remainder) {
+            emit_line(ctx, "xor eax, eax");
+        }
+    } else if (k > 0) {
+        emit_power_of_two_division(ctx, regs, k, remainder);
+    } else {
+        emit_magic_division(ctx, regs, magnitude, remainder);
+    }
+    if (divisor < 0 && !remainder) {
+        emit_line(ctx, "neg %s", regs->a);
+    }
+    get_compile_stats()->constant_divisions_reduced++;
+
+    if (mode == WANT_VALUE) {
+        emit_push(ctx, "rax");
+    }
+    return true;
+}
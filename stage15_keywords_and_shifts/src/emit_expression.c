@@ -2,6 +2,8 @@
 // Created by scott on 8/9/25.
 //
 
+#include <stdlib.h>
+
 #include "internal.h"
 #include "ast.h"
 
@@ -12,6 +14,10 @@
 #include "emit_expression.h"
 #include "emit_condition.h"
 #include "emit_stack.h"
+#include "emit_select.h"
+#include "emit_divide.h"
+#include "emit_branchless.h"
+#include "emit_fp.h"
 
 #include "error.h"
 
@@ -28,7 +34,8 @@ INTERNAL void emit_function_call_expr(EmitterContext * ctx, ASTNode * node, Eval
         for (int i = node->function_call.arg_list->count - 1; i >= 0; i--) {
             ASTNode * argNode = ASTNode_list_get(node->function_call.arg_list, i);
             if (is_floating_point_type(argNode->ctype)) {
-                emit_fp_expr_to_xmm0(ctx, argNode, WANT_VALUE);
+                emit_fp_operand(ctx, argNode);
+                emit_fpush(ctx, "xmm0", getFPWidthFromCType(argNode->ctype));
                 stack_args_size += 16;
             }
             else {
@@ -72,228 +79,105 @@ INTERNAL void emit_function_call_expr(EmitterContext * ctx, ASTNode * node, Eval
 
 }
 
-INTERNAL void emit_cast_expr(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_line(ctx, "; emitting cast");
-    //emit_tree_node(ctx, node->cast_expr.expr);
-    emit_expr_to_reg(ctx, node->cast_expr.expr, mode);
-    if (node->ctype->kind == CTYPE_DOUBLE) {
-        switch (node->cast_expr.expr->ctype->kind) {
-            case CTYPE_FLOAT:
-                if (mode == WANT_VALUE) {
-                    emit_fpop(ctx, "xmm0", FP32);
-                }
-                emit_line(ctx, "cvtss2sd %s, %s", "xmm0", "xmm0    ; float -> double");
-                break;
-            case CTYPE_INT:
-                if (mode == WANT_VALUE) {
-                    emit_pop(ctx, "RAX");
-                }
-                emit_line(ctx, "cvtsi2sd %s, %s", "xmm0", "eax    ; int -> double");
-
-                break;
-            case CTYPE_LONG:
-                if (mode == WANT_VALUE) {
-                    emit_pop(ctx, "RAX");
-                }
-
-                emit_line(ctx, "cvtsi2sd %s, %s", "xmm0", "rax    ; long -> double");
-                break;
-            default: error("Unsupported cast expression type %d", node->type);
-        }
-        if (mode == WANT_VALUE) {
-            emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-        }
-    }
-    else if (node->ctype->kind == CTYPE_FLOAT) {
-        switch (node->cast_expr.expr->ctype->kind) {
-            case CTYPE_DOUBLE:
-                if (mode == WANT_VALUE) {
-                    emit_fpop(ctx, "xmm0", FP64);
-                }
-                emit_line(ctx, "cvtsd2ss %s, %s", "xmm0", "xmm0     ; double -> float"    );
-                break;
-            case CTYPE_INT:
-                if (mode == WANT_VALUE) {
-                    emit_pop(ctx, "rax");
-                }
-                emit_line(ctx, "cvtsi2ss %s, %s", "xmm0", "eax     ; int -> float");
-                break;
-            case CTYPE_LONG:
-                if (mode == WANT_VALUE) {
-                    emit_pop(ctx, "rax");
-                }
-                emit_line(ctx, "cvtsi2ss %s, %s", "xmm0", "rax    ; long -> float");
-                break;
-            default: error("Unsupported cast expression type %d", node->type);
-        }
-        if (mode == WANT_VALUE) {
-            emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-        }
-
-    }
-}
-
 INTERNAL void emit_int_cast_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
 
     if (is_floating_point_type(node->cast_expr.expr->ctype)) {
-        emit_fp_expr_to_xmm0(ctx, node->cast_expr.expr, mode);
-
-        if (mode == WANT_VALUE) {
-            emit_fpop(ctx, stack_reg_for_type(node->cast_expr.expr->ctype), getFPWidthFromCType(node->cast_expr.expr->ctype));
-        }
-
-        if (node->cast_expr.expr->ctype->kind == CTYPE_FLOAT) {
-            emit_line(ctx, "cvttss2si %s, %s", reg_for_type(node->ctype), reg_for_type(node->cast_expr.expr->ctype));
-        } else if (node->cast_expr.expr->ctype->kind == CTYPE_DOUBLE) {
-            emit_line(ctx, "cvttsd2si %s, %s", reg_for_type(node->ctype), reg_for_type(node->cast_expr.expr->ctype));
-        }
-        else {
-            error("Invalid Type");
+        ASTNode * inner = node->cast_expr.expr;
+        const char * convert = inner->ctype->kind == CTYPE_FLOAT ? "cvttss2si" : "cvttsd2si";
+        const char * reg = node->ctype->size == 8 ? "rax" : "eax";
+        if (has_direct_address(inner)) {
+            Address address;
+            select_address(ctx, inner, &address);
+            emit_line(ctx, "%s %s, %s", convert, reg, operand_text(&address, inner->ctype));
+        } else {
+            emit_fp_operand(ctx, inner);
+            emit_line(ctx, "%s %s, xmm0", convert, reg);
         }
-
         if (mode == WANT_VALUE) {
-            emit_push(ctx, stack_reg_for_type(node->ctype));
+            emit_push(ctx, "rax");
         }
         return;
     }
 
-    emit_int_expr_to_rax(ctx, node->cast_expr.expr, WANT_VALUE);     // eval inner expression
-
-    CType * from_type = node->cast_expr.expr->ctype;
+    ASTNode * inner = node->cast_expr.expr;
+    CType * from_type = inner->ctype;
     CType * to_type = node->cast_expr.target_ctype;
 
-    int from_size = from_type->size;
+    int from_size = is_array_type(from_type) ? 8 : from_type->size;
     int to_size = to_type->size;
 
-    bool from_signed = from_type->is_signed;
-    bool to_signed = to_type->is_signed;
-
-    if ((from_type->kind == CTYPE_PTR || from_type->kind == CTYPE_ARRAY) &&
-        (to_type->kind == CTYPE_PTR || to_type->kind == CTYPE_ARRAY)) {
-        // pointer to pointer or array to pointer: no-op in codegen
-        return;
-    }
-
-
-
     if (from_size == to_size) {
-        return;  // NOOP
-    }
-
-    // narrowing
-    if (from_size > to_size) {
-        //emit_line(ctx, "pop rax");
-        emit_pop(ctx, "rax");
-        switch (to_size) {
-            case 1: emit_line(ctx, "movsx eax, al"); break;
-            case 2: emit_line(ctx, "movsx eax, ax"); break;
-            case 4: emit_line(ctx, "mov eax, eax"); break;
-            default:
-                error("Unsupported narrowing cast to %d bytes", to_size);
-        }
-        if (mode == WANT_VALUE) {
-            emit_push(ctx, "rax");
-        }
+        // pointer to pointer, array to pointer, or the same bits read as another type
+        emit_int_expr_to_rax(ctx, inner, mode);
         return;
     }
 
-    // widening cast
-    if (from_size < to_size) {
-        emit_pop(ctx, "rax");
-
-        if (from_signed && to_signed) {
-            switch (from_size) {
+    if (from_size > to_size) {
+        // narrowing reads only the low bytes, straight from memory when it can
+        if (!emit_truncating_load(ctx, inner, to_type)) {
+            emit_int_operand(ctx, inner);
+            switch (to_size) {
                 case 1: emit_line(ctx, "movsx eax, al"); break;
                 case 2: emit_line(ctx, "movsx eax, ax"); break;
-                case 4: emit_line(ctx, "movsxd rax, eax"); break;
-                default:
-                    error("Unsupported sign-extension from %d bytes", from_size);
-            }
-        } else {
-            switch (from_size) {
-                case 1: emit_line(ctx, "movzx eax, al"); break;
-                case 2: emit_line(ctx, "movzx eax, ax"); break;
-                case 4: emit_line(ctx, "mov eax, eax"); break;
+                case 4: break;  // the upper half of an int is never read
                 default:
-                    error("Unsupported zero-extension from %d bytes", from_size);
+                    error("Unsupported narrowing cast to %d bytes", to_size);
             }
         }
-        if (mode == WANT_VALUE) {
-            emit_push(ctx, "rax");
-        }
+    } else {
+        // widening follows the signedness of the source, and is left out
+        // when the value is already extended that far
+        emit_int_operand_extended(ctx, inner, to_size);
+    }
+    if (mode == WANT_VALUE) {
+        emit_push(ctx, "rax");
     }
 }
 
 void emit_int_assignment_expr_to_rax(EmitterContext * ctx, ASTNode* node, EvalMode mode) {
     emit_line(ctx, "; emitting assignment - LHS %s = RHS %s",
         get_ast_node_name(node->binary.lhs), get_ast_node_name(node->binary.rhs));
-    // eval RHS -> rax then push
-    if (is_array_type(node->binary.rhs->ctype)) {
-        emit_addr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
-    }
-    else {
-        emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
+    // x = x op y updates x in place
+    if (emit_read_modify_write(ctx, node, mode)) {
+        return;
     }
-    //    emit_line(ctx, "push rax");
-
-    // eval LHS addr -> rcx
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_ADDRESS);
-
-    // pop LHS into rcx
-    //    emit_line(ctx, "pop rcx");
-    emit_pop(ctx, "rcx");
-
-    // pop RHS in rax
-    //    emit_line(ctx, "pop rax");
-    emit_pop(ctx, "rax");
-
-    CType * ctype = node->binary.lhs->ctype;
-
-    emit_line(ctx, "mov %s [rcx], %s",
-        mem_size_for_type(ctype),
-        reg_for_type(ctype));
-
+    emit_store_to_lvalue(ctx, node->binary.lhs, node->binary.rhs, mode);
 }
 
-INTERNAL void emit_int_ptr_add_expr_to_rax(EmitterContext * ctx, ASTNode* node, EvalMode mode) {
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-
-    //    emit_line(ctx, "pop rcx");                      // pop rhs to RCX
-    //    emit_line(ctx, "pop rax");                      // pop lhs to RAX
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
-
+/* p + i and i + p. the integer is widened and scaled by the element
+ * size, folded into lea when the size is 1, 2, 4 or 8.
+ */
+INTERNAL void emit_int_ptr_offset_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
     CType *lhs_type = node->binary.lhs->ctype;
-    CType *rhs_type = node->binary.rhs->ctype;
+    bool pointer_lhs = is_pointer_type(lhs_type) || is_array_type(lhs_type);
+    ASTNode * pointer = pointer_lhs ? node->binary.lhs : node->binary.rhs;
+    ASTNode * offset = pointer_lhs ? node->binary.rhs : node->binary.lhs;
 
-    if (lhs_type->kind == CTYPE_PTR && is_integer_type(rhs_type)) {
-        int elem_size = sizeof_type(lhs_type->base_type);
-        emit_line(ctx, "imul rcx, %d", elem_size);
-        emit_line(ctx, "add rax, rcx");
+    if (!is_integer_type(offset->ctype)) {
+        error("Unsupported types for binary pointer add operation");
     }
-    else if (is_integer_type(lhs_type) && rhs_type->kind == CTYPE_PTR) {
-        int elem_size = sizeof_type(rhs_type->base_type);
-        emit_line(ctx, "imul rax, %d", elem_size);
+    emit_operands_extended(ctx, pointer, offset, 8);
+
+    int elem_size = pointer->ctype->base_type->size;
+    if (node->binary.op == BINOP_SUB) {
+        emit_line(ctx, "imul rcx, rcx, %d", elem_size);
+        emit_line(ctx, "sub rax, rcx");
+    } else if (elem_size == 1 || elem_size == 2 || elem_size == 4 || elem_size == 8) {
+        emit_line(ctx, "lea rax, [rax+rcx*%d]", elem_size);
+    } else {
+        emit_line(ctx, "imul rcx, rcx, %d", elem_size);
         emit_line(ctx, "add rax, rcx");
     }
-    else {
-        error("Unsupported types for binary pointer add operation");
-    }
     if (mode == WANT_VALUE) {
         emit_push(ctx, "rax");
     }
 }
 
 INTERNAL void emit_int_add_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-
-//    emit_line(ctx, "pop rcx");                      // pop rhs to RCX
-//    emit_line(ctx, "pop rax");                      // pop lhs to RAX
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
-
+    if (emit_int_binary_tile(ctx, node, mode)) {
+        return;
+    }
+    emit_operands_extended(ctx, node->binary.lhs, node->binary.rhs, node->ctype->size);
 
     CType *lhs_type = node->binary.lhs->ctype;
     CType *rhs_type = node->binary.rhs->ctype;
@@ -310,24 +194,8 @@ INTERNAL void emit_int_add_expr_to_rax(EmitterContext * ctx, ASTNode * node, Eva
     // }
     //else
     if (is_integer_type(lhs_type) && is_integer_type(rhs_type)) {
-        emit_line(ctx, "; lhs in rax, rhs in rcx");
-        if (lhs_type->kind == CTYPE_CHAR) {
-            emit_line(ctx, "movsx rax, al");
-        } else if (lhs_type->kind == CTYPE_SHORT) {
-            emit_line(ctx, "movsx rax, ax");
-        } else if (lhs_type->kind == CTYPE_INT) {
-            emit_line(ctx, "movsxd rax, eax");
-        }
-
-        if (rhs_type->kind == CTYPE_CHAR) {
-            emit_line(ctx, "movsx rcx, cl");
-        } else if (rhs_type->kind == CTYPE_SHORT) {
-            emit_line(ctx, "movsx rcx, cx");
-        } else if (rhs_type->kind == CTYPE_INT) {
-            emit_line(ctx, "movsxd rcx, ecx");
-        }
-
-        emit_line(ctx, "add rax, rcx");
+        emit_line(ctx, "; lhs in rax, rhs in rcx, extended to the result");
+        emit_line(ctx, node->ctype->size == 8 ? "add rax, rcx" : "add eax, ecx");
     }
     else {
         error("Unsupported types for binary add operation");
@@ -342,47 +210,21 @@ INTERNAL void emit_int_add_expr_to_rax(EmitterContext * ctx, ASTNode * node, Eva
 }
 
 INTERNAL void emit_int_sub_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-
-    // emit_line(ctx, "pop rcx");                      // pop rhs to RCX
-    // emit_line(ctx, "pop rax");                      // pop lhs to RAX
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
-
-
     CType *lhs_type = node->binary.lhs->ctype;
     CType *rhs_type = node->binary.rhs->ctype;
 
-    if (lhs_type->kind == CTYPE_PTR && is_integer_type(rhs_type)) {
-        int elem_size = sizeof_type(lhs_type);
-        emit_line(ctx, "imul rcx, %d", elem_size);
-        emit_line(ctx, "add rax, rcx");
+    if ((is_pointer_type(lhs_type) || is_array_type(lhs_type)) && is_integer_type(rhs_type)) {
+        emit_int_ptr_offset_expr_to_rax(ctx, node, mode);
+        return;
     }
-    else if (is_integer_type(lhs_type) && rhs_type->kind == CTYPE_PTR) {
-        int elem_size = sizeof_type(rhs_type);
-        emit_line(ctx, "imul rax, %d", elem_size);
-        emit_line(ctx, "add rax, rcx");
+    if (emit_int_binary_tile(ctx, node, mode)) {
+        return;
     }
-    else if (is_integer_type(lhs_type) && is_integer_type(rhs_type)) {
-        emit_line(ctx, "; lhs in rax, rhs in rcx");
-        if (lhs_type->kind == CTYPE_CHAR) {
-            emit_line(ctx, "movsx rax, al");
-        } else if (lhs_type->kind == CTYPE_SHORT) {
-            emit_line(ctx, "movsx rax, ax");
-        } else if (lhs_type->kind == CTYPE_INT) {
-            emit_line(ctx, "movsxd rax, eax");
-        }
-
-        if (rhs_type->kind == CTYPE_CHAR) {
-            emit_line(ctx, "movsx rcx, cl");
-        } else if (rhs_type->kind == CTYPE_SHORT) {
-            emit_line(ctx, "movsx rcx, cx");
-        } else if (rhs_type->kind == CTYPE_INT) {
-            emit_line(ctx, "movsxd rcx, ecx");
-        }
+    emit_operands_extended(ctx, node->binary.lhs, node->binary.rhs, node->ctype->size);
 
-        emit_line(ctx, "sub rax, rcx");
+    if (is_integer_type(lhs_type) && is_integer_type(rhs_type)) {
+        emit_line(ctx, "; lhs in rax, rhs in rcx, extended to the result");
+        emit_line(ctx, node->ctype->size == 8 ? "sub rax, rcx" : "sub eax, ecx");
     }
     else {
         error("Unsupported types for binary add operation");
@@ -398,283 +240,125 @@ INTERNAL void emit_int_sub_expr_to_rax(EmitterContext * ctx, ASTNode * node, Eva
 
 
 INTERNAL void emit_int_multi_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
-
-    emit_binary_op(ctx, node->binary.op);        // emit proper for op
+    if (emit_int_binary_tile(ctx, node, mode)) {
+        return;
+    }
+    emit_operands_extended(ctx, node->binary.lhs, node->binary.rhs, node->ctype->size);
+    emit_line(ctx, node->ctype->size == 8 ? "imul rax, rcx" : "imul eax, ecx");
 
     if (mode == WANT_VALUE) {
         emit_push(ctx, "rax");
     }
 }
 
+/* idiv at the width of the result. long division extends int operands
+ * first, loading them with movsxd where it can.
+ */
+INTERNAL void emit_int_idiv(EmitterContext * ctx, ASTNode * node) {
+    emit_operands_extended(ctx, node->binary.lhs, node->binary.rhs, node->ctype->size);
+
+    if (node->ctype->size == 8) {
+        emit_line(ctx, "cqo");
+        emit_line(ctx, "idiv rcx");
+    } else {
+        emit_line(ctx, "cdq");
+        emit_line(ctx, "idiv ecx");
+    }
+}
+
 void emit_int_div_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-    // emit_line(ctx, "pop rcx");           // pop rhs to rCX
-    // emit_line(ctx, "pop rax");           // pop lhs to rax
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
-
-
-    // emit_line(ctx, "mov ecx, eax");                 // move denominator to ecx
-    // emit_line(ctx, "pop rax");                      // restore numerator to eax
-    emit_line(ctx, "cdq");
-    emit_line(ctx, "idiv ecx");
-    //    emit_line(ctx, "push rax");
+    if (emit_int_divide_by_constant(ctx, node, mode)) {
+        return;
+    }
+    emit_int_idiv(ctx, node);
     if (mode == WANT_VALUE) {
         emit_push(ctx, "rax");
     }
-
-
 }
 
 INTERNAL void emit_int_mod_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-    // emit_line(ctx, "pop rcx");           // pop rhs to rCX
-    // emit_line(ctx, "pop rax");           // pop lhs to rax
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
-
-    emit_line(ctx, "cdq");
-    emit_line(ctx, "idiv ecx");               // divide eax by ecx. result goes to eax, remainder to edx
-    emit_line(ctx, "mov eax, edx");           // move remainer in edx to eax
-
-    //    emit_line(ctx, "push rax");
+    if (emit_int_divide_by_constant(ctx, node, mode)) {
+        return;
+    }
+    emit_int_idiv(ctx, node);
+    emit_line(ctx, node->ctype->size == 8 ? "mov rax, rdx" : "mov eax, edx");      // remainder is left in rdx
     if (mode == WANT_VALUE) {
         emit_push(ctx, "rax");
     }
-
 }
 
-INTERNAL void emit_int_logical_and_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    int label_true = get_label_id(ctx);
-    int label_false = get_label_id(ctx);
-    int label_end = get_label_id(ctx);
-
-    emit_condition(ctx, node, label_true, label_false, mode);
+/* a && b and a || b as 0 or 1. the operands branch as they would in an
+ * if, so they short circuit without materializing their own values.
+ */
+INTERNAL void emit_int_logical_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    int id = get_label_id(ctx);
+    char * false_label = make_label_text("logical_false", id);
+    char * end_label = make_label_text("logical_end", id);
 
-    emit_label(ctx, "Lcond", label_true);
+    emit_branch(ctx, node, false_label, false);
     emit_line(ctx, "mov eax, 1");
-    emit_jump(ctx, "jmp", "Lcond", label_end);
-
-    emit_label(ctx, "Lcond", label_false);
+    emit_jump_from_text(ctx, "jmp", end_label);
+    emit_label_from_text(ctx, false_label);
     emit_line(ctx, "xor eax, eax");
-
-    emit_label(ctx, "Lcond", label_end);
-
-    // //lhs
-    // emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);
-    // emit_pop(ctx, "rax");
-    // emit_line(ctx, "cmp eax, 0");
-    // emit_jump(ctx, "je", "false", label_false);
-    //
-    // //rhs
-    // emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
-    // emit_pop(ctx, "rax");
-    // emit_line(ctx, "cmp eax, 0");
-    // emit_jump(ctx, "je", "false", label_false);
-    //
-    // // both true
-    // emit_line(ctx, "mov eax, 1");
-    // emit_jump(ctx, "jmp", "end", label_end);
-    //
-    // emit_label(ctx, "false", label_false);
-    // emit_line(ctx, "mov eax, 0");
+    emit_label_from_text(ctx, end_label);
 
     if (mode == WANT_VALUE) {
         emit_push(ctx, "rax");
     }
-
-//    emit_label(ctx, "end", label_end);
+    free(false_label);
+    free(end_label);
 }
 
-INTERNAL void emit_int_logical_or_expr_to_rax(EmitterContext * ctx, ASTNode* node, EvalMode mode) {
-    int label_true = get_label_id(ctx);
-    int label_end = get_label_id(ctx);
-
-    // lhs
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);
-    emit_pop(ctx, "rax");
-    emit_line(ctx, "cmp eax, 0");
-    emit_jump(ctx, "jne", "true", label_true);
-
-    // rhs
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
-    emit_pop(ctx, "rax");
-    emit_line(ctx, "cmp eax, 0");
-    emit_jump(ctx, "jne", "true", label_true);
-
-    emit_label(ctx, "true", label_true);
-    emit_line(ctx, "mov eax, 1");
+/* c ? a : b, without a branch when both arms are cheap. otherwise the
+ * condition branches as it would in an if, and each arm leaves its value
+ * in rax or xmm0.
+ */
+INTERNAL void emit_cond_expr(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    bool fp = is_floating_point_type(node->ctype);
+    if (!emit_branchless_select(ctx, node)) {
+        int id = get_label_id(ctx);
+        char * else_label = make_label_text("cond_else", id);
+        char * end_label = make_label_text("cond_end", id);
+
+        emit_line(ctx, "; emitting conditional expression");
+        emit_branch(ctx, node->cond_expr.cond, else_label, false);
+        if (fp) {
+            emit_fp_operand(ctx, node->cond_expr.then_expr);
+        } else {
+            emit_int_operand(ctx, node->cond_expr.then_expr);
+        }
+        emit_jump_from_text(ctx, "jmp", end_label);
+        emit_label_from_text(ctx, else_label);
+        if (fp) {
+            emit_fp_operand(ctx, node->cond_expr.else_expr);
+        } else {
+            emit_int_operand(ctx, node->cond_expr.else_expr);
+        }
+        emit_label_from_text(ctx, end_label);
+        free(else_label);
+        free(end_label);
+    }
 
     if (mode == WANT_VALUE) {
-        emit_push(ctx, "rax");
+        if (fp) {
+            emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
+        } else {
+            emit_push(ctx, "rax");
+        }
     }
-
-    emit_label(ctx, "end", label_end);
 }
 
-INTERNAL void emit_int_add_assignment_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-
-    // compute lhs address -> rcx
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_ADDRESS);
-
-    emit_pop(ctx, "rcx");               // pop rcx off the stack to load the lhs value
-    emit_push(ctx, "rcx");              // push rcx back on the stack to latter store the result
-    // load lhs into rax
-    emit_line(ctx, "mov DWORD eax, [rcx]");
-//    emit_line(ctx, "push rax");
-    emit_push(ctx, "rax");
-
-
-    // evaluate RHS into eax
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
-
-    // restore RHS into ecx
-    emit_pop(ctx, "rcx");
-
-    // restore LHS into eax
-    emit_pop(ctx, "rax");
-
-
-    // add RHS to LHS
-    emit_line(ctx, "add eax, ecx");
-
-    // restore LHS address
-    emit_pop(ctx, "rcx");
-
-
-    // write back result to LHS
-    emit_line(ctx, "mov [rcx], eax");
-
-    if (mode == WANT_VALUE) {
-        emit_push(ctx, "rax");
+/* x += y and x -= y on integers and pointers update x in place */
+INTERNAL void emit_int_compound_assignment_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    if (!emit_read_modify_write(ctx, node, mode)) {
+        error("Unsupported compound assignment to %s", get_ast_node_name(node->binary.lhs));
     }
 }
 
 void emit_fp_assignment_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
     emit_line(ctx, "; emitting assignment - LHS %s = RHS %s",
     get_ast_node_name(node->binary.lhs), get_ast_node_name(node->binary.rhs));
-    // eval RHS -> rax then push
-    if (is_array_type(node->binary.rhs->ctype)) {
-        emit_addr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
-    }
-    else {
-        emit_fp_expr_to_xmm0(ctx, node->binary.rhs, WANT_VALUE);
-    }
-
-    // eval LHS addr -> rcx
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_ADDRESS);
-
-    // pop LHS into rcx
-    emit_pop(ctx, "rcx");
-
-    // pop RHS in rax
-    if (is_array_type(node->binary.rhs->ctype)) {
-        emit_pop(ctx, "rax");
-    }
-    else {
-        emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->binary.rhs->ctype));
-    }
-
-    CType * ctype = node->binary.lhs->ctype;
-
-    emit_line(ctx, "%s %s [rcx], %s",
-        mov_instruction_for_type(ctype),
-        mem_size_for_type(ctype),
-        reg_for_type(ctype));
-
-
-}
-
-void emit_fp_add_assignment_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-
-    // compute lhs address -> rcx
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_ADDRESS);
-
-    emit_pop(ctx, "rcx");               // pop rcx off the stack to load the lhs value
-    emit_push(ctx, "rcx");              // push rcx back on the stack to latter store the result
-    // load lhs into rax
-    emit_line(ctx, "%s xmm0, [rcx]", mov_instruction_for_type(node->binary.lhs->ctype));
-    //    emit_line(ctx, "push rax");
-    emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->binary.lhs->ctype));
-
-
-    // evaluate RHS into eax
-    emit_expr_to_reg(ctx, node->binary.rhs, WANT_VALUE);
-
-    // restore RHS into ecx
-    //    emit_line(ctx, "pop rcx");
-    emit_fpop(ctx, "xmm1", getFPWidthFromCType(node->binary.rhs->ctype));
-
-    // restore LHS into eax
-    //    emit_line(ctx, "pop rax");
-    emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->binary.lhs->ctype));
-
-    // add RHS to LHS
-    emit_line(ctx, "%s xmm0, xmm1", get_fp_binop(node->binary.lhs));
-
-    // restore LHS address
-    //    emit_line(ctx, "pop rcx");
-    emit_pop(ctx, "rcx");
-
-
-    // write back result to LHS
-    emit_line(ctx, "%s [rcx], xmm0", mov_instruction_for_type(node->binary.lhs->ctype));
-
-    if (mode == WANT_VALUE) {
-        emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->binary.lhs->ctype));
-    }
-}
-
-
-INTERNAL void emit_int_sub_assignment_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-
-    // compute lhs address -> rcx
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_ADDRESS);
-
-    emit_pop(ctx, "rcx");               // pop rcx off the stack to load the lhs value
-    emit_push(ctx, "rcx");              // push rcx back on the stack to latter store the result
-
-    // push LHS address on stack
-    emit_line(ctx, "mov DWORD eax, [rcx]");
-    emit_push(ctx, "rax");
-
-
-    // // load current value into eax
-    // emit_line(ctx, "mov eax, [rcx]");
-    //
-    // // save current RHS value in eax on stack
-    // emit_line(ctx, "push rax");
-
-    // evaluate RHS into eax
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
-
-
-    // restore RHS into ecx
-    emit_pop(ctx, "rcx");
-
-    // restore LHS into eax
-    emit_pop(ctx, "rax");
-
-    // sub RHS from LHS
-    emit_line(ctx, "sub eax, ecx");
-
-    // restore LHS address
-    emit_pop(ctx, "rcx");
-
-    // write back result to LHS
-    emit_line(ctx, "mov [rcx], eax");
-
-    if (mode == WANT_VALUE) {
-        emit_push(ctx, "rax");
-    }
+    emit_store_to_lvalue(ctx, node->binary.lhs, node->binary.rhs, mode);
 }
 
 void emit_signed_integer_condition_codes(EmitterContext * ctx, BinaryOperator op) {
@@ -795,44 +479,7 @@ void emit_floating_point_condition_codes(EmitterContext * ctx, BinaryOperator op
 }
 
 INTERNAL void emit_int_comparison_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    // eval left-hand side -> result in eax -> push results onto the stack
-    if (is_floating_point_type(node->binary.common_type)) {
-        emit_fp_expr_to_xmm0(ctx, node->binary.lhs, WANT_VALUE);
-        emit_fp_expr_to_xmm0(ctx, node->binary.rhs, WANT_VALUE);
-    }
-    else {
-        emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);
-        emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);
-    }
-
-    // emit_line(ctx, "pop rcx");
-    // emit_line(ctx, "pop rax");
-    if (is_floating_point_type(node->binary.common_type)) {
-        emit_fpop(ctx, "xmm1", getFPWidthFromCType(node->binary.common_type));
-        emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->binary.common_type));
-    }
-    else {
-        emit_pop(ctx, "rcx");
-        emit_pop(ctx, "rax");
-    }
-
-    // eval right-hand side -> reult in eax
-
-    // restore lhs into rcx
-
-    if (!is_floating_point_type(node->binary.common_type)) {
-        emit_line(ctx, "mov ecx, ecx");   // zero upper bits
-        emit_line(ctx, "mov eax, eax");   // zero upper bits
-    }
-
-    // compare rax (lhs) with ecx (rhs), cmp rcx, eax means rcx - eax
-    if (node->binary.common_type->kind == CTYPE_FLOAT) {
-        emit_line(ctx, "ucomiss xmm0, xmm1     ; fp compare");
-    } else if (node->binary.common_type->kind == CTYPE_DOUBLE) {
-        emit_line(ctx, "ucomisd xmm0, xmm1     ; dbl compare");
-    } else {
-        emit_line(ctx, "cmp eax, ecx");
-    }
+    emit_comparison_flags(ctx, node, false);
 
     if (is_signed_integer_type(node->binary.common_type) || is_pointer_type(node->binary.common_type)) {
         emit_signed_integer_condition_codes(ctx, node->binary.op);
@@ -893,7 +540,7 @@ void emit_int_binary_expr_to_rax(EmitterContext * ctx, ASTNode *node, EvalMode m
             break;
         case BINOP_ADD: {
             if (is_pointer_type(node->binary.lhs->ctype) || is_pointer_type(node->binary.rhs->ctype)) {
-                emit_int_ptr_add_expr_to_rax(ctx, node, mode);
+                emit_int_ptr_offset_expr_to_rax(ctx, node, mode);
             }
             else if (is_integer_type(node->ctype)) {
                 emit_int_add_expr_to_rax(ctx, node, mode);
@@ -919,20 +566,15 @@ void emit_int_binary_expr_to_rax(EmitterContext * ctx, ASTNode *node, EvalMode m
             emit_int_mod_expr_to_rax(ctx, node, mode);
             break;
         case BINOP_LOGICAL_AND:
-            emit_int_logical_and_expr_to_rax(ctx, node, mode);
-            break;
-
         case BINOP_LOGICAL_OR:
-            emit_int_logical_or_expr_to_rax(ctx, node, mode);
+            emit_int_logical_expr_to_rax(ctx, node, mode);
             break;
         case BINOP_ASSIGNMENT:
             emit_int_assignment_expr_to_rax(ctx, node, mode);
             break;
         case BINOP_COMPOUND_ADD_ASSIGN:
-            emit_int_add_assignment_expr_to_rax(ctx, node, mode);
-            break;
         case BINOP_COMPOUND_SUB_ASSIGN:
-            emit_int_sub_assignment_expr_to_rax(ctx, node, mode);
+            emit_int_compound_assignment_expr_to_rax(ctx, node, mode);
             break;
         case BINOP_BITWISE_AND:
         case BINOP_BITWISE_OR:
@@ -959,7 +601,7 @@ INTERNAL void emit_unary(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
 //            emit_line(ctx, "pop rax");
             emit_pop(ctx, "rax");
 
-            emit_line(ctx, "neg eax");
+            emit_line(ctx, node->ctype->size == 8 ? "neg rax" : "neg eax");
 //            emit_line(ctx, "push rax");
             if (mode == WANT_VALUE) {
                 emit_push(ctx, "rax");
@@ -973,49 +615,21 @@ INTERNAL void emit_unary(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
             // !x becomes (x == 0) -> 1 else 0
             emit_int_expr_to_rax(ctx, node->unary.operand, WANT_VALUE);
             emit_pop(ctx, "rax");
-            emit_line(ctx, "cmp eax, 0");
+            emit_line(ctx, node->unary.operand->ctype->size == 8 ? "cmp rax, 0" : "cmp eax, 0");
             emit_line(ctx, "sete al");
             emit_line(ctx, "movzx eax, al");
             if (mode == WANT_VALUE) {
                 emit_push(ctx, "rax");
             }
             break;
-        case UNARY_PRE_INC: {
-            char * reference_label = create_variable_reference(ctx, node->unary.operand);
-            emit_line(ctx, "mov eax, %s", reference_label);
-            emit_line(ctx, "add eax, 1");
-            emit_line(ctx, "mov %s, eax", reference_label);
-            free(reference_label);
-            break;
-        }
-        case UNARY_PRE_DEC: {
-            char * reference_label = create_variable_reference(ctx, node->unary.operand);
-            emit_line(ctx, "mov eax, %s", reference_label);
-            emit_line(ctx, "sub eax, 1");
-            emit_line(ctx, "mov %s, eax", reference_label);
-            free(reference_label);
-        break;
-        }
-        case UNARY_POST_INC: {
-            char * reference_label = create_variable_reference(ctx, node->unary.operand);
-            emit_line(ctx, "mov eax, %s", reference_label);
-            emit_line(ctx, "mov ecx, eax");
-            emit_line(ctx, "add eax, 1");
-            emit_line(ctx, "mov %s, eax", reference_label);
-            emit_line(ctx, "mov eax, ecx");
-            free(reference_label);
-            break;
-        }
-        case UNARY_POST_DEC: {
-            char * reference_label = create_variable_reference(ctx, node->unary.operand);
-            emit_line(ctx, "mov eax, %s", reference_label);
-            emit_line(ctx, "mov ecx, eax");
-            emit_line(ctx, "sub eax, 1");
-            emit_line(ctx, "mov %s, eax", reference_label);
-            emit_line(ctx, "mov eax, ecx");
-            free(reference_label);
+        case UNARY_PRE_INC:
+        case UNARY_PRE_DEC:
+        case UNARY_POST_INC:
+        case UNARY_POST_DEC:
+            if (!emit_read_modify_write(ctx, node, mode)) {
+                error("Unsupported operand for increment or decrement");
+            }
             break;
-        }
         case UNARY_ADDRESS: {
             emit_int_expr_to_rax(ctx, node->unary.operand, WANT_ADDRESS);
 //             char * reference_label = create_variable_reference(ctx, node->unary.operand);
@@ -1026,32 +640,13 @@ INTERNAL void emit_unary(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
 //             free(reference_label);
             break;
         }
-        case UNARY_DEREF: {
-            emit_int_expr_to_rax(ctx, node->unary.operand, WANT_VALUE);
-//            emit_line(ctx, "pop rax");
-            emit_pop(ctx, "rax");
-
-            if (node->ctype->kind == CTYPE_CHAR) {
-                emit_line(ctx, "movzx eax, BYTE [rax]");
-            } else if (node->ctype->kind == CTYPE_SHORT) {
-                emit_line(ctx, "movzx eax, WORD [rax]");
-            } else if (node->ctype->kind == CTYPE_INT) {
-                emit_line(ctx, "mov eax, [rax]");
-            }
-            else if (node->ctype->kind == CTYPE_LONG) {
-                emit_line(ctx, "mov rax, [rax]");
-            }
-//            emit_line(ctx, "push rax");
-            if (mode == WANT_VALUE) {
-                emit_push(ctx, "rax");
-            }
-
+        case UNARY_DEREF:
+            emit_lvalue_to_reg(ctx, node, mode);
             break;
-        }
         case UNARY_BITWISE_NOT:
             emit_int_expr_to_rax(ctx, node->unary.operand, WANT_VALUE);
             emit_pop(ctx, "rax");
-            emit_line(ctx, "not eax");
+            emit_line(ctx, node->ctype->size == 8 ? "not rax" : "not eax");
             if (mode == WANT_VALUE) {
                 emit_push(ctx, "rax");
             }
@@ -1064,43 +659,13 @@ INTERNAL void emit_unary(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
 
 
 
-void emit_fp_arith_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_fp_expr_to_xmm0(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_fp_expr_to_xmm0(ctx, node->binary.rhs, WANT_VALUE);
-
-    FPWidth width = getFPWidthFromCType(node->ctype);
-    const char * instruction = get_fp_binop(node);
-
-    emit_fpop(ctx, "xmm1", width);
-    emit_fpop(ctx, "xmm0", width);
-
-    emit_line(ctx, "%s xmm0, xmm1", instruction);
-
-    if (mode == WANT_VALUE) {
-        emit_fpush(ctx, "xmm0", width);
-    }
-}
-
 void emit_fp_unary_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
     switch (node->unary.op) {
         case UNARY_NEGATE:
-            emit_fp_expr_to_xmm0(ctx, node->unary.operand, WANT_VALUE);
-            //            emit_line(ctx, "pop rax");
-            emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-
-            if (node->ctype->kind == CTYPE_FLOAT) {
-//                emit_line(ctx, "movaps    xmm1, [rel mask_f32]          ; mask = 0x80000000");
-                emit_line(ctx, "movups    xmm1, [rel mask_f32]          ; mask = 0x80000000");
-                emit_line(ctx, "xorps     xmm0, xmm1                ; flips sign bit");
-            }
-            else if (node->ctype->kind == CTYPE_DOUBLE) {
-//                emit_line(ctx, "movapd    xmm1, [rel mask_f64]          ; mask = 0x8000000000000000");
-                emit_line(ctx, "movupd    xmm1, [rel mask_f64]          ; mask = 0x8000000000000000");
-                emit_line(ctx, "xorpd     xmm0, xmm1                ; flips sign bit");
-            }
-            if (mode == WANT_VALUE) {
-                emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-            }
+            emit_fp_negate(ctx, node, mode);
+            break;
+        case UNARY_DEREF:
+            emit_lvalue_to_reg(ctx, node, mode);
             break;
         default:
             error("Unsupported unary op in emitter");
@@ -1123,24 +688,17 @@ void emit_fp_binary_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode
         case BINOP_DIV:
         case BINOP_SUB: {
             if (is_floating_point_type(node->ctype)) {
-                emit_fp_arith_expr_to_xmm0(ctx, node, mode);
+                emit_fp_arith(ctx, node, mode);
             }
             break;
         }
 
-            //TODO Need something to handle the assignments include compound like
-            // a floating point version of emit_int_sub_assignment_expr_to_rax
-            // or a more general version that handles both
-
         case BINOP_ASSIGNMENT:
             emit_fp_assignment_expr_to_xmm0(ctx, node, mode);
             break;
         case BINOP_COMPOUND_ADD_ASSIGN:
-            emit_fp_add_assignment_expr_to_xmm0(ctx, node, mode);
-//            emit_int_add_assignment_expr_to_rax(ctx, node, mode);
-            break;
         case BINOP_COMPOUND_SUB_ASSIGN:
-            emit_int_sub_assignment_expr_to_rax(ctx, node, mode);
+            emit_fp_compound_assignment(ctx, node, mode);
             break;
 
         // case BINOP_MUL: {
@@ -1177,20 +735,27 @@ void emit_fp_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
     }
     switch (node->type) {
 
-        case AST_CAST_EXPR: {
-             emit_cast_expr(ctx, node, mode);
+        case AST_CAST_EXPR:
+            emit_fp_conversion(ctx, node, mode);
             break;
-        }
 
         case AST_FLOAT_LITERAL:
-            emit_line(ctx, "movss xmm0, [rel %s]", node->float_literal.label);  // need label
+            if (is_fp_zero(node)) {
+                emit_line(ctx, "xorps xmm0, xmm0");
+            } else {
+                emit_line(ctx, "movss xmm0, [rel %s]", node->float_literal.label);
+            }
             if (mode == WANT_VALUE) {
                 emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
             }
             break;
 
         case AST_DOUBLE_LITERAL:
-            emit_line(ctx, "movsd xmm0, [rel %s]", node->double_literal.label);  // need label
+            if (is_fp_zero(node)) {
+                emit_line(ctx, "xorps xmm0, xmm0");
+            } else {
+                emit_line(ctx, "movsd xmm0, [rel %s]", node->double_literal.label);
+            }
             if (mode == WANT_VALUE) {
                 emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
             }
@@ -1205,27 +770,7 @@ void emit_fp_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
             break;
 
         case AST_VAR_REF_EXPR:
-            emit_addr_to_rax(ctx, node, mode);
-            if (!is_array_type(node->ctype)) {
-                if (is_floating_point_type(node->ctype)) {
-                    //emit_fpop(ctx, "xmm0", FP32);
-                    if (mode == WANT_VALUE) {
-                        emit_pop(ctx, "rax");
-                    }
-                    emit_load_from(ctx, node->ctype, "rax");
-                    if (mode == WANT_VALUE) {
-                        emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-                    }
-                } else {
-                    if (mode == WANT_VALUE) {
-                        emit_pop(ctx, "rax");
-                    }
-                    emit_load_from(ctx, node->ctype, "rax");
-                    if (mode == WANT_VALUE) {
-                        emit_push(ctx, "rax");
-                    }
-                }
-            }
+            emit_lvalue_to_reg(ctx, node, mode);
             break;
 
         case AST_FUNCTION_CALL_EXPR:
@@ -1234,44 +779,12 @@ void emit_fp_expr_to_xmm0(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
 
         case AST_ARRAY_ACCESS:
             emit_line(ctx, "; emitting array access");
-            emit_addr_to_rax(ctx, node, mode);
-
-            if (node->ctype->kind != CTYPE_ARRAY) {
-                emit_pop(ctx, "rcx");
-                emit_line(ctx, "; emitting array element value");
-                emit_load_from(ctx, node->ctype, "rcx");                    // load
-                if (mode == WANT_VALUE) {
-                    emit_push_for_type(ctx, node->ctype);
-                }
-            }
-
+            emit_lvalue_to_reg(ctx, node, mode);
             break;
 
-        case AST_COND_EXPR: {
-            int id = get_label_id(ctx);
-            emit_line(ctx, "; emitting conditional expression");
-            emit_int_expr_to_rax(ctx, node->cond_expr.cond, mode);
-            emit_pop(ctx, "rax");
-            emit_line(ctx, "cmp eax, 0");
-
-            emit_line(ctx, "je Lelse%d", id);
-            emit_line(ctx, "; emitting then expr");
-            emit_fp_expr_to_xmm0(ctx, node->cond_expr.then_expr, mode);
-            emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-            emit_line(ctx, "jmp Lend%d", id);
-            emit_label(ctx, "else", id);
-            emit_line(ctx, "; emitting else expr");
-            emit_fp_expr_to_xmm0(ctx, node->cond_expr.else_expr, mode);
-            emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-
-            emit_label(ctx, "end", id);
-
-            if (mode == WANT_VALUE) {
-                emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype) );
-            }
-
+        case AST_COND_EXPR:
+            emit_cond_expr(ctx, node, mode);
             break;
-        }
         default:
             error("Unexpected node type %d", get_ast_node_name(node));
     }
@@ -1305,42 +818,9 @@ void emit_int_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
             }
             break;
 
-        case AST_VAR_REF_EXPR: {
-            emit_addr_to_rax(ctx, node, mode);
-            if (!is_array_type(node->ctype)) {
-                if (is_floating_point_type(node->ctype)) {
-                    //emit_fpop(ctx, "xmm0", FP32);
-                    if (mode == WANT_VALUE) {
-                        emit_pop(ctx, "rax");
-                    }
-                    emit_load_from(ctx, node->ctype, "rax");
-                    if (mode == WANT_VALUE) {
-                        emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
-                    }
-                } else {
-                    if (mode == WANT_VALUE) {
-                        emit_pop(ctx, "rax");
-                    }
-                    emit_load_from(ctx, node->ctype, "rax");
-                    if (mode == WANT_VALUE) {
-                        emit_push(ctx, "rax");
-                    }
-                }
-            }
-            // if (node->symbol->ctype->kind == CTYPE_ARRAY) {
-            //     emit_line(ctx, "lea rax, [rbp-%d]", abs(node->symbol->info.var.offset));
-            //     emit_push(ctx, "rax");
-            // }
-            // else if (node->symbol->node->var_decl.is_global) {
-            //     emit_line(ctx, "mov %s, [rel %s] ", reg_for_type(node->ctype), node->symbol->name);
-            //     emit_push(ctx, "rax");
-            // } else {
-            //     int offset = node->symbol->info.var.offset;
-            //     emit_line(ctx, "mov %s, [rbp%+d]", reg_for_type(node->ctype), offset);
-            //     emit_push(ctx, "rax");
-            // }
+        case AST_VAR_REF_EXPR:
+            emit_lvalue_to_reg(ctx, node, mode);
             break;
-        }
         case AST_UNARY_EXPR:
             emit_unary(ctx, node, mode);
             break;
@@ -1352,47 +832,15 @@ void emit_int_expr_to_rax(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
             break;
         case AST_ARRAY_ACCESS:
             emit_line(ctx, "; emitting array access");
-            emit_addr_to_rax(ctx, node, mode);
-
-            if (node->ctype->kind != CTYPE_ARRAY) {
-                emit_pop(ctx, "rcx");
-                emit_line(ctx, "; emitting array element value");
-                emit_load_from(ctx, node->ctype, "rcx");                    // load
-                if (mode == WANT_VALUE) {
-                    emit_push(ctx, "rax");
-                }
-            }
-
+            emit_lvalue_to_reg(ctx, node, mode);
             break;
         case AST_CAST_EXPR:
             emit_int_cast_expr_to_rax(ctx, node, mode);
             break;
 
-        case AST_COND_EXPR: {
-            int id = get_label_id(ctx);
-            emit_line(ctx, "; emitting conditional expression");
-            emit_int_expr_to_rax(ctx, node->cond_expr.cond, mode);
-            emit_pop(ctx, "rax");
-            emit_line(ctx, "cmp eax, 0");
-
-            emit_line(ctx, "je Lelse%d", id);
-            emit_line(ctx, "; emitting then expr");
-            emit_int_expr_to_rax(ctx, node->cond_expr.then_expr, mode);
-            emit_pop(ctx, "rax");
-            emit_line(ctx, "jmp Lend%d", id);
-            emit_label(ctx, "else", id);
-            emit_line(ctx, "; emitting else expr");
-            emit_int_expr_to_rax(ctx, node->cond_expr.else_expr, mode);
-            emit_pop(ctx, "rax");
-
-            emit_label(ctx, "end", id);
-
-            if (mode == WANT_VALUE) {
-                emit_push(ctx, "rax");
-            }
-
+        case AST_COND_EXPR:
+            emit_cond_expr(ctx, node, mode);
             break;
-        }
         case AST_STRING_LITERAL: {
             emit_addr_to_rax(ctx, node, mode);
             // char * label = node->string_literal.label;
@@ -1426,21 +874,20 @@ void emit_expr_to_reg(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
 }
 
 void emit_bitwise_binary_expr(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
+    if (emit_int_binary_tile(ctx, node, mode)) {
+        return;
+    }
+    emit_operands_to_rax_rcx(ctx, node->binary.lhs, node->binary.rhs);
 
     switch (node->binary.op) {
         case BINOP_BITWISE_AND:
-            emit_line(ctx, "and eax, ecx");
+            emit_line(ctx, node->ctype->size == 8 ? "and rax, rcx" : "and eax, ecx");
             break;
         case BINOP_BITWISE_OR:
-            emit_line(ctx, "or eax, ecx");
+            emit_line(ctx, node->ctype->size == 8 ? "or rax, rcx" : "or eax, ecx");
             break;
         case BINOP_BITWISE_XOR:
-            emit_line(ctx, "xor eax, ecx");
+            emit_line(ctx, node->ctype->size == 8 ? "xor rax, rcx" : "xor eax, ecx");
             break;
         default:
             error("invalid bitwise operator");
@@ -1452,18 +899,17 @@ void emit_bitwise_binary_expr(EmitterContext * ctx, ASTNode * node, EvalMode mod
 }
 
 void emit_shift_expr(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
-    emit_int_expr_to_rax(ctx, node->binary.lhs, WANT_VALUE);       // codegen to eval lhs with result in EAX
-    emit_int_expr_to_rax(ctx, node->binary.rhs, WANT_VALUE);       // codegen to eval rhs with result in EAX
-
-    emit_pop(ctx, "rcx");
-    emit_pop(ctx, "rax");
+    if (emit_int_binary_tile(ctx, node, mode)) {
+        return;
+    }
+    emit_operands_to_rax_rcx(ctx, node->binary.lhs, node->binary.rhs);
 
     switch (node->binary.op) {
         case BINOP_SHIFT_LEFT:
-            emit_line(ctx, "shl eax, cl");
+            emit_line(ctx, node->ctype->size == 8 ? "shl rax, cl" : "shl eax, cl");
             break;
             case BINOP_SHIFT_RIGHT:
-            emit_line(ctx, "sar eax, cl");
+            emit_line(ctx, node->ctype->size == 8 ? "sar rax, cl" : "sar eax, cl");
             break;
     }
 
@@ -2,113 +2,69 @@
 // Created by scott on 7/13/25.
 //
 
+#include <stdlib.h>
+
 #include "emitter.h"
 #include "emitter_context.h"
 #include "emitter_helpers.h"
 #include "emit_stack.h"
 #include "emit_expression.h"
+#include "emit_condition.h"
+#include "emit_extensions.h"
+#include "compile_stats.h"
 #include "error.h"
 
-void emit_print_int_extension_function(EmitterContext * ctx) {
-    int label_convert = get_label_id(ctx);
-    int label_done = get_label_id(ctx);
-    int label_buffer = get_label_id(ctx);
-    int label_loop = get_label_id(ctx);
-
-    emit_bss_section_header(ctx);
-    emit_line(ctx, "buffer%d resb 20", label_buffer);
-
-    emit_text_section_header(ctx);
-    emit_line(ctx, "print_int:");
-    emit_line(ctx, "; assumes integer to print is in eax");
-    emit_line(ctx, "; converts and prints using syscall");
-    emit_line(ctx, "mov rcx, buffer%d + 19", label_buffer);
-    emit_line(ctx, "mov byte [rcx], 10");
-    emit_line(ctx, "dec rcx");
-    emit_line(ctx, "");
-    emit_line(ctx, "cmp eax, 0");
-    emit_jump(ctx, "jne", "convert", label_convert);
-    emit_line(ctx, "mov byte [rcx], '0'");
-    emit_line(ctx, "dec rcx");
-    emit_jump(ctx, "jmp", "done", label_done);
-    emit_line(ctx, "");
-    emit_label(ctx, "convert", label_convert);
-    emit_line(ctx, "xor edx, edx");
-    emit_line(ctx, "mov ebx, 10");
-    emit_label(ctx, "loop", label_loop);
-    emit_line(ctx, "xor edx, edx");
-    emit_line(ctx, "div ebx");
-    emit_line(ctx, "add dl, '0'");
-    emit_line(ctx, "mov [rcx], dl");
-    emit_line(ctx, "dec rcx");
-    emit_line(ctx, "test eax, eax");
-    emit_jump(ctx, "jnz", "loop", label_loop);
-    emit_line(ctx, "");
-    emit_label(ctx, "done", label_done);
-    emit_line(ctx, "lea rsi, [rcx + 1]    ; message buffer address");
-    emit_line(ctx, "mov rdx, buffer%d + 20", label_buffer);
-    emit_line(ctx, "sub rdx, rsi          ; message buffer length");
-    emit_line(ctx, "mov rax, 1      ; SYSTEM CALL WRITE");
-    emit_line(ctx, "mov rdi, 1      ; FILE HANDLE stdout");
-    emit_line(ctx, "syscall");
-    emit_line(ctx, "ret");
-
-}
-
-void emit_print_double_extension_function(EmitterContext * ctx) {
-    // emit_line(ctx, "section .data");
-    // emit_line(ctx, "dbl_format  db \"%f\", 10, 0");
-    // emit_line(ctx, "");
-    // emit_line(ctx, "section .text");
-    // emit_line(ctx, "extern printf");
-    // emit_line(ctx, "");
-
-    //emit_line(ctx, "print_double:");
-
-    // emit stack alignment
-    // emit_line(ctx, "push r11");
-    // emit_line(ctx, "mov r11, rsp");
-    // emit_line(ctx, "and rsp, 0xfffffffffffffff0");
-    // emit_line(ctx, "sub rsp, 8");
-
-
-    // emit_line(ctx, "mov rdi, [rel dbl_format]");
-    // emit_line(ctx, "mov rax, 1");
-    // emit_line(ctx, "call printf");
-
-    // reset stack to before alignment
-    // emit_line(ctx, "mov rsp, r11");
-    // emit_line(ctx, "pop r11");
-
-//    emit_line(ctx, "ret");
-}
+/* an _assert waiting for its failure path, which goes to .text.cold after
+ * the function so the hot code only carries the compare and branch
+ */
+typedef struct AssertSite {
+    char * label;
+    int line;
+    struct AssertSite * next;
+} AssertSite;
 
 void emit_assert_extension_statement(EmitterContext * ctx, ASTNode * node) {
-    int label_pass = get_label_id(ctx);
-
-    // evaluate expression
-    emit_tree_node(ctx, node->expr_stmt.expr);
-    emit_pop(ctx, "rax");
-
-    // compare result in eax with 0
-    emit_line(ctx, "cmp eax, 0");
-    emit_jump(ctx, "jne", "assert_pass", label_pass);
-
-    // assert failed
-    // print message
-    emit_line(ctx, "mov rax, 1");
-    emit_line(ctx, "mov rdi, 1");
-    emit_line(ctx, "lea rsi, [rel assert_fail_msg]");
-    emit_line(ctx, "mov rdx, 17");
-    emit_line(ctx, "syscall");
-
-    // exit
-    emit_line(ctx, "mov rax, 60");
-    emit_line(ctx, "mov rdi, 1");
-    emit_line(ctx, "syscall");
+    AssertSite * site = malloc(sizeof(AssertSite));
+    site->label = make_label_text("assert_fail", get_label_id(ctx));
+    site->line = node->expr_stmt.line;
+    site->next = ctx->assert_sites;
+    ctx->assert_sites = site;
+
+    // a forward jump to another section is predicted not taken
+    emit_branch(ctx, node->expr_stmt.expr, site->label, false);
+    get_compile_stats()->asserts_outlined++;
+}
 
-    emit_label(ctx, "assert_pass", label_pass);
+void emit_assert_failure_paths(EmitterContext * ctx, const char * function_name) {
+    if (!ctx->assert_sites) {
+        return;
+    }
+    int id = get_label_id(ctx);
 
+    emit_line(ctx, "");
+    emit_line(ctx, "section .rodata");
+    emit_line(ctx, "assert_function%d: db \"%s\", 0", id, function_name);
+
+    // each site passes its line to one stub shared by the function.
+    // the runtime only makes syscalls, so the stack needs no alignment.
+    emit_line(ctx, "section .text.cold progbits alloc exec nowrite align=16");
+    for (AssertSite * site = ctx->assert_sites; site; ) {
+        AssertSite * next = site->next;
+        emit_label_from_text(ctx, site->label);
+        emit_line(ctx, "mov edi, %d", site->line);
+        if (next) {
+            emit_jump(ctx, "jmp", "assert_stub", id);
+        }
+        free(site->label);
+        free(site);
+        site = next;
+    }
+    emit_label(ctx, "assert_stub", id);
+    emit_line(ctx, "lea rsi, [rel assert_function%d]", id);
+    emit_line(ctx, "call __mimic99_assert_fail");
+    emit_line(ctx, "section .text");
+    emit_line(ctx, "");
+    ctx->assert_sites = NULL;
 }
 
 void emit_print_extension_call(EmitterContext * ctx, ASTNode * node) {
@@ -121,45 +77,21 @@ void emit_print_extension_call(EmitterContext * ctx, ASTNode * node) {
     //     emit_add_rsp(ctx, 16);
     // }
 
-    if (is_integer_type(node->expr_stmt.expr->ctype)) {
-        // emit_line(ctx, "push r11");
-        // emit_line(ctx, "mov r11, rsp");
-        // emit_line(ctx, "and rsp, 0xfffffffffffffff0");
-        // emit_line(ctx, "sub rsp, 8");
-//        emit_line(ctx, "call print_int");
-        // emit_line(ctx, "mov rsp, r11");
-        // emit_line(ctx, "pop r11");
-//        ctx->emit_print_int_extension = true;
-
-        // printf 1 integer
-        emit_line(ctx, "lea rdi, [rel int_format]");
-        emit_line(ctx, "mov rsi, rax");
-        emit_line(ctx, "xor eax, eax");
-        emit_line(ctx, "call printf");
+    // the runtime routines take the value as their only argument, doubles in xmm0
+    if (is_integer_type(node->expr_stmt.expr->ctype) && node->expr_stmt.expr->ctype->size == 8) {
+        emit_line(ctx, "mov rdi, rax");
+        emit_line(ctx, "call __mimic99_print_long");
+    }
+    else if (is_integer_type(node->expr_stmt.expr->ctype)) {
+        emit_line(ctx, "mov rdi, rax");
+        emit_line(ctx, "call __mimic99_print_int");
     }
     else if (is_double_type(node->expr_stmt.expr->ctype)) {
-
-        emit_line(ctx, "lea rdi, [rel dbl_format]");
-        emit_line(ctx, "mov al, 1");
-        emit_line(ctx, "call printf");
-//        emit_line(ctx, "ret");
-
-        //
-        // emit_line(ctx, "push r11");
-        // emit_line(ctx, "mov r11, rsp");
-        // emit_line(ctx, "and rsp, 0xfffffffffffffff0");
-        // emit_line(ctx, "sub rsp, 8");
-        // emit_line(ctx, "call print_double");
-        // emit_line(ctx, "mov rsp, r11");
-        // emit_line(ctx, "pop r11");
-
-//        ctx->emit_print_double_extension = true;
+        emit_line(ctx, "call __mimic99_print_double");
     }
     else if (is_string_type(node->expr_stmt.expr->ctype)) {
-        emit_line(ctx, "lea rdi, [rel str_format]");
-        emit_line(ctx, "mov rsi, rax");
-        emit_line(ctx, "xor eax, eax");
-        emit_line(ctx, "call printf");
+        emit_line(ctx, "mov rdi, rax");
+        emit_line(ctx, "call __mimic99_print_string");
     }
     else {
         error("invalid argument type");
@@ -0,0 +1,165 @@
+#include <math.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "emitter.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "emit_stack.h"
+#include "emit_select.h"
+#include "compile_stats.h"
+#include "compiler_options.h"
+#include "error.h"
+#include "emit_fp.h"
+
+#define HELD_XMM_COUNT 8
+
+static const char * HELD_XMM[HELD_XMM_COUNT] = {
+    "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15"
+};
+
+bool contains_call(ASTNode * node) {
+    if (!node) return false;
+    switch (node->type) {
+        case AST_FUNCTION_CALL_EXPR:
+            return true;
+        case AST_BINARY_EXPR:
+            return contains_call(node->binary.lhs) || contains_call(node->binary.rhs);
+        case AST_UNARY_EXPR:
+            return contains_call(node->unary.operand);
+        case AST_CAST_EXPR:
+            return contains_call(node->cast_expr.expr);
+        case AST_COND_EXPR:
+            return contains_call(node->cond_expr.cond) ||
+                   contains_call(node->cond_expr.then_expr) ||
+                   contains_call(node->cond_expr.else_expr);
+        case AST_ARRAY_ACCESS:
+            return contains_call(node->array_access.base) || contains_call(node->array_access.index);
+        default:
+            return false;
+    }
+}
+
+bool is_fp_zero(ASTNode * node) {
+    if (node->type == AST_FLOAT_LITERAL) {
+        return node->float_literal.value == 0 && !signbit(node->float_literal.value);
+    }
+    if (node->type == AST_DOUBLE_LITERAL) {
+        return node->double_literal.value == 0 && !signbit(node->double_literal.value);
+    }
+    return false;
+}
+
+HeldFPValue hold_fp_value(EmitterContext * ctx, CType * ctype, ASTNode * pending) {
+    HeldFPValue held = { NULL, getFPWidthFromCType(ctype) };
+    if (optimizations_enabled() && ctx->fp_held < HELD_XMM_COUNT && !contains_call(pending)) {
+        held.reg = HELD_XMM[ctx->fp_held++];
+        emit_line(ctx, "movaps %s, xmm0", held.reg);
+        get_compile_stats()->fp_values_held++;
+    } else {
+        emit_fpush(ctx, "xmm0", held.width);
+    }
+    return held;
+}
+
+void restore_fp_value(EmitterContext * ctx, HeldFPValue * held, const char * xmm) {
+    if (!held->reg) {
+        emit_fpop(ctx, xmm, held->width);
+        return;
+    }
+    emit_line(ctx, "movaps %s, %s", xmm, held->reg);
+    ctx->fp_held--;
+}
+
+/* variables and literals, which load without side effects */
+static bool is_fp_load(ASTNode * node) {
+    return node->type == AST_FLOAT_LITERAL || node->type == AST_DOUBLE_LITERAL ||
+           (has_direct_address(node) && is_floating_point_type(node->ctype));
+}
+
+void emit_fp_operands(EmitterContext * ctx, ASTNode * lhs, ASTNode * rhs) {
+    // at -O0 lhs always goes first, and is held on the stack
+    bool reorder = optimizations_enabled();
+    if (reorder && is_fp_load(lhs)) {
+        emit_fp_operand(ctx, rhs);
+        emit_line(ctx, "movaps xmm1, xmm0");
+        emit_fp_operand(ctx, lhs);
+        return;
+    }
+    if (reorder && contains_call(rhs) && !contains_call(lhs)) {
+        // the order is unspecified, so the call goes first and nothing is held across it
+        emit_fp_operand(ctx, rhs);
+        HeldFPValue held = hold_fp_value(ctx, rhs->ctype, lhs);
+        emit_fp_operand(ctx, lhs);
+        restore_fp_value(ctx, &held, "xmm1");
+        return;
+    }
+    emit_fp_operand(ctx, lhs);
+    HeldFPValue held = hold_fp_value(ctx, lhs->ctype, rhs);
+    emit_fp_operand(ctx, rhs);
+    emit_line(ctx, "movaps xmm1, xmm0");
+    restore_fp_value(ctx, &held, "xmm0");
+}
+
+void emit_fp_arith(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    if (emit_fp_binary_tile(ctx, node, mode)) {
+        return;
+    }
+    emit_fp_operands(ctx, node->binary.lhs, node->binary.rhs);
+    emit_line(ctx, "%s xmm0, xmm1", get_fp_binop(node));
+
+    if (mode == WANT_VALUE) {
+        emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
+    }
+}
+
+void emit_fp_negate(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    emit_fp_operand(ctx, node->unary.operand);
+    if (node->ctype->kind == CTYPE_FLOAT) {
+        emit_line(ctx, "xorps     xmm0, [rel mask_f32]      ; flips sign bit");
+    } else {
+        emit_line(ctx, "xorpd     xmm0, [rel mask_f64]      ; flips sign bit");
+    }
+    if (mode == WANT_VALUE) {
+        emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
+    }
+}
+
+void emit_fp_conversion(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    ASTNode * inner = node->cast_expr.expr;
+    CType * from = inner->ctype;
+    bool to_double = node->ctype->kind == CTYPE_DOUBLE;
+    Address address;
+
+    if (is_floating_point_type(from)) {
+        const char * convert = to_double ? "cvtss2sd" : "cvtsd2ss";
+        if (from->kind == node->ctype->kind) {
+            emit_fp_operand(ctx, inner);
+        } else if (optimizations_enabled() && has_direct_address(inner)) {
+            select_address(ctx, inner, &address);
+            emit_line(ctx, "%s xmm0, %s", convert, operand_text(&address, from));
+        } else {
+            emit_fp_operand(ctx, inner);
+            emit_line(ctx, "%s xmm0, xmm0", convert);
+        }
+    } else if (is_integer_type(from)) {
+        // cvtsi2sd only writes the low lane, so xorps breaks the dependency on the rest
+        const char * convert = to_double ? "cvtsi2sd" : "cvtsi2ss";
+        if (optimizations_enabled() && (from->size == 4 || from->size == 8) && has_direct_address(inner)) {
+            select_address(ctx, inner, &address);
+            emit_line(ctx, "xorps xmm0, xmm0");
+            emit_line(ctx, "%s xmm0, %s", convert, operand_text(&address, from));
+        } else {
+            emit_int_operand_extended(ctx, inner, from->size == 8 ? 8 : 4);
+            emit_line(ctx, "xorps xmm0, xmm0");
+            emit_line(ctx, "%s xmm0, %s", convert, from->size == 8 ? "rax" : "eax");
+        }
+    } else {
+        error("Unsupported cast expression type %d", node->type);
+    }
+
+    if (mode == WANT_VALUE) {
+        emit_fpush(ctx, "xmm0", getFPWidthFromCType(node->ctype));
+    }
+}
@@ -0,0 +1,407 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "error.h"
+#include "emitter.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "emit_select.h"
+#include "vreg.h"
+#include "compile_stats.h"
+#include "emit_initializer.h"
+
+// copies and fills up to this size are unrolled into moves, larger ones use rep
+#define INLINE_COPY_BYTES 64
+#define INLINE_ZERO_BYTES 128
+
+#define VALUES_PER_LINE 16
+
+typedef struct InitConstant {
+    bool is_fp;
+    long integer;
+    double fp;
+} InitConstant;
+
+/* literals, negated literals and casts of them */
+static bool fold_constant(ASTNode * node, InitConstant * value) {
+    switch (node->type) {
+        case AST_INT_LITERAL:
+            value->is_fp = false;
+            value->integer = node->int_value;
+            return true;
+        case AST_FLOAT_LITERAL:
+            value->is_fp = true;
+            value->fp = node->float_literal.value;
+            return true;
+        case AST_DOUBLE_LITERAL:
+            value->is_fp = true;
+            value->fp = node->double_literal.value;
+            return true;
+        case AST_UNARY_EXPR:
+            if (node->unary.op != UNARY_NEGATE && node->unary.op != UNARY_PLUS) return false;
+            if (!fold_constant(node->unary.operand, value)) return false;
+            if (node->unary.op == UNARY_NEGATE) {
+                value->integer = -value->integer;
+                value->fp = -value->fp;
+            }
+            return true;
+        case AST_CAST_EXPR:
+            if (!fold_constant(node->cast_expr.expr, value)) return false;
+            if (is_floating_point_type(node->ctype)) {
+                if (!value->is_fp) value->fp = (double) value->integer;
+                if (node->ctype->kind == CTYPE_FLOAT) value->fp = (float) value->fp;
+                value->is_fp = true;
+            } else if (value->is_fp) {
+                value->integer = (long) value->fp;
+                value->is_fp = false;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* the bits a constant has as an element of the given type */
+static uint64_t constant_bits(InitConstant * value, CType * ctype) {
+    if (ctype->kind == CTYPE_FLOAT) {
+        float f = value->is_fp ? (float) value->fp : (float) value->integer;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+    if (ctype->kind == CTYPE_DOUBLE) {
+        double d = value->is_fp ? value->fp : (double) value->integer;
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        return bits;
+    }
+    uint64_t bits = value->is_fp ? (uint64_t) (long) value->fp : (uint64_t) value->integer;
+    return ctype->size == 8 ? bits : bits & (((uint64_t) 1 << (ctype->size * 8)) - 1);
+}
+
+static int element_count(CType * ctype) {
+    int count = 1;
+    while (is_array_type(ctype)) {
+        count *= ctype->array_len;
+        ctype = ctype->base_type;
+    }
+    return count;
+}
+
+typedef void (*InitVisitor)(int position, ASTNode * item, void * arg);
+
+/* visits each initializer with the position of the element it initializes.
+ * a braced list for a row starts at the next row; without braces the
+ * values run on through the rows in order. values past the end are
+ * dropped, as gcc does.
+ */
+static void walk_items(ASTNode * list, CType * ctype, int start, InitVisitor visit, void * arg) {
+    CType * element = ctype->base_type;
+    int stride = element_count(element);
+    int end = start + element_count(ctype);
+    int position = start;
+
+    for (ASTNode_list_node * n = list->initializer_list.items->head; n; n = n->next) {
+        ASTNode * item = n->value;
+        if (item->type == AST_INITIALIZER_LIST && is_array_type(element)) {
+            position = start + (position - start + stride - 1) / stride * stride;
+            if (position + stride > end) {
+                warning("Excess elements in array initializer");
+                return;
+            }
+            walk_items(item, element, position, visit, arg);
+            position += stride;
+            continue;
+        }
+        // braces around a scalar
+        while (item->type == AST_INITIALIZER_LIST && item->initializer_list.items->count > 0) {
+            item = item->initializer_list.items->head->value;
+        }
+        if (item->type == AST_INITIALIZER_LIST) {
+            error("Empty initializer for an array element");
+        }
+        if (position >= end) {
+            warning("Excess elements in array initializer");
+            return;
+        }
+        visit(position++, item, arg);
+    }
+}
+
+static void fill_slot(int position, ASTNode * item, void * arg) {
+    ASTNode ** slots = arg;
+    slots[position] = item;
+}
+
+/* --- data directives --- */
+
+// a value repeated at least this often is written with times
+#define MIN_RUN_LENGTH 4
+
+/* writes the elements of an array as data directives. equal values are
+ * collected into runs, so a large zero tail is one times line.
+ */
+typedef struct DataWriter {
+    EmitterContext * ctx;
+    CType * element_type;
+    const char * directive;
+    uint64_t run_bits;
+    long run_length;
+    char line[1024];
+    int line_used;
+    int line_count;
+    long written;           // elements, including the pending run
+} DataWriter;
+
+static void init_data_writer(DataWriter * writer, EmitterContext * ctx, CType * element_type) {
+    writer->ctx = ctx;
+    writer->element_type = element_type;
+    writer->directive = get_data_directive(element_type);
+    writer->run_bits = 0;
+    writer->run_length = 0;
+    writer->line_used = 0;
+    writer->line_count = 0;
+    writer->written = 0;
+}
+
+static void flush_line(DataWriter * writer) {
+    if (writer->line_count > 0) {
+        emit_line(writer->ctx, "%s", writer->line);
+    }
+    writer->line_used = 0;
+    writer->line_count = 0;
+}
+
+static void append_value(DataWriter * writer, const char * text) {
+    if (writer->line_count == VALUES_PER_LINE) {
+        flush_line(writer);
+    }
+    char * end = writer->line + writer->line_used;
+    size_t room = sizeof(writer->line) - writer->line_used;
+    if (writer->line_count == 0) {
+        writer->line_used += snprintf(end, room, "    %s %s", writer->directive, text);
+    } else {
+        writer->line_used += snprintf(end, room, ", %s", text);
+    }
+    writer->line_count++;
+}
+
+static void flush_run(DataWriter * writer) {
+    char text[32];
+    snprintf(text, sizeof(text), "0x%llX", (unsigned long long) writer->run_bits);
+    if (writer->run_length >= MIN_RUN_LENGTH) {
+        flush_line(writer);
+        emit_line(writer->ctx, "    times %ld %s %s", writer->run_length, writer->directive, text);
+    } else {
+        for (long i = 0; i < writer->run_length; i++) {
+            append_value(writer, text);
+        }
+    }
+    writer->run_length = 0;
+}
+
+static void write_bits(DataWriter * writer, uint64_t bits, long count) {
+    if (count <= 0) return;
+    if (writer->run_length > 0 && writer->run_bits != bits) {
+        flush_run(writer);
+    }
+    writer->run_bits = bits;
+    writer->run_length += count;
+    writer->written += count;
+}
+
+static void write_label(DataWriter * writer, const char * label) {
+    flush_run(writer);
+    append_value(writer, label);
+    writer->written++;
+}
+
+static void finish_data(DataWriter * writer) {
+    flush_run(writer);
+    flush_line(writer);
+}
+
+static const char * size_keyword(int size) {
+    switch (size) {
+        case 1: return "BYTE";
+        case 2: return "WORD";
+        case 4: return "DWORD";
+        default: return "QWORD";
+    }
+}
+
+static void emit_copy_from_template(EmitterContext * ctx, const char * label, int offset, int bytes) {
+    if (bytes > INLINE_COPY_BYTES) {
+        emit_line(ctx, "lea rsi, [rel %s]", label);
+        emit_line(ctx, "lea rdi, [rbp%+d]", offset);
+        emit_line(ctx, "mov ecx, %d", bytes);
+        emit_line(ctx, "rep movsb");
+        return;
+    }
+    int done = 0;
+    for (; bytes - done >= 16; done += 16) {
+        emit_line(ctx, "movdqu xmm0, [rel %s+%d]", label, done);
+        emit_line(ctx, "movdqu [rbp%+d], xmm0", offset + done);
+    }
+    for (int width = 8; width >= 1; width /= 2) {
+        if (bytes - done >= width) {
+            const char * reg = phys_gpr_name(PR_RAX, width);
+            emit_line(ctx, "mov %s, [rel %s+%d]", reg, label, done);
+            emit_line(ctx, "mov [rbp%+d], %s", offset + done, reg);
+            done += width;
+        }
+    }
+}
+
+static void emit_zero_fill(EmitterContext * ctx, int offset, int bytes) {
+    int done = 0;
+    if (bytes > INLINE_ZERO_BYTES) {
+        emit_line(ctx, "lea rdi, [rbp%+d]", offset);
+        emit_line(ctx, "xor eax, eax");
+        emit_line(ctx, "mov ecx, %d", bytes / 8);
+        emit_line(ctx, "rep stosq");
+        done = bytes / 8 * 8;
+    } else if (bytes >= 16) {
+        emit_line(ctx, "pxor xmm0, xmm0");
+        for (; bytes - done >= 16; done += 16) {
+            emit_line(ctx, "movdqu [rbp%+d], xmm0", offset + done);
+        }
+    }
+    for (int width = 8; width >= 1; width /= 2) {
+        if (bytes - done >= width) {
+            emit_line(ctx, "mov %s [rbp%+d], 0", size_keyword(width), offset + done);
+            done += width;
+        }
+    }
+}
+
+static void emit_element_store(EmitterContext * ctx, ASTNode * value, CType * element_type, int offset) {
+    if (is_floating_point_type(element_type)) {
+        emit_fp_operand(ctx, value);
+    } else {
+        emit_int_operand(ctx, value);
+    }
+    emit_line(ctx, "%s %s [rbp%+d], %s", mov_instruction_for_type(element_type),
+              mem_size_for_type(element_type), offset, reg_for_type(element_type));
+}
+
+void emit_array_initializer(EmitterContext * ctx, ASTNode * var_decl) {
+    CType * element_type = get_base_type(var_decl->ctype);
+    int element_size = element_type->size;
+    int count = element_count(var_decl->ctype);
+    int offset = var_decl->symbol->info.array.offset;
+
+    ASTNode ** slots = calloc(count, sizeof(ASTNode *));
+    walk_items(var_decl->var_decl.init_expr, var_decl->ctype, 0, fill_slot, slots);
+
+    // the template ends at the last constant that is not zero
+    int template_count = 0;
+    for (int i = 0; i < count; i++) {
+        InitConstant value;
+        if (slots[i] && fold_constant(slots[i], &value) && constant_bits(&value, element_type) != 0) {
+            template_count = i + 1;
+        }
+    }
+
+    if (template_count > 0) {
+        ArrayTemplate * template = malloc(sizeof(ArrayTemplate));
+        template->label = make_label_text("ArrayInit", get_label_id(ctx));
+        template->element_type = element_type;
+        template->slots = slots;
+        template->count = template_count;
+        template->next = ctx->array_templates;
+        ctx->array_templates = template;
+        emit_copy_from_template(ctx, template->label, offset, template_count * element_size);
+        get_compile_stats()->array_templates++;
+    }
+    if (template_count < count) {
+        emit_zero_fill(ctx, offset + template_count * element_size, (count - template_count) * element_size);
+    }
+
+    for (int i = 0; i < count; i++) {
+        InitConstant value;
+        if (slots[i] && !fold_constant(slots[i], &value)) {
+            emit_line(ctx, "; initializing element %d", i);
+            emit_element_store(ctx, slots[i], element_type, offset + i * element_size);
+        }
+    }
+
+    if (template_count == 0) {
+        free(slots);
+    }
+}
+
+void emit_array_templates(EmitterContext * ctx) {
+    while (ctx->array_templates) {
+        ArrayTemplate * template = ctx->array_templates;
+        DataWriter writer;
+        init_data_writer(&writer, ctx, template->element_type);
+
+        emit_line(ctx, "align 16");
+        emit_line(ctx, "%s:", template->label);
+        for (int i = 0; i < template->count; i++) {
+            InitConstant value = { false, 0, 0 };
+            if (template->slots[i]) {
+                fold_constant(template->slots[i], &value);
+            }
+            write_bits(&writer, constant_bits(&value, template->element_type), 1);
+        }
+        finish_data(&writer);
+
+        ctx->array_templates = template->next;
+        free(template->label);
+        free(template->slots);
+        free(template);
+    }
+}
+
+/* --- globals --- */
+
+typedef struct ZeroCheck {
+    CType * element_type;
+    bool all_zero;
+} ZeroCheck;
+
+static void check_zero(int position, ASTNode * item, void * arg) {
+    ZeroCheck * check = arg;
+    InitConstant value;
+    if (!fold_constant(item, &value) || constant_bits(&value, check->element_type) != 0) {
+        check->all_zero = false;
+    }
+}
+
+bool is_zero_array_initializer(ASTNode * global_var) {
+    ZeroCheck check = { get_base_type(global_var->ctype), true };
+    walk_items(global_var->var_decl.init_expr, global_var->ctype, 0, check_zero, &check);
+    return check.all_zero;
+}
+
+static void write_global_element(int position, ASTNode * item, void * arg) {
+    DataWriter * writer = arg;
+    write_bits(writer, 0, position - writer->written);
+
+    InitConstant value;
+    if (fold_constant(item, &value)) {
+        write_bits(writer, constant_bits(&value, writer->element_type), 1);
+    } else if (item->type == AST_STRING_LITERAL && is_pointer_type(writer->element_type)) {
+        write_label(writer, item->string_literal.label);
+    } else {
+        error("Initializer element %d is not a constant", position);
+    }
+}
+
+void emit_global_array(EmitterContext * ctx, ASTNode * global_var) {
+    DataWriter writer;
+    init_data_writer(&writer, ctx, get_base_type(global_var->ctype));
+
+    emit_line(ctx, "%s:", global_var->var_decl.name);
+    walk_items(global_var->var_decl.init_expr, global_var->ctype, 0, write_global_element, &writer);
+    write_bits(&writer, 0, element_count(global_var->ctype) - writer.written);
+    finish_data(&writer);
+}
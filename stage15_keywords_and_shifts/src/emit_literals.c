@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "compile_stats.h"
+#include "emit_literals.h"
+
+/* the first literal seen with each content, found by its hash */
+typedef struct LiteralSlot {
+    const void * key;
+    size_t length;
+    uint64_t hash;
+    ASTNode * owner;
+} LiteralSlot;
+
+typedef struct LiteralTable {
+    LiteralSlot * slots;
+    int capacity;           // a power of two
+    int count;
+} LiteralTable;
+
+static uint64_t hash_bytes(const void * key, size_t length) {
+    const unsigned char * bytes = key;
+    uint64_t hash = 0xcbf29ce484222325;     // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+static void init_table(LiteralTable * table, int expected) {
+    table->capacity = 16;
+    while (table->capacity < expected * 2) {
+        table->capacity *= 2;
+    }
+    table->slots = calloc(table->capacity, sizeof(LiteralSlot));
+    table->count = 0;
+}
+
+/* the literal with the same content as node, which is node itself the first time */
+static ASTNode * intern(LiteralTable * table, const void * key, size_t length, ASTNode * node) {
+    uint64_t hash = hash_bytes(key, length);
+    int mask = table->capacity - 1;
+    for (int i = (int) (hash & mask); ; i = (i + 1) & mask) {
+        LiteralSlot * slot = &table->slots[i];
+        if (!slot->owner) {
+            slot->key = key;
+            slot->length = length;
+            slot->hash = hash;
+            slot->owner = node;
+            table->count++;
+            return node;
+        }
+        if (slot->hash == hash && slot->length == length && memcmp(slot->key, key, length) == 0) {
+            return slot->owner;
+        }
+    }
+}
+
+static void add_to_pool(LiteralPool * pool, ASTNode * node) {
+    if (pool->count == pool->capacity) {
+        pool->capacity = pool->capacity ? pool->capacity * 2 : 16;
+        pool->entries = realloc(pool->entries, pool->capacity * sizeof(ASTNode *));
+    }
+    pool->entries[pool->count++] = node;
+}
+
+static char ** label_of(ASTNode * node) {
+    switch (node->type) {
+        case AST_STRING_LITERAL: return &node->string_literal.label;
+        case AST_FLOAT_LITERAL: return &node->float_literal.label;
+        default: return &node->double_literal.label;
+    }
+}
+
+static const void * literal_key(ASTNode * node, size_t * length) {
+    switch (node->type) {
+        case AST_STRING_LITERAL:
+            *length = strlen(node->string_literal.value) + 1;
+            return node->string_literal.value;
+        case AST_FLOAT_LITERAL:
+            *length = sizeof(float);
+            return &node->float_literal.value;
+        default:
+            *length = sizeof(double);
+            return &node->double_literal.value;
+    }
+}
+
+/* keeps the first literal of each content in the pool. the table still
+ * maps every literal to that first one afterwards.
+ */
+static void pool_unique(LiteralTable * table, ASTNode_list * literals, LiteralPool * pool) {
+    init_table(table, literals->count);
+    for (ASTNode_list_node * n = literals->head; n; n = n->next) {
+        size_t length;
+        const void * key = literal_key(n->value, &length);
+        if (intern(table, key, length, n->value) == n->value) {
+            add_to_pool(pool, n->value);
+        } else {
+            get_compile_stats()->literal_bytes_merged += (int) length;
+        }
+    }
+}
+
+/* gives the rest of the literals the label of the one they were merged with */
+static void share_labels(LiteralTable * table, ASTNode_list * literals) {
+    for (ASTNode_list_node * n = literals->head; n; n = n->next) {
+        size_t length;
+        const void * key = literal_key(n->value, &length);
+        ASTNode * owner = intern(table, key, length, n->value);
+        *label_of(n->value) = *label_of(owner);
+    }
+    free(table->slots);
+}
+
+typedef struct PooledString {
+    ASTNode * node;
+    int index;              // in the pool
+} PooledString;
+
+/* orders strings by their reversed text, longest first among equal tails,
+ * so a string comes right after the strings that end with it
+ */
+static int compare_reversed(const void * a, const void * b) {
+    const char * s = ((const PooledString *) a)->node->string_literal.value;
+    const char * t = ((const PooledString *) b)->node->string_literal.value;
+    size_t i = strlen(s);
+    size_t j = strlen(t);
+    while (i > 0 && j > 0) {
+        unsigned char cs = s[--i];
+        unsigned char ct = t[--j];
+        if (cs != ct) {
+            return cs < ct ? 1 : -1;
+        }
+    }
+    return i > 0 ? -1 : (j > 0 ? 1 : 0);
+}
+
+static bool ends_with(const char * text, const char * tail) {
+    size_t text_length = strlen(text);
+    size_t tail_length = strlen(tail);
+    return tail_length <= text_length && memcmp(text + text_length - tail_length, tail, tail_length) == 0;
+}
+
+/* labels the unique strings. a string that is the tail of a longer one is
+ * labelled as an offset into it and dropped from the pool.
+ */
+static void merge_string_tails(EmitterContext * ctx, LiteralPool * pool) {
+    PooledString * sorted = malloc((pool->count + 1) * sizeof(PooledString));
+    bool * merged = calloc(pool->count + 1, sizeof(bool));
+    for (int i = 0; i < pool->count; i++) {
+        sorted[i].node = pool->entries[i];
+        sorted[i].index = i;
+    }
+    qsort(sorted, pool->count, sizeof(PooledString), compare_reversed);
+
+    ASTNode * host = NULL;
+    for (int i = 0; i < pool->count; i++) {
+        ASTNode * node = sorted[i].node;
+        if (host && ends_with(host->string_literal.value, node->string_literal.value)) {
+            int offset = (int) (strlen(host->string_literal.value) - strlen(node->string_literal.value));
+            int size = snprintf(NULL, 0, "%s+%d", host->string_literal.label, offset) + 1;
+            node->string_literal.label = malloc(size);
+            snprintf(node->string_literal.label, size, "%s+%d", host->string_literal.label, offset);
+            merged[sorted[i].index] = true;
+            get_compile_stats()->literal_bytes_merged += (int) strlen(node->string_literal.value) + 1;
+        } else {
+            host = node;
+            host->string_literal.label = make_label_text("Str", get_label_id(ctx));
+        }
+    }
+
+    // only the hosts are written out
+    int kept = 0;
+    for (int i = 0; i < pool->count; i++) {
+        if (!merged[i]) {
+            pool->entries[kept++] = pool->entries[i];
+        }
+    }
+    pool->count = kept;
+    free(sorted);
+    free(merged);
+}
+
+void assign_literal_labels(EmitterContext * ctx, ASTNode * translation_unit) {
+    LiteralPools * pools = calloc(1, sizeof(LiteralPools));
+    LiteralTable table;
+
+    pool_unique(&table, translation_unit->translation_unit.string_literals, &pools->strings);
+    merge_string_tails(ctx, &pools->strings);
+    share_labels(&table, translation_unit->translation_unit.string_literals);
+
+    pool_unique(&table, translation_unit->translation_unit.float_literals, &pools->floats);
+    for (int i = 0; i < pools->floats.count; i++) {
+        pools->floats.entries[i]->float_literal.label = make_label_text("Flt", get_label_id(ctx));
+    }
+    share_labels(&table, translation_unit->translation_unit.float_literals);
+
+    pool_unique(&table, translation_unit->translation_unit.double_literals, &pools->doubles);
+    for (int i = 0; i < pools->doubles.count; i++) {
+        pools->doubles.entries[i]->double_literal.label = make_label_text("Dbl", get_label_id(ctx));
+    }
+    share_labels(&table, translation_unit->translation_unit.double_literals);
+
+    ctx->literal_pools = pools;
+}
+
+void emit_literal_pools(EmitterContext * ctx) {
+    LiteralPools * pools = ctx->literal_pools;
+    if (!pools) {
+        return;
+    }
+    CompileStats * stats = get_compile_stats();
+
+    // 8 byte doubles first keep every constant aligned without padding
+    if (pools->doubles.count + pools->floats.count > 0) {
+        emit_line(ctx, "align 16");
+    }
+    for (int i = 0; i < pools->doubles.count; i++) {
+        ASTNode * node = pools->doubles.entries[i];
+        emit_double_literal(ctx, node->double_literal.label, node->double_literal.value);
+        stats->literal_bytes += sizeof(double);
+    }
+    for (int i = 0; i < pools->floats.count; i++) {
+        ASTNode * node = pools->floats.entries[i];
+        emit_float_literal(ctx, node->float_literal.label, node->float_literal.value);
+        stats->literal_bytes += sizeof(float);
+    }
+    for (int i = 0; i < pools->strings.count; i++) {
+        ASTNode * node = pools->strings.entries[i];
+        emit_string_literal(ctx, node->string_literal.label, node->string_literal.value);
+        stats->literal_bytes += (int) strlen(node->string_literal.value) + 1;
+    }
+
+    free(pools->strings.entries);
+    free(pools->floats.entries);
+    free(pools->doubles.entries);
+    free(pools);
+    ctx->literal_pools = NULL;
+}
@@ -0,0 +1,1105 @@
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "emitter.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "emit_stack.h"
+#include "emit_address.h"
+#include "emit_expression.h"
+#include "error.h"
+#include "emit_select.h"
+#include "emit_fp.h"
+#include "compiler_options.h"
+
+/* the parts of rax and rcx by operand size */
+typedef struct RegisterSet {
+    const char * byte;
+    const char * word;
+    const char * dword;
+    const char * qword;
+    const char * xmm;
+} RegisterSet;
+
+static const RegisterSet RAX = { "al", "ax", "eax", "rax", "xmm0" };
+static const RegisterSet RCX = { "cl", "cx", "ecx", "rcx", "xmm1" };
+static const RegisterSet RDX = { "dl", "dx", "edx", "rdx", NULL };
+
+typedef enum {
+    INDEX_CONSTANT,         // folds into the displacement
+    INDEX_VARIABLE,         // loaded straight into rdx
+    INDEX_COMPUTED          // evaluated through the stack, then popped into rdx
+} IndexKind;
+
+static const char * register_for(const RegisterSet * set, CType * ctype) {
+    if (is_floating_point_type(ctype)) return set->xmm;
+    switch (ctype->size) {
+        case 1: return set->byte;
+        case 2: return set->word;
+        case 4: return set->dword;
+        default: return set->qword;
+    }
+}
+
+static int element_size(CType * ctype) {
+    return ctype->base_type ? ctype->base_type->size : 1;
+}
+
+static void clear_address(Address * address) {
+    address->base = NULL;
+    address->label = NULL;
+    address->index = NULL;
+    address->scale = 1;
+    address->disp = 0;
+    address->reg = PR_NONE;
+    address->text[0] = '\0';
+    address->operand[0] = '\0';
+}
+
+const char * address_text(Address * address) {
+    if (address->reg != PR_NONE) {
+        error("A local kept in %s has no address", phys_gpr_name(address->reg, 8));
+    }
+    const char * base = address->label ? "rel " : "";
+    const char * name = address->label ? address->label : address->base;
+    char index[16] = "";
+    char disp[24] = "";
+    if (address->index) {
+        snprintf(index, sizeof index, "+%s*%d", address->index, address->scale);
+    }
+    if (address->disp) {
+        snprintf(disp, sizeof disp, "%+ld", address->disp);
+    }
+    int length = snprintf(address->text, sizeof address->text, "[%s%s%s%s]", base, name, index, disp);
+    if (length >= (int) sizeof address->text) {
+        error("Address of %s is too long", name);
+    }
+    return address->text;
+}
+
+const char * operand_text(Address * address, CType * ctype) {
+    if (address->reg != PR_NONE) {
+        return phys_gpr_name(address->reg, ctype->size);
+    }
+    snprintf(address->operand, sizeof address->operand, "%s %s", mem_size_for_type(ctype), address_text(address));
+    return address->operand;
+}
+
+bool literal_value(ASTNode * node, long * value) {
+    if (node->type == AST_INT_LITERAL) {
+        *value = node->int_value;
+        return true;
+    }
+    if (node->type != AST_CAST_EXPR || node->cast_expr.expr->type != AST_INT_LITERAL) return false;
+    if (!is_integer_type(node->ctype) && !is_pointer_type(node->ctype)) return false;
+
+    long constant = node->cast_expr.expr->int_value;
+    switch (node->ctype->size) {
+        case 1: constant = (signed char) constant; break;
+        case 2: constant = (short) constant; break;
+        case 4: constant = (int) constant; break;
+        default: break;
+    }
+    *value = constant;
+    return true;
+}
+
+bool has_direct_address(ASTNode * node) {
+    switch (node->type) {
+        case AST_VAR_DECL:
+        case AST_VAR_REF_EXPR:
+            return node->symbol != NULL;
+        case AST_ARRAY_ACCESS:
+            return is_array_type(node->array_access.base->ctype) &&
+                   has_direct_address(node->array_access.base) &&
+                   node->array_access.index->type == AST_INT_LITERAL;
+        default:
+            return false;
+    }
+}
+
+static bool is_scalar_lvalue(ASTNode * node) {
+    if (!node->ctype || !is_scalar_type(node->ctype)) return false;
+    switch (node->type) {
+        case AST_VAR_REF_EXPR:
+            return node->symbol != NULL;
+        case AST_ARRAY_ACCESS:
+            return true;
+        case AST_UNARY_EXPR:
+            return node->unary.op == UNARY_DEREF;
+        default:
+            return false;
+    }
+}
+
+/* literals and directly addressed integers load into any register with
+ * one instruction and without touching rcx or rdx
+ */
+static bool is_int_leaf(ASTNode * node) {
+    long constant;
+    if (literal_value(node, &constant)) return true;
+    return has_direct_address(node) && node->ctype &&
+           (is_integer_type(node->ctype) || is_pointer_type(node->ctype));
+}
+
+static bool is_fp_leaf(ASTNode * node, CTypeKind kind) {
+    if (!node->ctype || node->ctype->kind != kind) return false;
+    return node->type == AST_FLOAT_LITERAL || node->type == AST_DOUBLE_LITERAL || has_direct_address(node);
+}
+
+/* conversions the emitter does not need an instruction for */
+static ASTNode * strip_noop_casts(ASTNode * node) {
+    while (node->type == AST_CAST_EXPR) {
+        CType * from = node->cast_expr.expr->ctype;
+        CType * to = node->ctype;
+        bool integers = (is_integer_type(from) || is_pointer_type(from)) &&
+                        (is_integer_type(to) || is_pointer_type(to));
+        if (!(integers && from->size == to->size) && !(is_floating_point_type(to) && from->kind == to->kind)) break;
+        node = node->cast_expr.expr;
+    }
+    return node;
+}
+
+static void emit_load(EmitterContext * ctx, CType * ctype, Address * address, const RegisterSet * set) {
+    const char * source = operand_text(address, ctype);
+    switch (ctype->kind) {
+        case CTYPE_CHAR:
+        case CTYPE_SHORT:
+            emit_line(ctx, "%s %s, %s", ctype->is_signed ? "movsx" : "movzx", set->dword, source);
+            break;
+        case CTYPE_INT:
+            emit_line(ctx, "mov %s, %s", set->dword, source);
+            break;
+        case CTYPE_LONG:
+        case CTYPE_PTR:
+            emit_line(ctx, "mov %s, %s", set->qword, source);
+            break;
+        case CTYPE_FLOAT:
+            emit_line(ctx, "movss %s, %s", set->xmm, source);
+            break;
+        case CTYPE_DOUBLE:
+            emit_line(ctx, "movsd %s, %s", set->xmm, source);
+            break;
+        default:
+            error("Unsupported type %d for load", ctype->kind);
+    }
+}
+
+static void emit_store(EmitterContext * ctx, CType * ctype, Address * address, const RegisterSet * set) {
+    emit_line(ctx, "%s %s, %s", mov_instruction_for_type(ctype), operand_text(address, ctype),
+              register_for(set, ctype));
+}
+
+static void emit_push_value(EmitterContext * ctx, CType * ctype) {
+    if (is_floating_point_type(ctype)) {
+        emit_fpush(ctx, "xmm0", getFPWidthFromCType(ctype));
+    } else {
+        emit_push(ctx, "rax");
+    }
+}
+
+static void emit_pop_value(EmitterContext * ctx, CType * ctype) {
+    if (is_floating_point_type(ctype)) {
+        emit_fpop(ctx, "xmm0", getFPWidthFromCType(ctype));
+    } else {
+        emit_pop(ctx, "rax");
+    }
+}
+
+/* a leaf in set, extended to size bytes by the load itself: movsx, movzx
+ * or movsxd straight from memory, or a 64 bit mov of a literal
+ */
+static void emit_int_leaf_extended(EmitterContext * ctx, ASTNode * node, const RegisterSet * set, int size) {
+    CType * ctype = node->ctype;
+    bool wide = size == 8 || ctype->size == 8;
+    long constant;
+    if (literal_value(node, &constant)) {
+        emit_line(ctx, "mov %s, %ld", wide ? set->qword : set->dword, constant);
+        return;
+    }
+    Address address;
+    select_address(ctx, node, &address);
+    const char * source = operand_text(&address, ctype);
+    const char * reg = wide ? set->qword : set->dword;
+    switch (ctype->size) {
+        case 1:
+        case 2:
+            emit_line(ctx, "%s %s, %s", ctype->is_signed ? "movsx" : "movzx", reg, source);
+            break;
+        case 4:
+            if (wide && ctype->is_signed) {
+                emit_line(ctx, "movsxd %s, %s", set->qword, source);
+            } else {
+                emit_line(ctx, "mov %s, %s", set->dword, source);
+            }
+            break;
+        default:
+            emit_line(ctx, "mov %s, %s", set->qword, source);
+            break;
+    }
+}
+
+static void emit_int_leaf(EmitterContext * ctx, ASTNode * node, const RegisterSet * set) {
+    emit_int_leaf_extended(ctx, node, set, node->ctype->size);
+}
+
+/* sign or zero extends the value in set to size bytes, as far as value
+ * says it is not already, and records the new width
+ */
+static void emit_extend(EmitterContext * ctx, const RegisterSet * set, VReg * value, int size) {
+    if (width_bits(value->width) >= size * 8) return;
+    CType * ctype = value->ctype;
+    bool is_signed = is_signed_integer_type(ctype);
+    const char * reg = size == 8 ? set->qword : set->dword;
+    switch (ctype->size) {
+        case 1:
+            emit_line(ctx, "%s %s, %s", is_signed ? "movsx" : "movzx", reg, set->byte);
+            break;
+        case 2:
+            emit_line(ctx, "%s %s, %s", is_signed ? "movsx" : "movzx", reg, set->word);
+            break;
+        default:
+            // a 32 bit write has already cleared the upper half
+            if (is_signed) {
+                emit_line(ctx, "movsxd %s, %s", set->qword, set->dword);
+            } else if (value->zeroKind != ZK_ZEROEXT32) {
+                emit_line(ctx, "mov %s, %s", set->dword, set->dword);
+            }
+            break;
+    }
+    value->width = width_for_size(size);
+    value->zeroKind = size == 8 ? ZK_FULL64 : ZK_ZEROEXT32;
+}
+
+void select_fp_leaf(EmitterContext * ctx, ASTNode * node, Address * address) {
+    clear_address(address);
+    if (node->type == AST_FLOAT_LITERAL) {
+        address->label = node->float_literal.label;
+    } else if (node->type == AST_DOUBLE_LITERAL) {
+        address->label = node->double_literal.label;
+    } else {
+        select_address(ctx, node, address);
+    }
+}
+
+/* arithmetic, comparisons and calls leave their result in rax or xmm0
+ * when only the effect is asked for, so nothing needs to be pushed
+ */
+static bool leaves_result_in_register(ASTNode * node) {
+    if (node->type == AST_FUNCTION_CALL_EXPR || node->type == AST_COND_EXPR) return true;
+    // negation and conversions to float or double end in xmm0
+    if (node->type == AST_UNARY_EXPR && node->unary.op == UNARY_NEGATE) return is_floating_point_type(node->ctype);
+    if (node->type == AST_CAST_EXPR) return is_floating_point_type(node->ctype);
+    if (node->type != AST_BINARY_EXPR) return false;
+    switch (node->binary.op) {
+        case BINOP_ADD:
+        case BINOP_SUB:
+        case BINOP_MUL:
+        case BINOP_DIV:
+            return true;
+        case BINOP_MOD:
+        case BINOP_BITWISE_AND:
+        case BINOP_BITWISE_OR:
+        case BINOP_BITWISE_XOR:
+        case BINOP_SHIFT_LEFT:
+        case BINOP_SHIFT_RIGHT:
+        case BINOP_EQ:
+        case BINOP_NE:
+        case BINOP_LT:
+        case BINOP_LE:
+        case BINOP_GT:
+        case BINOP_GE:
+            return !is_floating_point_type(node->ctype);
+        default:
+            return false;
+    }
+}
+
+void emit_int_operand(EmitterContext * ctx, ASTNode * node) {
+    if (is_int_leaf(node) || (is_scalar_lvalue(node) && !is_floating_point_type(node->ctype))) {
+        emit_int_leaf(ctx, node, &RAX);
+        return;
+    }
+    if (leaves_result_in_register(node)) {
+        emit_int_expr_to_rax(ctx, node, WANT_EFFECT);
+        return;
+    }
+    emit_int_expr_to_rax(ctx, node, WANT_VALUE);
+    emit_pop(ctx, "rax");
+}
+
+static bool is_int_conversion(ASTNode * node) {
+    if (node->type != AST_CAST_EXPR) return false;
+    CType * from = node->cast_expr.expr->ctype;
+    return (is_integer_type(from) || is_pointer_type(from) || is_array_type(from)) &&
+           (is_integer_type(node->ctype) || is_pointer_type(node->ctype));
+}
+
+VReg int_operand_vreg(ASTNode * node) {
+    VReg value = make_vreg(RC_GPR, node->ctype);
+    value.phys = PR_RAX;
+    long constant;
+
+    if (!optimizations_enabled()) {
+        // nothing is assumed, so every operand is extended
+        return value;
+    }
+    if (literal_value(node, &constant)) {
+        // mov eax, imm clears the upper half, which extends anything positive
+        if (node->ctype->size < 8) {
+            value.width = constant >= 0 ? W64 : W32;
+            value.zeroKind = constant >= 0 ? ZK_FULL64 : ZK_ZEROEXT32;
+        }
+        return value;
+    }
+    if (is_int_leaf(node) || is_scalar_lvalue(node)) {
+        // char and short load with movsx or movzx into the 32 bit register
+        if (node->ctype->size < 8) {
+            value.width = W32;
+            value.zeroKind = ZK_ZEROEXT32;
+        }
+        return value;
+    }
+    if (is_int_conversion(node)) {
+        ASTNode * inner = node->cast_expr.expr;
+        int from_size = is_array_type(inner->ctype) ? 8 : inner->ctype->size;
+        int to_size = node->ctype->size;
+        if (from_size == to_size) {
+            value = int_operand_vreg(inner);
+            value.ctype = node->ctype;
+        } else if (to_size < 4 || (from_size > to_size && is_scalar_lvalue(inner))) {
+            value.width = W32;
+            value.zeroKind = ZK_ZEROEXT32;
+        } else if (to_size == 4) {
+            value.width = W32;
+        }
+        return value;
+    }
+    // 0 or 1, from setcc and movzx or from mov and xor
+    bool truth_value = (node->type == AST_BINARY_EXPR &&
+                        (is_comparison_op(node->binary.op) ||
+                         node->binary.op == BINOP_LOGICAL_AND || node->binary.op == BINOP_LOGICAL_OR)) ||
+                       (node->type == AST_UNARY_EXPR && node->unary.op == UNARY_LOGICAL_NOT);
+    if (truth_value) {
+        value.width = W64;
+        value.zeroKind = ZK_FULL64;
+    }
+    return value;
+}
+
+void emit_int_operand_extended(EmitterContext * ctx, ASTNode * node, int size) {
+    if (is_int_leaf(node) || (is_scalar_lvalue(node) && !is_floating_point_type(node->ctype))) {
+        emit_int_leaf_extended(ctx, node, &RAX, size);
+        return;
+    }
+    // (long) x on a variable loads x extended to the wider of the two
+    ASTNode * inner = node->type == AST_CAST_EXPR ? node->cast_expr.expr : NULL;
+    if (is_int_conversion(node) && is_scalar_lvalue(inner) && !is_floating_point_type(inner->ctype) &&
+        node->ctype->size > inner->ctype->size) {
+        emit_int_leaf_extended(ctx, inner, &RAX, size > node->ctype->size ? size : node->ctype->size);
+        return;
+    }
+    VReg value = int_operand_vreg(node);
+    emit_int_operand(ctx, node);
+    emit_extend(ctx, &RAX, &value, size);
+}
+
+bool emit_truncating_load(EmitterContext * ctx, ASTNode * node, CType * to_type) {
+    if (!optimizations_enabled() || !is_scalar_lvalue(node) || is_floating_point_type(node->ctype)) return false;
+    Address address;
+    select_address(ctx, node, &address);
+    emit_load(ctx, to_type, &address, &RAX);
+    return true;
+}
+
+void emit_fp_operand(EmitterContext * ctx, ASTNode * node) {
+    if (is_fp_zero(node)) {
+        emit_line(ctx, "xorps xmm0, xmm0");
+        return;
+    }
+    if (is_fp_leaf(node, node->ctype->kind) || is_scalar_lvalue(node)) {
+        Address address;
+        select_fp_leaf(ctx, node, &address);
+        emit_load(ctx, node->ctype, &address, &RAX);
+        return;
+    }
+    if (leaves_result_in_register(node)) {
+        emit_fp_expr_to_xmm0(ctx, node, WANT_EFFECT);
+        return;
+    }
+    emit_fp_expr_to_xmm0(ctx, node, WANT_VALUE);
+    emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->ctype));
+}
+
+static bool is_int_variable(ASTNode * node) {
+    return has_direct_address(node) && is_integer_type(node->ctype);
+}
+
+/* i, i + k, k + i and i - k for a variable i and constant k. unsigned
+ * variables only match alone, since their sum wraps before it is widened.
+ */
+static IndexKind classify_index(ASTNode * index, ASTNode ** variable, long * constant) {
+    *variable = NULL;
+    *constant = 0;
+    if (literal_value(index, constant)) return INDEX_CONSTANT;
+    if (is_int_variable(index)) {
+        *variable = index;
+        return INDEX_VARIABLE;
+    }
+    if (index->type != AST_BINARY_EXPR || !is_integer_type(index->ctype)) return INDEX_COMPUTED;
+
+    ASTNode * lhs = index->binary.lhs;
+    ASTNode * rhs = index->binary.rhs;
+    long k;
+    if (index->binary.op == BINOP_ADD || index->binary.op == BINOP_SUB) {
+        if (is_int_variable(lhs) && lhs->ctype->is_signed && literal_value(rhs, &k)) {
+            *variable = lhs;
+            *constant = index->binary.op == BINOP_ADD ? k : -k;
+            return INDEX_VARIABLE;
+        }
+        if (index->binary.op == BINOP_ADD && is_int_variable(rhs) && rhs->ctype->is_signed && literal_value(lhs, &k)) {
+            *variable = rhs;
+            *constant = k;
+            return INDEX_VARIABLE;
+        }
+    }
+    return INDEX_COMPUTED;
+}
+
+static void emit_index_load(EmitterContext * ctx, ASTNode * variable) {
+    Address address;
+    select_address(ctx, variable, &address);
+    CType * ctype = variable->ctype;
+    const char * source = operand_text(&address, ctype);
+    switch (ctype->size) {
+        case 1:
+        case 2:
+            emit_line(ctx, "%s rdx, %s", ctype->is_signed ? "movsx" : "movzx", source);
+            break;
+        case 4:
+            emit_line(ctx, ctype->is_signed ? "movsxd rdx, %s" : "mov edx, %s", source);
+            break;
+        default:
+            emit_line(ctx, "mov rdx, %s", source);
+            break;
+    }
+}
+
+/* rdx holds the index; element sizes the hardware cannot scale by are
+ * multiplied first
+ */
+static void scale_index(EmitterContext * ctx, Address * address, int size) {
+    address->index = "rdx";
+    if (size == 1 || size == 2 || size == 4 || size == 8) {
+        address->scale = size;
+        return;
+    }
+    emit_line(ctx, "imul rdx, rdx, %d", size);
+    address->scale = 1;
+}
+
+static void select_pointer(EmitterContext * ctx, ASTNode * pointer, Address * address) {
+    if (has_direct_address(pointer)) {
+        Address variable;
+        select_address(ctx, pointer, &variable);
+        emit_line(ctx, "mov rcx, %s", operand_text(&variable, pointer->ctype));
+    } else {
+        emit_int_expr_to_rax(ctx, pointer, WANT_VALUE);
+        emit_pop(ctx, "rcx");
+    }
+    clear_address(address);
+    address->base = "rcx";
+}
+
+/* the start of an array, or the value of a pointer. an address that is
+ * about to get an index must not have one already, nor be rip relative,
+ * so those are moved to rcx first.
+ */
+static void select_base(EmitterContext * ctx, ASTNode * base, Address * address, bool indexed) {
+    if (!is_array_type(base->ctype)) {
+        select_pointer(ctx, base, address);
+        return;
+    }
+    select_address(ctx, base, address);
+    if (indexed && (address->index || address->label)) {
+        emit_line(ctx, "lea rcx, %s", address_text(address));
+        clear_address(address);
+        address->base = "rcx";
+    }
+}
+
+static void select_indexed(EmitterContext * ctx, ASTNode * base, ASTNode * index, int size, Address * address) {
+    ASTNode * variable;
+    long constant;
+    IndexKind kind = classify_index(index, &variable, &constant);
+
+    if (kind == INDEX_COMPUTED) {
+        emit_int_expr_to_rax(ctx, index, WANT_VALUE);
+    }
+    select_base(ctx, base, address, kind != INDEX_CONSTANT);
+    if (kind == INDEX_COMPUTED) {
+        VReg value = int_operand_vreg(index);
+        emit_pop(ctx, "rdx");
+        emit_extend(ctx, &RDX, &value, 8);
+        scale_index(ctx, address, size);
+    } else if (kind == INDEX_VARIABLE) {
+        emit_index_load(ctx, variable);
+        scale_index(ctx, address, size);
+    }
+    address->disp += constant * size;
+}
+
+/* *(p + i) and *(p - k) are addressed like p[i] and p[-k] */
+static void select_dereference(EmitterContext * ctx, ASTNode * pointer, Address * address) {
+    if (pointer->type == AST_BINARY_EXPR) {
+        ASTNode * lhs = pointer->binary.lhs;
+        ASTNode * rhs = pointer->binary.rhs;
+        long constant;
+        if ((is_pointer_type(lhs->ctype) || is_array_type(lhs->ctype)) && is_integer_type(rhs->ctype)) {
+            if (pointer->binary.op == BINOP_ADD) {
+                select_indexed(ctx, lhs, rhs, element_size(lhs->ctype), address);
+                return;
+            }
+            if (pointer->binary.op == BINOP_SUB && literal_value(rhs, &constant)) {
+                select_base(ctx, lhs, address, false);
+                address->disp -= constant * element_size(lhs->ctype);
+                return;
+            }
+        }
+    }
+    select_base(ctx, pointer, address, false);
+}
+
+void select_address(EmitterContext * ctx, ASTNode * node, Address * address) {
+    clear_address(address);
+    switch (node->type) {
+        case AST_VAR_DECL:
+        case AST_VAR_REF_EXPR:
+            if (is_global_var(ctx, node)) {
+                address->label = node->symbol->name;
+            } else if (node->symbol->reg != PR_NONE) {
+                address->reg = node->symbol->reg;
+            } else {
+                address->base = "rbp";
+                address->disp = get_offset(ctx, node);
+            }
+            break;
+        case AST_STRING_LITERAL:
+            address->label = node->string_literal.label;
+            break;
+        case AST_ARRAY_ACCESS: {
+            CType * base_type = node->array_access.base->ctype;
+            if (!is_array_type(base_type) && !is_pointer_type(base_type)) {
+                error("Unsupported types for array access");
+            }
+            select_indexed(ctx, node->array_access.base, node->array_access.index, element_size(base_type), address);
+            break;
+        }
+        case AST_UNARY_EXPR:
+            if (node->unary.op != UNARY_DEREF) {
+                error("Unsupported unary operator in emit_addr");
+            }
+            select_dereference(ctx, node->unary.operand, address);
+            break;
+        default:
+            error("Unexpected node type %s", get_ast_node_name(node));
+    }
+}
+
+void emit_lvalue_to_reg(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    if (is_array_type(node->ctype)) {
+        emit_addr_to_rax(ctx, node, mode);
+        return;
+    }
+    Address address;
+    select_address(ctx, node, &address);
+    emit_load(ctx, node->ctype, &address, &RAX);
+    if (mode == WANT_VALUE) {
+        emit_push_value(ctx, node->ctype);
+    }
+}
+
+static bool is_leaf_value(ASTNode * node) {
+    if (is_floating_point_type(node->ctype)) return is_fp_leaf(node, node->ctype->kind);
+    return is_int_leaf(node);
+}
+
+/* the value of an assignment in rax or xmm0 */
+static void emit_value_operand(EmitterContext * ctx, ASTNode * value) {
+    if (is_array_type(value->ctype)) {
+        emit_addr_to_rax(ctx, value, WANT_EFFECT);
+    } else if (is_floating_point_type(value->ctype)) {
+        emit_fp_operand(ctx, value);
+    } else {
+        emit_int_operand(ctx, value);
+    }
+}
+
+void emit_store_to_lvalue(EmitterContext * ctx, ASTNode * target, ASTNode * value, EvalMode mode) {
+    CType * ctype = target->ctype;
+    Address address;
+    long constant;
+
+    if (!is_floating_point_type(ctype) && literal_value(value, &constant)) {
+        select_address(ctx, target, &address);
+        emit_line(ctx, "mov %s, %ld", operand_text(&address, ctype), constant);
+        if (mode == WANT_VALUE) {
+            emit_line(ctx, "mov %s, %ld", ctype->size == 8 ? "rax" : "eax", constant);
+            emit_push(ctx, "rax");
+        }
+        return;
+    }
+
+    if (has_direct_address(target)) {
+        // nothing is left in rcx or rdx, so the value may use them
+        emit_value_operand(ctx, value);
+        select_address(ctx, target, &address);
+    } else if (is_leaf_value(value)) {
+        select_address(ctx, target, &address);
+        emit_value_operand(ctx, value);
+    } else {
+        if (is_array_type(value->ctype)) {
+            emit_addr_to_rax(ctx, value, WANT_VALUE);
+        } else if (is_floating_point_type(value->ctype)) {
+            emit_fp_operand(ctx, value);
+            HeldFPValue held = hold_fp_value(ctx, value->ctype, target);
+            select_address(ctx, target, &address);
+            restore_fp_value(ctx, &held, "xmm0");
+            emit_store(ctx, ctype, &address, &RAX);
+            if (mode == WANT_VALUE) {
+                emit_push_value(ctx, ctype);
+            }
+            return;
+        } else {
+            emit_int_expr_to_rax(ctx, value, WANT_VALUE);
+        }
+        select_address(ctx, target, &address);
+        emit_pop_value(ctx, is_array_type(value->ctype) ? target->ctype : value->ctype);
+    }
+    emit_store(ctx, ctype, &address, &RAX);
+
+    if (mode == WANT_VALUE) {
+        emit_push_value(ctx, ctype);
+    }
+}
+
+static const char * rmw_instruction(BinaryOperator op, CType * ctype) {
+    switch (op) {
+        case BINOP_ADD: return "add";
+        case BINOP_SUB: return "sub";
+        case BINOP_BITWISE_AND: return "and";
+        case BINOP_BITWISE_OR: return "or";
+        case BINOP_BITWISE_XOR: return "xor";
+        case BINOP_SHIFT_LEFT: return "shl";
+        case BINOP_SHIFT_RIGHT: return ctype->is_signed ? "sar" : "shr";
+        default: return NULL;
+    }
+}
+
+static bool is_commutative(BinaryOperator op) {
+    return op == BINOP_ADD || op == BINOP_BITWISE_AND || op == BINOP_BITWISE_OR || op == BINOP_BITWISE_XOR;
+}
+
+bool same_lvalue(ASTNode * a, ASTNode * b) {
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case AST_VAR_REF_EXPR:
+            return a->symbol && a->symbol == b->symbol;
+        case AST_INT_LITERAL:
+            return a->int_value == b->int_value;
+        case AST_ARRAY_ACCESS:
+            return same_lvalue(a->array_access.base, b->array_access.base) &&
+                   same_lvalue(a->array_access.index, b->array_access.index);
+        case AST_UNARY_EXPR:
+            return a->unary.op == UNARY_DEREF && b->unary.op == UNARY_DEREF &&
+                   same_lvalue(a->unary.operand, b->unary.operand);
+        default:
+            return false;
+    }
+}
+
+/* x = x op y or x = y op x for a commutative op, giving op and y */
+static bool match_assignment(ASTNode * node, BinaryOperator * op, ASTNode ** value) {
+    ASTNode * target = node->binary.lhs;
+    ASTNode * rhs = strip_noop_casts(node->binary.rhs);
+    if (rhs->type != AST_BINARY_EXPR || !rhs->ctype || rhs->ctype->kind != target->ctype->kind) return false;
+    if (!rmw_instruction(rhs->binary.op, target->ctype)) return false;
+    if (is_pointer_type(target->ctype) && rhs->binary.op != BINOP_ADD && rhs->binary.op != BINOP_SUB) return false;
+
+    if (same_lvalue(strip_noop_casts(rhs->binary.lhs), target)) {
+        *value = rhs->binary.rhs;
+    } else if (is_commutative(rhs->binary.op) && same_lvalue(strip_noop_casts(rhs->binary.rhs), target)) {
+        *value = rhs->binary.lhs;
+    } else {
+        return false;
+    }
+    long constant;
+    bool shift = rhs->binary.op == BINOP_SHIFT_LEFT || rhs->binary.op == BINOP_SHIFT_RIGHT;
+    if (shift && !literal_value(*value, &constant)) return false;
+    *op = rhs->binary.op;
+    return is_integer_type((*value)->ctype);
+}
+
+static void emit_rmw(EmitterContext * ctx, ASTNode * target, BinaryOperator op, ASTNode * value,
+                     bool postfix, EvalMode mode) {
+    CType * ctype = target->ctype;
+    int scale = is_pointer_type(ctype) ? element_size(ctype) : 1;
+    Address address;
+    char source[32];
+    long constant = 1;
+
+    // pointers step by whole elements of the integer before it was cast
+    if (value && is_pointer_type(ctype) && value->type == AST_CAST_EXPR &&
+        is_integer_type(value->cast_expr.expr->ctype)) {
+        value = value->cast_expr.expr;
+    }
+
+    if (!value || literal_value(value, &constant)) {
+        select_address(ctx, target, &address);
+        snprintf(source, sizeof source, "%ld", constant * scale);
+    } else {
+        if (is_int_leaf(value)) {
+            select_address(ctx, target, &address);
+            emit_int_leaf_extended(ctx, value, &RAX, ctype->size);
+        } else {
+            VReg extension = int_operand_vreg(value);
+            emit_int_expr_to_rax(ctx, value, WANT_VALUE);
+            select_address(ctx, target, &address);
+            emit_pop(ctx, "rax");
+            emit_extend(ctx, &RAX, &extension, ctype->size);
+        }
+        if (scale > 1) {
+            emit_line(ctx, "imul rax, rax, %d", scale);
+        }
+        snprintf(source, sizeof source, "%s", register_for(&RAX, ctype));
+    }
+
+    if (postfix && mode == WANT_VALUE) {
+        emit_load(ctx, ctype, &address, &RAX);
+    }
+    emit_line(ctx, "%s %s, %s", rmw_instruction(op, ctype), operand_text(&address, ctype), source);
+    if (!postfix && mode == WANT_VALUE) {
+        emit_load(ctx, ctype, &address, &RAX);
+    }
+    if (mode == WANT_VALUE) {
+        emit_push(ctx, "rax");
+    }
+}
+
+bool emit_read_modify_write(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    ASTNode * target;
+    ASTNode * value = NULL;
+    BinaryOperator op;
+    bool postfix = false;
+
+    if (node->type == AST_UNARY_EXPR) {
+        switch (node->unary.op) {
+            case UNARY_POST_INC: postfix = true; // fall through
+            case UNARY_PRE_INC: op = BINOP_ADD; break;
+            case UNARY_POST_DEC: postfix = true; // fall through
+            case UNARY_PRE_DEC: op = BINOP_SUB; break;
+            default: return false;
+        }
+        target = node->unary.operand;
+    } else if (node->type == AST_BINARY_EXPR) {
+        target = node->binary.lhs;
+        if (node->binary.op == BINOP_COMPOUND_ADD_ASSIGN || node->binary.op == BINOP_COMPOUND_SUB_ASSIGN) {
+            op = node->binary.op == BINOP_COMPOUND_ADD_ASSIGN ? BINOP_ADD : BINOP_SUB;
+            value = node->binary.rhs;
+        } else if (node->binary.op != BINOP_ASSIGNMENT || !is_scalar_lvalue(target) ||
+                   !match_assignment(node, &op, &value)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    if (!is_scalar_lvalue(target) || is_floating_point_type(target->ctype)) return false;
+    emit_rmw(ctx, target, op, value, postfix, mode);
+    return true;
+}
+
+void emit_fp_compound_assignment(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    ASTNode * target = node->binary.lhs;
+    ASTNode * value = strip_noop_casts(node->binary.rhs);
+    CType * ctype = target->ctype;
+    bool add = node->binary.op == BINOP_COMPOUND_ADD_ASSIGN;
+    const char * instruction = ctype->kind == CTYPE_FLOAT ? (add ? "addss" : "subss") : (add ? "addsd" : "subsd");
+    Address address;
+
+    if (is_fp_leaf(value, ctype->kind)) {
+        Address source;
+        select_address(ctx, target, &address);
+        emit_load(ctx, ctype, &address, &RAX);
+        select_fp_leaf(ctx, value, &source);
+        emit_line(ctx, "%s xmm0, %s", instruction, operand_text(&source, ctype));
+    } else {
+        emit_fp_operand(ctx, value);
+        HeldFPValue held = hold_fp_value(ctx, ctype, target);
+        select_address(ctx, target, &address);
+        restore_fp_value(ctx, &held, "xmm1");
+        emit_load(ctx, ctype, &address, &RAX);
+        emit_line(ctx, "%s xmm0, xmm1", instruction);
+    }
+    emit_store(ctx, ctype, &address, &RAX);
+
+    if (mode == WANT_VALUE) {
+        emit_fpush(ctx, "xmm0", getFPWidthFromCType(ctype));
+    }
+}
+
+static const char * alu_instruction(BinaryOperator op) {
+    switch (op) {
+        case BINOP_ADD: return "add";
+        case BINOP_SUB: return "sub";
+        case BINOP_MUL: return "imul";
+        case BINOP_BITWISE_AND: return "and";
+        case BINOP_BITWISE_OR: return "or";
+        case BINOP_BITWISE_XOR: return "xor";
+        default: return NULL;
+    }
+}
+
+static int exact_log2(long value) {
+    if (value <= 0 || (value & (value - 1))) return -1;
+    int shift = 0;
+    while (value > 1) {
+        value >>= 1;
+        shift++;
+    }
+    return shift;
+}
+
+/* powers of two shift, and 3, 5 and 9 add the value to itself scaled */
+static void emit_multiply_immediate(EmitterContext * ctx, const char * reg, long constant) {
+    int shift = exact_log2(constant);
+    if (shift == 0) return;
+    if (shift > 0) {
+        emit_line(ctx, "shl %s, %d", reg, shift);
+    } else if (constant == 3 || constant == 5 || constant == 9) {
+        emit_line(ctx, "lea %s, [rax+rax*%ld]", reg, constant - 1);
+    } else {
+        emit_line(ctx, "imul %s, %s, %ld", reg, reg, constant);
+    }
+}
+
+/* y * 2, 4 or 8, or y << 1, 2 or 3, all of which lea scales for free */
+static bool scaled_term(ASTNode * node, CTypeKind kind, ASTNode ** term, int * scale) {
+    long constant;
+    if (node->type != AST_BINARY_EXPR || !node->ctype || node->ctype->kind != kind) return false;
+    if (node->binary.lhs->ctype->kind != kind || !literal_value(node->binary.rhs, &constant)) return false;
+    if (node->binary.op == BINOP_MUL && (constant == 2 || constant == 4 || constant == 8)) {
+        *scale = (int) constant;
+    } else if (node->binary.op == BINOP_SHIFT_LEFT && constant >= 1 && constant <= 3) {
+        *scale = 1 << constant;
+    } else {
+        return false;
+    }
+    *term = node->binary.lhs;
+    return true;
+}
+
+bool emit_int_binary_tile(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    CType * ctype = node->ctype;
+    ASTNode * lhs = node->binary.lhs;
+    ASTNode * rhs = node->binary.rhs;
+    BinaryOperator op = node->binary.op;
+    if (!optimizations_enabled()) return false;
+    if (!ctype || (ctype->kind != CTYPE_INT && ctype->kind != CTYPE_LONG) || lhs->ctype->kind != ctype->kind) {
+        return false;
+    }
+
+    const char * reg = register_for(&RAX, ctype);
+    bool same_kind = rhs->ctype->kind == ctype->kind;
+    ASTNode * term;
+    int scale;
+    long constant;
+
+    if (literal_value(rhs, &constant)) {
+        if (op == BINOP_MUL) {
+            emit_int_operand(ctx, lhs);
+            emit_multiply_immediate(ctx, reg, constant);
+        } else if (op == BINOP_SHIFT_LEFT || op == BINOP_SHIFT_RIGHT) {
+            emit_int_operand(ctx, lhs);
+            emit_line(ctx, "%s %s, %ld", rmw_instruction(op, ctype), reg, constant);
+        } else if (alu_instruction(op)) {
+            emit_int_operand(ctx, lhs);
+            emit_line(ctx, "%s %s, %ld", alu_instruction(op), reg, constant);
+        } else {
+            return false;
+        }
+    } else if (alu_instruction(op) && same_kind && is_int_leaf(rhs)) {
+        Address source;
+        emit_int_operand(ctx, lhs);
+        select_address(ctx, rhs, &source);
+        emit_line(ctx, "%s %s, %s", alu_instruction(op), reg, operand_text(&source, ctype));
+    } else if (op == BINOP_ADD && same_kind && scaled_term(rhs, ctype->kind, &term, &scale)) {
+        emit_operands_to_rax_rcx(ctx, lhs, term);
+        emit_line(ctx, "lea %s, [rax+rcx*%d]", reg, scale);
+    } else if (op == BINOP_ADD && same_kind && scaled_term(lhs, ctype->kind, &term, &scale)) {
+        emit_operands_to_rax_rcx(ctx, rhs, term);
+        emit_line(ctx, "lea %s, [rax+rcx*%d]", reg, scale);
+    } else {
+        return false;
+    }
+
+    if (mode == WANT_VALUE) {
+        emit_push(ctx, "rax");
+    }
+    return true;
+}
+
+bool emit_fp_binary_tile(EmitterContext * ctx, ASTNode * node, EvalMode mode) {
+    ASTNode * lhs = node->binary.lhs;
+    ASTNode * rhs = strip_noop_casts(node->binary.rhs);
+    CType * ctype = node->ctype;
+    if (!optimizations_enabled() || !ctype || lhs->ctype->kind != ctype->kind) return false;
+    if (!is_fp_leaf(rhs, ctype->kind)) {
+        // x + y and x * y take either operand from memory
+        bool commutes = node->binary.op == BINOP_ADD || node->binary.op == BINOP_MUL;
+        ASTNode * leaf = strip_noop_casts(lhs);
+        if (!commutes || !is_fp_leaf(leaf, ctype->kind) || node->binary.rhs->ctype->kind != ctype->kind) return false;
+        lhs = node->binary.rhs;
+        rhs = leaf;
+    }
+
+    Address source;
+    emit_fp_operand(ctx, lhs);
+    select_fp_leaf(ctx, rhs, &source);
+    emit_line(ctx, "%s xmm0, %s", get_fp_binop(node), operand_text(&source, ctype));
+
+    if (mode == WANT_VALUE) {
+        emit_fpush(ctx, "xmm0", getFPWidthFromCType(ctype));
+    }
+    return true;
+}
+
+bool emit_int_compare_tile(EmitterContext * ctx, ASTNode * node) {
+    ASTNode * lhs = node->binary.lhs;
+    ASTNode * rhs = node->binary.rhs;
+    CType * ctype = node->binary.common_type;
+    CType * lhs_type = lhs->ctype;
+    if (!optimizations_enabled()) return false;
+    if (!ctype || is_floating_point_type(ctype) || !is_scalar_type(lhs_type) || is_floating_point_type(lhs_type)) {
+        return false;
+    }
+    // mixed int and long operands keep going through the stack
+    if ((lhs_type->size != 4 && lhs_type->size != 8) || lhs_type->size != ctype->size) return false;
+
+    const char * reg = register_for(&RAX, lhs_type);
+    Address address;
+    long constant;
+
+    if (literal_value(rhs, &constant)) {
+        if (is_scalar_lvalue(lhs)) {
+            select_address(ctx, lhs, &address);
+            emit_line(ctx, "cmp %s, %ld", operand_text(&address, lhs_type), constant);
+        } else {
+            emit_int_operand(ctx, lhs);
+            emit_line(ctx, "cmp %s, %ld", reg, constant);
+        }
+        return true;
+    }
+    if (is_int_leaf(rhs) && rhs->ctype->size == lhs_type->size) {
+        emit_int_operand(ctx, lhs);
+        select_address(ctx, rhs, &address);
+        emit_line(ctx, "cmp %s, %s", reg, operand_text(&address, lhs_type));
+        return true;
+    }
+    return false;
+}
+
+static void emit_fp_comparison_flags(EmitterContext * ctx, ASTNode * node, bool swapped) {
+    CType * ctype = node->binary.common_type;
+    const char * compare = ctype->kind == CTYPE_FLOAT ? "ucomiss" : "ucomisd";
+    ASTNode * first = swapped ? node->binary.rhs : node->binary.lhs;
+    ASTNode * second = strip_noop_casts(swapped ? node->binary.lhs : node->binary.rhs);
+
+    // loading a leaf has no side effects, so it can come after the other operand
+    if (optimizations_enabled() && is_fp_leaf(second, ctype->kind) && first->ctype->kind == ctype->kind) {
+        Address source;
+        emit_fp_operand(ctx, first);
+        select_fp_leaf(ctx, second, &source);
+        emit_line(ctx, "%s xmm0, %s", compare, operand_text(&source, ctype));
+        return;
+    }
+    emit_fp_operands(ctx, node->binary.lhs, node->binary.rhs);
+    emit_line(ctx, swapped ? "%s xmm1, xmm0" : "%s xmm0, xmm1", compare);
+}
+
+void emit_comparison_flags(EmitterContext * ctx, ASTNode * node, bool swapped) {
+    CType * ctype = node->binary.common_type;
+    if (is_floating_point_type(ctype)) {
+        emit_fp_comparison_flags(ctx, node, swapped);
+        return;
+    }
+    if (emit_int_compare_tile(ctx, node)) {
+        return;
+    }
+    CType * lhs_type = node->binary.lhs->ctype;
+    CType * rhs_type = node->binary.rhs->ctype;
+    if (ctype->size == 8 || lhs_type->size == 8 || rhs_type->size == 8) {
+        emit_operands_extended(ctx, node->binary.lhs, node->binary.rhs, 8);
+        emit_line(ctx, "cmp rax, rcx");
+    } else {
+        emit_operands_to_rax_rcx(ctx, node->binary.lhs, node->binary.rhs);
+        emit_line(ctx, "cmp eax, ecx");
+    }
+}
+
+bool emit_int_test_tile(EmitterContext * ctx, ASTNode * node) {
+    CType * ctype = node->ctype;
+    if (!ctype || !(is_integer_type(ctype) || is_pointer_type(ctype))) return false;
+
+    if (optimizations_enabled() && is_scalar_lvalue(node)) {
+        Address address;
+        select_address(ctx, node, &address);
+        emit_line(ctx, "cmp %s, 0", operand_text(&address, ctype));
+        return true;
+    }
+    emit_int_operand(ctx, node);
+    emit_line(ctx, ctype->size == 8 ? "test rax, rax" : "test eax, eax");
+    return true;
+}
+
+void emit_operands_to_rax_rcx(EmitterContext * ctx, ASTNode * lhs, ASTNode * rhs) {
+    if (is_int_leaf(rhs)) {
+        emit_int_operand(ctx, lhs);
+        emit_int_leaf(ctx, rhs, &RCX);
+        return;
+    }
+    if (is_int_leaf(lhs)) {
+        emit_int_operand(ctx, rhs);
+        emit_line(ctx, "mov rcx, rax");
+        emit_int_leaf(ctx, lhs, &RAX);
+        return;
+    }
+    emit_int_expr_to_rax(ctx, lhs, WANT_VALUE);
+    emit_int_operand(ctx, rhs);
+    emit_line(ctx, "mov rcx, rax");
+    emit_pop(ctx, "rax");
+}
+
+void emit_operands_extended(EmitterContext * ctx, ASTNode * lhs, ASTNode * rhs, int size) {
+    if (is_int_leaf(rhs)) {
+        emit_int_operand_extended(ctx, lhs, size);
+        emit_int_leaf_extended(ctx, rhs, &RCX, size);
+        return;
+    }
+    if (is_int_leaf(lhs)) {
+        emit_int_operand_extended(ctx, rhs, size);
+        emit_line(ctx, "mov rcx, rax");
+        emit_int_leaf_extended(ctx, lhs, &RAX, size);
+        return;
+    }
+    // push and pop keep all 64 bits, so lhs comes back as wide as it was computed
+    VReg value = int_operand_vreg(lhs);
+    emit_int_expr_to_rax(ctx, lhs, WANT_VALUE);
+    emit_int_operand_extended(ctx, rhs, size);
+    emit_line(ctx, "mov rcx, rax");
+    emit_pop(ctx, "rax");
+    emit_extend(ctx, &RAX, &value, size);
+}
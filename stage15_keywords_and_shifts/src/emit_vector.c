@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "emitter.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "emit_stack.h"
+#include "emit_address.h"
+#include "emit_expression.h"
+#include "emit_select.h"
+#include "error.h"
+#include "compile_stats.h"
+#include "compiler_options.h"
+#include "vectorize.h"
+#include "emit_vector.h"
+
+/* reductions keep two accumulators so consecutive additions do not wait
+ * on each other
+ */
+#define REDUCTION_ACCUMULATORS 2
+
+typedef struct VectorForm {
+    int size;               // bytes per element
+    int width;              // elements per xmm register
+    const char * move;      // unaligned load and store
+    const char * zero;
+} VectorForm;
+
+static const VectorForm INT_FORM = { 4, 4, "movdqu", "pxor" };
+static const VectorForm FLOAT_FORM = { 4, 4, "movups", "xorps" };
+static const VectorForm DOUBLE_FORM = { 8, 2, "movupd", "xorpd" };
+
+static const VectorForm * form_for(CType * element_type) {
+    switch (element_type->kind) {
+        case CTYPE_FLOAT: return &FLOAT_FORM;
+        case CTYPE_DOUBLE: return &DOUBLE_FORM;
+        default: return &INT_FORM;
+    }
+}
+
+static const char * packed_op(BinaryOperator op, CType * element_type) {
+    switch (element_type->kind) {
+        case CTYPE_FLOAT:
+            switch (op) {
+                case BINOP_ADD: return "addps";
+                case BINOP_SUB: return "subps";
+                case BINOP_MUL: return "mulps";
+                case BINOP_DIV: return "divps";
+                default: break;
+            }
+            break;
+        case CTYPE_DOUBLE:
+            switch (op) {
+                case BINOP_ADD: return "addpd";
+                case BINOP_SUB: return "subpd";
+                case BINOP_MUL: return "mulpd";
+                case BINOP_DIV: return "divpd";
+                default: break;
+            }
+            break;
+        default:
+            switch (op) {
+                case BINOP_ADD: return "paddd";
+                case BINOP_SUB: return "psubd";
+                case BINOP_BITWISE_AND: return "pand";
+                case BINOP_BITWISE_OR: return "por";
+                case BINOP_BITWISE_XOR: return "pxor";
+                default: break;
+            }
+            break;
+    }
+    error("No packed instruction for binary operator %d", op);
+    return NULL;
+}
+
+/* scalar operands are computed once and copied to every lane. lhs goes to
+ * xmm6 and rhs to xmm7; both are evaluated before either is broadcast so
+ * evaluating one cannot disturb the other.
+ */
+static void emit_scalar_operands(EmitterContext * ctx, VectorLoop * loop) {
+    ASTNode * operands[2] = { loop->lhs, loop->rhs };
+    const char * lanes[2] = { "xmm6", "xmm7" };
+    bool fp = is_floating_point_type(loop->element_type);
+    FPWidth width = fp ? getFPWidthFromCType(loop->element_type) : FPWIDTHUNKN;
+
+    for (int k = 0; k < 2; k++) {
+        if (!operands[k] || is_vector_array_operand(operands[k])) continue;
+        if (fp) {
+            emit_fp_expr_to_xmm0(ctx, operands[k], WANT_VALUE);
+        } else {
+            emit_int_expr_to_rax(ctx, operands[k], WANT_VALUE);
+        }
+    }
+    for (int k = 1; k >= 0; k--) {
+        if (!operands[k] || is_vector_array_operand(operands[k])) continue;
+        const char * lane = lanes[k];
+        switch (loop->element_type->kind) {
+            case CTYPE_FLOAT:
+                emit_fpop(ctx, "xmm0", width);
+                emit_line(ctx, "movaps %s, xmm0", lane);
+                emit_line(ctx, "shufps %s, %s, 0", lane, lane);
+                break;
+            case CTYPE_DOUBLE:
+                emit_fpop(ctx, "xmm0", width);
+                emit_line(ctx, "movapd %s, xmm0", lane);
+                emit_line(ctx, "unpcklpd %s, %s", lane, lane);
+                break;
+            default:
+                emit_pop(ctx, "rax");
+                emit_line(ctx, "movd %s, eax", lane);
+                emit_line(ctx, "pshufd %s, %s, 0", lane, lane);
+                break;
+        }
+    }
+}
+
+static void emit_array_base(EmitterContext * ctx, ASTNode * access, const char * reg) {
+    emit_addr_to_rax(ctx, access->array_access.base, WANT_EFFECT);
+    emit_line(ctx, "mov %s, rax", reg);
+}
+
+/* loads element i + offset of an array operand, or the broadcast scalar */
+static void emit_load_operand(EmitterContext * ctx, const VectorForm * form, ASTNode * operand,
+                              const char * base, const char * lane, int offset, const char * xmm) {
+    if (is_vector_array_operand(operand)) {
+        emit_line(ctx, "%s %s, [%s + rsi*%d + %d]", form->move, xmm, base, form->size, offset * form->size);
+    } else {
+        emit_line(ctx, "movaps %s, %s", xmm, lane);
+    }
+}
+
+/* xmm0 and xmm3 hold partial sums; they are folded into one lane and added
+ * to the accumulator
+ */
+static void emit_horizontal_sum(EmitterContext * ctx, VectorLoop * loop) {
+    Address address;
+    select_address(ctx, loop->target, &address);
+    const char * acc = operand_text(&address, loop->element_type);
+    switch (loop->element_type->kind) {
+        case CTYPE_FLOAT:
+            emit_line(ctx, "addps xmm0, xmm3");
+            emit_line(ctx, "movhlps xmm1, xmm0");
+            emit_line(ctx, "addps xmm0, xmm1");
+            emit_line(ctx, "movaps xmm1, xmm0");
+            emit_line(ctx, "shufps xmm1, xmm1, 0x55");
+            emit_line(ctx, "addss xmm0, xmm1");
+            emit_line(ctx, "addss xmm0, %s", acc);
+            emit_line(ctx, "movss %s, xmm0", acc);
+            break;
+        case CTYPE_DOUBLE:
+            emit_line(ctx, "addpd xmm0, xmm3");
+            emit_line(ctx, "movhlps xmm1, xmm0");
+            emit_line(ctx, "addsd xmm0, xmm1");
+            emit_line(ctx, "addsd xmm0, %s", acc);
+            emit_line(ctx, "movsd %s, xmm0", acc);
+            break;
+        default:
+            emit_line(ctx, "paddd xmm0, xmm3");
+            emit_line(ctx, "pshufd xmm1, xmm0, 0x4e");
+            emit_line(ctx, "paddd xmm0, xmm1");
+            emit_line(ctx, "pshufd xmm1, xmm0, 0xb1");
+            emit_line(ctx, "paddd xmm0, xmm1");
+            emit_line(ctx, "movd ecx, xmm0");
+            emit_line(ctx, "add %s, ecx", acc);
+            break;
+    }
+}
+
+static void emit_reduction_step(EmitterContext * ctx, VectorLoop * loop, const VectorForm * form,
+                                int offset, const char * sum) {
+    emit_load_operand(ctx, form, loop->lhs, "r9", "xmm6", offset, "xmm1");
+    if (loop->op != BINOP_UNASSIGNED_OP) {
+        emit_load_operand(ctx, form, loop->rhs, "r10", "xmm7", offset, "xmm2");
+        emit_line(ctx, "%s xmm1, xmm2", packed_op(loop->op, loop->element_type));
+    }
+    emit_line(ctx, "%s %s, xmm1", packed_op(BINOP_ADD, loop->element_type), sum);
+}
+
+static void emit_elementwise_step(EmitterContext * ctx, VectorLoop * loop, const VectorForm * form) {
+    emit_load_operand(ctx, form, loop->lhs, "r9", "xmm6", 0, "xmm1");
+    if (loop->op != BINOP_UNASSIGNED_OP) {
+        const char * rhs = "xmm7";
+        if (is_vector_array_operand(loop->rhs)) {
+            emit_load_operand(ctx, form, loop->rhs, "r10", "xmm7", 0, "xmm2");
+            rhs = "xmm2";
+        }
+        emit_line(ctx, "%s xmm1, %s", packed_op(loop->op, loop->element_type), rhs);
+    }
+    emit_line(ctx, "%s [r8 + rsi*%d], xmm1", form->move, form->size);
+}
+
+/* runs as many iterations as fit in whole registers, leaving the
+ * induction variable at the first element the scalar loop still has to do.
+ * rsi holds the index, and a full step fits while it is below rdx;
+ * array bases are in r8 (destination), r9 (lhs) and r10 (rhs).
+ */
+void emit_vector_loop(EmitterContext * ctx, ASTNode * node) {
+    VectorLoop loop;
+    if (!match_vector_loop(node, &loop)) return;
+
+    const VectorForm * form = form_for(loop.element_type);
+    bool reduction = loop.kind == VECTOR_REDUCTION;
+    int step = reduction ? form->width * REDUCTION_ACCUMULATORS : form->width;
+
+    char * loop_label = make_label_text("vector_loop", get_label_id(ctx));
+    char * end_label = make_label_text("vector_end", get_label_id(ctx));
+
+    emit_line(ctx, "; vectorized loop, %d elements per iteration", step);
+    emit_scalar_operands(ctx, &loop);
+
+    if (!reduction) {
+        emit_addr_to_rax(ctx, loop.target, WANT_EFFECT);
+        emit_line(ctx, "mov r8, rax");
+    }
+    if (is_vector_array_operand(loop.lhs)) {
+        emit_array_base(ctx, loop.lhs, "r9");
+    }
+    if (is_vector_array_operand(loop.rhs)) {
+        emit_array_base(ctx, loop.rhs, "r10");
+    }
+
+    Address iv;
+    select_address(ctx, loop.iv, &iv);
+    emit_line(ctx, "movsxd rsi, %s", operand_text(&iv, loop.iv->ctype));
+    if (loop.bound->type == AST_INT_LITERAL) {
+        emit_line(ctx, "mov rdx, %d", loop.bound->int_value);
+    } else {
+        Address bound;
+        select_address(ctx, loop.bound, &bound);
+        emit_line(ctx, "movsxd rdx, %s", operand_text(&bound, loop.bound->ctype));
+    }
+    emit_line(ctx, "sub rdx, %d", loop.inclusive ? step - 2 : step - 1);
+    emit_line(ctx, "cmp rsi, rdx");
+    emit_jump_from_text(ctx, "jge", end_label);
+
+    if (reduction) {
+        emit_line(ctx, "%s xmm0, xmm0", form->zero);
+        emit_line(ctx, "%s xmm3, xmm3", form->zero);
+    }
+
+    if (get_compiler_options()->align_loops) {
+        emit_line(ctx, "align 16");
+    }
+    emit_label_from_text(ctx, loop_label);
+    if (reduction) {
+        emit_reduction_step(ctx, &loop, form, 0, "xmm0");
+        emit_reduction_step(ctx, &loop, form, form->width, "xmm3");
+    } else {
+        emit_elementwise_step(ctx, &loop, form);
+    }
+    emit_line(ctx, "add rsi, %d", step);
+    emit_line(ctx, "cmp rsi, rdx");
+    emit_jump_from_text(ctx, "jl", loop_label);
+
+    if (reduction) {
+        emit_horizontal_sum(ctx, &loop);
+    }
+    emit_line(ctx, "mov %s, esi", operand_text(&iv, loop.iv->ctype));
+    emit_label_from_text(ctx, end_label);
+
+    get_compile_stats()->loops_vectorized++;
+
+    free(loop_label);
+    free(end_label);
+}
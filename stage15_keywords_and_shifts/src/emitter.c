@@ -20,6 +20,13 @@
 #include "emitter_helpers.h"
 #include "emit_address.h"
 #include "emit_expression.h"
+#include "emit_condition.h"
+#include "emit_vector.h"
+#include "emit_select.h"
+#include "emit_branchless.h"
+#include "emit_initializer.h"
+#include "emit_literals.h"
+#include "compiler_options.h"
 
 
 // Register order for integer/pointer args in AMD64
@@ -35,39 +42,20 @@ bool wantAddress(EvalMode mode) { return mode == WANT_ADDRESS; }
 void emit_header(EmitterContext * ctx) {
     emit_line(ctx, "section .text");
     emit_line(ctx, "global main");
-    // emit external declaration that will need to be removed later
-    emit_line(ctx, "extern printf");
     emit_line(ctx, "");
 }
 
-void emit_rodata(EmitterContext * ctx, ASTNode_list * string_literals, ASTNode_list * float_literals, ASTNode_list * double_literals) {
+void emit_rodata(EmitterContext * ctx) {
     emit_line(ctx, "");
     emit_line(ctx, "section .rodata");
-    emit_line(ctx, "assert_fail_msg: db \"Assertion failed!\", 10, 0");
-    emit_line(ctx, "mask_f32:     dd    0x80000000");
-    emit_line(ctx, "mask_f64:     dq    0x8000000000000000");
-    emit_line(ctx, "dbl_format:  db \"Double: %%f\", 10, 0");
-    emit_line(ctx, "str_format:  db \"String: %%s\", 10, 0");
-    emit_line(ctx, "int_format:  db \"Integer: %%d\", 10, 0");
-
-    for (ASTNode_list_node * n = string_literals->head; n; n = n->next) {
-        ASTNode * str_literal = n->value;
-        emit_string_literal(ctx, str_literal->string_literal.label, str_literal->string_literal.value);
-//        emit_line(ctx, "%s: db %s, 0", str_literal->string_literal.label, escaped_string(str_literal->string_literal.value));
-    }
-
-    for (ASTNode_list_node * n = float_literals->head; n; n = n->next) {
-        ASTNode * float_literal = n->value;
-        emit_float_literal(ctx, float_literal->float_literal.label, float_literal->float_literal.value);
-        //        emit_line(ctx, "%s: db %s, 0", str_literal->string_literal.label, escaped_string(str_literal->string_literal.value));
-    }
-
-    for (ASTNode_list_node * n = double_literals->head; n; n = n->next) {
-        ASTNode * double_literal = n->value;
-        emit_double_literal(ctx, double_literal->double_literal.label, double_literal->double_literal.value);
-        //        emit_line(ctx, "%s: db %s, 0", str_literal->string_literal.label, escaped_string(str_literal->string_literal.value));
-    }
-
+    RuntimeUsage * usage = &ctx->runtime_usage;
+    // the sign masks fill a whole register, so xorps can take them from memory
+    if (usage->mask_f32 || usage->mask_f64) emit_line(ctx, "align 16");
+    if (usage->mask_f32) emit_line(ctx, "mask_f32:     times 4 dd 0x80000000");
+    if (usage->mask_f64) emit_line(ctx, "mask_f64:     times 2 dq 0x8000000000000000");
+
+    emit_literal_pools(ctx);
+    emit_array_templates(ctx);
 }
 
 void emit_text_section_header(EmitterContext * ctx) {
@@ -78,8 +66,13 @@ void emit_text_section_header(EmitterContext * ctx) {
     emit_line(ctx, "");
     emit_line(ctx, "section .text");
     emit_line(ctx, "global main");
-    // emit external declaration that will need to be removed later
-    emit_line(ctx, "extern printf");
+    // the _print and _assert routines live in libmimic99_runtime.a
+    RuntimeUsage * usage = &ctx->runtime_usage;
+    if (usage->print_int) emit_line(ctx, "extern __mimic99_print_int");
+    if (usage->print_long) emit_line(ctx, "extern __mimic99_print_long");
+    if (usage->print_double) emit_line(ctx, "extern __mimic99_print_double");
+    if (usage->print_string) emit_line(ctx, "extern __mimic99_print_string");
+    if (usage->assert_fail) emit_line(ctx, "extern __mimic99_assert_fail");
 
     emit_line(ctx, "");
 }
@@ -122,59 +115,23 @@ char * get_string_literal_label(ASTNode* node, char * literal) {
     return "\0";
 }
 
+/* initialized arrays whose elements are all zero take no space in the file */
+static bool is_zero_global(ASTNode * global_var) {
+    return is_array_type(global_var->ctype) && is_zero_array_initializer(global_var);
+}
+
 void emit_translation_unit(EmitterContext * ctx, ASTNode * node) {
     emit_data_section_header(ctx);
 
-    for (ASTNode_list_node * n = node->translation_unit.string_literals->head; n; n = n->next) {
-        ASTNode * str_literal = n->value;
-        char * label = make_label_text("Str", get_label_id(ctx));
-        str_literal->string_literal.label = label;
-    }
-
-    for (ASTNode_list_node * n = node->translation_unit.float_literals->head; n; n = n->next) {
-        ASTNode * float_literal = n->value;
-        char * label = make_label_text("Flt", get_label_id(ctx));
-        float_literal->float_literal.label = label;
-    }
-
-    for (ASTNode_list_node * n = node->translation_unit.double_literals->head; n; n = n->next) {
-        ASTNode * double_literal = n->value;
-        char * label = make_label_text("Dbl", get_label_id(ctx));
-        double_literal->float_literal.label = label;
-    }
+    assign_literal_labels(ctx, node);
 
     for (ASTNode_list_node * n = node->translation_unit.globals->head; n; n = n->next) {
         ASTNode * global_var = n->value;
-        if (global_var->var_decl.init_expr) {
+        if (global_var->var_decl.init_expr && !is_zero_global(global_var)) {
             // TODO write out correct emit_tree_node(ctx, n->value);
             char * data_directive = get_data_directive(global_var->ctype);
             if (is_array_type(global_var->ctype)) {
-                ASTNode * init_expr = global_var->var_decl.init_expr;
-                ASTNode_list * init_list = init_expr->initializer_list.items;
-                ASTNode_list * flattened_list = create_node_list();
-                flatten_list(init_list, flattened_list);
-                char buff[1024];
-                buff[0] = '\0';
-                int total_elements = get_total_nested_array_elements(global_var);
-                if (total_elements < flattened_list->count) {
-                    error("Array has too many items in initializer");
-                }
-                size_t used = snprintf(buff, sizeof(buff), "%s:   %s ", global_var->var_decl.name, data_directive);
-                for (int i = 0; i < total_elements; i++) {
-                    if (i > 0) {
-                        used += snprintf(buff + used, sizeof(buff) - used, ",");
-                    }
-                    if (i < flattened_list->count) {
-                        int value = ASTNode_list_get(flattened_list, i)->int_value;
-                        used += snprintf(buff+used, sizeof(buff) - used, " %d", value);
-                    }
-                    else {
-                        used += snprintf(buff+used, sizeof(buff)  -used,  " 0");
-                    }
-                }
-                emit_line(ctx, buff);
-                // global_var->ctype->array_len < global_var->var_decl.init_expr ? 1 : 0;
-                // for (int i=0;global_var->)
+                emit_global_array(ctx, global_var);
             }
             else if (is_pointer_type(global_var->ctype) && global_var->ctype->base_type->kind == CTYPE_CHAR ) {
                 char * literal_label = get_string_literal_label(node, global_var->var_decl.init_expr->string_literal.value);
@@ -195,10 +152,10 @@ void emit_translation_unit(EmitterContext * ctx, ASTNode * node) {
     emit_bss_section_header(ctx);
     for (ASTNode_list_node * n = node->translation_unit.globals->head; n; n = n->next) {
         ASTNode * global_var = n->value;
-        if (!global_var->var_decl.init_expr) {
+        if (!global_var->var_decl.init_expr || is_zero_global(global_var)) {
             // TODO write out correct emit_tree_node(ctx, n->value);
             char * reservation_directive = get_reservation_directive(global_var->ctype);
-            int size = (is_array_type(global_var->ctype) ? global_var->ctype->array_len : 1);
+            int size = get_total_nested_array_elements(global_var);
             emit_line(ctx, "%s: %s %d", global_var->var_decl.name, reservation_directive, size);
         }
     }
@@ -207,75 +164,93 @@ void emit_translation_unit(EmitterContext * ctx, ASTNode * node) {
     for (ASTNode_list_node * n = node->translation_unit.functions->head; n; n = n->next) {
         emit_tree_node(ctx, n->value);
     }
-    emit_rodata(ctx, node->translation_unit.string_literals, node->translation_unit.float_literals, node->translation_unit.double_literals);
+    emit_rodata(ctx);
 }
 
 void emit_if_statement(EmitterContext * ctx, ASTNode * node) {
+    if (emit_branchless_if(ctx, node)) {
+        return;
+    }
     int id = get_label_id(ctx);
-    // eval condition
-    emit_int_expr_to_rax(ctx, node->if_stmt.cond, WANT_VALUE);
-    emit_pop(ctx, "rax");
-    // compare result with 0
-    emit_line(ctx, "cmp eax, 0");
+    char * else_label = make_label_text("else", id);
+    char * end_label = make_label_text("end", id);
 
+    // the then branch falls through from the test
+    emit_branch(ctx, node->if_stmt.cond, node->if_stmt.else_stmt ? else_label : end_label, false);
+    emit_tree_node(ctx, node->if_stmt.then_stmt);
     if (node->if_stmt.else_stmt) {
-        emit_line(ctx, "je Lelse%d", id);  // jump to else if false
-        emit_tree_node(ctx, node->if_stmt.then_stmt);
-        emit_line(ctx, "jmp Lend%d", id);  // jump to end over else
-        emit_label(ctx, "else", id);
+        emit_jump_from_text(ctx, "jmp", end_label);  // jump to end over else
+        emit_label_from_text(ctx, else_label);
         emit_tree_node(ctx, node->if_stmt.else_stmt);
     }
-    else {
-        emit_line(ctx, "je Lend%d", id);  // skip over if false
-        emit_tree_node(ctx, node->if_stmt.then_stmt);
+    emit_label_from_text(ctx, end_label);
+
+    free(else_label);
+    free(end_label);
+}
+
+/* pads the top of a loop body to a 16 byte boundary when --align-loops is given */
+static void emit_loop_alignment(EmitterContext * ctx) {
+    if (get_compiler_options()->align_loops) {
+        emit_line(ctx, "align 16");
     }
-    emit_label(ctx, "end", id);
 }
 
+/* loops are emitted in rotated form: a guard test skips the loop when the
+ * condition is false on entry, and the test at the bottom branches back to
+ * the body while it holds. each iteration then takes a single conditional
+ * branch instead of a test at the top and a jmp back.
+ */
 void emit_while_statement(EmitterContext * ctx, ASTNode * node) {
 
     char * loop_start_label = make_label_text("while_start", get_label_id(ctx));
     char * loop_end_label = make_label_text("while_end", get_label_id(ctx));
+    char * condition_label = make_label_text("while_condition", get_label_id(ctx));
 
-    //emit_expr(ctx, node->switch_stmt.expr);
-    //emit_line(ctx, "push rax   ; save switch expression");
-    //emit_push(ctx, "rax");
-
+    push_loop_context(ctx, condition_label, loop_end_label);
 
-    push_loop_context(ctx, loop_start_label, loop_end_label);
+    // guard
+    emit_branch(ctx, node->while_stmt.cond, loop_end_label, false);
 
-    // start label
+    emit_loop_alignment(ctx);
     emit_label_from_text(ctx, loop_start_label);
-    // eval cond
-    emit_int_expr_to_rax(ctx, node->while_stmt.cond, WANT_VALUE);
-    emit_pop(ctx, "rax");
-    // cmp to zero
-    emit_line(ctx, "cmp eax, 0");
-    // jmp to end if condition not met
-    emit_jump_from_text(ctx, "je", loop_end_label);
     emit_tree_node(ctx, node->while_stmt.body);
-    // jmp to start
-    emit_jump_from_text(ctx, "jmp", loop_start_label);
+
+    // continue jumps to the test at the bottom
+    emit_label_from_text(ctx, condition_label);
+    emit_branch(ctx, node->while_stmt.cond, loop_start_label, true);
     emit_label_from_text(ctx, loop_end_label);
 
+    pop_loop_context(ctx);
+
     free(loop_start_label);
     free(loop_end_label);
-
+    free(condition_label);
 }
 
 void emit_do_while_statement(EmitterContext * ctx, ASTNode * node) {
     int id = get_label_id(ctx);
-    emit_label(ctx, "do_while_start", id);
+    char * start_label = make_label_text("do_while_start", id);
+    char * condition_label = make_label_text("do_while_condition", id);
+    char * end_label = make_label_text("do_while_end", id);
+
+    push_loop_context(ctx, condition_label, end_label);
+
+    emit_loop_alignment(ctx);
+    emit_label_from_text(ctx, start_label);
     emit_line(ctx, "; emitting do_while main body statement");
     emit_tree_node(ctx, node->do_while_stmt.body);
 
     emit_line(ctx, "; emitting do_while condition expression");
-    emit_int_expr_to_rax(ctx, node->do_while_stmt.expr, WANT_VALUE);
-    emit_pop(ctx, "rax");
+    emit_label_from_text(ctx, condition_label);
+    emit_branch(ctx, node->do_while_stmt.expr, start_label, true);
+    emit_label_from_text(ctx, end_label);
 
-    emit_line(ctx, "cmp eax, 0");
-    emit_jump(ctx, "jne", "do_while_start", id);
-    emit_label(ctx, "do_while_end", id);
+    pop_loop_context(ctx);
+
+    free(start_label);
+    free(condition_label);
+    free(end_label);
 }
 
 void emit_block(EmitterContext * ctx, ASTNode * node, bool enterNewScope) {
@@ -314,17 +289,33 @@ void emit_function_definition(EmitterContext * ctx, ASTNode * node) {
         emit_line(ctx, "sub rsp, %d        ; allocating space for locals", aligned_space);
     }
 
+    // the registers promoted locals live in belong to the caller
+    for (int i = 0; i < node->function_def.saved_registers; i++) {
+        emit_line(ctx, "mov [rbp%+d], %s", node->function_def.save_area + 8 * i,
+                  phys_gpr_name(callee_saved_gpr(i), 8));
+    }
+
     if (node->function_def.param_list) {
         for (const ASTNode_list_node * n = node->function_def.param_list->head;n;n=n->next) {
-            emit_var_declaration(ctx, n->value);
+            ASTNode * param = n->value;
+            emit_var_declaration(ctx, param);
+            if (param->symbol->reg != PR_NONE) {
+                emit_line(ctx, "mov %s, [rbp%+d]", phys_gpr_name(param->symbol->reg, param->ctype->size),
+                          param->symbol->info.var.offset);
+            }
         }
     }
 
     emit_block(ctx, node->function_def.body, false);
 
     emit_label_from_text(ctx, func_end_label);
+    for (int i = 0; i < node->function_def.saved_registers; i++) {
+        emit_line(ctx, "mov %s, [rbp%+d]", phys_gpr_name(callee_saved_gpr(i), 8),
+                  node->function_def.save_area + 8 * i);
+    }
     emit_leave(ctx);
     emit_line(ctx, "ret");
+    emit_assert_failure_paths(ctx, node->function_def.name);
 
     assert(ctx->stack_depth == 0);
     ctx->stack_depth = prev_stack_depth;
@@ -342,73 +333,11 @@ void emit_var_declaration(EmitterContext * ctx, ASTNode * node) {
 
     if (node->var_decl.init_expr->type == AST_INITIALIZER_LIST) {
         emit_line(ctx,"; initializing array");
-        Symbol * symbol = node->symbol;
-        ASTNode_list * init_items = node->var_decl.init_expr->initializer_list.items;
-        ASTNode_list * flattened_list = create_node_list();
-        flatten_list(init_items, flattened_list);
-        int total_items = get_total_nested_array_elements(node);
-//            for (int i=0;i<init_items->count;i++) {
-//            for (int i=0;i<node->ctype->array_len;i++) {
-        for (int i = 0; i < total_items; i++) {
-            emit_line(ctx, "; initializing element %d", i);
-
-            if (i < flattened_list->count) {
-                ASTNode * init_value = ASTNode_list_get(flattened_list, i);
-                //emit_int_expr_to_rax(ctx, init_value, WANT_VALUE);
-                emit_expr_to_reg(ctx, init_value, WANT_VALUE);
-            }
-            else {
-                emit_line(ctx, "mov eax, 0");
-                emit_line(ctx, "push rax");
-            }
-
-            int offset = symbol->info.array.offset + i*sizeof_basetype(node->ctype);
-
-            emit_line(ctx, "lea rcx, [rbp%+d]", offset);
-
-//                emit_line(ctx, "pop rax");
-            //emit_pop(ctx, "rax");
-            emit_pop_for_type(ctx, node->ctype->base_type);
-
-            emit_line(ctx, "%s [rcx], %s", mov_instruction_for_type(node->ctype),
-                reg_for_type(node->ctype));
-        }
+        emit_array_initializer(ctx, node);
     }
     else {
         emit_line(ctx,"; initializing variable");
-        if (is_array_type(node->var_decl.init_expr->ctype)) {
-            emit_addr_to_rax(ctx, node->var_decl.init_expr, WANT_ADDRESS);
-        } else if (is_floating_point_type(node->var_decl.init_expr->ctype)) {
-            emit_fp_expr_to_xmm0(ctx, node->var_decl.init_expr, WANT_VALUE);
-        }
-        else {
-            emit_int_expr_to_rax(ctx, node->var_decl.init_expr, WANT_VALUE);
-        }
-        emit_addr_to_rax(ctx, node, WANT_VALUE);
-        // emit_line(ctx, "pop rcx");
-        // emit_line(ctx, "pop rax");
-        emit_pop(ctx, "rcx");
-        //emit_pop(ctx, "rax");
-        emit_pop_for_type(ctx, node->ctype);
-
-        // emit a line to copy register value to proper address
-        // example: mov [rcx], eax
-        emit_line(ctx, "%s %s [rcx], %s",
-            mov_instruction_for_type(node->ctype),
-            mem_size_for_type(node->ctype),
-            reg_for_type(node->ctype));
-        // if (node->ctype->kind == CTYPE_CHAR) {
-        //     emit_line(ctx, "mov BYTE [rcx], al\n");
-        // } else if (node->ctype->kind == CTYPE_SHORT) {
-        //     emit_line(ctx, "mov WORD [rcx], ax\n");
-        // } else if (node->ctype->kind == CTYPE_INT) {
-        //     emit_line(ctx, "mov DWORD [rcx], eax\n");
-        // } else if (node->ctype->kind == CTYPE_LONG || node->ctype->kind == CTYPE_PTR) {
-        //     emit_line(ctx, "mov QWORD [rcx], rax\n");
-        // }
-        // else {
-        //     error("Unsupported type");
-        // }
+        emit_store_to_lvalue(ctx, node, node->var_decl.init_expr, WANT_EFFECT);
     }
     // char * reference_label = create_variable_reference(ctx, node);
     // emit_tree_node(ctx, node->var_decl.init_expr);
@@ -421,7 +350,6 @@ void emit_for_statement(EmitterContext * ctx, ASTNode * node) {
 
     char * start_label = make_label_text("for_start", get_label_id(ctx));
     char * end_label = make_label_text("for_end", get_label_id(ctx));
-    char * condition_label = make_label_text("for_condition", get_label_id(ctx));
     char * continue_label = make_label_text("for_continue", get_label_id(ctx));
 
     push_loop_context(ctx, continue_label, end_label);
@@ -432,14 +360,17 @@ void emit_for_statement(EmitterContext * ctx, ASTNode * node) {
         emit_tree_node(ctx, node->for_stmt.init_expr);
     }
 
-    // jump to condition check
-    emit_jump_from_text(ctx, "jmp", condition_label);
+    // whole registers of elements first, the loop below finishes the rest
+    emit_vector_loop(ctx, node);
 
-    // jump label (target) for main body start
-    emit_label_from_text(ctx, start_label);
+    // guard, rotated the same way as a while loop
+    if (node->for_stmt.cond_expr) {
+        emit_branch(ctx, node->for_stmt.cond_expr, end_label, false);
+    }
 
-    // loop body start
-    emit_block(ctx, node->for_stmt.body, false);
+    emit_loop_alignment(ctx);
+    emit_label_from_text(ctx, start_label);
+    emit_tree_node(ctx, node->for_stmt.body);
 
     // emit continue label
     emit_label_from_text(ctx, continue_label);
@@ -450,16 +381,12 @@ void emit_for_statement(EmitterContext * ctx, ASTNode * node) {
     }
 
     // loop condition
-    emit_label_from_text(ctx, condition_label);
     if (node->for_stmt.cond_expr) {
-        emit_int_expr_to_rax(ctx, node->for_stmt.cond_expr, WANT_VALUE);
-        emit_pop(ctx, "rax");
-        emit_line(ctx, "cmp eax, 0");
-        emit_jump_from_text(ctx, "je", end_label);     // exit if false
+        emit_branch(ctx, node->for_stmt.cond_expr, start_label, true);
+    } else {
+        emit_jump_from_text(ctx, "jmp", start_label);
     }
 
-    emit_jump_from_text(ctx, "jmp", start_label);
-    
     // end/break label
     emit_label_from_text(ctx, end_label);
 
@@ -467,7 +394,6 @@ void emit_for_statement(EmitterContext * ctx, ASTNode * node) {
 
     free(start_label);
     free(end_label);
-    free(condition_label);
     free(continue_label);
 
 }
@@ -649,12 +575,10 @@ void emit_tree_node(EmitterContext * ctx, ASTNode * node) {
                 emit_pop(ctx, "rax");
             }
             else if (is_floating_point_type(node->ctype)) {
-                emit_fp_expr_to_xmm0(ctx, node->return_stmt.expr, WANT_VALUE);
+                emit_fp_operand(ctx, node->return_stmt.expr);
                 if (ctx->functionExitStack && ctx->functionExitStack->exit_label) {
                     emit_jump_from_text(ctx, "jmp", ctx->functionExitStack->exit_label);
                 }
-                //            emit_line(ctx, "pop rax");
-                emit_fpop(ctx, "xmm0", getFPWidthFromCType(node->ctype));
             }
             else {
                 error("invalid return statement type");
@@ -733,7 +657,8 @@ void emit_tree_node(EmitterContext * ctx, ASTNode * node) {
         case AST_ARRAY_ACCESS:
         case AST_FLOAT_LITERAL:
         case AST_DOUBLE_LITERAL: {
-            emit_expr_to_reg(ctx, node, WANT_VALUE);
+            // a statement like i++ is only evaluated for its effect
+            emit_expr_to_reg(ctx, node, is_inc_dec(node) ? WANT_EFFECT : WANT_VALUE);
             // if (is_floating_point_type(node->ctype)) {
             //     emit_fp_expr_to_xmm0(ctx, node, WANT_VALUE);
             // } else {
@@ -744,6 +669,11 @@ void emit_tree_node(EmitterContext * ctx, ASTNode * node) {
 
         case AST_EXPRESSION_STMT: {
             ASTNode * expr = node->expr_stmt.expr;
+            if (expr && expr->type == AST_FUNCTION_CALL_EXPR) {
+                // result is discarded
+                emit_expr_to_reg(ctx, expr, WANT_EFFECT);
+                break;
+            }
             emit_tree_node(ctx, expr);
 // //            emit_expr_to_reg(ctx, expr, WANT_EFFECT);
 //
@@ -800,14 +730,12 @@ void emit_tree_node(EmitterContext * ctx, ASTNode * node) {
 
 void emit(EmitterContext * ctx, ASTNode * translation_unit) {
    // populate_symbol_table(translation_unit);
-    emit_tree_node(ctx, translation_unit);
-
-    // emit referenced private functions
-    if (ctx->emit_print_int_extension) {
-        emit_print_int_extension_function(ctx);
+    bool gas = get_compiler_options()->asm_dialect == ASM_GAS;
+    if (gas) {
+        emit_line(ctx, ".intel_syntax noprefix");
     }
-    if (ctx->emit_print_double_extension) {
-        emit_print_double_extension_function(ctx);
+    emit_tree_node(ctx, translation_unit);
+    if (gas) {
+        emit_line(ctx, ".section .note.GNU-stack,\"\",@progbits");
     }
-
 }
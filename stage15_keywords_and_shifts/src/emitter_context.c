@@ -8,6 +8,8 @@
 #include "ast.h"
 #include "symbol.h"
 #include "emitter_context.h"
+#include "asm_writer.h"
+#include "compile_stats.h"
 
 
 EmitterContext * create_emitter_context(const char * filename) {
@@ -17,14 +19,17 @@ EmitterContext * create_emitter_context(const char * filename) {
     EmitterContext * ctx = malloc(sizeof(EmitterContext));
     ctx->label_id = 0;
     ctx->filename = strdup(filename);
-    ctx->out = fopen(ctx->filename, "w");
-    ctx->emit_print_int_extension = false;
-    ctx->emit_print_double_extension = false;
+    ctx->out = asm_writer_open(ctx->filename);
     ctx->functionExitStack = NULL;
     ctx->switch_stack = NULL;
     ctx->loop_stack = NULL;
     ctx->stack_depth = 0;
     ctx->local_space = 0;
+    ctx->fp_held = 0;
+    ctx->array_templates = NULL;
+    ctx->literal_pools = NULL;
+    ctx->assert_sites = NULL;
+    runtime_usage_init(&ctx->runtime_usage, true);
     return ctx;
 }
 
@@ -32,16 +37,24 @@ EmitterContext * create_emitter_context_from_fp(FILE * file) {
     EmitterContext * ctx = malloc(sizeof(EmitterContext));
     ctx->label_id = 0;
     ctx->filename = strdup("memf");
-    ctx->out = file;
-    ctx->emit_print_int_extension = false;
+    ctx->out = asm_writer_from_fp(file);
     ctx->functionExitStack = NULL;
     ctx->switch_stack = NULL;
     ctx->loop_stack = NULL;
+    ctx->stack_depth = 0;
+    ctx->local_space = 0;
+    ctx->fp_held = 0;
+    ctx->array_templates = NULL;
+    ctx->literal_pools = NULL;
+    ctx->assert_sites = NULL;
+    runtime_usage_init(&ctx->runtime_usage, true);
     return ctx;
 }
 
 void emitter_finalize(EmitterContext * ctx) {
-    fclose(ctx->out);
+    asm_writer_flush(ctx->out);
+    get_compile_stats()->asm_bytes += ctx->out->bytes_written;
+    asm_writer_close(ctx->out);
     free(ctx->filename);
     free(ctx);
 }
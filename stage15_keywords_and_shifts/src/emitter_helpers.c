@@ -24,6 +24,8 @@
 #include "symbol.h"
 #include "emitter_helpers.h"
 #include "emit_stack.h"
+#include "asm_dialect.h"
+#include "compiler_options.h"
 
 
 char * escaped_string(const char * s) {
@@ -180,18 +182,13 @@ const char * mem_size_for_type(CType * ctype) {
 
 void emit_line(EmitterContext * ctx, const char* fmt, ...) {
     va_list args;
-
-    // --- 1. Write to the file
     va_start(args, fmt);
-    vfprintf(ctx->out, fmt, args);
+    char * line = asm_format_line(ctx->out, fmt, args);
     va_end(args);
-    fputc('\n', ctx->out);
 
-    // --- 2. Echo to stdout (re-initialize args)
-    va_start(args, fmt);
-    vfprintf(stdout, fmt, args);
-    va_end(args);
-    fputc('\n', stdout);
+    // the writer echoes it to stdout as well
+    CompilerOptions * options = get_compiler_options();
+    write_asm_line(ctx->out, options->asm_dialect, options->compact_asm, line);
 }
 
 char * make_label_text(const char * prefix, int num) {
@@ -230,7 +227,9 @@ char * get_reservation_directive(CType * ctype) {
         case CTYPE_CHAR: return "resb";
         case CTYPE_SHORT: return "resw";
         case CTYPE_INT: return "resd";
+        case CTYPE_FLOAT: return "resd";
         case CTYPE_LONG: return "resq";
+        case CTYPE_DOUBLE: return "resq";
         case CTYPE_PTR: return "resq";
         case CTYPE_ARRAY: return get_reservation_directive(ctype->base_type);
         default:
@@ -0,0 +1,284 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lexer_scan.h"
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#define LEX_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+/* the helpers below are forced inline, a call per character or per block
+ * costs more than the scan does
+ */
+#define SCAN_INLINE static inline __attribute__((always_inline))
+
+/* scalar */
+
+SCAN_INLINE bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+SCAN_INLINE bool is_identifier_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+SCAN_INLINE bool is_line_char(char c) {
+    return c && c != '\n';
+}
+
+SCAN_INLINE bool is_comment_char(char c) {
+    return c && c != '/';
+}
+
+SCAN_INLINE bool is_plain_string_char(char c) {
+    return c && c != '"' && c != '\\';
+}
+
+#define DEFINE_SCALAR_SCANNER(name, in_run)         \
+static int name(const char * text, int pos) {       \
+    while (in_run(text[pos])) {                     \
+        pos++;                                      \
+    }                                               \
+    return pos;                                     \
+}
+
+DEFINE_SCALAR_SCANNER(skip_whitespace_scalar, is_space)
+DEFINE_SCALAR_SCANNER(skip_identifier_scalar, is_identifier_char)
+DEFINE_SCALAR_SCANNER(find_line_end_scalar, is_line_char)
+DEFINE_SCALAR_SCANNER(find_slash_scalar, is_comment_char)
+DEFINE_SCALAR_SCANNER(find_string_stop_scalar, is_plain_string_char)
+
+static const LexScanners SCALAR_SCANNERS = {
+    skip_whitespace_scalar,
+    skip_identifier_scalar,
+    find_line_end_scalar,
+    find_slash_scalar,
+    find_string_stop_scalar,
+};
+
+#ifdef LEX_SCAN_X86
+
+/* most runs are a few characters, a single space or a short name, so a
+ * vector scanner looks at the first SCALAR_PREFIX characters one at a time.
+ * past those it loads the aligned blocks from the one holding pos, and
+ * stops at the first byte its stop mask, a bit per byte, has set. an
+ * aligned load never crosses into the page after the '\0', which every
+ * stop mask includes. the bytes it reads past the '\0' are not the
+ * string's, so address sanitizer is kept out of these.
+ */
+#define SCALAR_PREFIX 8
+
+#define DEFINE_VECTOR_SCANNER(name, width, isa, vector, load, stop_mask, in_run) \
+__attribute__((target(isa), no_sanitize_address))                            \
+static int name(const char * text, int pos) {                                \
+    for (int end = pos + SCALAR_PREFIX; pos < end; pos++) {                  \
+        if (!in_run(text[pos])) {                                            \
+            return pos;                                                      \
+        }                                                                    \
+    }                                                                        \
+    const char * p = text + pos;                                             \
+    const char * block = (const char *) ((uintptr_t) p & ~(uintptr_t) (width - 1)); \
+    unsigned ignore = (1u << (p - block)) - 1;      /* the bytes before pos */ \
+    for (;;) {                                                               \
+        vector x = load((const vector *) block);                             \
+        unsigned stop = stop_mask(x) & ~ignore;                              \
+        if (stop) {                                                          \
+            return (int) (block - text) + __builtin_ctz(stop);               \
+        }                                                                    \
+        ignore = 0;                                                          \
+        block += width;                                                      \
+    }                                                                        \
+}
+
+/* the bytes the stop masks compare against, each repeated across 32 bytes
+ * so either width loads it. _mm_set1_epi8 builds its vector a byte at a
+ * time without optimization, which costs more than a short run
+ */
+#define REPEAT_4(c) c, c, c, c
+#define REPEAT_32(c) REPEAT_4(c), REPEAT_4(c), REPEAT_4(c), REPEAT_4(c), \
+                     REPEAT_4(c), REPEAT_4(c), REPEAT_4(c), REPEAT_4(c)
+
+enum {
+    SPLAT_SPACE,
+    SPLAT_TAB,
+    SPLAT_TAB_TO_CR,        // '\r' - '\t', the other whitespace follows the tab
+    SPLAT_CASE_BIT,         // or'ed in, upper case letters become lower case
+    SPLAT_LOWER_A,
+    SPLAT_A_TO_Z,
+    SPLAT_DIGIT_0,
+    SPLAT_0_TO_9,
+    SPLAT_UNDERSCORE,
+    SPLAT_NEWLINE,
+    SPLAT_SLASH,
+    SPLAT_QUOTE,
+    SPLAT_BACKSLASH,
+    SPLAT_COUNT
+};
+
+static const char SPLATS[SPLAT_COUNT][32] __attribute__((aligned(32))) = {
+    [SPLAT_SPACE] = { REPEAT_32(' ') },
+    [SPLAT_TAB] = { REPEAT_32('\t') },
+    [SPLAT_TAB_TO_CR] = { REPEAT_32('\r' - '\t') },
+    [SPLAT_CASE_BIT] = { REPEAT_32(0x20) },
+    [SPLAT_LOWER_A] = { REPEAT_32('a') },
+    [SPLAT_A_TO_Z] = { REPEAT_32('z' - 'a') },
+    [SPLAT_DIGIT_0] = { REPEAT_32('0') },
+    [SPLAT_0_TO_9] = { REPEAT_32('9' - '0') },
+    [SPLAT_UNDERSCORE] = { REPEAT_32('_') },
+    [SPLAT_NEWLINE] = { REPEAT_32('\n') },
+    [SPLAT_SLASH] = { REPEAT_32('/') },
+    [SPLAT_QUOTE] = { REPEAT_32('"') },
+    [SPLAT_BACKSLASH] = { REPEAT_32('\\') },
+};
+
+#define SPLAT_128(which) _mm_load_si128((const __m128i *) SPLATS[which])
+#define SPLAT_256(which) _mm256_load_si256((const __m256i *) SPLATS[which])
+
+/* low <= x <= low + span as x - low <= span unsigned, which SSE2 has no compare for */
+__attribute__((target("sse2"))) SCAN_INLINE __m128i in_range_128(__m128i x, int low, int span) {
+    __m128i offset = _mm_sub_epi8(x, SPLAT_128(low));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, SPLAT_128(span)), offset);
+}
+
+__attribute__((target("sse2"))) SCAN_INLINE unsigned whitespace_stop_128(__m128i x) {
+    __m128i space = _mm_or_si128(_mm_cmpeq_epi8(x, SPLAT_128(SPLAT_SPACE)), in_range_128(x, SPLAT_TAB, SPLAT_TAB_TO_CR));
+    return ~(unsigned) _mm_movemask_epi8(space) & 0xffff;
+}
+
+__attribute__((target("sse2"))) SCAN_INLINE unsigned identifier_stop_128(__m128i x) {
+    __m128i letter = in_range_128(_mm_or_si128(x, SPLAT_128(SPLAT_CASE_BIT)), SPLAT_LOWER_A, SPLAT_A_TO_Z);
+    __m128i digit = in_range_128(x, SPLAT_DIGIT_0, SPLAT_0_TO_9);
+    __m128i underscore = _mm_cmpeq_epi8(x, SPLAT_128(SPLAT_UNDERSCORE));
+    return ~(unsigned) _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore)) & 0xffff;
+}
+
+__attribute__((target("sse2"))) SCAN_INLINE unsigned byte_or_end_128(__m128i x, int which) {
+    return (unsigned) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, SPLAT_128(which)),
+                                                     _mm_cmpeq_epi8(x, _mm_setzero_si128())));
+}
+
+__attribute__((target("sse2"))) SCAN_INLINE unsigned line_end_stop_128(__m128i x) {
+    return byte_or_end_128(x, SPLAT_NEWLINE);
+}
+
+__attribute__((target("sse2"))) SCAN_INLINE unsigned slash_stop_128(__m128i x) {
+    return byte_or_end_128(x, SPLAT_SLASH);
+}
+
+__attribute__((target("sse2"))) SCAN_INLINE unsigned string_stop_128(__m128i x) {
+    return byte_or_end_128(x, SPLAT_QUOTE) | (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, SPLAT_128(SPLAT_BACKSLASH)));
+}
+
+DEFINE_VECTOR_SCANNER(skip_whitespace_sse2, 16, "sse2", __m128i, _mm_load_si128, whitespace_stop_128, is_space)
+DEFINE_VECTOR_SCANNER(skip_identifier_sse2, 16, "sse2", __m128i, _mm_load_si128, identifier_stop_128, is_identifier_char)
+DEFINE_VECTOR_SCANNER(find_line_end_sse2, 16, "sse2", __m128i, _mm_load_si128, line_end_stop_128, is_line_char)
+DEFINE_VECTOR_SCANNER(find_slash_sse2, 16, "sse2", __m128i, _mm_load_si128, slash_stop_128, is_comment_char)
+DEFINE_VECTOR_SCANNER(find_string_stop_sse2, 16, "sse2", __m128i, _mm_load_si128, string_stop_128, is_plain_string_char)
+
+static const LexScanners SSE2_SCANNERS = {
+    skip_whitespace_sse2,
+    skip_identifier_sse2,
+    find_line_end_sse2,
+    find_slash_sse2,
+    find_string_stop_sse2,
+};
+
+__attribute__((target("avx2"))) SCAN_INLINE __m256i in_range_256(__m256i x, int low, int span) {
+    __m256i offset = _mm256_sub_epi8(x, SPLAT_256(low));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, SPLAT_256(span)), offset);
+}
+
+__attribute__((target("avx2"))) SCAN_INLINE unsigned whitespace_stop_256(__m256i x) {
+    __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(x, SPLAT_256(SPLAT_SPACE)), in_range_256(x, SPLAT_TAB, SPLAT_TAB_TO_CR));
+    return ~(unsigned) _mm256_movemask_epi8(space);
+}
+
+__attribute__((target("avx2"))) SCAN_INLINE unsigned identifier_stop_256(__m256i x) {
+    __m256i letter = in_range_256(_mm256_or_si256(x, SPLAT_256(SPLAT_CASE_BIT)), SPLAT_LOWER_A, SPLAT_A_TO_Z);
+    __m256i digit = in_range_256(x, SPLAT_DIGIT_0, SPLAT_0_TO_9);
+    __m256i underscore = _mm256_cmpeq_epi8(x, SPLAT_256(SPLAT_UNDERSCORE));
+    return ~(unsigned) _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), underscore));
+}
+
+__attribute__((target("avx2"))) SCAN_INLINE unsigned byte_or_end_256(__m256i x, int which) {
+    return (unsigned) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, SPLAT_256(which)),
+                                                           _mm256_cmpeq_epi8(x, _mm256_setzero_si256())));
+}
+
+__attribute__((target("avx2"))) SCAN_INLINE unsigned line_end_stop_256(__m256i x) {
+    return byte_or_end_256(x, SPLAT_NEWLINE);
+}
+
+__attribute__((target("avx2"))) SCAN_INLINE unsigned slash_stop_256(__m256i x) {
+    return byte_or_end_256(x, SPLAT_SLASH);
+}
+
+__attribute__((target("avx2"))) SCAN_INLINE unsigned string_stop_256(__m256i x) {
+    return byte_or_end_256(x, SPLAT_QUOTE) | (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, SPLAT_256(SPLAT_BACKSLASH)));
+}
+
+DEFINE_VECTOR_SCANNER(skip_whitespace_avx2, 32, "avx2", __m256i, _mm256_load_si256, whitespace_stop_256, is_space)
+DEFINE_VECTOR_SCANNER(skip_identifier_avx2, 32, "avx2", __m256i, _mm256_load_si256, identifier_stop_256, is_identifier_char)
+DEFINE_VECTOR_SCANNER(find_line_end_avx2, 32, "avx2", __m256i, _mm256_load_si256, line_end_stop_256, is_line_char)
+DEFINE_VECTOR_SCANNER(find_slash_avx2, 32, "avx2", __m256i, _mm256_load_si256, slash_stop_256, is_comment_char)
+DEFINE_VECTOR_SCANNER(find_string_stop_avx2, 32, "avx2", __m256i, _mm256_load_si256, string_stop_256, is_plain_string_char)
+
+static const LexScanners AVX2_SCANNERS = {
+    skip_whitespace_avx2,
+    skip_identifier_avx2,
+    find_line_end_avx2,
+    find_slash_avx2,
+    find_string_stop_avx2,
+};
+
+#endif // LEX_SCAN_X86
+
+static const LexScanners * lex_scanners = NULL;
+static LexScanMode lex_scan_mode = LEX_SCAN_SCALAR;
+
+static LexScanMode best_supported_mode() {
+#ifdef LEX_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return LEX_SCAN_AVX2;
+    }
+    return LEX_SCAN_SSE2;
+#else
+    return LEX_SCAN_SCALAR;
+#endif
+}
+
+LexScanMode set_lex_scan_mode(LexScanMode mode) {
+    LexScanMode best = best_supported_mode();
+    lex_scan_mode = mode < best ? mode : best;
+    switch (lex_scan_mode) {
+#ifdef LEX_SCAN_X86
+        case LEX_SCAN_AVX2: lex_scanners = &AVX2_SCANNERS; break;
+        case LEX_SCAN_SSE2: lex_scanners = &SSE2_SCANNERS; break;
+#endif
+        default: lex_scanners = &SCALAR_SCANNERS; break;
+    }
+    return lex_scan_mode;
+}
+
+const LexScanners * get_lex_scanners() {
+    if (!lex_scanners) {
+        set_lex_scan_mode(LEX_SCAN_SCALAR);
+    }
+    return lex_scanners;
+}
+
+LexScanMode get_lex_scan_mode() {
+    get_lex_scanners();
+    return lex_scan_mode;
+}
+
+const char * lex_scan_mode_name(LexScanMode mode) {
+    switch (mode) {
+        case LEX_SCAN_SCALAR: return "scalar";
+        case LEX_SCAN_SSE2: return "sse2";
+        case LEX_SCAN_AVX2: return "avx2";
+    }
+    return "unknown";
+}
@@ -3,6 +3,7 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
 
 #include "list_util.h"
 #include "ast.h"
@@ -18,13 +19,18 @@
 #include "emitter_context.h"
 #include "error.h"
 #include "symbol_table.h"
+#include "compiler_options.h"
+#include "compile_stats.h"
+#include "runtime_usage.h"
+#include "optimizer.h"
+#include "lexer_scan.h"
 
-void token_formatted_output(const char * label, const char * text, TokenType tokenType, int num, int line, int col) {
+void token_formatted_output(const char * label, const Token * token, int num) {
     char left[64];
     char right[64];
-    snprintf(left, sizeof(left), "%s: %s", label, text);
-    snprintf(right, sizeof(right), "TOKEN_TYPE: %s", token_type_name(tokenType));
-    printf("[%6d]  %-25s %-25s%6d%6d\n", num, left, right, line, col);
+    snprintf(left, sizeof(left), "%s: %.*s", label, token->length, token_start(token));
+    snprintf(right, sizeof(right), "TOKEN_TYPE: %s", token_type_name(token->type));
+    printf("[%6d]  %-25s %-25s%6d%6d\n", num, left, right, token_line(token), token_col(token));
 }
 
 /* main and related */
@@ -32,7 +38,7 @@ void token_formatted_output(const char * label, const char * text, TokenType tok
 int main(int argc, char ** argv) {
 
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <source file> [-o <output file]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <source file> [-o <output file] [-O0|-O1] [--stats] [--align-loops] [--unroll=N] [--no-vectorize] [--fast-math] [--no-branchless] [--no-register-locals] [--asm=gas|nasm] [--compact-asm] [--lex-scan=scalar|sse2|avx2]\n", argv[0]);
         return 1;
     }
 
@@ -44,6 +50,42 @@ int main(int argc, char ** argv) {
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
             output_file = argv[++i];
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            get_compiler_options()->opt_level = 0;
+        } else if (strcmp(argv[i], "-O1") == 0) {
+            get_compiler_options()->opt_level = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            get_compiler_options()->print_stats = true;
+        } else if (strcmp(argv[i], "--align-loops") == 0) {
+            get_compiler_options()->align_loops = true;
+        } else if (strncmp(argv[i], "--unroll=", 9) == 0) {
+            get_compiler_options()->unroll_factor = atoi(argv[i] + 9);
+        } else if (strcmp(argv[i], "--no-vectorize") == 0) {
+            get_compiler_options()->vectorize = false;
+        } else if (strcmp(argv[i], "--fast-math") == 0) {
+            get_compiler_options()->fast_math = true;
+        } else if (strcmp(argv[i], "--no-branchless") == 0) {
+            get_compiler_options()->branchless = false;
+        } else if (strcmp(argv[i], "--no-register-locals") == 0) {
+            get_compiler_options()->register_locals = false;
+        } else if (strcmp(argv[i], "--asm=gas") == 0) {
+            get_compiler_options()->asm_dialect = ASM_GAS;
+        } else if (strcmp(argv[i], "--asm=nasm") == 0) {
+            get_compiler_options()->asm_dialect = ASM_NASM;
+        } else if (strncmp(argv[i], "--lex-scan=", 11) == 0) {
+            // for comparing the lexer scanners, the default is scalar
+            const char * name = argv[i] + 11;
+            int mode = LEX_SCAN_SCALAR;
+            while (mode <= LEX_SCAN_AVX2 && strcmp(name, lex_scan_mode_name(mode)) != 0) {
+                mode++;
+            }
+            if (mode > LEX_SCAN_AVX2) {
+                error("Unknown lexer scan mode: %s", name);
+            } else if (set_lex_scan_mode(mode) != mode) {
+                warning("%s is not supported on this CPU, using %s", name, lex_scan_mode_name(get_lex_scan_mode()));
+            }
+        } else if (strcmp(argv[i], "--compact-asm") == 0) {
+            get_compiler_options()->compact_asm = true;
         } else if (!program_file) {
             program_file = argv[i];
         } else {
@@ -60,21 +102,30 @@ int main(int argc, char ** argv) {
         output_file_owned = true;
     }
 
-    char * program_text = read_text_file(program_file);
+    SourceText source = map_text_file(program_file);
+    const char * program_text = source.text;
     if (!program_text) {
         error("Could not read file: %s", program_file);
     }
 
     printf("Compiling\n\n%s\n\n", program_text);
 
+    struct timespec tokenize_start, tokenize_end;
+    clock_gettime(CLOCK_MONOTONIC, &tokenize_start);
+
     tokenlist * tokens = tokenize(program_text);
 
+    clock_gettime(CLOCK_MONOTONIC, &tokenize_end);
+    get_compile_stats()->source_bytes = source.length;
+    get_compile_stats()->tokenize_microseconds = (tokenize_end.tv_sec - tokenize_start.tv_sec) * 1000000L +
+                                                 (tokenize_end.tv_nsec - tokenize_start.tv_nsec) / 1000;
+
     int i=0;
     // output list
     for (tokenlist_node * node = tokens->head; node != NULL; node = node->next) {
         Token * token = node->value;
 
-        token_formatted_output("TOKEN:", token->text, token->type, ++i, token->line, token->col);
+        token_formatted_output("TOKEN:", token, ++i);
     }
 
     printf("\n");
@@ -86,6 +137,7 @@ int main(int argc, char ** argv) {
     
     tokenlist_free(tokens);
     free(tokens);
+    release_token_source();
 
     printf("\nAST After Parsing\n");
     print_ast(astNode, 0);
@@ -105,17 +157,37 @@ int main(int argc, char ** argv) {
     printf("\nAST After Analyzer\n");
     print_ast(astNode, 0);
 
+    RuntimeUsage runtime_usage;
+    runtime_usage_init(&runtime_usage, true);
+
+    if (optimizations_enabled()) {
+        printf("\n");
+        printf("--------------------------------------------\n");
+        printf("Beginning Optimization\n");
+        printf("--------------------------------------------\n\n\n");
+
+        optimize_translation_unit(astNode, &runtime_usage);
+    }
+
     printf("\n");
     printf("--------------------------------------------\n");
     printf("Beginning Code Generation\n");
     printf("--------------------------------------------\n\n\n");
 
 
+    struct timespec emit_start, emit_end;
+    clock_gettime(CLOCK_MONOTONIC, &emit_start);
+
     EmitterContext * emitter_context = create_emitter_context(output_file);
+    emitter_context->runtime_usage = runtime_usage;
     emit(emitter_context, astNode);
 
     emitter_finalize(emitter_context);
 
+    clock_gettime(CLOCK_MONOTONIC, &emit_end);
+    get_compile_stats()->emit_microseconds = (emit_end.tv_sec - emit_start.tv_sec) * 1000000L +
+                                             (emit_end.tv_nsec - emit_start.tv_nsec) / 1000;
+
     // TODO THIS NEEDS TO BE FIXED and OTHER CLEAN AS WELL.
     // cleanup_token_list(&tokenList);
 
@@ -130,7 +202,11 @@ int main(int argc, char ** argv) {
     if (output_file_owned) {
         free((void*)output_file);
     }
-    free(program_text);
+    release_text_file(&source);
+
+    if (get_compiler_options()->print_stats) {
+        print_compile_stats(stdout);
+    }
 
     printf("Finished\n");
     exit(0);
@@ -0,0 +1,653 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "cfg.h"
+#include "bitset.h"
+#include "compile_stats.h"
+#include "optimizer.h"
+#include "opt_cse.h"
+#include "vectorize.h"
+
+/* value numbers name the value an expression has at a program point. two
+ * expressions with the same number compute the same value, so the second one
+ * can read what the first one left in a temporary.
+ *
+ * tracked locals are numbered by version, a store gives the variable a new
+ * version. everything else that lives in memory (globals, arrays, locals whose
+ * address is taken) is numbered together with a memory epoch that moves on at
+ * every store through memory and every call.
+ */
+typedef enum {
+    VN_VAR,             // tracked local: index, version
+    VN_MEMORY_VAR,      // untracked scalar: symbol, epoch
+    VN_ARRAY,           // address of a named array: symbol
+    VN_ADDRESS,         // &variable: symbol
+    VN_CONSTANT,        // integer literal: value, type
+    VN_CAST,            // type, operand
+    VN_UNARY,           // op, type, operand
+    VN_BINARY,          // op, type, lhs, rhs
+    VN_CONDITIONAL,     // cond, then, else
+    VN_ELEMENT,         // element address: base, index, element size
+    VN_LOAD             // value read through an address: address, epoch, type
+} VNTag;
+
+typedef struct VNKey {
+    long tag;
+    long a;
+    long b;
+    long c;
+    long d;
+} VNKey;
+
+typedef struct VNTable {
+    VNKey * keys;
+    int * values;       // 0 marks an empty slot
+    int capacity;
+    int count;
+} VNTable;
+
+/* the first occurrence of a value in the dominator tree. the temporary is
+ * only created once a second occurrence is found.
+ */
+typedef struct Available {
+    ASTNode ** slot;
+    bool is_address;
+    Symbol * temp;
+} Available;
+
+typedef struct GVN {
+    ASTNode * function;
+    CFG * cfg;
+    LocalVars vars;
+    VNTable table;
+    int next_value;
+
+    int * versions;             // current version of each tracked local
+    int epoch;                  // current memory state
+    int ** exit_versions;       // state at the end of each block, by block id
+    int * exit_epoch;
+
+    Bitset ** kills;            // tracked locals each block may store to
+    bool * clobbers;            // blocks that may store to memory
+    int * visit_mark;           // scratch marks for the region search
+
+    int * memo;                 // value number of each node, 0 if not computed yet
+    int memo_size;
+
+    Available ** available;     // by value number
+    int available_capacity;
+    int * scope;                // value numbers made available, innermost last
+    int scope_count;
+    int scope_capacity;
+
+    BasicBlock *** children;    // dominator tree
+    int * child_count;
+
+    Bitset * vector_bodies;     // statements of loops the vectorizer takes, by node id
+} GVN;
+
+static int fresh_value(GVN * gvn) {
+    return ++gvn->next_value;
+}
+
+/* --- value table --- */
+
+static unsigned long hash_key(VNKey * key) {
+    unsigned long h = 1469598103934665603UL;
+    long parts[5] = { key->tag, key->a, key->b, key->c, key->d };
+    for (int i = 0; i < 5; i++) {
+        h ^= (unsigned long)parts[i];
+        h *= 1099511628211UL;
+    }
+    return h;
+}
+
+static bool keys_equal(VNKey * x, VNKey * y) {
+    return x->tag == y->tag && x->a == y->a && x->b == y->b && x->c == y->c && x->d == y->d;
+}
+
+static void table_grow(VNTable * table) {
+    VNKey * old_keys = table->keys;
+    int * old_values = table->values;
+    int old_capacity = table->capacity;
+
+    table->capacity = old_capacity ? old_capacity * 2 : 256;
+    table->keys = malloc(table->capacity * sizeof(VNKey));
+    table->values = calloc(table->capacity, sizeof(int));
+    for (int i = 0; i < old_capacity; i++) {
+        if (!old_values[i]) continue;
+        unsigned long slot = hash_key(&old_keys[i]) & (table->capacity - 1);
+        while (table->values[slot]) {
+            slot = (slot + 1) & (table->capacity - 1);
+        }
+        table->keys[slot] = old_keys[i];
+        table->values[slot] = old_values[i];
+    }
+    free(old_keys);
+    free(old_values);
+}
+
+static int lookup_value(GVN * gvn, long tag, long a, long b, long c, long d) {
+    VNTable * table = &gvn->table;
+    if ((table->count + 1) * 2 > table->capacity) {
+        table_grow(table);
+    }
+    VNKey key = { tag, a, b, c, d };
+    unsigned long slot = hash_key(&key) & (table->capacity - 1);
+    while (table->values[slot]) {
+        if (keys_equal(&table->keys[slot], &key)) {
+            return table->values[slot];
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    table->keys[slot] = key;
+    table->values[slot] = fresh_value(gvn);
+    table->count++;
+    return table->values[slot];
+}
+
+/* --- numbering expressions --- */
+
+static long type_key(CType * ctype) {
+    if (!ctype) return -1;
+    long key = ctype->kind | (ctype->is_signed ? 0x10 : 0) | ((long)ctype->size << 8);
+    if (ctype->kind == CTYPE_PTR && ctype->base_type) {
+        key |= (long)sizeof_type(ctype->base_type) << 32;
+    }
+    return key;
+}
+
+static bool is_commutative(BinaryOperator op) {
+    switch (op) {
+        case BINOP_ADD:
+        case BINOP_MUL:
+        case BINOP_EQ:
+        case BINOP_NE:
+        case BINOP_BITWISE_AND:
+        case BINOP_BITWISE_OR:
+        case BINOP_BITWISE_XOR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static int value_of(GVN * gvn, ASTNode * node);
+
+static int element_address(GVN * gvn, ASTNode * node) {
+    return lookup_value(gvn, VN_ELEMENT, value_of(gvn, node->array_access.base),
+                        value_of(gvn, node->array_access.index), sizeof_type(node->ctype), 0);
+}
+
+static int compute_value(GVN * gvn, ASTNode * node) {
+    switch (node->type) {
+        case AST_INT_LITERAL:
+            return lookup_value(gvn, VN_CONSTANT, node->int_value, type_key(node->ctype), 0, 0);
+        case AST_VAR_REF_EXPR: {
+            if (!node->symbol || is_function_type(node->ctype)) {
+                return fresh_value(gvn);
+            }
+            int index = local_var_index(&gvn->vars, node->symbol);
+            if (index >= 0) {
+                return lookup_value(gvn, VN_VAR, index, gvn->versions[index], 0, 0);
+            }
+            if (is_array_type(node->ctype)) {
+                return lookup_value(gvn, VN_ARRAY, (long)(intptr_t)node->symbol, 0, 0, 0);
+            }
+            return lookup_value(gvn, VN_MEMORY_VAR, (long)(intptr_t)node->symbol, gvn->epoch, 0, 0);
+        }
+        case AST_CAST_EXPR:
+            return lookup_value(gvn, VN_CAST, type_key(node->ctype), value_of(gvn, node->cast_expr.expr), 0, 0);
+        case AST_UNARY_EXPR: {
+            ASTNode * operand = node->unary.operand;
+            switch (node->unary.op) {
+                case UNARY_DEREF:
+                    return lookup_value(gvn, VN_LOAD, value_of(gvn, operand), gvn->epoch, type_key(node->ctype), 0);
+                case UNARY_ADDRESS:
+                    if (operand->type == AST_ARRAY_ACCESS) {
+                        return element_address(gvn, operand);
+                    }
+                    if (operand->type == AST_VAR_REF_EXPR && operand->symbol) {
+                        return lookup_value(gvn, VN_ADDRESS, (long)(intptr_t)operand->symbol, 0, 0, 0);
+                    }
+                    return fresh_value(gvn);
+                case UNARY_NEGATE:
+                case UNARY_PLUS:
+                case UNARY_LOGICAL_NOT:
+                case UNARY_BITWISE_NOT:
+                    return lookup_value(gvn, VN_UNARY, node->unary.op, type_key(node->ctype), value_of(gvn, operand), 0);
+                default:
+                    return fresh_value(gvn);
+            }
+        }
+        case AST_BINARY_EXPR: {
+            if (is_assignment(node)) {
+                return fresh_value(gvn);
+            }
+            long lhs = value_of(gvn, node->binary.lhs);
+            long rhs = value_of(gvn, node->binary.rhs);
+            if (is_commutative(node->binary.op) && lhs > rhs) {
+                long t = lhs;
+                lhs = rhs;
+                rhs = t;
+            }
+            return lookup_value(gvn, VN_BINARY, node->binary.op, type_key(node->ctype), lhs, rhs);
+        }
+        case AST_ARRAY_ACCESS: {
+            int address = element_address(gvn, node);
+            if (is_array_type(node->ctype)) {
+                return address;
+            }
+            return lookup_value(gvn, VN_LOAD, address, gvn->epoch, type_key(node->ctype), 0);
+        }
+        case AST_COND_EXPR:
+            return lookup_value(gvn, VN_CONDITIONAL, value_of(gvn, node->cond_expr.cond),
+                                value_of(gvn, node->cond_expr.then_expr),
+                                value_of(gvn, node->cond_expr.else_expr), type_key(node->ctype));
+        default:
+            return fresh_value(gvn);
+    }
+}
+
+static int value_of(GVN * gvn, ASTNode * node) {
+    if (node->id >= gvn->memo_size) {
+        return compute_value(gvn, node);
+    }
+    if (!gvn->memo[node->id]) {
+        gvn->memo[node->id] = compute_value(gvn, node);
+    }
+    return gvn->memo[node->id];
+}
+
+/* --- rewriting --- */
+
+/* the first occurrence E becomes (t = E), or *(t = &E) for an address */
+static void materialize(GVN * gvn, Available * first) {
+    ASTNode * expr = *first->slot;
+    CType * ctype = first->is_address ? make_pointer_type(expr->ctype) : expr->ctype;
+    first->temp = create_temp_local(gvn->function, ctype, "cse");
+
+    ASTNode * value = first->is_address ? create_typed_unary(UNARY_ADDRESS, expr, ctype) : expr;
+    ASTNode * assignment = create_temp_assignment(first->temp, value);
+    *first->slot = first->is_address ? create_typed_unary(UNARY_DEREF, assignment, expr->ctype) : assignment;
+}
+
+static void reuse(GVN * gvn, Available * first, ASTNode ** slot) {
+    if (!first->temp) {
+        materialize(gvn, first);
+    }
+    ASTNode * old = *slot;
+    ASTNode * ref = create_temp_ref(first->temp);
+    *slot = first->is_address ? create_typed_unary(UNARY_DEREF, ref, old->ctype) : ref;
+    discard_ast(old);
+    get_compile_stats()->common_subexpressions_eliminated++;
+}
+
+static Available * find_available(GVN * gvn, int value) {
+    return value < gvn->available_capacity ? gvn->available[value] : NULL;
+}
+
+static void make_available(GVN * gvn, int value, ASTNode ** slot, bool is_address) {
+    if (value >= gvn->available_capacity) {
+        int old_capacity = gvn->available_capacity;
+        gvn->available_capacity = (value + 1) * 2;
+        gvn->available = realloc(gvn->available, gvn->available_capacity * sizeof(Available *));
+        for (int i = old_capacity; i < gvn->available_capacity; i++) {
+            gvn->available[i] = NULL;
+        }
+    }
+    Available * entry = malloc(sizeof(Available));
+    entry->slot = slot;
+    entry->is_address = is_address;
+    entry->temp = NULL;
+    gvn->available[value] = entry;
+
+    if (gvn->scope_count == gvn->scope_capacity) {
+        gvn->scope_capacity = gvn->scope_capacity ? gvn->scope_capacity * 2 : 64;
+        gvn->scope = realloc(gvn->scope, gvn->scope_capacity * sizeof(int));
+    }
+    gvn->scope[gvn->scope_count++] = value;
+}
+
+/* walks an expression in the order the emitter evaluates it. values computed
+ * only on some paths (right of && and ||, arms of ?:) may reuse earlier values
+ * but are not made available themselves.
+ */
+static void visit(GVN * gvn, ASTNode ** slot, bool conditional) {
+    ASTNode * node = *slot;
+    if (!node) return;
+
+    bool is_address = is_reusable_address(node);
+    bool is_candidate = is_address || is_reusable_arithmetic(node);
+    int value = 0;
+    if (is_candidate) {
+        value = is_address ? element_address(gvn, node) : value_of(gvn, node);
+        Available * first = find_available(gvn, value);
+        if (first) {
+            reuse(gvn, first, slot);
+            return;
+        }
+    }
+
+    switch (node->type) {
+        case AST_CAST_EXPR:
+            visit(gvn, &node->cast_expr.expr, conditional);
+            break;
+        case AST_UNARY_EXPR:
+            visit(gvn, &node->unary.operand, conditional);
+            break;
+        case AST_ARRAY_ACCESS:
+            visit(gvn, &node->array_access.base, conditional);
+            visit(gvn, &node->array_access.index, conditional);
+            break;
+        case AST_BINARY_EXPR:
+            if (is_assignment(node)) {
+                // the emitter evaluates the rhs first, compound assignments included
+                visit(gvn, &node->binary.rhs, conditional);
+                if (node->binary.lhs->type != AST_VAR_REF_EXPR) {
+                    visit(gvn, &node->binary.lhs, conditional);
+                }
+            } else if (node->binary.op == BINOP_LOGICAL_AND || node->binary.op == BINOP_LOGICAL_OR) {
+                visit(gvn, &node->binary.lhs, conditional);
+                visit(gvn, &node->binary.rhs, true);
+            } else {
+                visit(gvn, &node->binary.lhs, conditional);
+                visit(gvn, &node->binary.rhs, conditional);
+            }
+            break;
+        case AST_COND_EXPR:
+            visit(gvn, &node->cond_expr.cond, conditional);
+            visit(gvn, &node->cond_expr.then_expr, true);
+            visit(gvn, &node->cond_expr.else_expr, true);
+            break;
+        default:
+            break;
+    }
+
+    if (is_candidate && !conditional) {
+        make_available(gvn, value, slot, is_address);
+    }
+}
+
+/* --- state --- */
+
+static void compute_block_kills(GVN * gvn) {
+    int n = gvn->cfg->block_count;
+    gvn->kills = malloc(n * sizeof(Bitset *));
+    gvn->clobbers = calloc(n, sizeof(bool));
+    for (int i = 0; i < n; i++) {
+        BasicBlock * block = gvn->cfg->blocks[i];
+        gvn->kills[i] = bitset_new(gvn->vars.count);
+        for (int j = 0; j < block->item_count; j++) {
+            if (!is_marker_item(&block->items[j])) {
+                collect_stores(block->items[j].node, &gvn->vars, gvn->kills[i], &gvn->clobbers[i]);
+            }
+        }
+    }
+}
+
+static void kill_stores(GVN * gvn, Bitset * stores, bool clobbers) {
+    for (int i = 0; i < gvn->vars.count; i++) {
+        if (bitset_test(stores, i)) {
+            gvn->versions[i] = fresh_value(gvn);
+        }
+    }
+    if (clobbers) {
+        gvn->epoch = fresh_value(gvn);
+    }
+}
+
+/* a block starts from the state its immediate dominator ends in, less
+ * whatever the blocks on the way from the dominator may have stored.
+ */
+static void enter_block(GVN * gvn, BasicBlock * block) {
+    if (block == gvn->cfg->entry) {
+        for (int i = 0; i < gvn->vars.count; i++) {
+            gvn->versions[i] = fresh_value(gvn);
+        }
+        gvn->epoch = fresh_value(gvn);
+        return;
+    }
+
+    BasicBlock * idom = block->idom;
+    for (int i = 0; i < gvn->vars.count; i++) {
+        gvn->versions[i] = gvn->exit_versions[idom->id][i];
+    }
+    gvn->epoch = gvn->exit_epoch[idom->id];
+    if (block->pred_count == 1 && block->preds[0] == idom) {
+        return;
+    }
+
+    Bitset * stores = bitset_new(gvn->vars.count);
+    bool clobbers = false;
+    BasicBlock ** stack = malloc(gvn->cfg->block_count * sizeof(BasicBlock *));
+    int depth = 0;
+    for (int i = 0; i < gvn->cfg->block_count; i++) {
+        gvn->visit_mark[i] = 0;
+    }
+    for (int p = 0; p < block->pred_count; p++) {
+        BasicBlock * pred = block->preds[p];
+        if (pred != idom && pred->rpo_index >= 0 && !gvn->visit_mark[pred->id]) {
+            gvn->visit_mark[pred->id] = 1;
+            stack[depth++] = pred;
+        }
+    }
+    while (depth > 0) {
+        BasicBlock * b = stack[--depth];
+        bitset_union(stores, gvn->kills[b->id]);
+        clobbers |= gvn->clobbers[b->id];
+        for (int p = 0; p < b->pred_count; p++) {
+            BasicBlock * pred = b->preds[p];
+            if (pred != idom && pred->rpo_index >= 0 && !gvn->visit_mark[pred->id]) {
+                gvn->visit_mark[pred->id] = 1;
+                stack[depth++] = pred;
+            }
+        }
+    }
+    free(stack);
+
+    kill_stores(gvn, stores, clobbers);
+    bitset_free(stores);
+}
+
+static void apply_item_kills(GVN * gvn, ASTNode * node) {
+    Bitset * stores = bitset_new(gvn->vars.count);
+    bool clobbers = false;
+    collect_stores(node, &gvn->vars, stores, &clobbers);
+    kill_stores(gvn, stores, clobbers);
+    bitset_free(stores);
+}
+
+static void apply_store(GVN * gvn, ASTNode * target) {
+    int index = -1;
+    if (target->type == AST_VAR_REF_EXPR && target->symbol) {
+        index = local_var_index(&gvn->vars, target->symbol);
+    }
+    if (index >= 0) {
+        gvn->versions[index] = fresh_value(gvn);
+    } else {
+        gvn->epoch = fresh_value(gvn);
+    }
+}
+
+/* --- items --- */
+
+/* the field holding the expression an item evaluates, NULL if it has none */
+static ASTNode ** item_expression(CFGItem * item) {
+    ASTNode * node = item->node;
+    ASTNode * owner = item->owner;
+    switch (item->kind) {
+        case CFG_ITEM_CONDITION:
+        case CFG_ITEM_EXPRESSION:
+            switch (owner->type) {
+                case AST_IF_STMT:
+                    return &owner->if_stmt.cond;
+                case AST_WHILE_STMT:
+                    return &owner->while_stmt.cond;
+                case AST_DO_WHILE_STMT:
+                    return &owner->do_while_stmt.expr;
+                case AST_SWITCH_STMT:
+                    return &owner->switch_stmt.expr;
+                case AST_FOR_STMT:
+                    if (node == owner->for_stmt.init_expr) return &owner->for_stmt.init_expr;
+                    if (node == owner->for_stmt.cond_expr) return &owner->for_stmt.cond_expr;
+                    return &owner->for_stmt.update_expr;
+                default:
+                    return NULL;
+            }
+        case CFG_ITEM_STATEMENT:
+        case CFG_ITEM_JUMP:
+            switch (node->type) {
+                case AST_EXPRESSION_STMT:
+                case AST_PRINT_EXTENSION_STATEMENT:
+                case AST_ASSERT_EXTENSION_STATEMENT:
+                    return &node->expr_stmt.expr;
+                case AST_RETURN_STMT:
+                    return &node->return_stmt.expr;
+                case AST_VAR_DECL:
+                    return &node->var_decl.init_expr;
+                default:
+                    return NULL;
+            }
+        default:
+            return NULL;
+    }
+}
+
+/* only items whose one effect is a store at the very end are rewritten, so
+ * the whole expression sees the state the item starts in. anything else just
+ * moves the state on.
+ */
+static void process_item(GVN * gvn, CFGItem * item) {
+    if (is_marker_item(item)) return;
+    if (bitset_test(gvn->vector_bodies, item->node->id)) {
+        apply_item_kills(gvn, item->node);
+        return;
+    }
+
+    ASTNode * node = item->node;
+    ASTNode ** slot = item_expression(item);
+    ASTNode * expr = slot ? *slot : NULL;
+
+    if (node->type == AST_VAR_DECL) {
+        if (expr && expr->type != AST_INITIALIZER_LIST && is_pure_expression(expr)) {
+            visit(gvn, slot, false);
+            if (local_var_index(&gvn->vars, node->symbol) >= 0) {
+                gvn->versions[local_var_index(&gvn->vars, node->symbol)] = fresh_value(gvn);
+            } else {
+                gvn->epoch = fresh_value(gvn);
+            }
+            return;
+        }
+    } else if (expr && expr->type == AST_BINARY_EXPR && is_assignment(expr)) {
+        if (is_pure_expression(expr->binary.lhs) && is_pure_expression(expr->binary.rhs)) {
+            visit(gvn, slot, false);
+            apply_store(gvn, expr->binary.lhs);
+            return;
+        }
+    } else if (expr && is_pure_expression(expr)) {
+        visit(gvn, slot, false);
+        return;
+    }
+    apply_item_kills(gvn, node);
+}
+
+/* the vectorizer matches a[i] accesses as written, so the bodies of its
+ * loops keep them rather than reading a temporary
+ */
+static void collect_vector_bodies(ASTNode * node, void * arg) {
+    VectorLoop loop;
+    if (node->type == AST_FOR_STMT && match_vector_loop(node, &loop)) {
+        ASTNode * body = node->for_stmt.body;
+        if (body->type == AST_BLOCK_STMT) {
+            body = body->block.statements->head->value;
+        }
+        bitset_set(arg, body->id);
+    }
+    ast_for_each_child(node, collect_vector_bodies, arg);
+}
+
+static void walk_dominator_tree(GVN * gvn, BasicBlock * block) {
+    enter_block(gvn, block);
+    int scope_mark = gvn->scope_count;
+
+    for (int i = 0; i < block->item_count; i++) {
+        process_item(gvn, &block->items[i]);
+    }
+
+    gvn->exit_versions[block->id] = malloc((gvn->vars.count ? gvn->vars.count : 1) * sizeof(int));
+    for (int i = 0; i < gvn->vars.count; i++) {
+        gvn->exit_versions[block->id][i] = gvn->versions[i];
+    }
+    gvn->exit_epoch[block->id] = gvn->epoch;
+
+    for (int i = 0; i < gvn->child_count[block->id]; i++) {
+        walk_dominator_tree(gvn, gvn->children[block->id][i]);
+    }
+
+    while (gvn->scope_count > scope_mark) {
+        int value = gvn->scope[--gvn->scope_count];
+        free(gvn->available[value]);
+        gvn->available[value] = NULL;
+    }
+}
+
+static void build_dominator_tree(GVN * gvn) {
+    int n = gvn->cfg->block_count;
+    gvn->children = calloc(n, sizeof(BasicBlock **));
+    gvn->child_count = calloc(n, sizeof(int));
+    for (int i = 1; i < gvn->cfg->rpo_count; i++) {
+        BasicBlock * block = gvn->cfg->rpo[i];
+        int parent = block->idom->id;
+        gvn->children[parent] = realloc(gvn->children[parent], (gvn->child_count[parent] + 1) * sizeof(BasicBlock *));
+        gvn->children[parent][gvn->child_count[parent]++] = block;
+    }
+}
+
+void eliminate_common_subexpressions(ASTNode * function_def) {
+    GVN gvn = { 0 };
+    gvn.function = function_def;
+    gvn.cfg = build_cfg(function_def);
+    compute_dominators(gvn.cfg);
+    collect_scalar_locals(function_def, &gvn.vars);
+
+    int n = gvn.cfg->block_count;
+    gvn.versions = malloc((gvn.vars.count ? gvn.vars.count : 1) * sizeof(int));
+    gvn.exit_versions = calloc(n, sizeof(int *));
+    gvn.exit_epoch = calloc(n, sizeof(int));
+    gvn.visit_mark = calloc(n, sizeof(int));
+    gvn.memo_size = get_ast_node_count() + 1;
+    gvn.memo = calloc(gvn.memo_size, sizeof(int));
+    gvn.vector_bodies = bitset_new(gvn.memo_size);
+    collect_vector_bodies(function_def->function_def.body, gvn.vector_bodies);
+    compute_block_kills(&gvn);
+    build_dominator_tree(&gvn);
+
+    walk_dominator_tree(&gvn, gvn.cfg->entry);
+
+    for (int i = 0; i < n; i++) {
+        free(gvn.exit_versions[i]);
+        free(gvn.children[i]);
+        bitset_free(gvn.kills[i]);
+    }
+    free(gvn.exit_versions);
+    free(gvn.exit_epoch);
+    free(gvn.children);
+    free(gvn.child_count);
+    free(gvn.kills);
+    free(gvn.clobbers);
+    free(gvn.visit_mark);
+    free(gvn.versions);
+    free(gvn.memo);
+    free(gvn.available);
+    free(gvn.scope);
+    free(gvn.table.keys);
+    free(gvn.table.values);
+    bitset_free(gvn.vector_bodies);
+    free_local_vars(&gvn.vars);
+    free_cfg(gvn.cfg);
+}
@@ -0,0 +1,320 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "cfg.h"
+#include "bitset.h"
+#include "compile_stats.h"
+#include "optimizer.h"
+#include "opt_dead_code.h"
+
+#define MAX_DEAD_STORE_ROUNDS 8
+
+/* --- unreachable code --- */
+
+typedef struct LiveSearch {
+    Bitset * live_items;
+    bool found;
+} LiveSearch;
+
+static void search_live(ASTNode * node, void * arg) {
+    LiveSearch * search = arg;
+    if (search->found) return;
+    if (bitset_test(search->live_items, node->id)) {
+        search->found = true;
+        return;
+    }
+    ast_for_each_child(node, search_live, search);
+}
+
+static bool contains_live_item(ASTNode * node, Bitset * live_items) {
+    LiveSearch search = { live_items, false };
+    search_live(node, &search);
+    return search.found;
+}
+
+static void strip_initializers(ASTNode * node) {
+    if (node->type == AST_VAR_DECL) {
+        discard_ast(node->var_decl.init_expr);
+        node->var_decl.init_expr = NULL;
+    } else if (node->type == AST_DECLARATION_STMT) {
+        for (ASTNode_list_node * n = node->declaration.init_declarator_list->head; n; n = n->next) {
+            strip_initializers(n->value);
+        }
+    }
+}
+
+static void prune_unreachable(ASTNode * node, void * arg) {
+    Bitset * live_items = arg;
+
+    if (node->type == AST_BLOCK_STMT) {
+        ASTNode_list * list = node->block.statements;
+        ASTNode_list_node * prev = NULL;
+        ASTNode_list_node * n = list->head;
+        while (n) {
+            ASTNode_list_node * next = n->next;
+            ASTNode * stmt = n->value;
+            if (contains_live_item(stmt, live_items)) {
+                prev = n;
+            } else if (stmt->type == AST_VAR_DECL || stmt->type == AST_DECLARATION_STMT) {
+                // the symbol keeps pointing at the declaration, only the initializer goes
+                if (!bitset_test(live_items, stmt->id)) {
+                    strip_initializers(stmt);
+                }
+                prev = n;
+            } else {
+                if (prev) {
+                    prev->next = next;
+                } else {
+                    list->head = next;
+                }
+                if (list->tail == n) {
+                    list->tail = prev;
+                }
+                list->count--;
+                discard_ast(stmt);
+                free(n);
+                get_compile_stats()->unreachable_statements_removed++;
+            }
+            n = next;
+        }
+    }
+    ast_for_each_child(node, prune_unreachable, live_items);
+}
+
+static void remove_unreachable_code(ASTNode * function_def) {
+    CFG * cfg = build_cfg(function_def);
+    Bitset * live_items = bitset_new(get_ast_node_count());
+    for (int i = 0; i < cfg->block_count; i++) {
+        BasicBlock * block = cfg->blocks[i];
+        if (!block->reachable) continue;
+        for (int j = 0; j < block->item_count; j++) {
+            bitset_set(live_items, block->items[j].node->id);
+        }
+    }
+    free_cfg(cfg);
+
+    prune_unreachable(function_def->function_def.body, live_items);
+    bitset_free(live_items);
+}
+
+/* --- liveness --- */
+
+typedef struct UseScan {
+    LocalVars * vars;
+    Bitset * uses;
+} UseScan;
+
+static void scan_uses(ASTNode * node, void * arg) {
+    UseScan * scan = arg;
+    if (node->type == AST_VAR_REF_EXPR) {
+        int index = node->symbol ? local_var_index(scan->vars, node->symbol) : -1;
+        if (index >= 0) {
+            bitset_set(scan->uses, index);
+        }
+        return;
+    }
+    ast_for_each_child(node, scan_uses, scan);
+}
+
+/* the variable an item stores to without reading it first, or -1 */
+static int item_def(CFGItem * item, LocalVars * vars) {
+    ASTNode * node = item->node;
+    if (node->type == AST_VAR_DECL) {
+        return node->var_decl.init_expr ? local_var_index(vars, node->symbol) : -1;
+    }
+    if (node->type == AST_EXPRESSION_STMT) {
+        ASTNode * expr = node->expr_stmt.expr;
+        if (expr && expr->type == AST_BINARY_EXPR && expr->binary.op == BINOP_ASSIGNMENT &&
+            is_tracked_var_ref(expr->binary.lhs, vars)) {
+            return local_var_index(vars, expr->binary.lhs->symbol);
+        }
+    }
+    return -1;
+}
+
+/* live = (live - def) + use for a single item */
+static void transfer_item(CFGItem * item, LocalVars * vars, Bitset * live) {
+    if (is_marker_item(item)) {
+        return;
+    }
+    UseScan scan = { vars, live };
+    int def = item_def(item, vars);
+    if (def >= 0) {
+        bitset_clear(live, def);
+        if (item->node->type == AST_VAR_DECL) {
+            scan_uses(item->node->var_decl.init_expr, &scan);
+        } else {
+            scan_uses(item->node->expr_stmt.expr->binary.rhs, &scan);
+        }
+    } else {
+        scan_uses(item->node, &scan);
+    }
+}
+
+static Bitset ** compute_live_out(CFG * cfg, LocalVars * vars) {
+    Bitset ** live_in = malloc(cfg->block_count * sizeof(Bitset *));
+    Bitset ** live_out = malloc(cfg->block_count * sizeof(Bitset *));
+    for (int i = 0; i < cfg->block_count; i++) {
+        live_in[i] = bitset_new(vars->count);
+        live_out[i] = bitset_new(vars->count);
+    }
+    Bitset * live = bitset_new(vars->count);
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = cfg->block_count - 1; i >= 0; i--) {
+            BasicBlock * block = cfg->blocks[i];
+            for (int s = 0; s < block->succ_count; s++) {
+                bitset_union(live_out[i], live_in[block->succs[s]->id]);
+            }
+            bitset_copy(live, live_out[i]);
+            for (int j = block->item_count - 1; j >= 0; j--) {
+                transfer_item(&block->items[j], vars, live);
+            }
+            if (!bitset_equals(live, live_in[i])) {
+                bitset_copy(live_in[i], live);
+                changed = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < cfg->block_count; i++) {
+        bitset_free(live_in[i]);
+    }
+    free(live_in);
+    bitset_free(live);
+    return live_out;
+}
+
+static ASTNode * strip_casts(ASTNode * node) {
+    while (node && node->type == AST_CAST_EXPR) {
+        node = node->cast_expr.expr;
+    }
+    return node;
+}
+
+/* rewrites an item whose stored value is never read. returns true if changed. */
+static bool remove_dead_store(CFGItem * item) {
+    ASTNode * node = item->node;
+    if (node->type == AST_VAR_DECL) {
+        if (!is_pure_expression(node->var_decl.init_expr)) {
+            return false;
+        }
+        discard_ast(node->var_decl.init_expr);
+        node->var_decl.init_expr = NULL;
+        return true;
+    }
+
+    ASTNode * assignment = node->expr_stmt.expr;
+    ASTNode * rhs = assignment->binary.rhs;
+    if (is_pure_expression(rhs)) {
+        node->expr_stmt.expr = NULL;
+        discard_ast(assignment);
+        return true;
+    }
+
+    // keep the call for its side effects, drop the store of its result
+    ASTNode * call = strip_casts(rhs);
+    if (call->type == AST_FUNCTION_CALL_EXPR) {
+        if (call != rhs) {
+            ASTNode * cast = rhs;
+            while (cast->cast_expr.expr != call) {
+                cast = cast->cast_expr.expr;
+            }
+            cast->cast_expr.expr = NULL;
+        } else {
+            assignment->binary.rhs = NULL;
+        }
+        node->expr_stmt.expr = call;
+        discard_ast(assignment);
+        return true;
+    }
+    return false;
+}
+
+static bool remove_dead_stores(ASTNode * function_def, LocalVars * vars) {
+    CFG * cfg = build_cfg(function_def);
+    Bitset ** live_out = compute_live_out(cfg, vars);
+    CompileStats * stats = get_compile_stats();
+    bool changed = false;
+
+    for (int i = 0; i < cfg->block_count; i++) {
+        BasicBlock * block = cfg->blocks[i];
+        Bitset * live = live_out[i];
+        for (int j = block->item_count - 1; j >= 0; j--) {
+            CFGItem * item = &block->items[j];
+            if (item->kind == CFG_ITEM_STATEMENT) {
+                int def = item_def(item, vars);
+                if (def >= 0 && !bitset_test(live, def) && remove_dead_store(item)) {
+                    stats->dead_stores_removed++;
+                    changed = true;
+                    if (item->node->type == AST_VAR_DECL || !item->node->expr_stmt.expr) {
+                        continue;
+                    }
+                } else if (item->node->type == AST_EXPRESSION_STMT && item->node->expr_stmt.expr &&
+                           is_pure_expression(item->node->expr_stmt.expr)) {
+                    discard_ast(item->node->expr_stmt.expr);
+                    item->node->expr_stmt.expr = NULL;
+                    stats->dead_computations_removed++;
+                    changed = true;
+                    continue;
+                }
+            }
+            transfer_item(item, vars, live);
+        }
+    }
+
+    for (int i = 0; i < cfg->block_count; i++) {
+        bitset_free(live_out[i]);
+    }
+    free(live_out);
+    free_cfg(cfg);
+    return changed;
+}
+
+/* expression statements emptied by dead store removal are dropped from their blocks */
+static void remove_empty_statements(ASTNode * node, void * arg) {
+    if (node->type == AST_BLOCK_STMT) {
+        ASTNode_list * list = node->block.statements;
+        ASTNode_list_node * prev = NULL;
+        ASTNode_list_node * n = list->head;
+        while (n) {
+            ASTNode_list_node * next = n->next;
+            ASTNode * stmt = n->value;
+            if (stmt->type == AST_EXPRESSION_STMT && !stmt->expr_stmt.expr) {
+                if (prev) {
+                    prev->next = next;
+                } else {
+                    list->head = next;
+                }
+                if (list->tail == n) {
+                    list->tail = prev;
+                }
+                list->count--;
+                discard_ast(stmt);
+                free(n);
+            } else {
+                prev = n;
+            }
+            n = next;
+        }
+    }
+    ast_for_each_child(node, remove_empty_statements, arg);
+}
+
+void eliminate_dead_code(ASTNode * function_def) {
+    remove_unreachable_code(function_def);
+
+    LocalVars vars;
+    collect_scalar_locals(function_def, &vars);
+    for (int round = 0; round < MAX_DEAD_STORE_ROUNDS; round++) {
+        if (!remove_dead_stores(function_def, &vars)) {
+            break;
+        }
+    }
+    free_local_vars(&vars);
+
+    remove_empty_statements(function_def->function_def.body, NULL);
+}
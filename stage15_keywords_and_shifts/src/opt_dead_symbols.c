@@ -0,0 +1,185 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "compile_stats.h"
+#include "runtime_usage.h"
+#include "opt_dead_symbols.h"
+
+typedef struct ReachContext {
+    ASTNode * translation_unit;
+    bool * live;                    // indexed by ASTNode id
+    ASTNode_list worklist;          // reached function definitions not yet walked
+    RuntimeUsage * usage;
+} ReachContext;
+
+static ASTNode * find_function_def(ASTNode * translation_unit, const char * name) {
+    for (ASTNode_list_node * n = translation_unit->translation_unit.functions->head; n; n = n->next) {
+        ASTNode * func = n->value;
+        if (func->type == AST_FUNCTION_DEF && strcmp(func->function_def.name, name) == 0) {
+            return func;
+        }
+    }
+    return NULL;
+}
+
+static void reach_function(ReachContext * ctx, const char * name) {
+    ASTNode * func = find_function_def(ctx->translation_unit, name);
+    if (func && !ctx->live[func->id]) {
+        ctx->live[func->id] = true;
+        ASTNode_list_append(&ctx->worklist, func);
+    }
+}
+
+static void mark_reachable(ASTNode * node, void * arg);
+
+static void reach_global(ReachContext * ctx, ASTNode * var_decl) {
+    if (ctx->live[var_decl->id]) return;
+    ctx->live[var_decl->id] = true;
+    // initializers may reference string literals
+    ast_for_each_child(var_decl, mark_reachable, ctx);
+}
+
+static void record_runtime_usage(ReachContext * ctx, ASTNode * node) {
+    RuntimeUsage * usage = ctx->usage;
+    switch (node->type) {
+        case AST_ASSERT_EXTENSION_STATEMENT:
+            usage->assert_fail = true;
+            break;
+        case AST_PRINT_EXTENSION_STATEMENT: {
+            CType * ctype = node->expr_stmt.expr->ctype;
+            if (is_integer_type(ctype) && ctype->size == 8) {
+                usage->print_long = true;
+            } else if (is_integer_type(ctype)) {
+                usage->print_int = true;
+            } else if (is_double_type(ctype)) {
+                usage->print_double = true;
+            } else if (is_string_type(ctype)) {
+                usage->print_string = true;
+            }
+            break;
+        }
+        case AST_UNARY_EXPR:
+            if (node->unary.op == UNARY_NEGATE && node->ctype) {
+                if (node->ctype->kind == CTYPE_FLOAT) {
+                    usage->mask_f32 = true;
+                } else if (node->ctype->kind == CTYPE_DOUBLE) {
+                    usage->mask_f64 = true;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void mark_reachable(ASTNode * node, void * arg) {
+    ReachContext * ctx = arg;
+
+    switch (node->type) {
+        case AST_FUNCTION_CALL_EXPR:
+            reach_function(ctx, node->function_call.name);
+            break;
+        case AST_VAR_REF_EXPR: {
+            Symbol * symbol = node->symbol;
+            if (symbol && symbol->kind == SYMBOL_FUNC) {
+                reach_function(ctx, symbol->name);
+            } else if (symbol && symbol->node && symbol->node->type == AST_VAR_DECL &&
+                       symbol->node->var_decl.is_global) {
+                reach_global(ctx, symbol->node);
+            }
+            break;
+        }
+        case AST_STRING_LITERAL:
+        case AST_FLOAT_LITERAL:
+        case AST_DOUBLE_LITERAL:
+            ctx->live[node->id] = true;
+            break;
+        default:
+            record_runtime_usage(ctx, node);
+            break;
+    }
+
+    ast_for_each_child(node, mark_reachable, ctx);
+}
+
+/* unlinks the list entries whose value is not live. returns how many were removed.
+ * with free_values set the removed values are released with the list's free_fn.
+ */
+static int prune_list(ASTNode_list * list, bool * live, bool free_values) {
+    int removed = 0;
+    ASTNode_list_node * prev = NULL;
+    ASTNode_list_node * n = list->head;
+    while (n) {
+        ASTNode_list_node * next = n->next;
+        if (live[n->value->id]) {
+            prev = n;
+        } else {
+            if (prev) {
+                prev->next = next;
+            } else {
+                list->head = next;
+            }
+            if (list->tail == n) {
+                list->tail = prev;
+            }
+            if (free_values) {
+                FREE_IF_DEFINED(list->free_fn, n->value);
+            }
+            free(n);
+            list->count--;
+            removed++;
+        }
+        n = next;
+    }
+    return removed;
+}
+
+void eliminate_dead_symbols(ASTNode * translation_unit, RuntimeUsage * usage) {
+    ReachContext ctx;
+    ctx.translation_unit = translation_unit;
+    ctx.live = calloc(get_ast_node_count(), sizeof(bool));
+    ctx.usage = usage;
+    ASTNode_list_init(&ctx.worklist, NULL);
+    runtime_usage_init(usage, false);
+
+    ASTNode_list * functions = translation_unit->translation_unit.functions;
+
+    if (find_function_def(translation_unit, "main")) {
+        reach_function(&ctx, "main");
+    } else {
+        for (ASTNode_list_node * n = functions->head; n; n = n->next) {
+            if (n->value->type == AST_FUNCTION_DEF) {
+                reach_function(&ctx, n->value->function_def.name);
+            }
+        }
+    }
+
+    // the worklist grows while it is walked as calls reach more functions
+    for (ASTNode_list_node * n = ctx.worklist.head; n; n = n->next) {
+        ast_for_each_child(n->value, mark_reachable, &ctx);
+    }
+
+    // prototypes are kept, they produce no code
+    for (ASTNode_list_node * n = functions->head; n; n = n->next) {
+        if (n->value->type == AST_FUNCTION_DECL) {
+            ctx.live[n->value->id] = true;
+        }
+    }
+
+    CompileStats * stats = get_compile_stats();
+
+    // literal lists first, the dead function bodies own the dead literal nodes
+    stats->literals_removed += prune_list(translation_unit->translation_unit.string_literals, ctx.live, false);
+    stats->literals_removed += prune_list(translation_unit->translation_unit.float_literals, ctx.live, false);
+    stats->literals_removed += prune_list(translation_unit->translation_unit.double_literals, ctx.live, false);
+    stats->globals_removed += prune_list(translation_unit->translation_unit.globals, ctx.live, false);
+    stats->functions_removed += prune_list(functions, ctx.live, true);
+    stats->runtime_helpers_removed += RUNTIME_HELPER_COUNT - runtime_usage_count(usage);
+
+    ASTNode_list_free(&ctx.worklist);
+    free(ctx.live);
+}
@@ -0,0 +1,857 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "parser_util.h"
+#include "cfg.h"
+#include "bitset.h"
+#include "compile_stats.h"
+#include "compiler_options.h"
+#include "optimizer.h"
+#include "opt_loops.h"
+#include "vectorize.h"
+
+/* a loop statement and the statement list it sits in. the preheader is
+ * made of statements inserted into that list just before the loop.
+ */
+typedef struct LoopSite {
+    ASTNode * stmt;
+    ASTNode_list * list;
+} LoopSite;
+
+typedef struct LoopSites {
+    LoopSite * items;
+    int count;
+    int capacity;
+} LoopSites;
+
+typedef enum {
+    HOIST_VALUE,            // integer arithmetic, the temporary holds the value
+    HOIST_ELEMENT,          // element address, the loop reads through the temporary
+    HOIST_SUBARRAY          // address of a row of a multi dimensional array
+} HoistKind;
+
+typedef struct Hoisted {
+    ASTNode * expr;
+    HoistKind kind;
+    Symbol * temp;
+} Hoisted;
+
+typedef struct Loop {
+    ASTNode * function;
+    ASTNode * stmt;
+    LocalVars * vars;
+    Bitset * stores;        // tracked locals stored anywhere in the loop
+    bool clobbers;          // memory stores or calls anywhere in the loop
+    ASTNode_list * preheader;
+    Hoisted * hoisted;
+    int hoisted_count;
+    int hoisted_capacity;
+} Loop;
+
+/* --- finding loops --- */
+
+static void collect_loop_sites(ASTNode * node, void * arg) {
+    LoopSites * sites = arg;
+    if (node->type == AST_BLOCK_STMT) {
+        ASTNode_list * list = node->block.statements;
+        for (ASTNode_list_node * n = list->head; n; n = n->next) {
+            ASTNode * stmt = n->value;
+            if (stmt->type != AST_FOR_STMT && stmt->type != AST_WHILE_STMT) continue;
+            if (sites->count == sites->capacity) {
+                sites->capacity = sites->capacity ? sites->capacity * 2 : 8;
+                sites->items = realloc(sites->items, sites->capacity * sizeof(LoopSite));
+            }
+            sites->items[sites->count++] = (LoopSite){ stmt, list };
+        }
+    }
+    ast_for_each_child(node, collect_loop_sites, arg);
+}
+
+static void insert_before(ASTNode_list * list, ASTNode * stmt, ASTNode_list * statements) {
+    ASTNode_list_node * prev = NULL;
+    ASTNode_list_node * n = list->head;
+    while (n && n->value != stmt) {
+        prev = n;
+        n = n->next;
+    }
+    if (!n) return;
+    for (ASTNode_list_node * s = statements->head; s; s = s->next) {
+        ASTNode_list_node * node = malloc(sizeof(ASTNode_list_node));
+        node->value = s->value;
+        node->next = n;
+        if (prev) {
+            prev->next = node;
+        } else {
+            list->head = node;
+        }
+        prev = node;
+        list->count++;
+    }
+}
+
+static void remove_statement(ASTNode_list * list, ASTNode * stmt) {
+    ASTNode_list_node * prev = NULL;
+    for (ASTNode_list_node * n = list->head; n; prev = n, n = n->next) {
+        if (n->value != stmt) continue;
+        if (prev) {
+            prev->next = n->next;
+        } else {
+            list->head = n->next;
+        }
+        if (list->tail == n) {
+            list->tail = prev;
+        }
+        list->count--;
+        free(n);
+        return;
+    }
+}
+
+/* the blocks of the natural loop headed by the statement's header. false if
+ * the statement does not loop back, or is entered other than through its header.
+ */
+static bool find_natural_loop(CFG * cfg, Loop * loop) {
+    BasicBlock * header = NULL;
+    for (int i = 0; i < cfg->block_count; i++) {
+        if (cfg->blocks[i]->loop == loop->stmt && cfg->blocks[i]->rpo_index >= 0) {
+            header = cfg->blocks[i];
+        }
+    }
+    if (!header) return false;
+
+    bool * in_loop = calloc(cfg->block_count, sizeof(bool));
+    BasicBlock ** stack = malloc(cfg->block_count * sizeof(BasicBlock *));
+    int depth = 0;
+    bool has_back_edge = false;
+    in_loop[header->id] = true;
+    for (int p = 0; p < header->pred_count; p++) {
+        BasicBlock * latch = header->preds[p];
+        if (latch->rpo_index >= 0 && dominates(header, latch)) {
+            has_back_edge = true;
+            if (!in_loop[latch->id]) {
+                in_loop[latch->id] = true;
+                stack[depth++] = latch;
+            }
+        }
+    }
+    while (depth > 0) {
+        BasicBlock * block = stack[--depth];
+        for (int p = 0; p < block->pred_count; p++) {
+            BasicBlock * pred = block->preds[p];
+            if (pred->rpo_index >= 0 && !in_loop[pred->id]) {
+                in_loop[pred->id] = true;
+                stack[depth++] = pred;
+            }
+        }
+    }
+    free(stack);
+
+    for (int i = 0; has_back_edge && i < cfg->block_count; i++) {
+        BasicBlock * block = cfg->blocks[i];
+        if (!in_loop[i]) continue;
+        for (int j = 0; j < block->item_count; j++) {
+            if (!is_marker_item(&block->items[j])) {
+                collect_stores(block->items[j].node, loop->vars, loop->stores, &loop->clobbers);
+            }
+        }
+    }
+    free(in_loop);
+    return has_back_edge;
+}
+
+/* --- invariance --- */
+
+static bool is_invariant(Loop * loop, ASTNode * node);
+
+static bool is_invariant_address(Loop * loop, ASTNode * node) {
+    if (node->type == AST_VAR_REF_EXPR) {
+        return node->symbol != NULL;
+    }
+    if (node->type == AST_ARRAY_ACCESS) {
+        return is_invariant(loop, node->array_access.base) && is_invariant(loop, node->array_access.index);
+    }
+    return false;
+}
+
+/* true if the expression has the same value on every iteration and can be
+ * evaluated before the loop even when the loop body never runs. nothing that
+ * loads through a pointer or divides by a variable qualifies.
+ */
+static bool is_invariant(Loop * loop, ASTNode * node) {
+    switch (node->type) {
+        case AST_INT_LITERAL:
+            return true;
+        case AST_VAR_REF_EXPR: {
+            if (!node->symbol || is_function_type(node->ctype)) return false;
+            int index = local_var_index(loop->vars, node->symbol);
+            if (index >= 0) {
+                // temporaries added while optimizing are never stored in the loop
+                return index >= loop->stores->size || !bitset_test(loop->stores, index);
+            }
+            return is_array_type(node->ctype) || !loop->clobbers;
+        }
+        case AST_CAST_EXPR:
+            return is_invariant(loop, node->cast_expr.expr);
+        case AST_UNARY_EXPR:
+            switch (node->unary.op) {
+                case UNARY_NEGATE:
+                case UNARY_PLUS:
+                case UNARY_LOGICAL_NOT:
+                case UNARY_BITWISE_NOT:
+                    return is_invariant(loop, node->unary.operand);
+                case UNARY_ADDRESS:
+                    return is_invariant_address(loop, node->unary.operand);
+                default:
+                    return false;
+            }
+        case AST_BINARY_EXPR: {
+            if (is_assignment(node)) return false;
+            BinaryOperator op = node->binary.op;
+            ASTNode * rhs = node->binary.rhs;
+            if ((op == BINOP_DIV || op == BINOP_MOD) && !(rhs->type == AST_INT_LITERAL && rhs->int_value > 0)) {
+                return false;
+            }
+            return is_invariant(loop, node->binary.lhs) && is_invariant(loop, rhs);
+        }
+        case AST_ARRAY_ACCESS:
+            // a row of a multi dimensional array is an address, an element would be a load
+            return is_array_type(node->ctype) && is_invariant_address(loop, node);
+        case AST_COND_EXPR:
+            return is_invariant(loop, node->cond_expr.cond) &&
+                   is_invariant(loop, node->cond_expr.then_expr) &&
+                   is_invariant(loop, node->cond_expr.else_expr);
+        default:
+            return false;
+    }
+}
+
+/* --- hoisting --- */
+
+static bool same_expression(ASTNode * a, ASTNode * b) {
+    if (a->type != b->type || !ctype_equals(a->ctype, b->ctype)) return false;
+    switch (a->type) {
+        case AST_INT_LITERAL:
+            return a->int_value == b->int_value;
+        case AST_VAR_REF_EXPR:
+            return a->symbol == b->symbol;
+        case AST_CAST_EXPR:
+            return same_expression(a->cast_expr.expr, b->cast_expr.expr);
+        case AST_UNARY_EXPR:
+            return a->unary.op == b->unary.op && same_expression(a->unary.operand, b->unary.operand);
+        case AST_BINARY_EXPR:
+            return a->binary.op == b->binary.op &&
+                   same_expression(a->binary.lhs, b->binary.lhs) &&
+                   same_expression(a->binary.rhs, b->binary.rhs);
+        case AST_ARRAY_ACCESS:
+            return same_expression(a->array_access.base, b->array_access.base) &&
+                   same_expression(a->array_access.index, b->array_access.index);
+        case AST_COND_EXPR:
+            return same_expression(a->cond_expr.cond, b->cond_expr.cond) &&
+                   same_expression(a->cond_expr.then_expr, b->cond_expr.then_expr) &&
+                   same_expression(a->cond_expr.else_expr, b->cond_expr.else_expr);
+        default:
+            return false;
+    }
+}
+
+static ASTNode * hoisted_reference(Hoisted * hoisted, CType * ctype) {
+    ASTNode * ref = create_temp_ref(hoisted->temp);
+    return hoisted->kind == HOIST_ELEMENT ? create_typed_unary(UNARY_DEREF, ref, ctype) : ref;
+}
+
+static void hoist(Loop * loop, ASTNode ** slot, HoistKind kind) {
+    ASTNode * expr = *slot;
+    for (int i = 0; i < loop->hoisted_count; i++) {
+        Hoisted * earlier = &loop->hoisted[i];
+        if (earlier->kind == kind && same_expression(earlier->expr, expr)) {
+            *slot = hoisted_reference(earlier, expr->ctype);
+            discard_ast(expr);
+            get_compile_stats()->loop_invariants_hoisted++;
+            return;
+        }
+    }
+
+    CType * ctype = expr->ctype;
+    if (kind == HOIST_ELEMENT) {
+        ctype = make_pointer_type(expr->ctype);
+    } else if (kind == HOIST_SUBARRAY) {
+        ctype = make_pointer_type(expr->ctype->base_type);
+    }
+    Symbol * temp = create_temp_local(loop->function, ctype, "licm");
+    add_local_var(loop->vars, temp);
+
+    ASTNode * value = kind == HOIST_ELEMENT ? create_typed_unary(UNARY_ADDRESS, expr, ctype) : expr;
+    ASTNode_list_append(loop->preheader, create_expression_statement_node(create_temp_assignment(temp, value)));
+
+    if (loop->hoisted_count == loop->hoisted_capacity) {
+        loop->hoisted_capacity = loop->hoisted_capacity ? loop->hoisted_capacity * 2 : 8;
+        loop->hoisted = realloc(loop->hoisted, loop->hoisted_capacity * sizeof(Hoisted));
+    }
+    Hoisted * hoisted = &loop->hoisted[loop->hoisted_count++];
+    *hoisted = (Hoisted){ expr, kind, temp };
+    *slot = hoisted_reference(hoisted, expr->ctype);
+    get_compile_stats()->loop_invariants_hoisted++;
+}
+
+static void hoist_invariants(ASTNode ** slot, void * arg);
+
+static void hoist_in_children(ASTNode * node, Loop * loop) {
+    if (node->type == AST_UNARY_EXPR && node->unary.op == UNARY_ADDRESS) {
+        // &row must keep taking the address of the row itself
+        ASTNode * operand = node->unary.operand;
+        if (operand->type == AST_ARRAY_ACCESS && is_array_type(operand->ctype)) {
+            ast_for_each_child_slot(operand, hoist_invariants, loop);
+            return;
+        }
+    }
+    if (node->type == AST_ARRAY_ACCESS) {
+        ASTNode * base = node->array_access.base;
+        if (base->type == AST_ARRAY_ACCESS && is_array_type(base->ctype) && is_invariant_address(loop, base)) {
+            hoist(loop, &node->array_access.base, HOIST_SUBARRAY);
+        } else {
+            hoist_invariants(&node->array_access.base, loop);
+        }
+        hoist_invariants(&node->array_access.index, loop);
+        return;
+    }
+    ast_for_each_child_slot(node, hoist_invariants, loop);
+}
+
+static void hoist_invariants(ASTNode ** slot, void * arg) {
+    Loop * loop = arg;
+    ASTNode * node = *slot;
+    if (is_reusable_address(node) && is_invariant_address(loop, node)) {
+        hoist(loop, slot, HOIST_ELEMENT);
+    } else if (is_reusable_arithmetic(node) && is_invariant(loop, node)) {
+        hoist(loop, slot, HOIST_VALUE);
+    } else if (node->type == AST_UNARY_EXPR && is_inc_dec(node)) {
+        // the emitter addresses the operand of ++ and -- by name
+        return;
+    } else {
+        hoist_in_children(node, loop);
+    }
+}
+
+/* --- induction variables --- */
+
+/* recognizes i++, i--, i += c, i -= c and i = i + c on a tracked integer */
+static bool find_induction_step(Loop * loop, ASTNode * update, Symbol ** iv, int * step) {
+    ASTNode * target = NULL;
+    int delta = 0;
+    if (is_inc_dec(update)) {
+        target = update->unary.operand;
+        delta = (update->unary.op == UNARY_PRE_INC || update->unary.op == UNARY_POST_INC) ? 1 : -1;
+    } else if (update->type == AST_BINARY_EXPR) {
+        ASTNode * lhs = update->binary.lhs;
+        ASTNode * rhs = update->binary.rhs;
+        if ((update->binary.op == BINOP_COMPOUND_ADD_ASSIGN || update->binary.op == BINOP_COMPOUND_SUB_ASSIGN) &&
+            rhs->type == AST_INT_LITERAL) {
+            target = lhs;
+            delta = update->binary.op == BINOP_COMPOUND_ADD_ASSIGN ? rhs->int_value : -rhs->int_value;
+        } else if (update->binary.op == BINOP_ASSIGNMENT && rhs->type == AST_BINARY_EXPR &&
+                   lhs->type == AST_VAR_REF_EXPR) {
+            ASTNode * a = rhs->binary.lhs;
+            ASTNode * b = rhs->binary.rhs;
+            bool a_is_var = a->type == AST_VAR_REF_EXPR && a->symbol == lhs->symbol;
+            bool b_is_var = b->type == AST_VAR_REF_EXPR && b->symbol == lhs->symbol;
+            if (rhs->binary.op == BINOP_ADD && a_is_var && b->type == AST_INT_LITERAL) {
+                delta = b->int_value;
+            } else if (rhs->binary.op == BINOP_ADD && b_is_var && a->type == AST_INT_LITERAL) {
+                delta = a->int_value;
+            } else if (rhs->binary.op == BINOP_SUB && a_is_var && b->type == AST_INT_LITERAL) {
+                delta = -b->int_value;
+            }
+            target = lhs;
+        }
+    }
+    if (!target || delta == 0 || !is_tracked_var_ref(target, loop->vars)) return false;
+    if (target->ctype->kind != CTYPE_INT && target->ctype->kind != CTYPE_LONG) return false;
+    *iv = target->symbol;
+    *step = delta;
+    return true;
+}
+
+/* index is iv, iv + k, k + iv or iv - k */
+static bool induction_offset(ASTNode * index, Symbol * iv, int * offset) {
+    if (index->type == AST_VAR_REF_EXPR && index->symbol == iv) {
+        *offset = 0;
+        return true;
+    }
+    if (index->type != AST_BINARY_EXPR) return false;
+    ASTNode * a = index->binary.lhs;
+    ASTNode * b = index->binary.rhs;
+    bool a_is_iv = a->type == AST_VAR_REF_EXPR && a->symbol == iv;
+    bool b_is_iv = b->type == AST_VAR_REF_EXPR && b->symbol == iv;
+    if (index->binary.op == BINOP_ADD && a_is_iv && b->type == AST_INT_LITERAL) {
+        *offset = b->int_value;
+        return true;
+    }
+    if (index->binary.op == BINOP_ADD && b_is_iv && a->type == AST_INT_LITERAL) {
+        *offset = a->int_value;
+        return true;
+    }
+    if (index->binary.op == BINOP_SUB && a_is_iv && b->type == AST_INT_LITERAL) {
+        *offset = -b->int_value;
+        return true;
+    }
+    return false;
+}
+
+typedef struct Stride {
+    Symbol * base;
+    int offset;
+    CType * ctype;
+    Symbol * pointer;
+    ASTNode * first;            // copy of the first access, initializes the pointer
+} Stride;
+
+typedef struct InductionScan {
+    Loop * loop;
+    Symbol * iv;
+    Stride * strides;
+    int count;
+    int capacity;
+} InductionScan;
+
+static void reduce_access(ASTNode ** slot, void * arg) {
+    InductionScan * scan = arg;
+    ASTNode * node = *slot;
+    ASTNode * base = node->type == AST_ARRAY_ACCESS ? node->array_access.base : NULL;
+    int offset;
+    if (!is_reusable_address(node) || base->type != AST_VAR_REF_EXPR || !base->symbol ||
+        !is_invariant(scan->loop, base) || !induction_offset(node->array_access.index, scan->iv, &offset)) {
+        if (!(node->type == AST_UNARY_EXPR && is_inc_dec(node))) {
+            ast_for_each_child_slot(node, reduce_access, scan);
+        }
+        return;
+    }
+
+    Stride * stride = NULL;
+    for (int i = 0; i < scan->count; i++) {
+        if (scan->strides[i].base == base->symbol && scan->strides[i].offset == offset &&
+            ctype_equals(scan->strides[i].ctype, node->ctype)) {
+            stride = &scan->strides[i];
+        }
+    }
+    if (!stride) {
+        if (scan->count == scan->capacity) {
+            scan->capacity = scan->capacity ? scan->capacity * 2 : 4;
+            scan->strides = realloc(scan->strides, scan->capacity * sizeof(Stride));
+        }
+        CType * pointer_type = make_pointer_type(node->ctype);
+        stride = &scan->strides[scan->count++];
+        stride->base = base->symbol;
+        stride->offset = offset;
+        stride->ctype = node->ctype;
+        stride->pointer = create_temp_local(scan->loop->function, pointer_type, "iv");
+        stride->first = clone_expression(node);
+        add_local_var(scan->loop->vars, stride->pointer);
+    }
+
+    *slot = create_typed_unary(UNARY_DEREF, create_temp_ref(stride->pointer), node->ctype);
+    discard_ast(node);
+    get_compile_stats()->induction_accesses_reduced++;
+}
+
+static void find_label(ASTNode * node, void * arg) {
+    bool * found = arg;
+    if (node->type == AST_LABELED_STMT) {
+        *found = true;
+        return;
+    }
+    ast_for_each_child(node, find_label, arg);
+}
+
+/* a continue statement jumps to the innermost enclosing loop, a label may be
+ * jumped to from anywhere in the function.
+ */
+static void find_label_or_continue(ASTNode * node, void * arg) {
+    bool * found = arg;
+    if (node->type == AST_LABELED_STMT || node->type == AST_CONTINUE_STMT) {
+        *found = true;
+        return;
+    }
+    if (node->type == AST_FOR_STMT || node->type == AST_WHILE_STMT || node->type == AST_DO_WHILE_STMT) {
+        ast_for_each_child(node, find_label, arg);
+        return;
+    }
+    ast_for_each_child(node, find_label_or_continue, arg);
+}
+
+/* rewrites B[i + k] in a for loop stepping i by a constant into *p, where p
+ * starts at &B[i + k] and is stepped with i. the update moves to the end of
+ * the body so the pointers can be stepped next to it, which is only done when
+ * no continue statement would skip them.
+ */
+static void reduce_induction_variables(Loop * loop) {
+    ASTNode * stmt = loop->stmt;
+    ASTNode * update = stmt->for_stmt.update_expr;
+    Symbol * iv;
+    int step;
+    if (stmt->type != AST_FOR_STMT || !update || !find_induction_step(loop, update, &iv, &step)) return;
+
+    Bitset * stores = bitset_new(loop->stores->size);
+    bool clobbers = false;
+    collect_stores(stmt->for_stmt.cond_expr, loop->vars, stores, &clobbers);
+    collect_stores(stmt->for_stmt.body, loop->vars, stores, &clobbers);
+    bool iv_stored = bitset_test(stores, local_var_index(loop->vars, iv));
+    bitset_free(stores);
+    bool label_or_continue = false;
+    find_label_or_continue(stmt->for_stmt.body, &label_or_continue);
+    if (iv_stored || label_or_continue) return;
+
+    InductionScan scan = { loop, iv, NULL, 0, 0 };
+    if (stmt->for_stmt.cond_expr) {
+        reduce_access(&stmt->for_stmt.cond_expr, &scan);
+    }
+    reduce_access(&stmt->for_stmt.body, &scan);
+    if (scan.count == 0) return;
+
+    ASTNode * body = stmt->for_stmt.body;
+    if (body->type != AST_BLOCK_STMT) {
+        ASTNode_list * statements = create_node_list();
+        ASTNode_list_append(statements, body);
+        body = create_block_node(statements);
+        body->block.introduce_scope = false;
+        stmt->for_stmt.body = body;
+    }
+    ASTNode_list_append(body->block.statements, create_expression_statement_node(update));
+    stmt->for_stmt.update_expr = NULL;
+
+    for (int i = 0; i < scan.count; i++) {
+        Stride * stride = &scan.strides[i];
+        ASTNode * start = create_typed_unary(UNARY_ADDRESS, stride->first, stride->pointer->ctype);
+        ASTNode_list_append(loop->preheader,
+            create_expression_statement_node(create_temp_assignment(stride->pointer, start)));
+
+        ASTNode * bump;
+        if (step == 1 || step == -1) {
+            bump = create_typed_unary(step == 1 ? UNARY_PRE_INC : UNARY_PRE_DEC,
+                                      create_temp_ref(stride->pointer), stride->pointer->ctype);
+        } else {
+            ASTNode * amount = create_int_literal_node(step > 0 ? step : -step);
+            amount->ctype = make_int_type(true);
+            bump = create_binary_node(create_temp_ref(stride->pointer),
+                                      step > 0 ? BINOP_COMPOUND_ADD_ASSIGN : BINOP_COMPOUND_SUB_ASSIGN, amount);
+            bump->ctype = stride->pointer->ctype;
+            bump->binary.common_type = stride->pointer->ctype;
+        }
+        ASTNode_list_append(body->block.statements, create_expression_statement_node(bump));
+    }
+    free(scan.strides);
+}
+
+/* --- driver --- */
+
+static void optimize_loop(ASTNode * function_def, LoopSite * site, LocalVars * vars) {
+    CFG * cfg = build_cfg(function_def);
+    compute_dominators(cfg);
+
+    Loop loop = { 0 };
+    loop.function = function_def;
+    loop.stmt = site->stmt;
+    loop.vars = vars;
+    loop.stores = bitset_new(vars->count);
+    loop.preheader = create_node_list();
+    bool found = find_natural_loop(cfg, &loop);
+    free_cfg(cfg);
+
+    if (found) {
+        ASTNode * stmt = site->stmt;
+        if (stmt->type == AST_FOR_STMT) {
+            if (stmt->for_stmt.cond_expr) {
+                hoist_invariants(&stmt->for_stmt.cond_expr, &loop);
+            }
+            hoist_invariants(&stmt->for_stmt.body, &loop);
+            if (stmt->for_stmt.update_expr) {
+                hoist_invariants(&stmt->for_stmt.update_expr, &loop);
+            }
+            // the vectorizer wants the a[i] accesses as they are
+            VectorLoop vector;
+            if (!match_vector_loop(stmt, &vector)) {
+                reduce_induction_variables(&loop);
+            }
+        } else {
+            hoist_invariants(&stmt->while_stmt.cond, &loop);
+            hoist_invariants(&stmt->while_stmt.body, &loop);
+        }
+    }
+
+    if (loop.preheader->count > 0) {
+        // the preheader runs after the for initializer, which may set what it reads
+        ASTNode_list * statements = create_node_list();
+        ASTNode * init = site->stmt->type == AST_FOR_STMT ? site->stmt->for_stmt.init_expr : NULL;
+        if (init) {
+            if (init->type != AST_DECLARATION_STMT && init->type != AST_EXPRESSION_STMT) {
+                init = create_expression_statement_node(init);
+            }
+            ASTNode_list_append(statements, init);
+            site->stmt->for_stmt.init_expr = NULL;
+        }
+        for (ASTNode_list_node * n = loop.preheader->head; n; n = n->next) {
+            ASTNode_list_append(statements, n->value);
+        }
+        insert_before(site->list, site->stmt, statements);
+        statements->free_fn = NULL;
+        ASTNode_list_free(statements);
+        free(statements);
+    }
+
+    loop.preheader->free_fn = NULL;
+    ASTNode_list_free(loop.preheader);
+    free(loop.preheader);
+    free(loop.hoisted);
+    bitset_free(loop.stores);
+}
+
+void optimize_loops(ASTNode * function_def) {
+    LoopSites sites = { NULL, 0, 0 };
+    collect_loop_sites(function_def->function_def.body, &sites);
+    if (sites.count == 0) return;
+
+    LocalVars vars;
+    collect_scalar_locals(function_def, &vars);
+    // outer loops first, so what they hoist is out of the inner loops' way
+    for (int i = 0; i < sites.count; i++) {
+        optimize_loop(function_def, &sites.items[i], &vars);
+    }
+    free_local_vars(&vars);
+    free(sites.items);
+}
+
+/* --- unrolling --- */
+
+#define UNROLL_MAX_TRIPS 16         // longest loop that is replaced by straight line code
+#define UNROLL_FULL_BUDGET 64       // nodes in the straight line code replacing a loop
+#define UNROLL_BODY_BUDGET 128      // nodes in the body of a partially unrolled loop
+
+/* for (i = start; i < bound; i += step) with a tracked int i that only the
+ * update stores, and a bound that is a constant or an unchanging local.
+ * the comparison may be <, <=, > or >= as long as it agrees with the step.
+ */
+typedef struct CountedLoop {
+    Symbol * iv;
+    int step;
+    BinaryOperator compare;
+    ASTNode * bound;
+    bool has_start;
+    int start;
+} CountedLoop;
+
+static void count_nodes(ASTNode * node, void * arg) {
+    (*(int *)arg)++;
+    ast_for_each_child(node, count_nodes, arg);
+}
+
+static bool find_counted_loop(ASTNode * stmt, LocalVars * vars, CountedLoop * counted) {
+    ASTNode * cond = stmt->for_stmt.cond_expr;
+    ASTNode * update = stmt->for_stmt.update_expr;
+    if (!cond || !update || !is_cloneable(stmt->for_stmt.body)) return false;
+
+    Loop loop = { 0 };
+    loop.vars = vars;
+    if (!find_induction_step(&loop, update, &counted->iv, &counted->step)) return false;
+    if (counted->iv->ctype->kind != CTYPE_INT) return false;
+
+    if (cond->type != AST_BINARY_EXPR) return false;
+    ASTNode * lhs = cond->binary.lhs;
+    ASTNode * bound = cond->binary.rhs;
+    counted->compare = cond->binary.op;
+    bool counts_up = counted->compare == BINOP_LT || counted->compare == BINOP_LE;
+    bool counts_down = counted->compare == BINOP_GT || counted->compare == BINOP_GE;
+    if (!(counts_up && counted->step > 0) && !(counts_down && counted->step < 0)) return false;
+    if (lhs->type != AST_VAR_REF_EXPR || lhs->symbol != counted->iv) return false;
+    if (bound->type != AST_INT_LITERAL &&
+        !(is_tracked_var_ref(bound, vars) && bound->ctype->kind == CTYPE_INT)) return false;
+    counted->bound = bound;
+
+    // neither the induction variable nor the bound may change outside the update
+    Bitset * stores = bitset_new(vars->count);
+    bool clobbers = false;
+    collect_stores(cond, vars, stores, &clobbers);
+    collect_stores(stmt->for_stmt.body, vars, stores, &clobbers);
+    bool stored = bitset_test(stores, local_var_index(vars, counted->iv)) ||
+                  (bound->type == AST_VAR_REF_EXPR && bitset_test(stores, local_var_index(vars, bound->symbol)));
+    bitset_free(stores);
+    if (stored) return false;
+
+    ASTNode * init = stmt->for_stmt.init_expr;
+    if (init && init->type == AST_EXPRESSION_STMT) {
+        init = init->expr_stmt.expr;
+    }
+    counted->has_start = init && init->type == AST_BINARY_EXPR && init->binary.op == BINOP_ASSIGNMENT &&
+                         init->binary.lhs->type == AST_VAR_REF_EXPR && init->binary.lhs->symbol == counted->iv &&
+                         init->binary.rhs->type == AST_INT_LITERAL;
+    if (counted->has_start) {
+        counted->start = init->binary.rhs->int_value;
+    }
+    return true;
+}
+
+/* number of iterations of a loop with a constant start and bound, or -1 if
+ * there are more than UNROLL_MAX_TRIPS
+ */
+static int trip_count(CountedLoop * counted) {
+    long long start = counted->start;
+    long long bound = counted->bound->int_value;
+    long long step = counted->step;
+    long long trips;
+    switch (counted->compare) {
+        case BINOP_LT: trips = start < bound ? (bound - start + step - 1) / step : 0; break;
+        case BINOP_LE: trips = start <= bound ? (bound - start) / step + 1 : 0; break;
+        case BINOP_GT: trips = start > bound ? (start - bound - step - 1) / -step : 0; break;
+        case BINOP_GE: trips = start >= bound ? (start - bound) / -step + 1 : 0; break;
+        default: return -1;
+    }
+    return trips <= UNROLL_MAX_TRIPS ? (int)trips : -1;
+}
+
+static ASTNode * create_int_node(int value) {
+    ASTNode * node = create_int_literal_node(value);
+    node->ctype = make_int_type(true);
+    return node;
+}
+
+static ASTNode * create_int_binary(ASTNode * lhs, BinaryOperator op, ASTNode * rhs) {
+    ASTNode * node = create_binary_node(lhs, op, rhs);
+    node->ctype = make_int_type(true);
+    node->binary.common_type = node->ctype;
+    return node;
+}
+
+/* i + offset, or just i */
+static ASTNode * create_iv_offset(Symbol * iv, int offset) {
+    if (offset == 0) return create_temp_ref(iv);
+    return offset > 0 ? create_int_binary(create_temp_ref(iv), BINOP_ADD, create_int_node(offset))
+                      : create_int_binary(create_temp_ref(iv), BINOP_SUB, create_int_node(-offset));
+}
+
+typedef struct IVSubstitution {
+    Symbol * iv;
+    int value;
+    bool constant;          // replace i by value, otherwise by i + value
+} IVSubstitution;
+
+static void substitute_iv(ASTNode ** slot, void * arg) {
+    IVSubstitution * sub = arg;
+    ASTNode * node = *slot;
+    if (node->type == AST_VAR_REF_EXPR && node->symbol == sub->iv) {
+        *slot = sub->constant ? create_int_node(sub->value) : create_iv_offset(sub->iv, sub->value);
+        discard_ast(node);
+        return;
+    }
+    ast_for_each_child_slot(node, substitute_iv, arg);
+}
+
+static ASTNode * clone_iteration(ASTNode * body, Symbol * iv, int value, bool constant) {
+    ASTNode * copy = clone_statement(body);
+    IVSubstitution sub = { iv, value, constant };
+    ast_for_each_child_slot(copy, substitute_iv, &sub);
+    return copy;
+}
+
+/* replaces a loop of a few iterations by one copy of the body per iteration,
+ * with the induction variable replaced by its value, and then sets the
+ * variable to its final value.
+ */
+static void unroll_fully(LoopSite * site, CountedLoop * counted, int trips) {
+    ASTNode * stmt = site->stmt;
+    ASTNode_list * statements = create_node_list();
+    for (int k = 0; k < trips; k++) {
+        ASTNode_list_append(statements,
+            clone_iteration(stmt->for_stmt.body, counted->iv, counted->start + k * counted->step, true));
+    }
+    ASTNode * final = create_temp_assignment(counted->iv, create_int_node(counted->start + trips * counted->step));
+    ASTNode_list_append(statements, create_expression_statement_node(final));
+
+    insert_before(site->list, stmt, statements);
+    remove_statement(site->list, stmt);
+    discard_ast(stmt);
+    statements->free_fn = NULL;
+    ASTNode_list_free(statements);
+    free(statements);
+    get_compile_stats()->loops_fully_unrolled++;
+}
+
+/* runs factor iterations per trip of a new main loop while all of them are
+ * in range. the original loop follows it and finishes the remaining ones.
+ */
+static void unroll_partially(LoopSite * site, CountedLoop * counted, int factor) {
+    ASTNode * stmt = site->stmt;
+    ASTNode_list * iterations = create_node_list();
+    for (int k = 0; k < factor; k++) {
+        ASTNode_list_append(iterations, clone_iteration(stmt->for_stmt.body, counted->iv, k * counted->step, false));
+    }
+    ASTNode * body = create_block_node(iterations);
+    body->block.introduce_scope = false;
+
+    int last = (factor - 1) * counted->step;
+    ASTNode * cond = create_int_binary(create_iv_offset(counted->iv, last), counted->compare,
+                                       clone_expression(counted->bound));
+    ASTNode * update = create_int_binary(create_temp_ref(counted->iv), BINOP_COMPOUND_ADD_ASSIGN,
+                                         create_int_node(factor * counted->step));
+    ASTNode * main_loop = create_for_statement_node(NULL, cond, update, body);
+
+    ASTNode_list * statements = create_node_list();
+    ASTNode * init = stmt->for_stmt.init_expr;
+    if (init) {
+        if (init->type != AST_DECLARATION_STMT && init->type != AST_EXPRESSION_STMT) {
+            init = create_expression_statement_node(init);
+        }
+        ASTNode_list_append(statements, init);
+        stmt->for_stmt.init_expr = NULL;
+    }
+    ASTNode_list_append(statements, main_loop);
+    insert_before(site->list, stmt, statements);
+    statements->free_fn = NULL;
+    ASTNode_list_free(statements);
+    free(statements);
+    get_compile_stats()->loops_unrolled++;
+}
+
+static void unroll_loop(LoopSite * site, LocalVars * vars, int factor) {
+    CountedLoop counted;
+    if (site->stmt->type != AST_FOR_STMT || !find_counted_loop(site->stmt, vars, &counted)) return;
+
+    int size = 0;
+    count_nodes(site->stmt->for_stmt.body, &size);
+
+    if (counted.has_start && counted.bound->type == AST_INT_LITERAL) {
+        int trips = trip_count(&counted);
+        if (trips >= 0 && trips * size <= UNROLL_FULL_BUDGET) {
+            unroll_fully(site, &counted, trips);
+            return;
+        }
+    }
+
+    // packed code already does several iterations per trip
+    VectorLoop vector;
+    if (match_vector_loop(site->stmt, &vector)) return;
+
+    while (factor > 1 && factor * size > UNROLL_BODY_BUDGET) {
+        factor /= 2;
+    }
+    if (factor > 1) {
+        unroll_partially(site, &counted, factor);
+    }
+}
+
+void unroll_loops(ASTNode * function_def) {
+    int factor = get_compiler_options()->unroll_factor;
+    if (factor <= 1) return;
+
+    LoopSites sites = { NULL, 0, 0 };
+    collect_loop_sites(function_def->function_def.body, &sites);
+    if (sites.count == 0) return;
+
+    LocalVars vars;
+    collect_scalar_locals(function_def, &vars);
+    for (int i = 0; i < sites.count; i++) {
+        unroll_loop(&sites.items[i], &vars, factor);
+    }
+    free_local_vars(&vars);
+    free(sites.items);
+}
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "vreg.h"
+#include "compile_stats.h"
+#include "compiler_options.h"
+#include "optimizer.h"
+#include "opt_registers.h"
+
+// a use inside a loop counts as this many uses outside it, per level of nesting
+#define LOOP_WEIGHT 8
+#define MAX_LOOP_DEPTH 6
+
+typedef struct UseScan {
+    LocalVars * vars;
+    long * weights;
+    long depth_weight;
+    int depth;
+} UseScan;
+
+static bool fits_register(Symbol * symbol) {
+    CType * ctype = symbol->ctype;
+    return is_integer_type(ctype) || is_pointer_type(ctype);
+}
+
+static void weigh_uses(ASTNode * node, void * arg) {
+    UseScan * scan = arg;
+    if (node->type == AST_VAR_REF_EXPR && node->symbol) {
+        int index = local_var_index(scan->vars, node->symbol);
+        if (index >= 0) {
+            scan->weights[index] += scan->depth_weight;
+        }
+    }
+
+    bool is_loop = node->type == AST_WHILE_STMT || node->type == AST_FOR_STMT ||
+                   node->type == AST_DO_WHILE_STMT;
+    UseScan outer = *scan;
+    if (is_loop && scan->depth < MAX_LOOP_DEPTH) {
+        scan->depth++;
+        scan->depth_weight *= LOOP_WEIGHT;
+    }
+    ast_for_each_child(node, weigh_uses, scan);
+    scan->depth = outer.depth;
+    scan->depth_weight = outer.depth_weight;
+}
+
+void promote_locals_to_registers(ASTNode * function_def) {
+    if (!get_compiler_options()->register_locals) {
+        return;
+    }
+
+    LocalVars vars;
+    collect_scalar_locals(function_def, &vars);
+    for (int i = 0; i < vars.count; ) {
+        if (fits_register(vars.symbols[i])) {
+            i++;
+        } else {
+            vars.symbols[i] = vars.symbols[--vars.count];
+        }
+    }
+
+    UseScan scan = { &vars, calloc(vars.count + 1, sizeof(long)), 1, 0 };
+    ast_for_each_child(function_def, weigh_uses, &scan);
+
+    int promoted = 0;
+    while (promoted < CALLEE_SAVED_GPR_COUNT) {
+        int best = -1;
+        for (int i = 0; i < vars.count; i++) {
+            if (vars.symbols[i]->reg == PR_NONE && scan.weights[i] > 0 &&
+                (best < 0 || scan.weights[i] > scan.weights[best])) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        vars.symbols[best]->reg = callee_saved_gpr(promoted++);
+    }
+
+    if (promoted > 0) {
+        int * frame_size = &function_def->function_def.size;
+        *frame_size = (*frame_size + 7) / 8 * 8 + promoted * 8;
+        function_def->function_def.saved_registers = promoted;
+        function_def->function_def.save_area = -*frame_size;
+        get_compile_stats()->locals_promoted += promoted;
+    }
+
+    free(scan.weights);
+    free_local_vars(&vars);
+}
@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "parser_util.h"
+#include "error.h"
+#include "bitset.h"
+#include "runtime_usage.h"
+#include "opt_dead_code.h"
+#include "opt_cse.h"
+#include "opt_loops.h"
+#include "opt_dead_symbols.h"
+#include "opt_registers.h"
+#include "optimizer.h"
+
+/* subtrees removed by the passes. the literal lists of the translation unit
+ * can still point into them until dead symbol elimination has pruned those
+ * lists, so freeing is deferred to the end of optimize_translation_unit.
+ */
+static ASTNode_list discarded = { NULL, NULL, 0, free_ast };
+
+void discard_ast(ASTNode * node) {
+    if (node) {
+        ASTNode_list_append(&discarded, node);
+    }
+}
+
+void optimize_translation_unit(ASTNode * translation_unit, RuntimeUsage * usage) {
+    for (ASTNode_list_node * n = translation_unit->translation_unit.functions->head; n; n = n->next) {
+        ASTNode * func = n->value;
+        if (func->type == AST_FUNCTION_DEF) {
+            eliminate_dead_code(func);
+            unroll_loops(func);
+            optimize_loops(func);
+            eliminate_common_subexpressions(func);
+            promote_locals_to_registers(func);
+        }
+    }
+
+    eliminate_dead_symbols(translation_unit, usage);
+
+    ASTNode_list_free(&discarded);
+}
+
+/* true if evaluating the expression has no effect other than its value */
+bool is_pure_expression(ASTNode * node) {
+    if (!node) return true;
+
+    switch (node->type) {
+        case AST_INT_LITERAL:
+        case AST_FLOAT_LITERAL:
+        case AST_DOUBLE_LITERAL:
+        case AST_STRING_LITERAL:
+        case AST_VAR_REF_EXPR:
+            return true;
+        case AST_CAST_EXPR:
+            return is_pure_expression(node->cast_expr.expr);
+        case AST_ARRAY_ACCESS:
+            return is_pure_expression(node->array_access.base) &&
+                   is_pure_expression(node->array_access.index);
+        case AST_UNARY_EXPR:
+            switch (node->unary.op) {
+                case UNARY_PRE_INC:
+                case UNARY_PRE_DEC:
+                case UNARY_POST_INC:
+                case UNARY_POST_DEC:
+                    return false;
+                default:
+                    return is_pure_expression(node->unary.operand);
+            }
+        case AST_BINARY_EXPR:
+            if (is_assignment(node)) {
+                return false;
+            }
+            return is_pure_expression(node->binary.lhs) && is_pure_expression(node->binary.rhs);
+        case AST_COND_EXPR:
+            return is_pure_expression(node->cond_expr.cond) &&
+                   is_pure_expression(node->cond_expr.then_expr) &&
+                   is_pure_expression(node->cond_expr.else_expr);
+        default:
+            return false;
+    }
+}
+
+void add_local_var(LocalVars * vars, Symbol * symbol) {
+    if (local_var_index(vars, symbol) >= 0) return;
+    if (vars->count == vars->capacity) {
+        vars->capacity = vars->capacity ? vars->capacity * 2 : 16;
+        vars->symbols = realloc(vars->symbols, vars->capacity * sizeof(Symbol *));
+    }
+    vars->symbols[vars->count++] = symbol;
+}
+
+static void remove_local(LocalVars * vars, Symbol * symbol) {
+    int index = local_var_index(vars, symbol);
+    if (index < 0) return;
+    vars->symbols[index] = vars->symbols[--vars->count];
+}
+
+static void collect_declarations(ASTNode * node, void * arg) {
+    LocalVars * vars = arg;
+    if (node->type == AST_VAR_DECL && node->symbol && !node->var_decl.is_global &&
+        !is_array_type(node->ctype)) {
+        add_local_var(vars, node->symbol);
+    }
+    ast_for_each_child(node, collect_declarations, vars);
+}
+
+static void drop_address_taken(ASTNode * node, void * arg) {
+    LocalVars * vars = arg;
+    if (node->type == AST_UNARY_EXPR && node->unary.op == UNARY_ADDRESS) {
+        ASTNode * operand = node->unary.operand;
+        if (operand->type == AST_VAR_REF_EXPR && operand->symbol) {
+            remove_local(vars, operand->symbol);
+        }
+    }
+    ast_for_each_child(node, drop_address_taken, vars);
+}
+
+void collect_scalar_locals(ASTNode * function_def, LocalVars * vars) {
+    vars->symbols = NULL;
+    vars->count = 0;
+    vars->capacity = 0;
+    ast_for_each_child(function_def, collect_declarations, vars);
+    ast_for_each_child(function_def, drop_address_taken, vars);
+}
+
+int local_var_index(LocalVars * vars, Symbol * symbol) {
+    for (int i = 0; i < vars->count; i++) {
+        if (vars->symbols[i] == symbol) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool is_tracked_var_ref(ASTNode * node, LocalVars * vars) {
+    return node && node->type == AST_VAR_REF_EXPR && node->symbol &&
+           local_var_index(vars, node->symbol) >= 0;
+}
+
+void free_local_vars(LocalVars * vars) {
+    free(vars->symbols);
+    vars->symbols = NULL;
+    vars->count = 0;
+    vars->capacity = 0;
+}
+
+/* --- stores --- */
+
+typedef struct StoreScan {
+    LocalVars * vars;
+    Bitset * stores;
+    bool clobbers;
+} StoreScan;
+
+static void note_store(StoreScan * scan, ASTNode * target) {
+    int index = -1;
+    if (target->type == AST_VAR_REF_EXPR && target->symbol) {
+        index = local_var_index(scan->vars, target->symbol);
+    }
+    if (index >= 0) {
+        bitset_set(scan->stores, index);
+    } else {
+        scan->clobbers = true;
+    }
+}
+
+static void scan_stores(ASTNode * node, void * arg) {
+    StoreScan * scan = arg;
+    switch (node->type) {
+        case AST_BINARY_EXPR:
+            if (is_assignment(node)) {
+                note_store(scan, node->binary.lhs);
+            }
+            break;
+        case AST_UNARY_EXPR:
+            switch (node->unary.op) {
+                case UNARY_PRE_INC:
+                case UNARY_PRE_DEC:
+                case UNARY_POST_INC:
+                case UNARY_POST_DEC:
+                    note_store(scan, node->unary.operand);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case AST_FUNCTION_CALL_EXPR:
+            scan->clobbers = true;
+            break;
+        case AST_VAR_DECL:
+            if (node->symbol && local_var_index(scan->vars, node->symbol) >= 0) {
+                bitset_set(scan->stores, local_var_index(scan->vars, node->symbol));
+            } else if (node->var_decl.init_expr) {
+                scan->clobbers = true;
+            }
+            break;
+        default:
+            break;
+    }
+    ast_for_each_child(node, scan_stores, scan);
+}
+
+/* adds the tracked locals the subtree may store to, and sets clobbers if it
+ * may store to anything else or call a function
+ */
+void collect_stores(ASTNode * node, LocalVars * vars, Bitset * stores, bool * clobbers) {
+    if (!node) return;
+    StoreScan scan = { vars, stores, *clobbers };
+    scan_stores(node, &scan);
+    *clobbers = scan.clobbers;
+}
+
+/* --- temporaries --- */
+
+/* element accesses whose load the emitter performs the same way through a
+ * pointer. char and short elements are sign extended by an array access but
+ * zero extended by a dereference, so they are left alone.
+ */
+bool is_reusable_address(ASTNode * node) {
+    if (node->type != AST_ARRAY_ACCESS || !node->ctype) return false;
+    switch (node->ctype->kind) {
+        case CTYPE_INT:
+        case CTYPE_LONG:
+        case CTYPE_PTR:
+        case CTYPE_FLOAT:
+        case CTYPE_DOUBLE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_leaf(ASTNode * node) {
+    while (node->type == AST_CAST_EXPR) {
+        node = node->cast_expr.expr;
+    }
+    return node->type == AST_VAR_REF_EXPR || node->type == AST_INT_LITERAL;
+}
+
+/* integer arithmetic worth a store and a reload: a multiply or divide, or an
+ * operation on something that is not a plain variable or constant.
+ */
+bool is_reusable_arithmetic(ASTNode * node) {
+    if (node->type != AST_BINARY_EXPR || !node->ctype) return false;
+    switch (node->binary.op) {
+        case BINOP_ADD:
+        case BINOP_SUB:
+        case BINOP_MUL:
+        case BINOP_DIV:
+        case BINOP_MOD:
+        case BINOP_BITWISE_AND:
+        case BINOP_BITWISE_OR:
+        case BINOP_BITWISE_XOR:
+        case BINOP_SHIFT_LEFT:
+        case BINOP_SHIFT_RIGHT:
+            break;
+        default:
+            return false;
+    }
+    if (node->ctype->kind != CTYPE_INT && node->ctype->kind != CTYPE_LONG) return false;
+    if (!is_integer_type(node->binary.lhs->ctype) || !is_integer_type(node->binary.rhs->ctype)) return false;
+
+    BinaryOperator op = node->binary.op;
+    return op == BINOP_MUL || op == BINOP_DIV || op == BINOP_MOD ||
+           !is_leaf(node->binary.lhs) || !is_leaf(node->binary.rhs);
+}
+
+static int temp_count = 0;
+
+/* temporaries are declared at the top of the function body so the emitter
+ * finds them like any other local.
+ */
+Symbol * create_temp_local(ASTNode * function_def, CType * ctype, const char * prefix) {
+    char name[64];
+    snprintf(name, sizeof(name), "__%s%d", prefix, temp_count++);
+
+    int size = sizeof_type(ctype);
+    int * frame_size = &function_def->function_def.size;
+    *frame_size = (*frame_size + size - 1) / size * size + size;
+
+    ASTNode * decl = create_var_decl_node(name, ctype, NULL);
+    Symbol * temp = create_symbol(name, SYMBOL_VAR, ctype, decl);
+    temp->storage = STORAGE_LOCAL;
+    temp->info.var.storage = STORAGE_LOCAL;
+    temp->info.var.offset = -*frame_size;
+    decl->symbol = temp;
+
+    ASTNode_list * body = function_def->function_def.body->block.statements;
+    ASTNode_list_node * n = malloc(sizeof(ASTNode_list_node));
+    n->value = decl;
+    n->next = body->head;
+    body->head = n;
+    if (!body->tail) {
+        body->tail = n;
+    }
+    body->count++;
+    return temp;
+}
+
+ASTNode * create_temp_ref(Symbol * temp) {
+    ASTNode * ref = create_var_ref_node(temp->name);
+    ref->symbol = temp;
+    ref->ctype = temp->ctype;
+    return ref;
+}
+
+ASTNode * create_temp_assignment(Symbol * temp, ASTNode * value) {
+    ASTNode * assignment = create_binary_node(create_temp_ref(temp), BINOP_ASSIGNMENT, value);
+    assignment->ctype = temp->ctype;
+    assignment->binary.common_type = temp->ctype;
+    return assignment;
+}
+
+ASTNode * create_typed_unary(UnaryOperator op, ASTNode * operand, CType * ctype) {
+    ASTNode * node = create_unary_node(op, operand);
+    node->ctype = ctype;
+    return node;
+}
+
+static void check_cloneable(ASTNode * node, void * arg) {
+    bool * cloneable = arg;
+    if (*cloneable && !is_cloneable(node)) {
+        *cloneable = false;
+    }
+}
+
+/* true if clone_expression or clone_statement can copy the whole subtree.
+ * literals with a data label, declarations and anything that jumps or
+ * defines a jump target are left out.
+ */
+bool is_cloneable(ASTNode * node) {
+    if (!node) return true;
+    switch (node->type) {
+        case AST_INT_LITERAL:
+        case AST_VAR_REF_EXPR:
+        case AST_CAST_EXPR:
+        case AST_UNARY_EXPR:
+        case AST_BINARY_EXPR:
+        case AST_ARRAY_ACCESS:
+        case AST_COND_EXPR:
+        case AST_FUNCTION_CALL_EXPR:
+        case AST_BLOCK_STMT:
+        case AST_EXPRESSION_STMT:
+        case AST_IF_STMT:
+        case AST_RETURN_STMT:
+        case AST_PRINT_EXTENSION_STATEMENT:
+        case AST_ASSERT_EXTENSION_STATEMENT:
+            break;
+        default:
+            return false;
+    }
+    bool cloneable = true;
+    ast_for_each_child(node, check_cloneable, &cloneable);
+    return cloneable;
+}
+
+/* copies an expression, keeping the analyzer's types and symbols */
+ASTNode * clone_expression(ASTNode * node) {
+    ASTNode * copy;
+    switch (node->type) {
+        case AST_INT_LITERAL:
+            copy = create_int_literal_node(node->int_value);
+            break;
+        case AST_VAR_REF_EXPR:
+            copy = create_var_ref_node(node->var_ref.name);
+            break;
+        case AST_CAST_EXPR:
+            copy = create_cast_expr_node(node->cast_expr.target_ctype, clone_expression(node->cast_expr.expr));
+            break;
+        case AST_UNARY_EXPR:
+            copy = create_unary_node(node->unary.op, clone_expression(node->unary.operand));
+            break;
+        case AST_BINARY_EXPR:
+            copy = create_binary_node(clone_expression(node->binary.lhs), node->binary.op,
+                                      clone_expression(node->binary.rhs));
+            copy->binary.common_type = node->binary.common_type;
+            break;
+        case AST_ARRAY_ACCESS:
+            copy = create_array_access_node(clone_expression(node->array_access.base),
+                                            clone_expression(node->array_access.index));
+            break;
+        case AST_COND_EXPR:
+            copy = create_cond_expr_node(clone_expression(node->cond_expr.cond),
+                                         clone_expression(node->cond_expr.then_expr),
+                                         clone_expression(node->cond_expr.else_expr));
+            copy->cond_expr.return_type = node->cond_expr.return_type;
+            copy->cond_expr.is_lvalue = node->cond_expr.is_lvalue;
+            break;
+        case AST_FUNCTION_CALL_EXPR: {
+            ASTNode_list * args = NULL;
+            if (node->function_call.arg_list) {
+                args = create_node_list();
+                for (ASTNode_list_node * n = node->function_call.arg_list->head; n; n = n->next) {
+                    ASTNode_list_append(args, clone_expression(n->value));
+                }
+            }
+            copy = create_function_call_node(node->function_call.name, args);
+            break;
+        }
+        default:
+            error("Unsupported node type %s in clone_expression", get_ast_node_name(node));
+            return NULL;
+    }
+    copy->ctype = node->ctype;
+    copy->symbol = node->symbol;
+    return copy;
+}
+
+/* copies a statement that passes is_cloneable */
+ASTNode * clone_statement(ASTNode * node) {
+    ASTNode * copy;
+    switch (node->type) {
+        case AST_BLOCK_STMT: {
+            ASTNode_list * statements = create_node_list();
+            for (ASTNode_list_node * n = node->block.statements->head; n; n = n->next) {
+                ASTNode_list_append(statements, clone_statement(n->value));
+            }
+            copy = create_block_node(statements);
+            copy->block.introduce_scope = node->block.introduce_scope;
+            break;
+        }
+        case AST_EXPRESSION_STMT:
+            copy = create_expression_statement_node(clone_expression(node->expr_stmt.expr));
+            break;
+        case AST_IF_STMT:
+            copy = create_if_else_statement_node(clone_expression(node->if_stmt.cond),
+                                                 clone_statement(node->if_stmt.then_stmt),
+                                                 node->if_stmt.else_stmt ? clone_statement(node->if_stmt.else_stmt) : NULL);
+            break;
+        case AST_RETURN_STMT:
+            copy = create_return_statement_node(node->return_stmt.expr ? clone_expression(node->return_stmt.expr) : NULL);
+            break;
+        case AST_PRINT_EXTENSION_STATEMENT:
+            copy = create_print_extension_node(clone_expression(node->expr_stmt.expr));
+            break;
+        case AST_ASSERT_EXTENSION_STATEMENT:
+            copy = create_assert_extension_node(clone_expression(node->expr_stmt.expr), node->expr_stmt.line);
+            break;
+        default:
+            error("Unsupported node type %s in clone_statement", get_ast_node_name(node));
+            return NULL;
+    }
+    copy->ctype = node->ctype;
+    copy->symbol = node->symbol;
+    return copy;
+}
@@ -115,8 +115,7 @@ Declarator * parse_direct_declarator(ParserContext * ctx, Declarator * declarato
         declarator = parse_postfix_declarator(ctx, declarator);
     } else {
         Token* tok_name = expect_token(ctx, TOKEN_IDENTIFIER);
-        char * name = strdup(tok_name->text);
-        declarator->name = strdup(name);
+        declarator->name = token_text(tok_name);
         //        set_current_decl_name(ctx, name);
         declarator = parse_postfix_declarator(ctx, declarator);
     }
@@ -328,19 +328,19 @@ ASTNode * parse_primary_expression(ParserContext * parserContext) {
     if (is_current_token(parserContext, TOKEN_INT_LITERAL)) {
         Token * tok = peek(parserContext);
         advance_parser(parserContext);
-        ASTNode * node = create_int_literal_node(tok->int_value);
+        ASTNode * node = create_int_literal_node(token_int_value(tok));
         return node;
     }
     if (is_current_token(parserContext, TOKEN_FLOAT_LITERAL)) {
         Token * tok = peek(parserContext);
         advance_parser(parserContext);
-        ASTNode * node = create_float_literal_node(tok->float_value);
+        ASTNode * node = create_float_literal_node(token_float_value(tok));
         return node;
     }
     if (is_current_token(parserContext, TOKEN_DOUBLE_LITERAL)) {
         Token * tok = peek(parserContext);
         advance_parser(parserContext);
-        ASTNode * node = create_double_literal_node(tok->double_value);
+        ASTNode * node = create_double_literal_node(token_double_value(tok));
         return node;
 
     }
@@ -355,12 +355,18 @@ ASTNode * parse_primary_expression(ParserContext * parserContext) {
     if (is_current_token(parserContext, TOKEN_IDENTIFIER)) {
         Token * tok = peek(parserContext);
         advance_parser(parserContext);
-        return create_var_ref_node(tok->text);
+        char * name = token_text(tok);
+        ASTNode * node = create_var_ref_node(name);
+        free(name);
+        return node;
     }
     if (is_current_token(parserContext, TOKEN_STRING_LITERAL)) {
         Token * tok = peek(parserContext);
         advance_parser(parserContext);
-        return create_string_literal_node(tok->text);
+        char * text = token_text(tok);
+        ASTNode * node = create_string_literal_node(text);
+        free(text);
+        return node;
     }
     error("Unhandled token error, %s", get_current_token_type_name(parserContext));
     return NULL;
@@ -296,7 +296,9 @@ ASTNode_list * parse_param_list(ParserContext * parserContext) {
         CType * ctype = parse_type_specifier(parserContext);
         print_c_type(ctype, 0);
         Token * param_name = expect_token(parserContext, TOKEN_IDENTIFIER);
-        ASTNode * param = create_var_decl_node(param_name->text, ctype, NULL);
+        char * name = token_text(param_name);
+        ASTNode * param = create_var_decl_node(name, ctype, NULL);
+        free(name);
         param->var_decl.is_param = true;
         ASTNode_list_append(param_list, param);
     } while (match_token(parserContext, TOKEN_COMMA));
@@ -362,6 +364,7 @@ ASTNode * parse_function_definition(ParserContext * parserContext, const char *
 //// STATEMENTS
 /////////////////////////////////////////////////////////
 ASTNode * parse_assert_extension_statement(ParserContext * parserContext) {
+    int line = get_current_token_line(parserContext);
     expect_token(parserContext, TOKEN_ASSERT_EXTENSION);
     expect_token(parserContext, TOKEN_LPAREN);
 
@@ -370,7 +373,7 @@ ASTNode * parse_assert_extension_statement(ParserContext * parserContext) {
     expect_token(parserContext, TOKEN_RPAREN);
     expect_token(parserContext, TOKEN_SEMICOLON);
 
-    return create_assert_extension_node(expr);
+    return create_assert_extension_node(expr, line);
 }
 
 ASTNode * parse_print_extension_statement(ParserContext * parserContext) {
@@ -402,12 +405,14 @@ ASTNode * parse_block(ParserContext* parserContext) {
 
 ASTNode * parse_label_statement(ParserContext* parserContext) {
     Token * labelToken = expect_token(parserContext, TOKEN_IDENTIFIER);
-    const char * label = labelToken->text;
+    char * label = token_text(labelToken);
     
     expect_token(parserContext, TOKEN_COLON);
     ASTNode * stmt = parse_statement(parserContext);
 
-    return create_ast_labeled_statement_node(label, stmt);
+    ASTNode * node = create_ast_labeled_statement_node(label, stmt);
+    free(label);
+    return node;
 }
 
 
@@ -431,10 +436,12 @@ ASTNode * parse_default_statement(ParserContext * parserContext) {
 ASTNode * parse_goto_statement(ParserContext * parserContext) {
     expect_token(parserContext, TOKEN_GOTO);
     Token * labelToken = expect_token(parserContext, TOKEN_IDENTIFIER);
-    const char * label = labelToken->text;
+    char * label = token_text(labelToken);
     expect_token(parserContext, TOKEN_SEMICOLON);
 
-    return create_goto_statement(label);
+    ASTNode * node = create_goto_statement(label);
+    free(label);
+    return node;
 }
 
 ASTNode * parse_do_while_statement(ParserContext * parserContext) {
@@ -21,9 +21,9 @@ void update_current_token_info(ParserContext* ctx) {
 //    Token * currentToken = tokenlist_cursor_next(ctx->cursor);
     Token * currentToken = peek(ctx);
     if (currentToken != NULL) {
-        snprintf(currentTokenInfo, sizeof(currentTokenInfo), "POS: %d, TOKEN: %s, TEXT: %s", 
+        snprintf(currentTokenInfo, sizeof(currentTokenInfo), "POS: %d, TOKEN: %s, TEXT: %.*s", 
             ctx->pos,
-            token_type_name(currentToken->type), currentToken->text ? currentToken->text : "(null)");
+            token_type_name(currentToken->type), currentToken->length, token_start(currentToken));
     }
     else {
         snprintf(currentTokenInfo, sizeof(currentTokenInfo), "(NULL)\n");
@@ -34,9 +34,9 @@ void update_current_token_info(ParserContext* ctx) {
 //    TokenData * next = curr->next;
     Token * nextToken = peek_next(ctx);
     if (nextToken != NULL) {
-        snprintf(nextTokenInfo, sizeof(nextTokenInfo), "POS: %d, TOKEN: %s, TEXT: %s", 
+        snprintf(nextTokenInfo, sizeof(nextTokenInfo), "POS: %d, TOKEN: %s, TEXT: %.*s", 
             ctx->pos+1,
-            token_type_name(nextToken->type), nextToken->text ? nextToken->text : "(null)");
+            token_type_name(nextToken->type), nextToken->length, token_start(nextToken));
     }
     else {
         snprintf(nextTokenInfo, sizeof(nextTokenInfo), "(NULL)\n");
@@ -137,11 +137,11 @@ const char * get_current_token_type_name(ParserContext * parserContext) {
 }
 
 int get_current_token_line(ParserContext * parserContext) {
-    return peek(parserContext)->line;
+    return token_line(peek(parserContext));
 }
 
 int get_current_token_col(ParserContext * parserContext) {
-    return peek(parserContext)->col;
+    return token_col(peek(parserContext));
 }
 
 // void set_current_decl_name(ParserContext * parserContext, const char * name) {
@@ -336,7 +336,7 @@ ASTNode * create_for_statement_node(ASTNode * init_expr, ASTNode * cond_expr,
     node->for_stmt.cond_expr = cond_expr;
     node->for_stmt.update_expr = update_expr;
     node->for_stmt.body = body;
-    if (node->for_stmt.body != NULL) {
+    if (node->for_stmt.body != NULL && node->for_stmt.body->type == AST_BLOCK_STMT) {
         node->for_stmt.body->block.introduce_scope = false;
     }
     return node;
@@ -405,10 +405,11 @@ Declarator * make_declarator() {
     return declarator;
 }
 
-ASTNode * create_assert_extension_node(ASTNode * expr) {
+ASTNode * create_assert_extension_node(ASTNode * expr, int line) {
     ASTNode * node = create_ast();
     node->type = AST_ASSERT_EXTENSION_STATEMENT;
     node->expr_stmt.expr = expr;
+    node->expr_stmt.line = line;
     node->ctype = NULL;
     return node;
 }
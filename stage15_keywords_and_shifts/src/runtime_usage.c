@@ -0,0 +1,19 @@
+#include <stdbool.h>
+
+#include "runtime_usage.h"
+
+void runtime_usage_init(RuntimeUsage * usage, bool used) {
+    usage->mask_f32 = used;
+    usage->mask_f64 = used;
+    usage->print_int = used;
+    usage->print_long = used;
+    usage->print_double = used;
+    usage->print_string = used;
+    usage->assert_fail = used;
+}
+
+int runtime_usage_count(RuntimeUsage * usage) {
+    return usage->mask_f32 + usage->mask_f64 +
+        usage->print_int + usage->print_long + usage->print_double + usage->print_string +
+        usage->assert_fail;
+}
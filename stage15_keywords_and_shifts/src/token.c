@@ -14,106 +14,219 @@ void add_token(tokenlist * tokens, Token * token) {
     tokenlist_append(tokens, token);
 }
 
-Token * make_token(TokenType type, const char * text, int line, int col) {
-    Token * token = malloc(sizeof(Token));
+/* the source the tokens point into, and what belongs to it */
+#define TOKEN_BLOCK_SIZE 4096
+
+typedef struct TokenBlock {
+    struct TokenBlock * next;
+    int used;
+    Token tokens[TOKEN_BLOCK_SIZE];
+} TokenBlock;
+
+static const char * token_source = "";
+static TokenBlock * token_blocks = NULL;    // newest first
+static double * double_values = NULL;       // the literal table, see make_double_token
+static int double_count = 0;
+static int double_capacity = 0;
+static int * line_starts = NULL;            // built by the first token_line
+static int line_count = 0;
+
+void release_token_source() {
+    while (token_blocks) {
+        TokenBlock * next = token_blocks->next;
+        free(token_blocks);
+        token_blocks = next;
+    }
+    free(double_values);
+    double_values = NULL;
+    double_count = double_capacity = 0;
+    free(line_starts);
+    line_starts = NULL;
+    line_count = 0;
+    token_source = "";
+}
+
+void set_token_source(const char * text) {
+    release_token_source();
+    token_source = text;
+}
+
+const char * get_token_source() {
+    return token_source;
+}
+
+const char * token_start(const Token * token) {
+    return token_source + token->offset;
+}
+
+bool token_text_is(const Token * token, const char * text) {
+    return strncmp(token_start(token), text, token->length) == 0 && text[token->length] == '\0';
+}
+
+static char escaped_char(char c) {
+    switch (c) {
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 't': return '\t';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case '0': return '\0';
+        default: return c;      // \\, \' and \", the tokenizer rejects the rest
+    }
+}
+
+char * token_text(const Token * token) {
+    const char * start = token_start(token);
+    char * text = malloc(token->length + 1);
+    if (token->type != TOKEN_STRING_LITERAL) {
+        memcpy(text, start, token->length);
+        text[token->length] = '\0';
+        return text;
+    }
+    // without the quotes
+    int length = 0;
+    for (unsigned int i = 1; i + 1 < token->length; i++) {
+        text[length++] = start[i] == '\\' ? escaped_char(start[++i]) : start[i];
+    }
+    text[length] = '\0';
+    return text;
+}
+
+static void build_line_starts() {
+    int capacity = 1024;
+    line_starts = malloc(capacity * sizeof(int));
+    line_starts[line_count++] = 0;
+    for (const char * s = token_source; (s = strchr(s, '\n')) != NULL; s++) {
+        if (line_count == capacity) {
+            capacity *= 2;
+            line_starts = realloc(line_starts, capacity * sizeof(int));
+        }
+        line_starts[line_count++] = (int) (s - token_source) + 1;
+    }
+}
+
+/* the index of the line holding the token, counting from 0 */
+static int find_line(const Token * token) {
+    if (!line_starts) {
+        build_line_starts();
+    }
+    int low = 0;
+    int high = line_count - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (line_starts[middle] <= (int) token->offset) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+int token_line(const Token * token) {
+    return find_line(token) + 1;
+}
+
+int token_col(const Token * token) {
+    int line = find_line(token);
+    return (int) token->offset - line_starts[line] + 1;
+}
+
+int token_int_value(const Token * token) {
+    return (int) token->value;
+}
+
+float token_float_value(const Token * token) {
+    float value;
+    memcpy(&value, &token->value, sizeof(value));
+    return value;
+}
+
+double token_double_value(const Token * token) {
+    return double_values[token->value];
+}
+
+Token * make_token(TokenType type, int offset, int length) {
+    if (!token_blocks || token_blocks->used == TOKEN_BLOCK_SIZE) {
+        TokenBlock * block = malloc(sizeof(TokenBlock));
+        block->next = token_blocks;
+        block->used = 0;
+        token_blocks = block;
+    }
+    Token * token = &token_blocks->tokens[token_blocks->used++];
     token->type = type;
-    token->text = strdup(text);
-    token->length = strlen(text);
-    token->int_value = 0;
-    token->line = line;
-    token->col = col;
+    token->offset = offset;
+    token->length = length;
+    token->value = 0;
     return token;
 }
 
-Token * make_int_token(char * numberText, int line, int col) {
-    Token * token = malloc(sizeof(Token));
-    token->type = TOKEN_INT_LITERAL;
-    int numberTextLen = strlen(numberText);
-    char * numberTextCopy = malloc(numberTextLen + 1);
-    memcpy(numberTextCopy, numberText, numberTextLen);
-    numberTextCopy[numberTextLen] = '\0';
-    token->text = numberTextCopy;
-    token->length = numberTextLen;
-    token->int_value = atoi(numberText);
-    token->line = line;
-    token->col = col;
-    return token;
+/* numbers are converted from a terminated copy, so the conversion stops
+ * where the tokenizer did
+ */
+static const char * number_text(const Token * token, char * buffer, size_t size) {
+    size_t length = token->length < size - 1 ? token->length : size - 1;
+    memcpy(buffer, token_start(token), length);
+    buffer[length] = '\0';
+    return buffer;
 }
 
-Token * make_float_token(char * numberText, int line, int col) {
-    Token * token = malloc(sizeof(Token));
-    token->type = TOKEN_FLOAT_LITERAL;
-    int numberTextLen = strlen(numberText);
-    char * numberTextCopy = malloc(numberTextLen + 1);
-    memcpy(numberTextCopy, numberText, numberTextLen);
-    numberTextCopy[numberTextLen] = '\0';
-    token->text = numberTextCopy;
-    token->length = numberTextLen;
-    token->float_value = strtof(numberText, NULL);
-    token->line = line;
-    token->col = col;
+Token * make_int_token(int offset, int length) {
+    char buffer[64];
+    Token * token = make_token(TOKEN_INT_LITERAL, offset, length);
+    token->value = (unsigned int) atoi(number_text(token, buffer, sizeof(buffer)));
     return token;
 }
 
-Token * make_double_token(char * numberText, int line, int col) {
-    Token * token = malloc(sizeof(Token));
-    token->type = TOKEN_DOUBLE_LITERAL;
-    int numberTextLen = strlen(numberText);
-    char * numberTextCopy = malloc(numberTextLen + 1);
-    memcpy(numberTextCopy, numberText, numberTextLen);
-    numberTextCopy[numberTextLen] = '\0';
-    token->text = numberTextCopy;
-    token->length = numberTextLen;
-    token->double_value = strtof(numberText, NULL);
-    token->line = line;
-    token->col = col;
+Token * make_float_token(int offset, int length) {
+    char buffer[64];
+    Token * token = make_token(TOKEN_FLOAT_LITERAL, offset, length);
+    float value = strtof(number_text(token, buffer, sizeof(buffer)), NULL);
+    memcpy(&token->value, &value, sizeof(value));
     return token;
 }
 
-Token * make_identifier_token(const char * id, int line, int col) {
-    Token * token = malloc(sizeof(Token));
-    token->type = TOKEN_IDENTIFIER;
-    token->text = strdup(id);
-    token->length = strlen(id);
-    token->int_value = 0;
-    token->line = line;
-    token->col = col;
+/* a double does not fit in the token, so it keeps an index into the literal table */
+Token * make_double_token(int offset, int length) {
+    char buffer[64];
+    Token * token = make_token(TOKEN_DOUBLE_LITERAL, offset, length);
+    if (double_count == double_capacity) {
+        double_capacity = double_capacity ? double_capacity * 2 : 64;
+        double_values = realloc(double_values, double_capacity * sizeof(double));
+    }
+    double_values[double_count] = strtof(number_text(token, buffer, sizeof(buffer)), NULL);
+    token->value = double_count++;
     return token;
 }
 
-Token * make_eof_token(int line, int col) {
-    Token * eofToken = malloc(sizeof(Token));
-    eofToken->type = TOKEN_EOF;
-    eofToken->text = '\0';
-    eofToken->length = 0;
-    eofToken->line = line;
-    eofToken->col = col;
-    return eofToken;
-}
-
-Token * make_string_literal_token(char * buf, int line, int col) {
-    Token * token = malloc(sizeof(Token));
-    token->type = TOKEN_STRING_LITERAL;
-    token->text = strdup(buf);
-    token->length = strlen(buf);
-    token->int_value = 0;
-    token->line = line;
-    token->col = col;
-    return token;
+Token * make_identifier_token(int offset, int length) {
+    return make_token(TOKEN_IDENTIFIER, offset, length);
 }
 
-void cleanup_token_list(tokenlist * tokens) {
+Token * make_eof_token(int offset) {
+    return make_token(TOKEN_EOF, offset, 0);
+}
 
-    for (tokenlist_node * node = tokens->head; node; node = node->next) {
-        Token * token = node->value;
-        free((void*)token->text);
-        free(token);
+/* the span includes the quotes, and the escapes as written */
+Token * make_string_literal_token(int offset, int length) {
+    return make_token(TOKEN_STRING_LITERAL, offset, length);
+}
+
+/* the tokens themselves belong to the token source */
+void cleanup_token_list(tokenlist * tokens) {
+    tokenlist_node * node = tokens->head;
+    while (node) {
+        tokenlist_node * next = node->next;
+        free(node);
+        node = next;
     }
+    tokens->head = tokens->tail = NULL;
 }
 
 void free_token(Token * token) {
-    free(token->text);
-    free(token);
+    // released with the rest of its source, see release_token_source
+    (void) token;
 }
 
 const char * token_type_name(TokenType type) {
@@ -11,7 +11,7 @@
 #include "tokenizer_context.h"
 #include "util.h"
 #include "error.h"
-#include "string_builder.h"
+#include "lexer_scan.h"
 
 typedef struct {
     const char* text;
@@ -86,11 +86,11 @@ TokenMapEntry single_char_operator_map[] = {
     { NULL, 0 }
 };
 
-Token * match_keyword(TokenizerContext * ctx, const char * text) {
-
+Token * match_keyword(TokenizerContext * ctx, int start, int length) {
+    const char * text = ctx->text + start;
     for (int i=0;keyword_map[i].text != NULL; i++) {
-        if (strcmp(text, keyword_map[i].text) == 0) {
-            return make_token(keyword_map[i].type, keyword_map[i].text, ctx->line, ctx->col);
+        if (strncmp(text, keyword_map[i].text, length) == 0 && keyword_map[i].text[length] == '\0') {
+            return make_token(keyword_map[i].type, start, length);
         }
     }
     return NULL;
@@ -101,7 +101,7 @@ Token * match_two_char_operator(TokenizerContext *ctx, char first, char second)
     char op_str[3] = { first, second, '\0' };
     for (int i=0;two_char_operator_map[i].text != NULL; i++) {
         if (strcmp(op_str, two_char_operator_map[i].text) == 0) {
-            Token *tok = make_token(two_char_operator_map[i].type, two_char_operator_map[i].text, ctx->line, ctx->col);
+            Token *tok = make_token(two_char_operator_map[i].type, ctx->pos, 2);
             advance(ctx);
             advance(ctx);
             return tok;
@@ -114,7 +114,7 @@ Token * match_one_char_operator(TokenizerContext * ctx, char c) {
     char match_str[2] = { c, '\0' };
     for (int i=0;single_char_operator_map[i].text != NULL; i++) {
         if (strcmp(match_str, single_char_operator_map[i].text) == 0) {
-            Token *tok = make_token(single_char_operator_map[i].type, single_char_operator_map[i].text, ctx->line, ctx->col);
+            Token *tok = make_token(single_char_operator_map[i].type, ctx->pos, 1);
             advance(ctx);
             return tok;
         }
@@ -122,54 +122,44 @@ Token * match_one_char_operator(TokenizerContext * ctx, char c) {
     return NULL;
 }
 
-void add_eof_token(tokenlist * tokens, int line, int col) {
-    Token * eofToken = make_eof_token(line, col);
+void add_eof_token(tokenlist * tokens, int offset) {
+    Token * eofToken = make_eof_token(offset);
     add_token(tokens, eofToken);
 }
 
 void tokenize_number(TokenizerContext * ctx, tokenlist * tokens, bool leading_digit_present) {
 
-    String_Builder * string_builder = create_string_builder();
-
-//    char buffer[128];
-    //int i=0;
-    int line = ctx->line;
-    int col = ctx->col;
+    int start = ctx->pos;
     bool is_floating_point = false;
     bool is_double = false;
 
     // main number
     if (leading_digit_present) {
         while(isdigit(ctx->curr_char)) {
-            append_char(string_builder, ctx->curr_char);
-            //        buffer[i++] = ctx->curr_char;
             advance(ctx);
         }
     }
     // match dot for floating point
     if (ctx->curr_char == '.') {
-        append_char(string_builder, ctx->curr_char);
         advance(ctx);
         is_floating_point = true;
         while(isdigit(ctx->curr_char)) {
-            append_char(string_builder, ctx->curr_char);
             advance(ctx);
         }
     }
     // optional exponent
     if (ctx->curr_char == 'e' || ctx->curr_char == 'E') {
         is_floating_point = true;
-        append_char(string_builder, ctx->curr_char);
         advance(ctx);
         if (ctx->curr_char == '+' || ctx->curr_char == '-') {
-            append_char(string_builder, ctx->curr_char);
             advance(ctx);
             while(isdigit(ctx->curr_char)) {
-                append_char(string_builder, ctx->curr_char);
                 advance(ctx);
             }
         }
     }
+    // the suffix is not part of the number text
+    int length = ctx->pos - start;
 
     // suffix
     if (is_floating_point) {
@@ -181,49 +171,45 @@ void tokenize_number(TokenizerContext * ctx, tokenlist * tokens, bool leading_di
     }
 
     // build proper number token
-    //
-    char * num_str = build_string(string_builder);
-//    buffer[i++] = '\0';
     if (is_floating_point) {
         if (is_double) {
-            add_token(tokens, make_double_token(num_str, line, col));
+            add_token(tokens, make_double_token(start, length));
         } else {
-            add_token(tokens, make_float_token(num_str, line, col));
+            add_token(tokens, make_float_token(start, length));
         }
     } else {
-        add_token(tokens, make_int_token(num_str, line, col));
+        add_token(tokens, make_int_token(start, length));
     }
 
 }
 
-void add_identifier_token(tokenlist * tokens, const char * id, int line, int col) {
+void add_identifier_token(tokenlist * tokens, int start, int length) {
     
-    Token * token = make_identifier_token(id, line, col);
+    Token * token = make_identifier_token(start, length);
 
     add_token(tokens, token);
 }
 
 void swallow_comment(TokenizerContext * ctx) {
     if (ctx->curr_char == '/') {
+        const LexScanners * scan = get_lex_scanners();
         if (ctx->next_char == '/') {
-            advance(ctx);
-            advance(ctx);
-            while (ctx->curr_char != '\n' && ctx->curr_char != '\0') {
-                advance(ctx);    // skip to end of line
-            }
+            // skip to end of line
+            advance_to(ctx, scan->find_line_end(ctx->text, ctx->pos + 2));
         }
         else if (ctx->next_char == '*') {
-            advance(ctx);
-            advance(ctx);
-            while (!(ctx->curr_char == '*' && ctx->next_char == '/')) {
-                if (ctx->curr_char == '\0') {
-                    error("Unterminated block comment\n");
-                    exit(1);
-                }
-                advance(ctx);
+            // the comment ends at a '/' right after a '*' that is not the opening one
+            int body = ctx->pos + 2;
+            int slash = scan->find_slash(ctx->text, body);
+            while (ctx->text[slash] && !(slash > body && ctx->text[slash - 1] == '*')) {
+                slash = scan->find_slash(ctx->text, slash + 1);
             }
-            advance(ctx);
-            advance(ctx);
+            if (ctx->text[slash] == '\0') {
+                advance_to(ctx, slash);
+                error("Unterminated block comment\n");
+                exit(1);
+            }
+            advance_to(ctx, slash + 1);
         }
     }
 }
@@ -240,61 +226,33 @@ tokenlist * tokenize(const char * text) {
     while(ctx->curr_char) {
         swallow_comment(ctx);
         if (isspace(ctx->curr_char)) {
-            advance(ctx);
+            advance_to(ctx, get_lex_scanners()->skip_whitespace(ctx->text, ctx->pos));
         }
         else if (isalpha(ctx->curr_char) || ctx->curr_char == '_') {
-            char buffer[128];
-            int i=0;
-            int line = ctx->line;
-            int col = ctx->col;
-            while(isalnum(ctx->curr_char) || ctx->curr_char == '_') {
-                  buffer[i++] = ctx->curr_char;
-                  advance(ctx);
-            }
-            buffer[i] = '\0';
+            int start = ctx->pos;
+            advance_to(ctx, get_lex_scanners()->skip_identifier(ctx->text, ctx->pos));
+            int length = ctx->pos - start;
 
-            if ((matched_tok = match_keyword(ctx, buffer)) != NULL) {
-                matched_tok->line = line;
-                matched_tok->col = col;
+            if ((matched_tok = match_keyword(ctx, start, length)) != NULL) {
                 add_token(tokens, matched_tok);
             } else {
-                add_identifier_token(tokens, buffer, line, col);
+                add_identifier_token(tokens, start, length);
             }
 
         }
         else if (ctx->curr_char == '"') {
-            char buffer[1024];
-            buffer[0] = '\0';
-            int buf_pos = 0;
-            int line = ctx->line;
-            int col = ctx->col;
+            int start = ctx->pos;
             advance(ctx);
-            while(ctx->curr_char && ctx->curr_char != '"') {
-                if (ctx->curr_char == '\\') {
-                    advance(ctx);
-                    switch (ctx->curr_char) {
-                        case 'n': buffer[buf_pos++] = '\n'; break;
-                        case 'r': buffer[buf_pos++] = '\r'; break;
-                        case 't': buffer[buf_pos++] = '\t'; break;
-                        case 'b': buffer[buf_pos++] = '\b'; break;
-                        case 'f': buffer[buf_pos++] = '\f'; break;
-                        case 'v': buffer[buf_pos++] = '\v'; break;
-                        case '0': buffer[buf_pos++] = '\0'; break;
-                        case '\\': buffer[buf_pos++] = '\\'; break;
-                        case '\'': buffer[buf_pos++] = '\''; break;
-                        case '\"': buffer[buf_pos++] = '\"'; break;
-                        default: error("Unknown escape sequence");
-                    }
-                    advance(ctx);
-                }
-                else {
-                    buffer[buf_pos++] = ctx->curr_char;
-                    advance(ctx);
+            while(advance_to(ctx, get_lex_scanners()->find_string_stop(ctx->text, ctx->pos)) == '\\') {
+                // token_text resolves the escape when the literal is used
+                advance(ctx);
+                if (!ctx->curr_char || !strchr("nrtbfv0\\'\"", ctx->curr_char)) {
+                    error("Unknown escape sequence");
                 }
+                advance(ctx);
             }
             advance(ctx);
-            buffer[buf_pos] = '\0';
-            add_token(tokens, make_string_literal_token(buffer, line, col));
+            add_token(tokens, make_string_literal_token(start, ctx->pos - start));
 
         }
         else if (isdigit(ctx->curr_char)) {
@@ -314,7 +272,7 @@ tokenlist * tokenize(const char * text) {
         }
     }
 
-    add_eof_token(tokens, ctx->line, ctx->col);
+    add_eof_token(tokens, ctx->pos);
     free_tokenizer_context(ctx);
     return tokens;
 }
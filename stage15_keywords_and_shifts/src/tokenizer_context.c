@@ -10,6 +10,7 @@
 TokenizerContext * init_tokenizer_context(const char * text) {
     TokenizerContext * context = malloc(sizeof(TokenizerContext));
     context->text = text;
+    set_token_source(text);
     context->text_len = strlen(text);
     context->pos = 0;
     context->line = 1;
@@ -45,6 +46,28 @@ char advance(TokenizerContext * context) {
     return context->curr_char;
 }
 
+/* jumps over a run the lexer scanners found, keeping line and col as
+ * advance would have
+ */
+char advance_to(TokenizerContext * context, int pos) {
+    const char * start = context->text + context->pos;
+    const char * end = context->text + pos;
+    const char * line_start = NULL;
+    for (const char * s = start; (s = memchr(s, '\n', end - s)) != NULL; s++) {
+        context->line++;
+        line_start = s + 1;
+    }
+    if (line_start) {
+        context->col = (int) (end - line_start) + 1;
+    } else {
+        context->col += pos - context->pos;
+    }
+    context->pos = pos;
+    context->curr_char = context->text[pos];
+    context->next_char = context->curr_char ? context->text[pos + 1] : '\0';
+    return context->curr_char;
+}
+
 // TokenList * get_tokens(TokenizerContext * context) {
 //     TokenList * tokenList = malloc(sizeof(TokenList));
 
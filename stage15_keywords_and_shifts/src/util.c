@@ -5,6 +5,9 @@
 #include <stdbool.h>
 #include <stdarg.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "util.h"
 #include "token.h"
@@ -42,6 +45,50 @@ char * read_text_file(const char* filename) {
 
 }
 
+/* the tokenizer stops at a '\0', which the zero fill after the end of the
+ * file provides. a file that ends exactly on a page boundary has no fill,
+ * so it is read into memory like an empty one.
+ */
+SourceText map_text_file(const char * filename) {
+    SourceText source = { NULL, 0, false };
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        exit(1);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0) {
+        perror("fstat");
+        exit(1);
+    }
+    source.length = file_stat.st_size;
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (source.length > 0 && source.length % page_size != 0) {
+        void * mapping = mmap(NULL, source.length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            close(fd);
+            source.text = mapping;
+            source.mapped = true;
+            return source;
+        }
+    }
+    close(fd);
+
+    source.text = read_text_file(filename);
+    source.length = strlen(source.text);
+    return source;
+}
+
+void release_text_file(SourceText * source) {
+    if (source->mapped) {
+        munmap((void *) source->text, source->length);
+    } else {
+        free((void *) source->text);
+    }
+    source->text = NULL;
+}
+
 // Writes `content` to a safe temp file and returns a malloc'd filename
 char *write_temp_file(const char *content) {
     char template[] = "/tmp/tmp_test_file_XXXXXX";
@@ -0,0 +1,223 @@
+#include <stdbool.h>
+
+#include "ast.h"
+#include "c_type.h"
+#include "symbol.h"
+#include "compiler_options.h"
+#include "vectorize.h"
+
+static bool is_var_ref_of(ASTNode * node, Symbol * symbol) {
+    return node->type == AST_VAR_REF_EXPR && node->symbol == symbol;
+}
+
+static bool is_scalar_var_ref(ASTNode * node, CTypeKind kind) {
+    return node->type == AST_VAR_REF_EXPR && node->symbol && node->ctype->kind == kind;
+}
+
+/* float and double literals do not always agree with declared types on
+ * signedness, which means nothing for them
+ */
+static bool is_element_type(CType * ctype, VectorLoop * loop) {
+    if (is_floating_point_type(loop->element_type)) return ctype->kind == loop->element_type->kind;
+    return ctype_equals(ctype, loop->element_type);
+}
+
+/* i++, ++i, i += 1, i = i + 1 or i = 1 + i */
+static bool is_unit_step(ASTNode * update, Symbol * iv) {
+    if (update->type == AST_UNARY_EXPR) {
+        return (update->unary.op == UNARY_POST_INC || update->unary.op == UNARY_PRE_INC) &&
+               is_var_ref_of(update->unary.operand, iv);
+    }
+    if (update->type != AST_BINARY_EXPR || !is_var_ref_of(update->binary.lhs, iv)) return false;
+    ASTNode * rhs = update->binary.rhs;
+    if (update->binary.op == BINOP_COMPOUND_ADD_ASSIGN) {
+        return rhs->type == AST_INT_LITERAL && rhs->int_value == 1;
+    }
+    if (update->binary.op != BINOP_ASSIGNMENT || rhs->type != AST_BINARY_EXPR || rhs->binary.op != BINOP_ADD) {
+        return false;
+    }
+    ASTNode * a = rhs->binary.lhs;
+    ASTNode * b = rhs->binary.rhs;
+    return (is_var_ref_of(a, iv) && b->type == AST_INT_LITERAL && b->int_value == 1) ||
+           (is_var_ref_of(b, iv) && a->type == AST_INT_LITERAL && a->int_value == 1);
+}
+
+/* a[i] on a named array of the element type. parameters are pointers that
+ * may overlap, so they are left to the scalar loop.
+ */
+static bool is_element_access(ASTNode * node, VectorLoop * loop) {
+    if (node->type != AST_ARRAY_ACCESS || !is_element_type(node->ctype, loop)) return false;
+    ASTNode * base = node->array_access.base;
+    return base->type == AST_VAR_REF_EXPR && base->symbol &&
+           base->ctype->kind == CTYPE_ARRAY && base->symbol->storage != STORAGE_PARAMETER &&
+           is_var_ref_of(node->array_access.index, loop->iv->symbol);
+}
+
+/* computed once in front of the vector loop, so it may not read anything
+ * the loop stores and may not trap
+ */
+static bool is_invariant_scalar(ASTNode * node, VectorLoop * loop) {
+    switch (node->type) {
+        case AST_INT_LITERAL:
+        case AST_FLOAT_LITERAL:
+        case AST_DOUBLE_LITERAL:
+            return true;
+        case AST_VAR_REF_EXPR:
+            return node->symbol && is_scalar_type(node->ctype) &&
+                   node->symbol != loop->iv->symbol &&
+                   !(loop->kind == VECTOR_REDUCTION && node->symbol == loop->target->symbol);
+        case AST_CAST_EXPR:
+            return is_scalar_type(node->ctype) && !is_pointer_type(node->ctype) &&
+                   is_invariant_scalar(node->cast_expr.expr, loop);
+        case AST_UNARY_EXPR:
+            return (node->unary.op == UNARY_NEGATE || node->unary.op == UNARY_PLUS) &&
+                   is_invariant_scalar(node->unary.operand, loop);
+        case AST_BINARY_EXPR:
+            return (node->binary.op == BINOP_ADD || node->binary.op == BINOP_SUB || node->binary.op == BINOP_MUL) &&
+                   !is_pointer_type(node->ctype) &&
+                   is_invariant_scalar(node->binary.lhs, loop) && is_invariant_scalar(node->binary.rhs, loop);
+        default:
+            return false;
+    }
+}
+
+static bool is_operand(ASTNode * node, VectorLoop * loop) {
+    if (is_element_access(node, loop)) return true;
+    return is_element_type(node->ctype, loop) && is_invariant_scalar(node, loop);
+}
+
+/* packed SSE2 forms exist for these. there is no packed 32 bit multiply
+ * before SSE4.1, and no packed division of integers at all.
+ */
+static bool has_packed_form(BinaryOperator op, CType * element_type) {
+    switch (op) {
+        case BINOP_ADD:
+        case BINOP_SUB:
+            return true;
+        case BINOP_MUL:
+        case BINOP_DIV:
+            return is_floating_point_type(element_type);
+        case BINOP_BITWISE_AND:
+        case BINOP_BITWISE_OR:
+        case BINOP_BITWISE_XOR:
+            return !is_floating_point_type(element_type);
+        default:
+            return false;
+    }
+}
+
+/* s = s + x, s = x + s or s += x, where x is a[i] or a[i] * b[i] */
+static bool match_reduction(ASTNode * expr, VectorLoop * loop) {
+    ASTNode * acc = expr->binary.lhs;
+    if (!is_scalar_var_ref(acc, loop->element_type->kind) || !is_element_type(acc->ctype, loop) ||
+        acc->symbol == loop->iv->symbol) return false;
+    if (loop->bound->type == AST_VAR_REF_EXPR && loop->bound->symbol == acc->symbol) return false;
+
+    ASTNode * term = NULL;
+    if (expr->binary.op == BINOP_COMPOUND_ADD_ASSIGN) {
+        term = expr->binary.rhs;
+    } else if (expr->binary.op == BINOP_ASSIGNMENT && expr->binary.rhs->type == AST_BINARY_EXPR &&
+               expr->binary.rhs->binary.op == BINOP_ADD) {
+        ASTNode * sum = expr->binary.rhs;
+        if (is_var_ref_of(sum->binary.lhs, acc->symbol)) {
+            term = sum->binary.rhs;
+        } else if (is_var_ref_of(sum->binary.rhs, acc->symbol)) {
+            term = sum->binary.lhs;
+        }
+    }
+    if (!term) return false;
+
+    loop->kind = VECTOR_REDUCTION;
+    loop->target = acc;
+    if (is_element_access(term, loop)) {
+        loop->op = BINOP_UNASSIGNED_OP;
+        loop->lhs = term;
+        loop->rhs = NULL;
+    } else if (term->type == AST_BINARY_EXPR && term->binary.op == BINOP_MUL &&
+               is_floating_point_type(loop->element_type) &&
+               is_element_access(term->binary.lhs, loop) && is_element_access(term->binary.rhs, loop)) {
+        loop->op = BINOP_MUL;
+        loop->lhs = term->binary.lhs;
+        loop->rhs = term->binary.rhs;
+    } else {
+        return false;
+    }
+    return !is_floating_point_type(loop->element_type) || get_compiler_options()->fast_math;
+}
+
+/* c[i] = x, c[i] = x op y, c[i] += y or c[i] -= y */
+static bool match_elementwise(ASTNode * expr, VectorLoop * loop) {
+    ASTNode * dest = expr->binary.lhs;
+    ASTNode * value = expr->binary.rhs;
+    if (!is_element_access(dest, loop)) return false;
+
+    loop->kind = VECTOR_ELEMENTWISE;
+    loop->target = dest->array_access.base;
+    if (expr->binary.op == BINOP_COMPOUND_ADD_ASSIGN || expr->binary.op == BINOP_COMPOUND_SUB_ASSIGN) {
+        loop->op = expr->binary.op == BINOP_COMPOUND_ADD_ASSIGN ? BINOP_ADD : BINOP_SUB;
+        loop->lhs = dest;
+        loop->rhs = value;
+        return is_operand(value, loop);
+    }
+    if (expr->binary.op != BINOP_ASSIGNMENT) return false;
+
+    if (value->type == AST_BINARY_EXPR && has_packed_form(value->binary.op, loop->element_type) &&
+        is_element_type(value->ctype, loop) &&
+        is_operand(value->binary.lhs, loop) && is_operand(value->binary.rhs, loop)) {
+        loop->op = value->binary.op;
+        loop->lhs = value->binary.lhs;
+        loop->rhs = value->binary.rhs;
+        return true;
+    }
+    loop->op = BINOP_UNASSIGNED_OP;
+    loop->lhs = value;
+    loop->rhs = NULL;
+    return is_operand(value, loop);
+}
+
+static CType * element_type_of(ASTNode * expr) {
+    ASTNode * lhs = expr->binary.lhs;
+    CType * ctype = lhs->ctype;
+    if (ctype->kind != CTYPE_INT && ctype->kind != CTYPE_FLOAT && ctype->kind != CTYPE_DOUBLE) return NULL;
+    return ctype;
+}
+
+bool match_vector_loop(ASTNode * for_stmt, VectorLoop * loop) {
+    CompilerOptions * options = get_compiler_options();
+    if (!optimizations_enabled() || !options->vectorize || for_stmt->type != AST_FOR_STMT) return false;
+
+    // for (...; i < n; i++) with an int i
+    ASTNode * cond = for_stmt->for_stmt.cond_expr;
+    ASTNode * update = for_stmt->for_stmt.update_expr;
+    if (!cond || !update || cond->type != AST_BINARY_EXPR) return false;
+    if (cond->binary.op != BINOP_LT && cond->binary.op != BINOP_LE) return false;
+    ASTNode * iv = cond->binary.lhs;
+    ASTNode * bound = cond->binary.rhs;
+    if (!is_scalar_var_ref(iv, CTYPE_INT) || !is_unit_step(update, iv->symbol)) return false;
+    if (bound->type != AST_INT_LITERAL &&
+        !(is_scalar_var_ref(bound, CTYPE_INT) && bound->symbol != iv->symbol)) return false;
+
+    // the body is a single assignment
+    ASTNode * body = for_stmt->for_stmt.body;
+    if (body->type == AST_BLOCK_STMT) {
+        if (body->block.statements->count != 1) return false;
+        body = body->block.statements->head->value;
+    }
+    if (body->type != AST_EXPRESSION_STMT || body->expr_stmt.expr->type != AST_BINARY_EXPR) return false;
+    ASTNode * expr = body->expr_stmt.expr;
+
+    loop->element_type = element_type_of(expr);
+    if (!loop->element_type) return false;
+    loop->iv = iv;
+    loop->bound = bound;
+    loop->inclusive = cond->binary.op == BINOP_LE;
+
+    if (expr->binary.lhs->type == AST_ARRAY_ACCESS) {
+        return match_elementwise(expr, loop);
+    }
+    return match_reduction(expr, loop);
+}
+
+bool is_vector_array_operand(ASTNode * operand) {
+    return operand && operand->type == AST_ARRAY_ACCESS;
+}
@@ -16,9 +16,49 @@ VReg make_vreg(RegClass regClass, CType* ctype) {
     v.regClass = regClass;
     v.phys = -1;
     v.spill_off = false;
+    // nothing is known beyond the value's own width, except that a long fills the register
+    v.width = ctype ? width_for_size(ctype->size) : W64;
+    v.zeroKind = v.width == W64 ? ZK_FULL64 : ZK_UNKNOWN;
     return v;
 }
 
+Width width_for_size(int size) {
+    switch (size) {
+        case 1: return W8;
+        case 2: return W16;
+        case 4: return W32;
+        default: return W64;
+    }
+}
+
+int width_bits(Width width) {
+    switch (width) {
+        case W8: return 8;
+        case W16: return 16;
+        case W32: return 32;
+        default: return 64;
+    }
+}
+
+PhysGpr callee_saved_gpr(int index) {
+    static const PhysGpr order[CALLEE_SAVED_GPR_COUNT] = { PR_RBX, PR_R12, PR_R13, PR_R14, PR_R15 };
+    return order[index];
+}
+
+const char * phys_gpr_name(PhysGpr reg, int size) {
+    static const char * names[PR_NONE][4] = {
+        { "al", "ax", "eax", "rax" },
+        { "cl", "cx", "ecx", "rcx" },
+        { "dl", "dx", "edx", "rdx" },
+        { "bl", "bx", "ebx", "rbx" },
+        { "r12b", "r12w", "r12d", "r12" },
+        { "r13b", "r13w", "r13d", "r13" },
+        { "r14b", "r14w", "r14d", "r14" },
+        { "r15b", "r15w", "r15d", "r15" },
+    };
+    return names[reg][width_for_size(size)];
+}
+
 VReg make_rax_vreg() {
     VReg v = make_vreg(RC_GPR, make_long_type(true));
     v.phys = PR_RAX;
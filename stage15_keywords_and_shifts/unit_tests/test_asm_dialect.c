@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include "test_assert.h"
+
+#include "asm_dialect.h"
+
+const char * current_test = NULL;
+
+/* the GAS form of one NASM line, which the caller frees */
+static char * gas_line(const char * line) {
+    char * buffer = NULL;
+    size_t buffer_size = 0;
+    AsmWriter * writer = asm_writer_from_fp(open_memstream(&buffer, &buffer_size));
+    writer->echo = false;
+    write_gas_line(writer, line);
+    asm_writer_close(writer);
+    return buffer;
+}
+
+static int matches(const char * line, const char * expected) {
+    char * output = gas_line(line);
+    int same = strcmp(output, expected) == 0;
+    if (!same) {
+        printf("\n  got: %s", output);
+    }
+    free(output);
+    return same;
+}
+
+void test_instructions_pass_through() {
+    TEST_ASSERT("Verify registers and immediates are unchanged",
+                matches("imul rcx, rdx, 100", "imul rcx, rdx, 100\n"));
+    TEST_ASSERT("Verify rep prefix is unchanged", matches("rep stosq", "rep stosq\n"));
+    TEST_ASSERT("Verify hex immediates are not symbols", matches("pshufd xmm1, xmm0, 0x4e", "pshufd xmm1, xmm0, 0x4e\n"));
+}
+
+void test_memory_operands() {
+    TEST_ASSERT("Verify sizes get PTR", matches("add eax, DWORD [rbp-4]", "add eax, DWORD PTR [rbp-4]\n"));
+    TEST_ASSERT("Verify lower case sizes get PTR", matches("movsx eax, byte [rcx]", "movsx eax, BYTE PTR [rcx]\n"));
+    TEST_ASSERT("Verify rel becomes rip", matches("ucomisd xmm0, QWORD [rel Dbl4]", "ucomisd xmm0, QWORD PTR [rip + Dbl4]\n"));
+    TEST_ASSERT("Verify rel keeps offsets", matches("lea rdi, [rel Str4+6]", "lea rdi, [rip + Str4+6]\n"));
+}
+
+void test_directives() {
+    TEST_ASSERT("Verify section", matches("section .rodata", ".section .rodata\n"));
+    TEST_ASSERT("Verify text section", matches("section .text", ".text\n"));
+    TEST_ASSERT("Verify cold section is executable",
+                matches("section .text.cold progbits alloc exec nowrite align=16", ".section .text.cold,\"ax\",@progbits\n"));
+    TEST_ASSERT("Verify global", matches("global main", ".globl main\n"));
+    TEST_ASSERT("Verify align", matches("align 16", ".balign 16\n"));
+}
+
+void test_data() {
+    TEST_ASSERT("Verify strings and bytes", matches("Str0: db \"a\\\\b\", 10, 0", "Str0: .ascii \"a\\\\\\\\b\"; .byte 10, 0\n"));
+    TEST_ASSERT("Verify doubles", matches("a: dq 42.000000", "a: .double 42.000000\n"));
+    TEST_ASSERT("Verify hex doubles stay integers", matches("Dbl3: dq 0x4004000000000000", "Dbl3: .quad 0x4004000000000000\n"));
+    TEST_ASSERT("Verify reservations", matches("g: resd 10", "g: .zero (10) * 4\n"));
+    TEST_ASSERT("Verify repeated quads", matches("mask_f64: times 2 dq 0x8000000000000000",
+                                                  "mask_f64: .rept 2\n.quad 0x8000000000000000\n.endr\n"));
+}
+
+void test_names_and_comments() {
+    TEST_ASSERT("Verify operator names are prefixed", matches("call mod", "call __mod\n"));
+    TEST_ASSERT("Verify operator labels are prefixed", matches("eq: dd 5", "__eq: .long 5\n"));
+    TEST_ASSERT("Verify instructions named like operators are kept", matches("and edx, -2", "and edx, -2\n"));
+    TEST_ASSERT("Verify comments", matches("push rbp    ; stack += 8", "push rbp    # stack += 8\n"));
+    TEST_ASSERT("Verify GAS lines are kept", matches(".intel_syntax noprefix", ".intel_syntax noprefix\n"));
+}
+
+int main() {
+    RUN_TEST(test_instructions_pass_through);
+    RUN_TEST(test_memory_operands);
+    RUN_TEST(test_directives);
+    RUN_TEST(test_data);
+    RUN_TEST(test_names_and_comments);
+}
@@ -46,8 +46,6 @@
         fflush(stdout); \
         if ((expected) != (actual)) { \
             printf(COLOR_RED "FAILED\n" COLOR_RESET); \
-            printf("  Expected:", expected); \
-            printf("  Actual: ", actual); \
             fprintf(stderr, "    Expected: %d\n    Actual:   %d\n", (expected), (actual)); \
             exit(1); \
         } else { \
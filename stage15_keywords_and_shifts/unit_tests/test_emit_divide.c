@@ -0,0 +1,328 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_assert.h"
+#include "ast.h"
+#include "c_type.h"
+#include "emit_divide.h"
+#include "emitter_context.h"
+#include "emitter_helpers.h"
+#include "compiler_options.h"
+
+const char * current_test = NULL;
+
+static uint64_t random_state = 0x9e3779b97f4a7c15;
+
+static uint64_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+/* just enough of x86-64 to run what the divide emits: mov, add, sub, and,
+ * xor, sar, shr, neg, both forms of imul and the final push of rax. a 32
+ * bit write clears the top half of the register as the hardware does, and
+ * c and d start out as garbage so a read before a write shows up
+ */
+typedef enum {
+    OP_MOV, OP_ADD, OP_SUB, OP_AND, OP_XOR, OP_SAR, OP_SHR, OP_NEG, OP_IMUL, OP_PUSH
+} Opcode;
+
+typedef struct Instruction {
+    Opcode op;
+    int bits;
+    int dst;
+    int operands;       // after the destination
+    int src;            // register, or -1 for the immediate
+    uint64_t imm;
+    uint64_t factor;    // the immediate of three operand imul
+} Instruction;
+
+#define MAX_DIVIDE_LINES 32
+
+/* the instructions emitted for one divisor, without the load of the
+ * dividend on the first line
+ */
+typedef struct EmittedDivide {
+    char lines[MAX_DIVIDE_LINES][64];
+    Instruction code[MAX_DIVIDE_LINES];
+    int count;
+} EmittedDivide;
+
+static int register_index(const char * name, int * bits) {
+    static const char * names[2][3] = { { "eax", "ecx", "edx" }, { "rax", "rcx", "rdx" } };
+    for (int wide = 0; wide < 2; wide++) {
+        for (int i = 0; i < 3; i++) {
+            if (strcmp(name, names[wide][i]) == 0) {
+                *bits = wide ? 64 : 32;
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+/* a register of the same width as the destination, or an immediate */
+static bool decode_operand(const char * text, int bits, int * reg, uint64_t * imm) {
+    int source_bits;
+    *reg = register_index(text, &source_bits);
+    if (*reg >= 0) return source_bits == bits;
+    char * end;
+    *imm = (uint64_t) strtoll(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+static bool decode_line(const char * line, Instruction * in) {
+    static const char * names[] = { "mov", "add", "sub", "and", "xor", "sar", "shr", "neg", "imul", "push" };
+    char op[16], args[3][24];
+    in->src = -1;
+    in->operands = sscanf(line, "%15s %23[^,], %23[^,], %23s", op, args[0], args[1], args[2]) - 2;
+    if (in->operands < 0) return false;
+
+    int op_count = sizeof(names) / sizeof(names[0]);
+    for (in->op = 0; (int) in->op < op_count && strcmp(op, names[in->op]) != 0; in->op++);
+    if ((int) in->op == op_count) return false;
+    in->dst = register_index(args[0], &in->bits);
+    if (in->dst < 0) return false;
+
+    switch (in->operands) {
+        case 0:
+            if (in->op == OP_PUSH) return in->dst == 0 && in->bits == 64;
+            return in->op == OP_NEG || in->op == OP_IMUL;
+        case 1:
+            return in->op < OP_NEG && decode_operand(args[1], in->bits, &in->src, &in->imm);
+        case 2:
+            if (in->op != OP_IMUL || !decode_operand(args[1], in->bits, &in->src, &in->imm)) return false;
+            int factor_reg;
+            return decode_operand(args[2], in->bits, &factor_reg, &in->factor) && factor_reg < 0;
+        default:
+            return false;
+    }
+}
+
+static ASTNode * make_literal(long value, CType * ctype) {
+    ASTNode * node = create_ast();
+    node->type = AST_INT_LITERAL;
+    node->int_value = value;
+    node->ctype = ctype;
+    return node;
+}
+
+/* emits 0 op divisor and decodes the lines after the load of the 0, so
+ * they can be run on any dividend
+ */
+static bool emit_divide(long divisor, bool is_long, BinaryOperator op, EmittedDivide * out) {
+    CType * ctype = is_long ? &CTYPE_LONG_T : &CTYPE_INT_T;
+    ASTNode * node = create_ast();
+    node->type = AST_BINARY_EXPR;
+    node->binary.op = op;
+    node->binary.lhs = make_literal(0, ctype);
+    node->binary.rhs = make_literal(divisor, ctype);
+    node->ctype = ctype;
+
+    char * buffer = NULL;
+    size_t buffer_size = 0;
+    FILE * mem_file = open_memstream(&buffer, &buffer_size);
+    EmitterContext * emitter_context = create_emitter_context_from_fp(mem_file);
+    bool ok = emit_int_divide_by_constant(emitter_context, node, WANT_VALUE);
+    emitter_finalize(emitter_context);
+
+    char * output = malloc(strlen(buffer) + 1);
+    strip_comments(buffer, output);
+    free(buffer);
+
+    out->count = 0;
+    bool loaded = false;
+    for (char * line = strtok(output, "\n"); ok && line; line = strtok(NULL, "\n")) {
+        while (*line == ' ' || *line == '\t') line++;
+        size_t length = strlen(line);
+        while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t')) line[--length] = '\0';
+        if (length == 0) continue;
+        if (!loaded) {
+            ok = loaded = strcmp(line, is_long ? "mov rax, 0" : "mov eax, 0") == 0;
+            continue;
+        }
+        ok = out->count < MAX_DIVIDE_LINES && decode_line(line, &out->code[out->count]);
+        if (!ok) break;
+        snprintf(out->lines[out->count++], sizeof(out->lines[0]), "%s", line);
+    }
+    free(output);
+    return ok && loaded && out->count > 0 && out->code[out->count - 1].op == OP_PUSH;
+}
+
+static uint64_t read_reg(const uint64_t * regs, int reg, int bits) {
+    return bits == 32 ? regs[reg] & 0xffffffff : regs[reg];
+}
+
+static void write_reg(uint64_t * regs, int reg, int bits, uint64_t value) {
+    regs[reg] = bits == 32 ? value & 0xffffffff : value;
+}
+
+static int64_t as_signed(uint64_t value, int bits) {
+    return bits == 32 ? (int32_t) (uint32_t) value : (int64_t) value;
+}
+
+/* runs the emitted instructions with x in a and returns what gets pushed */
+static int64_t run_divide(const EmittedDivide * emitted, int64_t x) {
+    uint64_t regs[3] = { (uint64_t) x, 0x5bd1e9955bd1e995, 0xc2b2ae3dc2b2ae3d };
+    for (int i = 0; i < emitted->count; i++) {
+        const Instruction * in = &emitted->code[i];
+        int bits = in->bits;
+        uint64_t lhs = read_reg(regs, in->dst, bits);
+        uint64_t rhs = in->src >= 0 ? read_reg(regs, in->src, bits) : in->imm;
+        uint64_t value;
+        switch (in->op) {
+            case OP_PUSH:
+                return (int64_t) regs[0];
+            case OP_NEG:
+                value = -lhs;
+                break;
+            case OP_IMUL:
+                if (in->operands == 2) {
+                    value = rhs * in->factor;
+                    break;
+                }
+                // d:a = a * dst, both signed
+                if (bits == 32) {
+                    uint64_t product = (uint64_t) (as_signed(read_reg(regs, 0, 32), 32) * as_signed(lhs, 32));
+                    write_reg(regs, 0, 32, product);
+                    write_reg(regs, 2, 32, product >> 32);
+                } else {
+                    unsigned __int128 product = (unsigned __int128) ((__int128) (int64_t) regs[0] * (int64_t) lhs);
+                    write_reg(regs, 0, 64, (uint64_t) product);
+                    write_reg(regs, 2, 64, (uint64_t) (product >> 64));
+                }
+                continue;
+            case OP_MOV: value = rhs; break;
+            case OP_ADD: value = lhs + rhs; break;
+            case OP_SUB: value = lhs - rhs; break;
+            case OP_AND: value = lhs & rhs; break;
+            case OP_XOR: value = lhs ^ rhs; break;
+            case OP_SAR: value = (uint64_t) (as_signed(lhs, bits) >> (rhs & (bits - 1))); break;
+            case OP_SHR: value = lhs >> (rhs & (bits - 1)); break;
+        }
+        write_reg(regs, in->dst, bits, value);
+    }
+    return 0;
+}
+
+static bool check_int_divisor(int32_t divisor) {
+    EmittedDivide quotient, remainder;
+    if (!emit_divide(divisor, false, BINOP_DIV, &quotient) || !emit_divide(divisor, false, BINOP_MOD, &remainder)) {
+        return false;
+    }
+    int32_t edges[] = { 0, 1, -1, 2, -2, INT32_MAX, INT32_MIN + 1, INT32_MAX - 1,
+                        divisor, (int32_t) ((uint32_t) divisor - 1), (int32_t) ((uint32_t) divisor + 1),
+                        (int32_t) (0u - (uint32_t) divisor) };
+    int edge_count = sizeof(edges) / sizeof(edges[0]);
+    for (int i = 0; i < edge_count + 500; i++) {
+        int32_t x = i < edge_count ? edges[i] : (int32_t) next_random();
+        if (i >= edge_count && (i & 1)) x >>= (i % 31);
+        // INT32_MIN / -1 traps in idiv as well
+        if (x == INT32_MIN && divisor == -1) continue;
+        if ((int32_t) run_divide(&quotient, x) != x / divisor) return false;
+        if ((int32_t) run_divide(&remainder, x) != x % divisor) return false;
+    }
+    return true;
+}
+
+static bool check_long_divisor(int64_t divisor) {
+    EmittedDivide quotient, remainder;
+    if (!emit_divide(divisor, true, BINOP_DIV, &quotient) || !emit_divide(divisor, true, BINOP_MOD, &remainder)) {
+        return false;
+    }
+    int64_t edges[] = { 0, 1, -1, INT64_MAX, INT64_MIN + 1, INT32_MAX, INT32_MIN,
+                        divisor, divisor - 1, divisor + 1, -divisor };
+    int edge_count = sizeof(edges) / sizeof(edges[0]);
+    for (int i = 0; i < edge_count + 500; i++) {
+        int64_t x = i < edge_count ? edges[i] : (int64_t) next_random();
+        if (i >= edge_count && (i & 1)) x >>= (i % 63);
+        if (run_divide(&quotient, x) != x / divisor) return false;
+        if (run_divide(&remainder, x) != x % divisor) return false;
+    }
+    return true;
+}
+
+void test_known_magic_numbers() {
+    DivisionMagic seven = signed_division_magic(7, 32);
+    TEST_ASSERT("Verify int multiplier for 7", seven.multiplier == 0x92492493);
+    TEST_ASSERT_EQ_INT("Verify int shift for 7", 2, seven.shift);
+
+    DivisionMagic three = signed_division_magic(3, 32);
+    TEST_ASSERT("Verify int multiplier for 3", three.multiplier == 0x55555556);
+    TEST_ASSERT_EQ_INT("Verify int shift for 3", 0, three.shift);
+
+    DivisionMagic ten = signed_division_magic(10, 32);
+    TEST_ASSERT("Verify int multiplier for 10", ten.multiplier == 0x66666667);
+    TEST_ASSERT_EQ_INT("Verify int shift for 10", 2, ten.shift);
+
+    DivisionMagic long_seven = signed_division_magic(7, 64);
+    TEST_ASSERT("Verify long multiplier for 7", long_seven.multiplier == 0x4924924924924925);
+    TEST_ASSERT_EQ_INT("Verify long shift for 7", 1, long_seven.shift);
+}
+
+void test_emitted_divide_by_seven() {
+    EmittedDivide emitted;
+    TEST_ASSERT("Verify x / 7 is emitted", emit_divide(7, false, BINOP_DIV, &emitted));
+    const char * expected[] = { "mov ecx, eax", "mov eax, -1840700269", "imul ecx", "add edx, ecx", "sar edx, 2",
+                                "mov eax, edx", "shr eax, 31", "add eax, edx", "push rax" };
+    bool matches = emitted.count == (int) (sizeof(expected) / sizeof(expected[0]));
+    for (int i = 0; matches && i < emitted.count; i++) {
+        matches = strcmp(emitted.lines[i], expected[i]) == 0;
+    }
+    TEST_ASSERT("Verify x / 7 is a multiply-high with no idiv", matches);
+}
+
+void test_int_small_divisors() {
+    bool ok = true;
+    for (int32_t divisor = 1; divisor <= 1000 && ok; divisor++) {
+        ok = check_int_divisor(divisor) && check_int_divisor(-divisor);
+    }
+    TEST_ASSERT("Verify emitted int division by every divisor up to 1000 matches idiv", ok);
+}
+
+void test_int_large_divisors() {
+    bool ok = check_int_divisor(INT32_MAX) && check_int_divisor(INT32_MIN) && check_int_divisor(1 << 30);
+    for (int i = 0; i < 2000 && ok; i++) {
+        int32_t divisor = (int32_t) next_random() >> (i % 31);
+        if (divisor == 0 || divisor == -1) continue;
+        ok = check_int_divisor(divisor);
+    }
+    TEST_ASSERT("Verify emitted int division by random divisors matches idiv", ok);
+}
+
+void test_long_divisors() {
+    bool ok = true;
+    for (int64_t divisor = 1; divisor <= 1000 && ok; divisor++) {
+        ok = check_long_divisor(divisor) && check_long_divisor(-divisor);
+    }
+    TEST_ASSERT("Verify emitted long division by every divisor up to 1000 matches idiv", ok);
+
+    ok = check_long_divisor(INT32_MAX) && check_long_divisor(INT32_MIN);
+    for (int i = 0; i < 2000 && ok; i++) {
+        int64_t divisor = (int32_t) next_random() >> (i % 31);
+        if (divisor == 0 || divisor == -1) continue;
+        ok = check_long_divisor(divisor);
+    }
+    TEST_ASSERT("Verify emitted long division by random int divisors matches idiv", ok);
+}
+
+void test_idiv_kept_at_O0() {
+    EmittedDivide emitted;
+    get_compiler_options()->opt_level = 0;
+    bool reduced = emit_divide(7, false, BINOP_DIV, &emitted) || emit_divide(8, true, BINOP_MOD, &emitted);
+    reset_compiler_options();
+    TEST_ASSERT("Verify division by constants is left to idiv at -O0", !reduced);
+}
+
+int main() {
+    RUN_TEST(test_known_magic_numbers);
+    RUN_TEST(test_emitted_divide_by_seven);
+    RUN_TEST(test_int_small_divisors);
+    RUN_TEST(test_int_large_divisors);
+    RUN_TEST(test_long_divisors);
+    RUN_TEST(test_idiv_kept_at_O0);
+}
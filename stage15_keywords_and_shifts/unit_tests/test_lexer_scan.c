@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "test_assert.h"
+#include "lexer_scan.h"
+
+const char * current_test = NULL;
+
+static const char * samples[] = {
+    "",
+    " ",
+    "int main() {\n    return 42;\n}",
+    "    \t\t\r\n\v\f    x",
+    "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789_abcdefghijklmnopqrstuvwxyz+",
+    "a`b@c[d{e/f:g",
+    "// a line comment that runs on past a couple of vector blocks before it ends\nint x;",
+    "/* a block comment * with / stray * and / slashes, ending on this line */ x = 1;",
+    "\"a string with \\\"escapes\\\" and \\\\ backslashes that runs on for a while\" ;",
+    "caf\xc3\xa9 \xa0\xff\x80 identifier\x7f_next",
+    "                                                                        end",
+};
+
+/* the scalar scanners are the reference, every mode has to stop where they do */
+static void check_mode(LexScanMode mode) {
+    LexScanMode used = set_lex_scan_mode(mode);
+    const LexScanners * scan = get_lex_scanners();
+    set_lex_scan_mode(LEX_SCAN_SCALAR);
+    const LexScanners * scalar = get_lex_scanners();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Verifying %s scanners match scalar", lex_scan_mode_name(used));
+
+    bool matches = true;
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        size_t length = strlen(samples[i]);
+        char * buffer = malloc(length + 64);
+        // every alignment of the start relative to a 32 byte block
+        for (int align = 0; align < 32; align++) {
+            char * text = buffer + align;
+            memcpy(text, samples[i], length + 1);
+            for (int pos = 0; pos <= (int) length; pos++) {
+                matches = matches &&
+                    scan->skip_whitespace(text, pos) == scalar->skip_whitespace(text, pos) &&
+                    scan->skip_identifier(text, pos) == scalar->skip_identifier(text, pos) &&
+                    scan->find_line_end(text, pos) == scalar->find_line_end(text, pos) &&
+                    scan->find_slash(text, pos) == scalar->find_slash(text, pos) &&
+                    scan->find_string_stop(text, pos) == scalar->find_string_stop(text, pos);
+            }
+        }
+        free(buffer);
+    }
+    TEST_ASSERT(msg, matches);
+}
+
+void test_scalar_scanners() {
+    set_lex_scan_mode(LEX_SCAN_SCALAR);
+    const LexScanners * scan = get_lex_scanners();
+    const char * text = "  \tname_1 + x // note\n\"a\\\"b\" / y";
+    TEST_ASSERT("Verifying whitespace stops at the name", scan->skip_whitespace(text, 0) == 3);
+    TEST_ASSERT("Verifying identifier stops at the space", scan->skip_identifier(text, 3) == 9);
+    TEST_ASSERT("Verifying line end stops at the newline", scan->find_line_end(text, 0) == 21);
+    TEST_ASSERT("Verifying slash stops at the comment", scan->find_slash(text, 0) == 14);
+    TEST_ASSERT("Verifying string stops at the backslash", scan->find_string_stop(text, 23) == 24);
+    TEST_ASSERT("Verifying string stops at the closing quote", scan->find_string_stop(text, 26) == 27);
+    TEST_ASSERT("Verifying scanners stop at the end", scan->find_line_end(text, 22) == (int) strlen(text));
+}
+
+void test_sse2_scanners() {
+    check_mode(LEX_SCAN_SSE2);
+}
+
+void test_avx2_scanners() {
+    check_mode(LEX_SCAN_AVX2);
+}
+
+void test_default_lex_scan_mode() {
+    TEST_ASSERT("Verifying scalar is the default", get_lex_scan_mode() == LEX_SCAN_SCALAR);
+}
+
+void test_set_lex_scan_mode() {
+    TEST_ASSERT("Verifying scalar is always available", set_lex_scan_mode(LEX_SCAN_SCALAR) == LEX_SCAN_SCALAR);
+    TEST_ASSERT("Verifying the mode is kept", get_lex_scan_mode() == LEX_SCAN_SCALAR);
+    LexScanMode used = set_lex_scan_mode(LEX_SCAN_AVX2);
+    TEST_ASSERT("Verifying the mode used is at most the one asked for", used <= LEX_SCAN_AVX2);
+    TEST_ASSERT("Verifying the mode used is reported", get_lex_scan_mode() == used);
+    TEST_ASSERT_EQ_STR("Verifying mode names", "sse2", lex_scan_mode_name(LEX_SCAN_SSE2));
+}
+
+int main() {
+    RUN_TEST(test_default_lex_scan_mode);
+    RUN_TEST(test_scalar_scanners);
+    RUN_TEST(test_sse2_scanners);
+    RUN_TEST(test_avx2_scanners);
+    RUN_TEST(test_set_lex_scan_mode);
+}
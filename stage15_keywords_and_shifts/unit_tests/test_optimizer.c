@@ -0,0 +1,517 @@
+#include "test_assert.h"
+#include "token.h"
+#include "tokenizer.h"
+#include "parser.h"
+#include "ast_printer.h"
+#include "symbol_table.h"
+#include "analyzer.h"
+#include "analyzer_context.h"
+#include "compile_stats.h"
+#include "runtime_usage.h"
+#include "opt_dead_symbols.h"
+#include "opt_dead_code.h"
+#include "opt_cse.h"
+#include "opt_loops.h"
+#include "cfg.h"
+#include "compiler_options.h"
+#include "vectorize.h"
+
+const char * current_test = NULL;
+
+static ASTNode * analyze_program(const char * program) {
+    TEST_MSG("Input Source Program:");
+    TEST_MSG(program);
+
+    tokenlist * tokens = tokenize(program);
+    ASTNode * translation_unit = parse(tokens);
+    init_global_table();
+    AnalyzerContext * ctx = analyzer_context_new();
+    analyze(ctx, translation_unit);
+    analyzer_context_free(ctx);
+    reset_compile_stats();
+    reset_compiler_options();
+    return translation_unit;
+}
+
+void test_dead_function_removed() {
+    const char * program = "int unused(int a) { return a + 1; }\n"
+                           "int used(int a) { return a * 2; }\n"
+                           "int main() { return used(21); }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    RuntimeUsage usage;
+    eliminate_dead_symbols(translation_unit, &usage);
+    print_ast(translation_unit, 0);
+
+    ASTNode_list * functions = translation_unit->translation_unit.functions;
+    TEST_ASSERT_EQ_INT("Verify two functions remain", 2, functions->count);
+    TEST_ASSERT_EQ_STR("Verify used is kept", "used", functions->head->value->function_def.name);
+    TEST_ASSERT_EQ_STR("Verify main is kept", "main", functions->tail->value->function_def.name);
+    TEST_ASSERT_EQ_INT("Verify removal is counted", 1, get_compile_stats()->functions_removed);
+}
+
+void test_transitively_called_function_kept() {
+    const char * program = "int leaf() { return 2; }\n"
+                           "int middle() { return leaf() + 1; }\n"
+                           "int main() { return middle(); }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    RuntimeUsage usage;
+    eliminate_dead_symbols(translation_unit, &usage);
+
+    TEST_ASSERT_EQ_INT("Verify all functions remain", 3, translation_unit->translation_unit.functions->count);
+}
+
+void test_dead_globals_and_literals_removed() {
+    const char * program = "int g_used = 1;\n"
+                           "int g_dead_only = 2;\n"
+                           "int g_unused;\n"
+                           "int dead() { _print(\"dead\"); return g_dead_only; }\n"
+                           "int main() { double d = 2.5; return g_used; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    RuntimeUsage usage;
+    eliminate_dead_symbols(translation_unit, &usage);
+
+    ASTNode_list * globals = translation_unit->translation_unit.globals;
+    TEST_ASSERT_EQ_INT("Verify one global remains", 1, globals->count);
+    TEST_ASSERT_EQ_STR("Verify g_used is kept", "g_used", globals->head->value->var_decl.name);
+    TEST_ASSERT_EQ_INT("Verify dead string literal removed", 0, translation_unit->translation_unit.string_literals->count);
+    TEST_ASSERT_EQ_INT("Verify live double literal kept", 1, translation_unit->translation_unit.double_literals->count);
+    TEST_ASSERT("Verify string printing is not needed", !usage.print_string);
+}
+
+void test_runtime_usage_recorded() {
+    const char * program = "int main() { double d = 1.0; d = -d; _print(3); _assert(1); return 0; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    RuntimeUsage usage;
+    eliminate_dead_symbols(translation_unit, &usage);
+
+    TEST_ASSERT("Verify integer printing is needed", usage.print_int);
+    TEST_ASSERT("Verify double printing is not needed", !usage.print_double);
+    TEST_ASSERT("Verify assert failure is needed", usage.assert_fail);
+    TEST_ASSERT("Verify double mask is needed", usage.mask_f64);
+    TEST_ASSERT("Verify float mask is not needed", !usage.mask_f32);
+}
+
+void test_no_main_keeps_all_functions() {
+    const char * program = "int a() { return 1; }\n"
+                           "int b() { return 2; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    RuntimeUsage usage;
+    eliminate_dead_symbols(translation_unit, &usage);
+
+    TEST_ASSERT_EQ_INT("Verify all functions remain", 2, translation_unit->translation_unit.functions->count);
+}
+
+static ASTNode * main_body(ASTNode * translation_unit) {
+    ASTNode * main_def = translation_unit->translation_unit.functions->tail->value;
+    return main_def->function_def.body;
+}
+
+void test_cfg_marks_code_after_return_unreachable() {
+    const char * program = "int main() { int a = 1; return a; a = 2; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    CFG * cfg = build_cfg(translation_unit->translation_unit.functions->head->value);
+    print_cfg(cfg);
+
+    int unreachable_items = 0;
+    for (int i = 0; i < cfg->block_count; i++) {
+        if (!cfg->blocks[i]->reachable) {
+            unreachable_items += cfg->blocks[i]->item_count;
+        }
+    }
+    TEST_ASSERT_EQ_INT("Verify the store after return is unreachable", 1, unreachable_items);
+    free_cfg(cfg);
+}
+
+void test_unreachable_statements_removed() {
+    const char * program = "int main() { int a = 1; while (a) { break; a = 3; } return a; a = 2; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_dead_code(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    ASTNode * body = main_body(translation_unit);
+    TEST_ASSERT_EQ_INT("Verify statement after return removed", 3, body->block.statements->count);
+    TEST_ASSERT_EQ_INT("Verify both removals counted", 2, get_compile_stats()->unreachable_statements_removed);
+}
+
+void test_empty_infinite_loop_kept() {
+    const char * program = "int main() { int x = 3; for (;;) {} return x; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_dead_code(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * last = body->block.statements->tail->value;
+    TEST_ASSERT("Verify the loop is kept", last->type == AST_FOR_STMT);
+    TEST_ASSERT("Verify only the return after it removed", get_compile_stats()->unreachable_statements_removed == 1);
+}
+
+void test_dead_store_removed() {
+    const char * program = "int main() { int a = 1; int b = 2; a = 5; b = a + 1; return a; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_dead_code(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * declaration = body->block.statements->head->value;
+    ASTNode * decl_a = declaration->declaration.init_declarator_list->head->value;
+    TEST_ASSERT("Verify overwritten initializer removed", decl_a->var_decl.init_expr == NULL);
+    TEST_ASSERT_EQ_INT("Verify dead stores removed", 3, get_compile_stats()->dead_stores_removed);
+    TEST_ASSERT_EQ_INT("Verify store to b removed", 4, body->block.statements->count);
+}
+
+void test_dead_store_keeps_call() {
+    const char * program = "int f() { return 3; }\n"
+                           "int main() { int a = 0; a = f(); return 0; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_dead_code(translation_unit->translation_unit.functions->tail->value);
+
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * stmt = ASTNode_list_get(body->block.statements, 1);
+    TEST_ASSERT("Verify call statement kept", stmt->type == AST_EXPRESSION_STMT &&
+        stmt->expr_stmt.expr->type == AST_FUNCTION_CALL_EXPR);
+}
+
+void test_store_live_around_loop_kept() {
+    const char * program = "int main() { int i = 0; int s = 0; while (i < 4) { s = s + i; i = i + 1; } return s; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_dead_code(translation_unit->translation_unit.functions->head->value);
+
+    TEST_ASSERT_EQ_INT("Verify no stores removed", 0, get_compile_stats()->dead_stores_removed);
+}
+
+void test_dominators_of_if_else() {
+    const char * program = "int main() { int a = 1; if (a) { a = 2; } else { a = 3; } return a; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    CFG * cfg = build_cfg(translation_unit->translation_unit.functions->head->value);
+    compute_dominators(cfg);
+    print_cfg(cfg);
+
+    BasicBlock * entry = cfg->entry;
+    BasicBlock * branch = entry->succs[0];
+    TEST_ASSERT_EQ_INT("Verify the if branches two ways", 2, branch->succ_count);
+    BasicBlock * then_block = branch->succs[0];
+    BasicBlock * else_block = branch->succs[1];
+    BasicBlock * join = then_block->succs[0];
+    TEST_ASSERT("Verify entry has no dominator", entry->idom == NULL);
+    TEST_ASSERT("Verify both arms are dominated by the branch",
+        then_block->idom == branch && else_block->idom == branch);
+    TEST_ASSERT("Verify the join is dominated by the branch", join->idom == branch);
+    TEST_ASSERT("Verify an arm does not dominate the join", !dominates(then_block, join));
+    TEST_ASSERT("Verify the entry dominates the join", dominates(entry, join));
+    free_cfg(cfg);
+}
+
+static ASTNode * find_init(ASTNode * body, int index) {
+    ASTNode * stmt = ASTNode_list_get(body->block.statements, index);
+    return stmt->declaration.init_declarator_list->head->value->var_decl.init_expr;
+}
+
+void test_repeated_arithmetic_reused() {
+    const char * program = "int main() { int a = 3; int b = 4; int c = a * b + 1; int d = a * b + 1; return c + d; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    ASTNode * function = translation_unit->translation_unit.functions->head->value;
+    eliminate_common_subexpressions(function);
+    print_ast(translation_unit, 0);
+
+    // the temporary is declared first, so the declarations move down by one
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * first = find_init(body, 3);
+    ASTNode * second = find_init(body, 4);
+    TEST_ASSERT_EQ_INT("Verify one reuse", 1, get_compile_stats()->common_subexpressions_eliminated);
+    TEST_ASSERT("Verify first occurrence assigns the temporary",
+        first->type == AST_BINARY_EXPR && first->binary.op == BINOP_ASSIGNMENT);
+    TEST_ASSERT("Verify second occurrence reads the temporary",
+        second->type == AST_VAR_REF_EXPR && second->symbol == first->binary.lhs->symbol);
+}
+
+void test_store_through_pointer_blocks_reuse() {
+    const char * program = "int main() { int a[4]; int *p = a; int i = 1; a[1] = 2;\n"
+                           "  int x = a[i] * 3; p[1] = 5; int y = a[i] * 3; return x + y; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_common_subexpressions(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    // the element address is reused, the loaded value is not
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * y = find_init(body, 7);
+    TEST_ASSERT_EQ_INT("Verify only the address is reused", 1, get_compile_stats()->common_subexpressions_eliminated);
+    TEST_ASSERT("Verify product is recomputed", y->type == AST_BINARY_EXPR && y->binary.op == BINOP_MUL);
+    TEST_ASSERT("Verify element read through the temporary",
+        y->binary.lhs->type == AST_UNARY_EXPR && y->binary.lhs->unary.op == UNARY_DEREF);
+}
+
+void test_loop_variant_expression_not_reused() {
+    const char * program = "int main() { int i = 0; int s = 0; int k = i * 7;\n"
+                           "  while (i < 3) { s = s + i * 7; i = i + 1; } return s + k; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_common_subexpressions(translation_unit->translation_unit.functions->head->value);
+
+    TEST_ASSERT_EQ_INT("Verify nothing reused", 0, get_compile_stats()->common_subexpressions_eliminated);
+}
+
+static ASTNode * first_expression(ASTNode * body) {
+    for (ASTNode_list_node * n = body->block.statements->head; n; n = n->next) {
+        if (n->value->type == AST_EXPRESSION_STMT) return n->value->expr_stmt.expr;
+    }
+    return NULL;
+}
+
+static bool is_temp_read(ASTNode * node) {
+    return node->type == AST_UNARY_EXPR && node->unary.op == UNARY_DEREF &&
+           node->unary.operand->type == AST_VAR_REF_EXPR;
+}
+
+void test_compound_assignment_reuses_rhs_address() {
+    const char * program = "int y[4]; int main() { int i = 1; y[i] += y[i] * 2; return y[1]; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_common_subexpressions(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    // the emitter evaluates the rhs first, so the temporary is assigned there
+    ASTNode * update = first_expression(main_body(translation_unit));
+    ASTNode * element = update->binary.rhs->binary.lhs;
+    TEST_ASSERT_EQ_INT("Verify the element address is reused once", 1,
+        get_compile_stats()->common_subexpressions_eliminated);
+    TEST_ASSERT("Verify the rhs assigns the temporary", element->type == AST_UNARY_EXPR &&
+        element->unary.operand->type == AST_BINARY_EXPR && element->unary.operand->binary.op == BINOP_ASSIGNMENT);
+    TEST_ASSERT("Verify the target reads the temporary", is_temp_read(update->binary.lhs));
+}
+
+void test_compound_assignment_conditional_rhs() {
+    const char * program = "int y[4]; int main() { int i = 1; int c = 1; y[i] += (c ? y[i] : 2); return y[1]; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    eliminate_common_subexpressions(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    // an arm of ?: may not run, so neither occurrence can define the temporary for the other
+    ASTNode * update = first_expression(main_body(translation_unit));
+    TEST_ASSERT_EQ_INT("Verify nothing reused", 0, get_compile_stats()->common_subexpressions_eliminated);
+    TEST_ASSERT("Verify the target is left as it was", update->binary.lhs->type == AST_ARRAY_ACCESS);
+}
+
+static ASTNode * statement_before(ASTNode * body, ASTNodeType type) {
+    ASTNode * prev = NULL;
+    for (ASTNode_list_node * n = body->block.statements->head; n; n = n->next) {
+        if (n->value->type == type) return prev;
+        prev = n->value;
+    }
+    return NULL;
+}
+
+void test_loop_invariant_hoisted() {
+    const char * program = "int main() { int a[8]; int n = 3; int k = 4; int i = 0;\n"
+                           "  while (i < 8) { a[i] = n * k; i = i + 1; } return a[2]; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    optimize_loops(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    ASTNode * preheader = statement_before(main_body(translation_unit), AST_WHILE_STMT);
+    TEST_ASSERT_EQ_INT("Verify one invariant hoisted", 1, get_compile_stats()->loop_invariants_hoisted);
+    TEST_ASSERT("Verify product computed before the loop",
+        preheader->type == AST_EXPRESSION_STMT &&
+        preheader->expr_stmt.expr->binary.op == BINOP_ASSIGNMENT &&
+        preheader->expr_stmt.expr->binary.rhs->binary.op == BINOP_MUL);
+}
+
+void test_induction_access_reduced() {
+    const char * program = "int main() { int a[8]; int s = 0; int i;\n"
+                           "  for (i = 0; i < 8; i++) { s = s + a[i]; } return s; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    // the vectorizer would take this loop as it is
+    get_compiler_options()->vectorize = false;
+    optimize_loops(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    // temporary, three declarations, then the initializer moved out in front of the pointer setup
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * preheader = statement_before(body, AST_FOR_STMT);
+    ASTNode * loop = ASTNode_list_get(body->block.statements, 6);
+    TEST_ASSERT_EQ_INT("Verify one access reduced", 1, get_compile_stats()->induction_accesses_reduced);
+    TEST_ASSERT("Verify pointer starts at the first element",
+        preheader->expr_stmt.expr->binary.rhs->type == AST_UNARY_EXPR &&
+        preheader->expr_stmt.expr->binary.rhs->unary.op == UNARY_ADDRESS);
+    TEST_ASSERT("Verify loop initializer moved out", loop->type == AST_FOR_STMT && loop->for_stmt.init_expr == NULL);
+    TEST_ASSERT("Verify update moved into the body", loop->for_stmt.update_expr == NULL);
+}
+
+void test_loop_variant_not_hoisted() {
+    const char * program = "int main() { int a[8]; int s = 0; int i;\n"
+                           "  for (i = 0; i < 8; i++) { if (a[i] > 2) continue; s = s + i * 7; } return s; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    optimize_loops(translation_unit->translation_unit.functions->head->value);
+
+    // continue would skip the pointer step, so indexing is left alone
+    TEST_ASSERT_EQ_INT("Verify nothing hoisted", 0, get_compile_stats()->loop_invariants_hoisted);
+    TEST_ASSERT_EQ_INT("Verify nothing reduced", 0, get_compile_stats()->induction_accesses_reduced);
+}
+
+void test_constant_loop_fully_unrolled() {
+    const char * program = "int main() { int a[4]; int i;\n"
+                           "  for (i = 0; i < 3; i++) { a[i] = i; } return a[2]; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    unroll_loops(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    // three copies of the body and the final value of i replace the loop
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * last = ASTNode_list_get(body->block.statements, 4);
+    ASTNode * final = ASTNode_list_get(body->block.statements, 5);
+    TEST_ASSERT_EQ_INT("Verify one loop fully unrolled", 1, get_compile_stats()->loops_fully_unrolled);
+    TEST_ASSERT_EQ_INT("Verify statement count", 7, body->block.statements->count);
+    ASTNode * store = last->block.statements->head->value->expr_stmt.expr;
+    TEST_ASSERT("Verify last copy indexes with a constant",
+        store->binary.lhs->array_access.index->type == AST_INT_LITERAL &&
+        store->binary.lhs->array_access.index->int_value == 2);
+    TEST_ASSERT_EQ_INT("Verify i is left at its final value", 3, final->expr_stmt.expr->binary.rhs->int_value);
+}
+
+void test_loop_unrolled_with_remainder() {
+    const char * program = "int main() { int a[100]; int n = 100; int s = 0; int i;\n"
+                           "  for (i = 0; i < n; i++) { s = s + a[i]; } return s; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    get_compiler_options()->vectorize = false;
+    unroll_loops(translation_unit->translation_unit.functions->head->value);
+    print_ast(translation_unit, 0);
+
+    // initializer, the unrolled loop, then the original loop for the remainder
+    ASTNode * body = main_body(translation_unit);
+    ASTNode * unrolled = ASTNode_list_get(body->block.statements, 5);
+    ASTNode * remainder = ASTNode_list_get(body->block.statements, 6);
+    TEST_ASSERT_EQ_INT("Verify one loop unrolled", 1, get_compile_stats()->loops_unrolled);
+    TEST_ASSERT("Verify unrolled loop runs four iterations per trip",
+        unrolled->type == AST_FOR_STMT && unrolled->for_stmt.body->block.statements->count == 4 &&
+        unrolled->for_stmt.update_expr->binary.rhs->int_value == 4);
+    TEST_ASSERT("Verify remainder loop keeps the original update",
+        remainder->type == AST_FOR_STMT && remainder->for_stmt.init_expr == NULL &&
+        remainder->for_stmt.update_expr != NULL);
+}
+
+void test_loop_with_break_not_unrolled() {
+    const char * program = "int main() { int a[100]; int s = 0; int i;\n"
+                           "  for (i = 0; i < 3; i++) { if (a[i]) break; s = s + 1; } return s; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    unroll_loops(translation_unit->translation_unit.functions->head->value);
+
+    TEST_ASSERT_EQ_INT("Verify nothing unrolled", 0,
+        get_compile_stats()->loops_fully_unrolled + get_compile_stats()->loops_unrolled);
+}
+
+static ASTNode * last_loop(ASTNode * translation_unit) {
+    ASTNode * loop = NULL;
+    for (ASTNode_list_node * n = main_body(translation_unit)->block.statements->head; n; n = n->next) {
+        if (n->value->type == AST_FOR_STMT) loop = n->value;
+    }
+    return loop;
+}
+
+void test_int_sum_vectorized() {
+    const char * program = "int a[100]; int main() { int n = 100; int s = 0; int i;\n"
+                           "  for (i = 0; i < n; i++) { s += a[i]; } return s; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    unroll_loops(translation_unit->translation_unit.functions->head->value);
+
+    VectorLoop loop;
+    TEST_ASSERT("Verify loop matched", match_vector_loop(last_loop(translation_unit), &loop));
+    TEST_ASSERT("Verify reduction into s",
+        loop.kind == VECTOR_REDUCTION && strcmp(loop.target->var_ref.name, "s") == 0);
+    TEST_ASSERT("Verify plain sum of one array", loop.op == BINOP_UNASSIGNED_OP && loop.rhs == NULL);
+    TEST_ASSERT_EQ_INT("Verify loop left for the vectorizer", 0, get_compile_stats()->loops_unrolled);
+}
+
+void test_elementwise_with_scalar_vectorized() {
+    const char * program = "int main() { float a[64]; float c[64]; float k = 2.0f; int i;\n"
+                           "  for (i = 0; i <= 63; i = i + 1) { c[i] = a[i] * k; } return 0; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+
+    VectorLoop loop;
+    TEST_ASSERT("Verify loop matched", match_vector_loop(last_loop(translation_unit), &loop));
+    TEST_ASSERT("Verify elementwise product",
+        loop.kind == VECTOR_ELEMENTWISE && loop.op == BINOP_MUL && loop.inclusive);
+    TEST_ASSERT("Verify array times scalar",
+        is_vector_array_operand(loop.lhs) && !is_vector_array_operand(loop.rhs));
+}
+
+void test_fp_sum_needs_fast_math() {
+    const char * program = "double a[100]; int main() { double s = 0.0; int i;\n"
+                           "  for (i = 0; i < 100; i++) { s = s + a[i]; } return 0; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    VectorLoop loop;
+    // adding in a different order can round differently
+    TEST_ASSERT("Verify sum kept in order", !match_vector_loop(last_loop(translation_unit), &loop));
+    get_compiler_options()->fast_math = true;
+    TEST_ASSERT("Verify sum matched with --fast-math", match_vector_loop(last_loop(translation_unit), &loop));
+}
+
+void test_pointer_loop_not_vectorized() {
+    const char * program = "void add(int * c, int * a, int n) { int i;\n"
+                           "  for (i = 0; i < n; i++) { c[i] = c[i] + a[i]; } }\n"
+                           "int main() { int a[8]; int m[8]; int i;\n"
+                           "  for (i = 0; i < 8; i++) { a[i] = a[i] * 3; }\n"
+                           "  for (i = 0; i < 8; i++) { m[i] = a[i + 1]; } return 0; }\n";
+
+    ASTNode * translation_unit = analyze_program(program);
+    ASTNode * add = translation_unit->translation_unit.functions->head->value;
+    ASTNode * loop = ASTNode_list_get(add->function_def.body->block.statements, 1);
+    ASTNode * main_loop = ASTNode_list_get(main_body(translation_unit)->block.statements, 3);
+
+    VectorLoop vector;
+    TEST_ASSERT("Verify parameters may overlap", !match_vector_loop(loop, &vector));
+    TEST_ASSERT("Verify no packed int multiply", !match_vector_loop(main_loop, &vector));
+    TEST_ASSERT("Verify other elements are not read", !match_vector_loop(last_loop(translation_unit), &vector));
+}
+
+int main() {
+    RUN_TEST(test_dead_function_removed);
+    RUN_TEST(test_transitively_called_function_kept);
+    RUN_TEST(test_dead_globals_and_literals_removed);
+    RUN_TEST(test_runtime_usage_recorded);
+    RUN_TEST(test_no_main_keeps_all_functions);
+    RUN_TEST(test_cfg_marks_code_after_return_unreachable);
+    RUN_TEST(test_unreachable_statements_removed);
+    RUN_TEST(test_empty_infinite_loop_kept);
+    RUN_TEST(test_dead_store_removed);
+    RUN_TEST(test_dead_store_keeps_call);
+    RUN_TEST(test_store_live_around_loop_kept);
+    RUN_TEST(test_dominators_of_if_else);
+    RUN_TEST(test_repeated_arithmetic_reused);
+    RUN_TEST(test_store_through_pointer_blocks_reuse);
+    RUN_TEST(test_loop_variant_expression_not_reused);
+    RUN_TEST(test_compound_assignment_reuses_rhs_address);
+    RUN_TEST(test_compound_assignment_conditional_rhs);
+    RUN_TEST(test_loop_invariant_hoisted);
+    RUN_TEST(test_induction_access_reduced);
+    RUN_TEST(test_loop_variant_not_hoisted);
+    RUN_TEST(test_constant_loop_fully_unrolled);
+    RUN_TEST(test_loop_unrolled_with_remainder);
+    RUN_TEST(test_loop_with_break_not_unrolled);
+    RUN_TEST(test_int_sum_vectorized);
+    RUN_TEST(test_elementwise_with_scalar_vectorized);
+    RUN_TEST(test_fp_sum_needs_fast_math);
+    RUN_TEST(test_pointer_loop_not_vectorized);
+}
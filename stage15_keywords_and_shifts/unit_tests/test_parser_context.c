@@ -33,7 +33,7 @@ void test_peek() {
 
     // verify
     TEST_ASSERT("Verifying token type", token->type == TOKEN_INT);
-    TEST_ASSERT("Verifying token position", token->col == 1 && token->line == 1);
+    TEST_ASSERT("Verifying token position", token_col(token) == 1 && token_line(token) == 1);
     
     // cleanup
     free_parser_context(ctx);
@@ -50,7 +50,7 @@ void test_peek_next() {
 
     // verify
     TEST_ASSERT("Verifying token type", token->type == TOKEN_IDENTIFIER);
-    TEST_ASSERT("Verifying token text", strcmp("main", token->text)==0);
+    TEST_ASSERT("Verifying token text", token_text_is(token, "main"));
     
     // cleanup
     free_parser_context(ctx);
@@ -210,7 +210,7 @@ void test_get_current_token_line() {
     tokenlist * tokens = tokenize(program_text);
     ParserContext * ctx = create_parser_context(tokens);
 
-    TEST_ASSERT("Verifying correct line", peek(ctx)->line == 1);
+    TEST_ASSERT("Verifying correct line", token_line(peek(ctx)) == 1);
 
     // cleanup
     free_parser_context(ctx);
@@ -221,7 +221,7 @@ void test_get_current_token_col() {
     tokenlist * tokens = tokenize(program_text);
     ParserContext * ctx = create_parser_context(tokens);
 
-    TEST_ASSERT("Verifying correct col", peek(ctx)->col == 1);
+    TEST_ASSERT("Verifying correct col", token_col(peek(ctx)) == 1);
 
     // cleanup
     free_parser_context(ctx);
@@ -424,11 +424,12 @@ void test_is_next_token_assignment() {
     tokenlist * tokens = malloc(sizeof(tokenlist));
     tokenlist_init(tokens, free_token);
  
-    tokenlist_append(tokens, make_int_token("42", 1, 1));
-    tokenlist_append(tokens, make_token(TOKEN_ASSIGN, "=", 1,1));
-    tokenlist_append(tokens, make_token(TOKEN_PLUS_EQUAL, "+=", 1, 1));
-    tokenlist_append(tokens, make_token(TOKEN_MINUS_EQUAL, "-=", 1, 1));
-    tokenlist_append(tokens, make_eof_token(1,1));
+    set_token_source("42 = += -=");
+    tokenlist_append(tokens, make_int_token(0, 2));
+    tokenlist_append(tokens, make_token(TOKEN_ASSIGN, 3, 1));
+    tokenlist_append(tokens, make_token(TOKEN_PLUS_EQUAL, 5, 2));
+    tokenlist_append(tokens, make_token(TOKEN_MINUS_EQUAL, 8, 2));
+    tokenlist_append(tokens, make_eof_token(10));
 
     ParserContext * parserContext = create_parser_context(tokens);
     // next token should be = which is an assignment token
@@ -20,37 +20,72 @@ void test_add_token() {
     tokenlist * list = malloc(sizeof(tokenlist));
     init_token_list(list);
     TEST_ASSERT("Verifying list has 0 elements", list->count == 0);
-    Token * token = make_eof_token(1,1);
+    Token * token = make_eof_token(0);
     add_token(list, token);
     TEST_ASSERT("Verifying list has 1 element", list->count == 1);
 }
 
 void test_make_token() {
-    Token * token = make_token(TOKEN_RETURN, "return", 1,1);
+    set_token_source("return 42;");
+    Token * token = make_token(TOKEN_RETURN, 0, 6);
     TEST_ASSERT("Verifying token has correct type", token->type == TOKEN_RETURN);
-    TEST_ASSERT("Verifying token has correct text", strcmp("return", token->text)==0);
+    TEST_ASSERT("Verifying token has correct text", token_text_is(token, "return"));
     TEST_ASSERT("Verifying token has correct text length", strlen("return") == token->length);
-    TEST_ASSERT("Verifying int value is 0", token->int_value == 0);
-    TEST_ASSERT("Verifying token has correct positions", token->line == 1 && token->col == 1);
+    TEST_ASSERT("Verifying int value is 0", token_int_value(token) == 0);
+    TEST_ASSERT("Verifying token has correct positions", token_line(token) == 1 && token_col(token) == 1);
 }
 
 void test_make_int_token() {
-    Token * token = make_int_token("42", 1,1);
+    set_token_source("return 42;");
+    Token * token = make_int_token(7, 2);
     TEST_ASSERT("Verifying token has correct type", token->type == TOKEN_INT_LITERAL);
-    TEST_ASSERT("Verifying token has correct text", strcmp("42", token->text)==0);
+    TEST_ASSERT("Verifying token has correct text", token_text_is(token, "42"));
     TEST_ASSERT("Verifying token has correct text length", strlen("42") == token->length);
-    TEST_ASSERT("Verifying token has correct int value", token->int_value == 42);
-    TEST_ASSERT("Verifying token has correct positions", token->line == 1 && token->col == 1);
+    TEST_ASSERT("Verifying token has correct int value", token_int_value(token) == 42);
+    TEST_ASSERT("Verifying token has correct positions", token_line(token) == 1 && token_col(token) == 8);
 }
 
 void test_make_identifier_token() {
-    const char * id = "main";
-    Token * token = make_identifier_token(id, 1, 1);
+    set_token_source("int main()");
+    Token * token = make_identifier_token(4, 4);
     TEST_ASSERT("Verifying token has correct type", token->type == TOKEN_IDENTIFIER);
-    TEST_ASSERT("Verifying token has correct text", strcmp(id, token->text)==0);
-    TEST_ASSERT("Verifying token has correct text length", strlen(id) == token->length);
-    TEST_ASSERT("Verifying token has correct int value", token->int_value == 0);
-    TEST_ASSERT("Verifying token has correct positions", token->line == 1 && token->col == 1);
+    TEST_ASSERT("Verifying token has correct text", token_text_is(token, "main"));
+    TEST_ASSERT("Verifying token is not a prefix match", !token_text_is(token, "mai"));
+    TEST_ASSERT("Verifying token has correct text length", strlen("main") == token->length);
+    TEST_ASSERT("Verifying token has correct int value", token_int_value(token) == 0);
+    TEST_ASSERT("Verifying token has correct positions", token_line(token) == 1 && token_col(token) == 5);
+}
+
+void test_string_literal_text() {
+    set_token_source("\"a\\tb\\n\"");
+    Token * token = make_string_literal_token(0, 8);
+    char * text = token_text(token);
+    TEST_ASSERT("Verifying escapes are resolved", strcmp("a\tb\n", text) == 0);
+    free(text);
+}
+
+void test_token_size() {
+    TEST_ASSERT("Verifying tokens are 16 bytes", sizeof(Token) == 16);
+}
+
+void test_literal_values() {
+    set_token_source("7 2.5f 0.25");
+    Token * int_token = make_int_token(0, 1);
+    Token * float_token = make_float_token(2, 3);
+    Token * double_token = make_double_token(7, 4);
+    TEST_ASSERT("Verifying int value", token_int_value(int_token) == 7);
+    TEST_ASSERT("Verifying float value", token_float_value(float_token) == 2.5f);
+    TEST_ASSERT("Verifying double value", token_double_value(double_token) == 0.25);
+}
+
+void test_line_and_col() {
+    set_token_source("int a;\n\n  return a;\n");
+    Token * first = make_token(TOKEN_INT, 0, 3);
+    Token * later = make_token(TOKEN_RETURN, 10, 6);
+    Token * eof = make_eof_token(20);
+    TEST_ASSERT("Verifying first line", token_line(first) == 1 && token_col(first) == 1);
+    TEST_ASSERT("Verifying later line", token_line(later) == 3 && token_col(later) == 3);
+    TEST_ASSERT("Verifying end of file", token_line(eof) == 4 && token_col(eof) == 1);
 }
 
 void test_token_type_name() {
@@ -63,5 +98,9 @@ int main() {
     RUN_TEST(test_make_token);
     RUN_TEST(test_make_int_token);
     RUN_TEST(test_make_identifier_token);
+    RUN_TEST(test_string_literal_text);
+    RUN_TEST(test_token_size);
+    RUN_TEST(test_literal_values);
+    RUN_TEST(test_line_and_col);
     RUN_TEST(test_token_type_name);
 }
\ No newline at end of file
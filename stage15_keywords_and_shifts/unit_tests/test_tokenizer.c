@@ -49,7 +49,7 @@ void test_match_keyword(const char * text, TokenType expectedType) {
     snprintf(msg_buf, sizeof(msg_buf), "Attempting to match keyword: %s", text);
 
     TokenizerContext * ctx = init_tokenizer_context(text);
-    Token * token = match_keyword(ctx, text);
+    Token * token = match_keyword(ctx, 0, strlen(text));
     TEST_ASSERT(msg_buf, expectedType == token->type);
     
     free_tokenizer_context(ctx);
@@ -66,8 +66,48 @@ void test_match_keywords() {
     test_match_keyword("else", TOKEN_ELSE);
 }
 
+/* the comments and the string are long enough for the scanners to take
+ * them a block at a time
+ */
+void test_comments_and_strings() {
+    const char * program_text =
+        "// a line comment that is long enough to need more than one block\n"
+        "int x; /* a block comment * with / stray characters\n"
+        "   that goes on for a second line **/ _print(\"a \\\"quoted\\\" string with a \\n newline\");\n"
+        "    return x;";
+
+    TokenType expected_types[] = {
+        TOKEN_INT, TOKEN_IDENTIFIER, TOKEN_SEMICOLON,
+        TOKEN_PRINT_EXTENSION, TOKEN_LPAREN, TOKEN_STRING_LITERAL, TOKEN_RPAREN, TOKEN_SEMICOLON,
+        TOKEN_RETURN, TOKEN_IDENTIFIER, TOKEN_SEMICOLON,
+        TOKEN_EOF
+    };
+    int expected_lines[] = { 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4 };
+
+    tokenlist * tokens = tokenize(program_text);
+    int count = 0;
+    bool matches = true;
+    for (tokenlist_node * node = tokens->head; node != NULL; node = node->next) {
+        matches = matches && count < 12 && node->value->type == expected_types[count] &&
+                  token_line(node->value) == expected_lines[count];
+        count++;
+    }
+    TEST_ASSERT("Verifying token types and lines", matches && count == 12);
+
+    Token * string = tokens->head->next->next->next->next->next->value;
+    TEST_ASSERT("Verifying the string starts after the block comment", token_col(string) == 46);
+    char * text = token_text(string);
+    TEST_ASSERT_EQ_STR("Verifying the string text", "a \"quoted\" string with a \n newline", text);
+    free(text);
+
+    tokenlist_free(tokens);
+    free(tokens);
+    release_token_source();
+}
+
 int main() {
     RUN_TEST(basic_test);
     RUN_TEST(test_match_keywords);
+    RUN_TEST(test_comments_and_strings);
 }
 
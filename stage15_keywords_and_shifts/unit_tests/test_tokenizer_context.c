@@ -43,6 +43,32 @@ void test_tokenizer_context() {
 
 }
 
+void test_advance_to() {
+    TokenizerContext * ctx = init_tokenizer_context(program);
+
+    TEST_MSG("Advancing to the return");
+    char c = advance_to(ctx, 17);
+    TEST_ASSERT("Verifying character returned is 'r'", c == 'r');
+    TEST_ASSERT("Verifying ctx next is 'e'", ctx->next_char == 'e');
+    TEST_ASSERT("Verifying ctx line is 2", ctx->line == 2);
+    TEST_ASSERT("Verifying ctx col is 5", ctx->col == 5);
+
+    TEST_MSG("Advancing within the line");
+    advance_to(ctx, 24);
+    TEST_ASSERT("Verifying ctx curr is '4'", ctx->curr_char == '4');
+    TEST_ASSERT("Verifying ctx col is 12", ctx->col == 12);
+
+    TEST_MSG("Advancing to the end");
+    c = advance_to(ctx, strlen(program));
+    TEST_ASSERT("Verifying character returned is the end", c == '\0');
+    TEST_ASSERT("Verifying ctx next is the end", ctx->next_char == '\0');
+    TEST_ASSERT("Verifying ctx line is 3", ctx->line == 3);
+    TEST_ASSERT("Verifying ctx col is 2", ctx->col == 2);
+
+    free_tokenizer_context(ctx);
+}
+
 int main() {
     RUN_TEST(test_tokenizer_context);
+    RUN_TEST(test_advance_to);
 }
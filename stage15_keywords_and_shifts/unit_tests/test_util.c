@@ -22,6 +22,16 @@ void test_read_text_file() {
     TEST_ASSERT("Verifying data was correctly read", strcmp(program_data, program) == 0);
 }
 
+void test_map_text_file() {
+    char * filename = write_temp_file(program);
+
+    SourceText source = map_text_file(filename);
+    TEST_ASSERT("Verifying data was correctly mapped", strcmp(source.text, program) == 0);
+    TEST_ASSERT("Verifying length", source.length == strlen(program));
+    TEST_ASSERT("Verifying a short file is mapped", source.mapped);
+    release_text_file(&source);
+}
+
 void test_change_extension() {
     char * original_filename = "c_source.c";
     char * new_filename = change_extension(original_filename, ".s");
@@ -30,5 +40,6 @@ void test_change_extension() {
 
 int main() {
     RUN_TEST(test_read_text_file);
+    RUN_TEST(test_map_text_file);
     RUN_TEST(test_change_extension);
 }
\ No newline at end of file